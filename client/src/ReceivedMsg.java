@@ -182,14 +182,17 @@ public enum ReceivedMsg {
          * */
         @Override
         public boolean isValid(String[] tokens) {
-            if (tokens.length != Connect4.ROWS * Connect4.COLUMNS + 1)
+            // GAME_RECOVERY <index of the first move> [moves as a string of columns]
+            if (tokens.length != 2 && tokens.length != 3)
                 return false;
             try {
-                for (int i = 1; i < Connect4.ROWS * Connect4.COLUMNS + 1; i++) {
-                    int value = Integer.parseInt(tokens[i]);
-                    if (!(value == 0 || value == 1 || value == 2))
+                int first = Integer.parseInt(tokens[1]);
+                String moves = tokens.length == 3 ? tokens[2] : "";
+                if (first < 0 || first + moves.length() > Connect4.ROWS * Connect4.COLUMNS)
+                    return false;
+                for (char c : moves.toCharArray())
+                    if (c < '0' || c >= '0' + Connect4.COLUMNS)
                         return false;
-                }
             } catch (Exception e) {
                 return false;
             }
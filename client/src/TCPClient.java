@@ -36,6 +36,8 @@ public class TCPClient extends Thread {
     private static final String O_GAME_CANCELED = "GAME_CANCELED";
     /** message to play the game (one turn) */
     private static final String O_GAME_PLAY     = "GAME_PLAY";
+    /** message to get the moves of the game the client has not seen yet */
+    private static final String O_GAME_RESYNC   = "GAME_RESYNC";
 
     /**
      * when the connection goes off this is the sleep period
@@ -74,6 +76,10 @@ public class TCPClient extends Thread {
     private boolean gameIsOn;
     /** flag if the user already accepted a game request (they cannot spam the button) */
     private boolean previouselyAccepted;
+    /** number of moves of the current game the client has seen */
+    private int movesSeen;
+    /** number of disks in each column of the current game */
+    private int[] columnHeights;
 
     /** Different states of the client */
     private enum State {
@@ -193,6 +199,8 @@ public class TCPClient extends Thread {
         player1 = false;
         gameIsOn = false;
         previouselyAccepted = false;
+        movesSeen = 0;
+        columnHeights = new int[Connect4.COLUMNS];
 
         // start attempting to connect to the server
         heartBeat = new HeartBeat();
@@ -378,6 +386,11 @@ public class TCPClient extends Thread {
 
         switch (msg) {
             case GAME_RECOVERY:
+                // some moves are missing in between - ask for them
+                if (Integer.parseInt(tokens[1]) > movesSeen) {
+                    sendMessage(O_GAME_RESYNC + " " + movesSeen);
+                    break;
+                }
                 main.gameRecovery(getRecoveryData(tokens));
                 break;
             case ADD_CLIENT:
@@ -398,11 +411,15 @@ public class TCPClient extends Thread {
                 break;
             case GAME_START:
                 gameIsOn = true;
+                movesSeen = 0;
+                columnHeights = new int[Connect4.COLUMNS];
                 main.gameStart(tokens[1]);
                 break;
             case GAME_PLAY:
                 int y = Integer.parseInt(tokens[2]);
                 int x = Integer.parseInt(tokens[3]);
+                movesSeen++;
+                columnHeights[x] = Connect4.ROWS - y;
                 main.playGame(y, x, player1 ? tokens[1].equals(nick) : !tokens[1].equals(nick));
                 break;
             case GAME_CANCELED:
@@ -427,25 +444,26 @@ public class TCPClient extends Thread {
     /**
      * Processes data for game recovery.
      * It parses it from the messages and returns it as a list of
-     * coordinates of individual disks on the board.
+     * coordinates of individual disks on the board. The moves the
+     * client has already seen are skipped.
      * @param tokens message split up into tokens
      * @return list of coordinates of the disks on the board
      * */
     private List<int[]> getRecoveryData(String[] tokens) {
         List<int[]> data = new ArrayList<>();
-        int y = 0;
-        int x = 0;
-        int value;
-
-        for (int i = 1; i <= Connect4.ROWS * Connect4.COLUMNS; i++) {
-            value = Integer.parseInt(tokens[i]);
-            if (value != 0)
-                data.add(new int[] { y, x, value });
-            x++;
-            if (i % Connect4.COLUMNS == 0) {
-                y++;
-                x = 0;
+        int index = Integer.parseInt(tokens[1]);
+        String moves = tokens.length == 3 ? tokens[2] : "";
+
+        for (char c : moves.toCharArray()) {
+            int x = c - '0';
+            if (index >= movesSeen && columnHeights[x] < Connect4.ROWS) {
+                // the first move was played by player1
+                int y = Connect4.ROWS - 1 - columnHeights[x];
+                data.add(new int[] { y, x, index % 2 == 0 ? 1 : 2 });
+                columnHeights[x]++;
+                movesSeen++;
             }
+            index++;
         }
         return data;
     }
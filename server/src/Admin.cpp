@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+
+#include <poll.h>
+#include <dirent.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+#include "Admin.h"
+#include "Position.h"
+
+Admin::Admin(Server &server) : server(server) {
+    listenFd = -1;
+    running = false;
+    sessions = 0;
+
+    // initialize the table of commands
+    commands["help"] = {&Admin::help, "", "lists the commands"};
+    commands["clients"] = {&Admin::clients, "", "lists the clients by their states"};
+    commands["games"] = {&Admin::games, "", "lists the games in progress with their boards"};
+    commands["requests"] = {&Admin::requests, "", "lists the pending game requests"};
+    commands["reconnecting"] = {&Admin::reconnecting, "", "lists the players the server waits for to reconnect"};
+    commands["threads"] = {&Admin::threads, "", "lists the threads by their CPU time and the running timers"};
+    commands["get"] = {&Admin::get, "", "prints out the timeouts and the maximum number of clients"};
+    commands["set"] = {&Admin::set, "<name> <value>", "changes a timeout (seconds) or the maximum number of clients"};
+    commands["log"] = {&Admin::log, "<level>", "logs the messages of the level and above only (0 - 6)"};
+    commands["trace"] = {&Admin::trace, "<n>", "traces every n-th message (0 - off)"};
+    commands["locks"] = {&Admin::locks, "[on|off]", "turns the lock profiling on/off or prints out the report"};
+    commands["metrics"] = {&Admin::metrics, "", "prints out the metrics (Prometheus text format)"};
+}
+
+Admin::~Admin() {
+    close();
+}
+
+bool Admin::open(const std::string &path) {
+    struct sockaddr_un address;
+    if (running || path.size() >= sizeof(address.sun_path))
+        return false;
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+        return false;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    // a socket left behind by a server that has not stopped properly
+    unlink(path.c_str());
+    // only the user running the server can control it (the socket
+    // is created with these permissions, so nobody else can connect meanwhile)
+    mode_t mask = umask(S_IRWXG | S_IRWXO);
+    bool bound = bind(listenFd, (struct sockaddr *)&address, sizeof(address)) == 0;
+    umask(mask);
+    if (!bound || listen(listenFd, MAX_ADMINS) < 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    this->path = path;
+    server.publishState();
+    running = true;
+    listener = std::thread(&Admin::listenerHandler, this);
+    publisher = std::thread(&Admin::publisherHandler, this);
+    return true;
+}
+
+void Admin::close() {
+    if (!running.exchange(false))
+        return;
+    listener.join();
+    publisher.join();
+    // the admins notice it within #STATE_INTERVAL_MS
+    while (sessions > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ::close(listenFd);
+    listenFd = -1;
+    unlink(path.c_str());
+}
+
+void Admin::publisherHandler() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(STATE_INTERVAL_MS));
+        server.publishState();
+    }
+}
+
+/// Sends the whole reply to an admin
+/// \param fd socket of the admin
+/// \param reply the reply
+/// \return true, if the reply has been sent. Otherwise, false.
+static bool sendReply(int fd, const std::string &reply) {
+    size_t sent = 0;
+    while (sent < reply.size()) {
+        ssize_t n = send(fd, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+void Admin::listenerHandler() {
+    while (running) {
+        struct pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, STATE_INTERVAL_MS) <= 0)
+            continue;
+        int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        if (sessions >= MAX_ADMINS) {
+            sendReply(fd, "ERROR too many admins are connected\n");
+            ::close(fd);
+            continue;
+        }
+        // a slow (or idle) admin does not hold up the others
+        sessions++;
+        std::thread session([this, fd]() {
+            serve(fd);
+            ::close(fd);
+            sessions--;
+        });
+        session.detach();
+    }
+}
+
+void Admin::serve(int fd) {
+    std::string buffer;
+    char data[256];
+    int idle = 0;
+    while (running) {
+        size_t end;
+        while ((end = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+            std::string reply = execute(line);
+            if (!sendReply(fd, reply))
+                return;
+        }
+        if (buffer.size() > MAX_COMMAND_LENGTH) {
+            sendReply(fd, "ERROR the command is too long\n");
+            return;
+        }
+        // the admin is waited for in short steps, so closing the socket does not wait for them
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, STATE_INTERVAL_MS);
+        if (ready < 0)
+            return;
+        if (ready == 0) {
+            idle += STATE_INTERVAL_MS;
+            if (idle >= IDLE_TIMEOUT_MS)
+                return;
+            continue;
+        }
+        idle = 0;
+        ssize_t n = recv(fd, data, sizeof(data), 0);
+        if (n <= 0)
+            return;
+        buffer.append(data, n);
+    }
+}
+
+std::string Admin::execute(const std::string &line) {
+    std::vector<std::string> tokens = split(line, ' ');
+    if (tokens.empty())
+        return "";
+    auto command = commands.find(tokens[0]);
+    if (command == commands.end())
+        return "ERROR unknown command '" + tokens[0] + "' (see help)\n";
+    std::vector<std::string> args(tokens.begin() + 1, tokens.end());
+    return (this->*command->second.handler)(args);
+}
+
+std::string Admin::help(const std::vector<std::string> &) {
+    std::stringstream ss;
+    for (auto &it : commands) {
+        std::string name = it.first + (it.second.usage.empty() ? "" : " " + it.second.usage);
+        ss << std::left << std::setw(24) << name << it.second.description << "\n";
+    }
+    return ss.str();
+}
+
+const char *Admin::getStateName(Client::State state) {
+    switch (state) {
+        case Client::NICK:        return "NICK";
+        case Client::LOBBY:       return "LOBBY";
+        case Client::SENT_RQ:     return "SENT_RQ";
+        case Client::RECV_RQ:     return "RECV_RQ";
+        case Client::GAME:        return "GAME";
+        case Client::QUEUED:      return "QUEUED";
+        case Client::KILL_THREAD: return "KILL_THREAD";
+    }
+    return "UNKNOWN";
+}
+
+/// Returns how old a copy of the state of the server is
+/// \param state the state
+/// \return the first line of a reply (e.g. "state 0.42s old")
+static std::string formatAge(const Server::State_t &state) {
+    std::stringstream ss;
+    ss << "state " << std::fixed << std::setprecision(2)
+       << std::chrono::duration<double>(std::chrono::steady_clock::now() - state.taken).count() << "s old\n";
+    return ss.str();
+}
+
+std::string Admin::clients(const std::vector<std::string> &) {
+    std::shared_ptr<const Server::State_t> state = server.getState();
+    if (state == NULL)
+        return "ERROR the state has not been published yet\n";
+    std::map<Client::State, std::vector<const Server::ClientInfo_t *>> byState;
+    for (const Server::ClientInfo_t &client : state->clients)
+        byState[client.state].push_back(&client);
+
+    std::stringstream ss;
+    ss << formatAge(*state) << state->clients.size() << " clients (at most " << server.getMaxClients() << ")\n";
+    for (auto &it : byState) {
+        ss << getStateName(it.first) << " (" << it.second.size() << "):";
+        for (const Server::ClientInfo_t *client : it.second)
+            ss << " " << client->nick << "@" << client->ip;
+        ss << "\n";
+    }
+    return ss.str();
+}
+
+std::string Admin::renderBoard(const std::string &moves) {
+    char board[Position::HEIGHT][Position::WIDTH];
+    int heights[Position::WIDTH] = {0};
+    memset(board, '.', sizeof(board));
+    for (size_t i = 0; i < moves.size(); i++) {
+        int x = moves[i] - '0';
+        if (x < 0 || x >= Position::WIDTH || heights[x] == Position::HEIGHT)
+            continue;
+        board[Position::HEIGHT - 1 - heights[x]++][x] = i % 2 == 0 ? 'X' : 'O';
+    }
+    std::string text;
+    for (int y = 0; y < Position::HEIGHT; y++) {
+        text += "  |";
+        for (int x = 0; x < Position::WIDTH; x++)
+            text += board[y][x];
+        text += "|\n";
+    }
+    text += "   0123456\n";
+    return text;
+}
+
+std::string Admin::games(const std::vector<std::string> &) {
+    std::shared_ptr<const Server::State_t> state = server.getState();
+    if (state == NULL)
+        return "ERROR the state has not been published yet\n";
+    std::stringstream ss;
+    ss << formatAge(*state) << state->games.size() << " games in progress\n";
+    time_t now = time(NULL);
+    for (const Server::GameInfo_t &game : state->games) {
+        ss << "#" << game.id << " " << game.player1 << " (X) vs " << game.player2 << " (O), ";
+        ss << game.moves.size() << " moves, " << (now - game.startTime) << "s";
+        if (game.restored)
+            ss << ", restored (waiting for the players)";
+        ss << "\n" << renderBoard(game.moves);
+    }
+    return ss.str();
+}
+
+std::string Admin::requests(const std::vector<std::string> &) {
+    std::shared_ptr<const Server::State_t> state = server.getState();
+    if (state == NULL)
+        return "ERROR the state has not been published yet\n";
+    std::stringstream ss;
+    ss << formatAge(*state) << state->gameRequests.size() << " pending game requests\n";
+    for (auto &request : state->gameRequests)
+        ss << request.first << " -> " << request.second << "\n";
+    return ss.str();
+}
+
+std::string Admin::reconnecting(const std::vector<std::string> &) {
+    std::shared_ptr<const Server::State_t> state = server.getState();
+    if (state == NULL)
+        return "ERROR the state has not been published yet\n";
+    std::stringstream ss;
+    ss << formatAge(*state) << state->reconnectingClients.size() << " players the server waits for to reconnect\n";
+    for (auto &player : state->reconnectingClients)
+        ss << player.first << " (opponent " << player.second << ")\n";
+    return ss.str();
+}
+
+std::string Admin::threads(const std::vector<std::string> &) {
+    // the CPU time of every thread of the process (utime + stime)
+    struct Thread_t {
+        int id;
+        char state;
+        uint64_t ticks;
+    };
+    std::vector<Thread_t> list;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.')
+                continue;
+            std::ifstream file(std::string("/proc/self/task/") + entry->d_name + "/stat");
+            std::string stat;
+            std::getline(file, stat);
+            size_t end = stat.rfind(')');
+            if (end == std::string::npos)
+                continue;
+            std::stringstream fields(stat.substr(end + 2));
+            std::string field;
+            Thread_t thread = {atoi(entry->d_name), '?', 0};
+            for (int i = 3; fields >> field && i <= 15; i++) {
+                if (i == 3)
+                    thread.state = field[0];
+                else if (i == 14 || i == 15)
+                    thread.ticks += strtoull(field.c_str(), NULL, 10);
+            }
+            list.push_back(thread);
+        }
+        closedir(dir);
+    }
+    std::sort(list.begin(), list.end(), [](const Thread_t &a, const Thread_t &b) {
+        return a.ticks > b.ticks;
+    });
+
+    std::stringstream ss;
+    long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    ss << list.size() << " threads (the busiest ones first)\n";
+    for (size_t i = 0; i < list.size() && i < (size_t)MAX_LISTED_THREADS; i++)
+        ss << "  " << std::setw(8) << list[i].id << " " << list[i].state << " " << std::fixed << std::setprecision(2)
+           << (double)list[i].ticks / ticksPerSecond << "s CPU\n";
+
+    // every timer is a thread sleeping a second at a time
+    ss << "running timers:";
+    for (const char *kind : {"nick", "ping", "game_request", "reconnect", "restored", "turn"}) {
+        Metrics::Gauge &timers = Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment",
+                                                               std::string("kind=\"") + kind + "\"");
+        ss << " " << kind << "=" << timers.value();
+    }
+    ss << "\n";
+    return ss.str();
+}
+
+std::atomic<int> *Admin::getTimeout(const std::string &name) {
+    Server::Timeouts_t &timeouts = server.getTimeouts();
+    if (name == "SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ")
+        return &timeouts.replyToGameRq;
+    if (name == "SECONDS_WAITING_FOR_DISCONNECTED_PLAYER")
+        return &timeouts.disconnectedPlayer;
+    if (name == "SECONDS_WAITING_FOR_CLIENT_ENTER_NICK")
+        return &timeouts.clientEnterNick;
+    if (name == "SECONDS_PING_REPLY")
+        return &timeouts.pingReply;
+    if (name == "SECONDS_WAITING_FOR_CLIENT_TO_PLAY")
+        return &timeouts.clientToPlay;
+    return NULL;
+}
+
+std::string Admin::get(const std::vector<std::string> &) {
+    std::stringstream ss;
+    for (const char *name : {"SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ", "SECONDS_WAITING_FOR_DISCONNECTED_PLAYER",
+                             "SECONDS_WAITING_FOR_CLIENT_ENTER_NICK", "SECONDS_PING_REPLY", "SECONDS_WAITING_FOR_CLIENT_TO_PLAY"})
+        ss << name << " " << getTimeout(name)->load() << "\n";
+    ss << "maxClients " << server.getMaxClients() << "\n";
+    return ss.str();
+}
+
+std::string Admin::set(const std::vector<std::string> &args) {
+    if (args.size() != 2 || args[1].empty() || args[1].size() > 6 || !std::all_of(args[1].begin(), args[1].end(), ::isdigit))
+        return "ERROR usage: set <name> <value>\n";
+    int value = atoi(args[1].c_str());
+    if (args[0] == "maxClients")
+        server.setMaxClients(value);
+    else {
+        std::atomic<int> *timeout = getTimeout(args[0]);
+        if (timeout == NULL)
+            return "ERROR unknown setting '" + args[0] + "' (see get)\n";
+        if (value < 1)
+            return "ERROR a timeout must be at least 1s\n";
+        timeout->store(value);
+    }
+    LOG_INFO("admin: " + args[0] + " set to " + args[1]);
+    return "OK " + args[0] + " " + args[1] + "\n";
+}
+
+std::string Admin::log(const std::vector<std::string> &args) {
+    if (args.size() != 1 || args[0].size() != 1 || args[0][0] < '0' || args[0][0] > '0' + LOG_LEVEL_ERROR)
+        return "ERROR usage: log <level> (0 countdown, 1 msg, 2 game, 3 info, 4 warning, 5 booting, 6 error)\n";
+    Logger::setMinLevel(args[0][0] - '0');
+    LOG_BOOTING("admin: minimum log level set to " + args[0]);
+    return "OK log " + args[0] + "\n";
+}
+
+std::string Admin::trace(const std::vector<std::string> &args) {
+    if (args.size() != 1 || args[0].empty() || args[0].size() > 9 || !std::all_of(args[0].begin(), args[0].end(), ::isdigit))
+        return "ERROR usage: trace <n>\n";
+    int everyNth = atoi(args[0].c_str());
+    if (everyNth != 0 && !Tracer::getInstance()->open())
+        return "ERROR the trace file cannot be opened\n";
+    Tracer::setSampling(everyNth);
+    LOG_INFO("admin: every " + args[0] + ". message is traced");
+    return "OK trace " + args[0] + "\n";
+}
+
+std::string Admin::locks(const std::vector<std::string> &args) {
+    if (args.empty())
+        return ProfiledMutex::report();
+    if (args.size() != 1 || (args[0] != "on" && args[0] != "off"))
+        return "ERROR usage: locks [on|off]\n";
+    ProfiledMutex::setEnabled(args[0] == "on");
+    LOG_INFO("admin: lock profiling turned " + args[0]);
+    return "OK locks " + args[0] + "\n";
+}
+
+std::string Admin::metrics(const std::vector<std::string> &) {
+    return Metrics::getInstance()->render();
+}
@@ -0,0 +1,136 @@
+#ifndef ADMIN_H
+#define ADMIN_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+
+#include "Server.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Admin control socket of the server (a Unix-domain socket).
+///
+/// Every line sent to the socket is a command (see #help) and the reply is sent
+/// back right away. The commands inspecting the server (the clients, games, game
+/// requests, reconnecting clients) read the copy of its state published every
+/// #STATE_INTERVAL_MS (see Server::publishState), so they never take any lock of
+/// the server no matter how often they are sent. Other commands change the
+/// timeouts, the maximum number of clients, the log level, the tracing and the
+/// lock profiling while the server is running.
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/// ./adminctl -s admin.sock games
+/// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class Admin {
+public:
+    /// amount of milliseconds between two copies of the state of the server
+    static const int STATE_INTERVAL_MS = 1000;
+    /// the longest command that can be sent
+    static const int MAX_COMMAND_LENGTH = 1024;
+    /// amount of milliseconds an admin can stay connected without sending anything
+    static const int IDLE_TIMEOUT_MS = 30000;
+    /// the most admins served at a time (each of them by their own thread)
+    static const int MAX_ADMINS = 4;
+    /// the most threads listed by the command threads
+    static const int MAX_LISTED_THREADS = 20;
+
+private:
+    /// Handler of a command
+    typedef std::string (Admin::*Handler)(const std::vector<std::string> &args);
+
+    /// One command of the admin socket
+    struct Command_t {
+        Handler handler;         ///< the handler of the command
+        std::string usage;       ///< the arguments of the command
+        std::string description; ///< what the command does
+    };
+
+    /// the server
+    Server &server;
+    /// the commands by their names
+    std::map<std::string, Command_t> commands;
+    /// the path of the socket
+    std::string path;
+    /// listening socket (-1 if it is not open)
+    int listenFd;
+    /// indication of whether or not the threads should keep running
+    std::atomic<bool> running;
+    /// the thread accepting the admins
+    std::thread listener;
+    /// number of admins being served at the moment
+    std::atomic<int> sessions;
+    /// the thread publishing the state of the server
+    std::thread publisher;
+
+private:
+    /// The body of the thread accepting the admins (every one of them is served by a thread of their own)
+    void listenerHandler();
+
+    /// The body of the thread publishing the state of the server
+    void publisherHandler();
+
+    /// Serves one admin (reads the commands and sends the replies until they disconnect)
+    /// \param fd socket of the admin
+    void serve(int fd);
+
+    /// Returns the timeout of a name (NULL if there is no such timeout)
+    /// \param name name of the timeout (e.g. SECONDS_PING_REPLY)
+    /// \return the timeout
+    std::atomic<int> *getTimeout(const std::string &name);
+
+    /// Returns the board of a game as text (X - player 1, O - player 2)
+    /// \param moves the moves of the game (columns '0' - '6')
+    /// \return the board (one line per row, the top one first)
+    static std::string renderBoard(const std::string &moves);
+
+    /// Returns the name of a state of a client
+    /// \param state the state
+    /// \return the name (e.g. LOBBY)
+    static const char *getStateName(Client::State state);
+
+    std::string help(const std::vector<std::string> &args);         ///< lists the commands
+    std::string clients(const std::vector<std::string> &args);      ///< lists the clients by their states
+    std::string games(const std::vector<std::string> &args);        ///< lists the games with their boards
+    std::string requests(const std::vector<std::string> &args);     ///< lists the pending game requests
+    std::string reconnecting(const std::vector<std::string> &args); ///< lists the clients the server waits for to reconnect
+    std::string threads(const std::vector<std::string> &args);      ///< lists the threads by CPU time and the running timers
+    std::string get(const std::vector<std::string> &args);          ///< prints out the settings that can be changed
+    std::string set(const std::vector<std::string> &args);          ///< changes a setting
+    std::string log(const std::vector<std::string> &args);          ///< changes the minimum log level
+    std::string trace(const std::vector<std::string> &args);        ///< changes the sampling of the tracer
+    std::string locks(const std::vector<std::string> &args);        ///< turns the lock profiling on/off or prints out the report
+    std::string metrics(const std::vector<std::string> &args);      ///< prints out the metrics
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// \param server the server
+    explicit Admin(Server &server);
+
+    /// Destructor of the class - closes the socket
+    ~Admin();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Admin(const Admin&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Admin&) = delete;
+
+    /// Opens the socket and starts serving the admins
+    /// \param path path of the socket (an old socket of the same path is removed)
+    /// \return true, if the socket is listening. Otherwise, false.
+    bool open(const std::string &path);
+
+    /// Stops serving the admins and removes the socket
+    void close();
+
+    /// Executes a command
+    /// \param line the command and its arguments separated by spaces
+    /// \return the reply
+    std::string execute(const std::string &line);
+};
+
+#endif
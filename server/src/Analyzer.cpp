@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Analyzer.h"
+
+Analyzer::Analyzer() : pool(TABLE_SIZE), cache(new Shard_t[CACHE_SHARDS]) {
+    running = false;
+    book = NULL;
+    tablebase = NULL;
+    served = 0;
+    rejected = 0;
+    incomplete = 0;
+    cacheHits = 0;
+    cacheMisses = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+        latencies[i] = 0;
+}
+
+Analyzer::~Analyzer() {
+    close();
+}
+
+void Analyzer::open(int threads, OpeningBook *book, Tablebase *tablebase) {
+    requestsMtx.lock();
+    if (running) {
+        requestsMtx.unlock();
+        return;
+    }
+    this->book = book;
+    this->tablebase = tablebase;
+    running = true;
+    pool.open(threads, book, [this](SolverPool::Worker_t *worker, Solver &solver) { workerHandler(worker, solver); });
+    requestsMtx.unlock();
+}
+
+void Analyzer::close() {
+    requestsMtx.lock();
+    if (!running) {
+        requestsMtx.unlock();
+        return;
+    }
+    running = false;
+    requests.clear();
+    owners.clear();
+    requestsMtx.unlock();
+    requestsCv.notify_all();
+    pool.close();
+}
+
+bool Analyzer::submit(const std::string &owner, const Position &position, std::chrono::milliseconds budget, Callback_t done) {
+    requestsMtx.lock();
+    if (!running || requests.size() >= MAX_QUEUED || owners.find(owner) != owners.end()) {
+        requestsMtx.unlock();
+        rejected++;
+        return false;
+    }
+    owners.insert(owner);
+    requests.push_back({owner, position, budget, std::chrono::steady_clock::now(), done});
+    requestsMtx.unlock();
+    requestsCv.notify_one();
+    return true;
+}
+
+void Analyzer::workerHandler(SolverPool::Worker_t *worker, Solver &solver) {
+    while (1) {
+        Request_t request;
+        {
+            std::unique_lock<std::mutex> lock(requestsMtx);
+            requestsCv.wait(lock, [&]() { return !running || !requests.empty(); });
+            if (!running)
+                return;
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        // the budget counts from when the request was received (the time spent in the queue included)
+        Result_t result;
+        pool.startBudget(worker, request.received + request.budget);
+        analyze(worker, solver, request.position, result);
+        pool.endBudget(worker);
+        result.micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request.received).count();
+        latencies[toBucket(result.micros)]++;
+        served++;
+        if (!result.complete)
+            incomplete++;
+
+        requestsMtx.lock();
+        owners.erase(request.owner);
+        requestsMtx.unlock();
+        request.done(result);
+    }
+}
+
+void Analyzer::analyze(SolverPool::Worker_t *worker, Solver &solver, const Position &position, Result_t &result) {
+    result.scores.assign(Position::WIDTH, Solver::INVALID_MOVE);
+    result.nbMoves = position.nbMoves();
+    result.cached = 0;
+    result.complete = true;
+
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (!position.canPlay(col))
+            continue;
+        if (position.isWinningMove(col)) {
+            result.scores[col] = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+            continue;
+        }
+        Position child(position);
+        child.playCol(col);
+        uint64_t key = child.canonicalKey();
+        int score;
+        if (lookup(key, score)) {
+            cacheHits++;
+            result.cached++;
+            result.scores[col] = -score;
+            continue;
+        }
+        cacheMisses++;
+        if (tablebase != NULL && tablebase->probe(child, score)) {
+            store(key, score);
+            result.scores[col] = -score;
+            continue;
+        }
+        if (!worker->stop)
+            score = solver.solve(child);
+        if (worker->stop) {
+            result.scores[col] = UNKNOWN_SCORE;
+            result.complete = false;
+            continue;
+        }
+        store(key, score);
+        result.scores[col] = -score;
+    }
+}
+
+bool Analyzer::lookup(uint64_t key, int &score) {
+    Shard_t &shard = cache[key & (CACHE_SHARDS - 1)];
+    shard.shardMtx.lock();
+    auto it = shard.current.find(key);
+    bool found = it != shard.current.end();
+    if (found)
+        score = it->second;
+    else {
+        it = shard.old.find(key);
+        found = it != shard.old.end();
+        if (found) {
+            // the position is still being used - it is kept in the current generation
+            score = it->second;
+            shard.old.erase(it);
+            if (shard.current.size() >= CACHE_SHARD_CAPACITY) {
+                shard.old.swap(shard.current);
+                shard.current.clear();
+            }
+            shard.current[key] = (int8_t)score;
+        }
+    }
+    shard.shardMtx.unlock();
+    return found;
+}
+
+void Analyzer::store(uint64_t key, int score) {
+    Shard_t &shard = cache[key & (CACHE_SHARDS - 1)];
+    shard.shardMtx.lock();
+    if (shard.current.size() >= CACHE_SHARD_CAPACITY) {
+        shard.old.swap(shard.current);
+        shard.current.clear();
+    }
+    shard.current[key] = (int8_t)score;
+    shard.shardMtx.unlock();
+}
+
+int Analyzer::toBucket(uint64_t micros) {
+    if (micros <= 1)
+        return 0;
+    return std::min(LATENCY_BUCKETS - 1, (int)ceil(log2((double)micros) * 4));
+}
+
+uint64_t Analyzer::bucketLimit(int bucket) {
+    return (uint64_t)pow(2.0, bucket / 4.0);
+}
+
+Analyzer::Stats_t Analyzer::getStats() {
+    Stats_t stats;
+    stats.requests = served;
+    stats.rejected = rejected;
+    stats.incomplete = incomplete;
+    stats.cacheHits = cacheHits;
+    stats.cacheMisses = cacheMisses;
+    stats.hitRate = stats.cacheHits + stats.cacheMisses > 0 ? (double)stats.cacheHits / (stats.cacheHits + stats.cacheMisses) : 0;
+    stats.cached = 0;
+    for (size_t i = 0; i < CACHE_SHARDS; i++) {
+        cache[i].shardMtx.lock();
+        stats.cached += cache[i].current.size() + cache[i].old.size();
+        cache[i].shardMtx.unlock();
+    }
+
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = latencies[i];
+        total += counts[i];
+    }
+    stats.p50Micros = 0;
+    stats.p99Micros = 0;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && total > 0; i++) {
+        seen += counts[i];
+        if (stats.p50Micros == 0 && seen * 2 >= total)
+            stats.p50Micros = bucketLimit(i);
+        if (seen * 100 >= total * 99) {
+            stats.p99Micros = bucketLimit(i);
+            break;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,211 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Position.h"
+#include "Solver.h"
+#include "SolverPool.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Analysis of positions (the value of every column) requested by the players.
+///
+/// The requests are queued (at most #MAX_QUEUED of them, one per client) and
+/// served by a fixed number of worker threads (#SolverPool), so no matter how many
+/// clients ask, the analysis never takes more than those threads. Every request has
+/// a time budget; the search is stopped once it runs out and the columns
+/// that have not been solved by then are reported as unknown.
+///
+/// The exact scores of the positions after every move are kept in a cache
+/// shared by all the workers, keyed by the canonical (mirror-reduced) key of
+/// the position (see #Position::canonicalKey), which identifies a position
+/// exactly. The same position reached in different games (or mirrored) is
+/// therefore solved only once. The cache is split into #CACHE_SHARDS shards,
+/// each with its own lock, and every shard keeps two generations of entries;
+/// once the current one is full, it becomes the old one and the previous old
+/// one is dropped (the entries used since then are moved to the current one).
+///
+/// A position is looked up in the cache, then in the tablebase and the opening
+/// book (by the solver) before it is searched.
+class Analyzer {
+public:
+    /// default number of worker threads
+    static const int DEFAULT_THREADS = 2;
+    /// the most requests waiting to be served
+    static const size_t MAX_QUEUED = 64;
+    /// default amount of milliseconds one request may take
+    static const int DEFAULT_BUDGET_MS = 500;
+    /// number of shards of the cache (power of two)
+    static const size_t CACHE_SHARDS = 64;
+    /// the most entries of one generation of a shard of the cache
+    static const size_t CACHE_SHARD_CAPACITY = 16384;
+    /// number of entries of the transposition table shared by the workers (a prime number)
+    static const uint64_t TABLE_SIZE = 1048583;
+    /// score of a column that has not been solved within the time budget
+    static const int UNKNOWN_SCORE = -2000;
+    /// number of buckets of the histogram of latencies (4 per power of two of microseconds)
+    static const int LATENCY_BUCKETS = 128;
+
+    /// Result of one analysis
+    struct Result_t {
+        std::vector<int> scores; ///< score of every column (#Solver::INVALID_MOVE if full, #UNKNOWN_SCORE if not solved)
+        int nbMoves;             ///< number of moves of the analyzed position
+        int cached;              ///< number of columns whose scores were found in the cache
+        bool complete;           ///< true, if all the columns have been solved
+        uint64_t micros;         ///< amount of microseconds from the request to the result
+    };
+
+    /// Statistics of the analysis
+    struct Stats_t {
+        uint64_t requests;    ///< number of requests served
+        uint64_t rejected;    ///< number of requests rejected (the queue was full, the client had one queued already)
+        uint64_t incomplete;  ///< number of requests that ran out of time
+        uint64_t cacheHits;   ///< number of positions found in the cache
+        uint64_t cacheMisses; ///< number of positions that had to be solved
+        uint64_t cached;      ///< number of positions in the cache
+        double hitRate;       ///< cacheHits / (cacheHits + cacheMisses)
+        uint64_t p50Micros;   ///< median latency of a request (upper bound of its bucket)
+        uint64_t p99Micros;   ///< 99th percentile of the latency of a request (upper bound of its bucket)
+    };
+
+    /// function called with the result of a request (from a worker thread)
+    typedef std::function<void(const Result_t &)> Callback_t;
+
+private:
+    /// One request waiting to be served
+    struct Request_t {
+        std::string owner;                               ///< nick of the client who sent it
+        Position position;                               ///< the position
+        std::chrono::milliseconds budget;                ///< the time budget
+        std::chrono::steady_clock::time_point received;  ///< when the request was received
+        Callback_t done;                                 ///< called with the result
+    };
+
+    /// One shard of the cache
+    struct Shard_t {
+        std::mutex shardMtx;                        ///< lock used when accessing the shard
+        std::unordered_map<uint64_t, int8_t> current; ///< the current generation (the key is the canonical key)
+        std::unordered_map<uint64_t, int8_t> old;     ///< the previous generation
+    };
+
+    /// lock used when accessing the queued requests
+    std::mutex requestsMtx;
+    /// used to wake up the workers
+    std::condition_variable requestsCv;
+    /// the queued requests
+    std::deque<Request_t> requests;
+    /// clients with a request queued or being served
+    std::unordered_set<std::string> owners;
+    /// indication of whether or not the workers should keep running
+    bool running;
+
+    /// the workers (and the watchdog stopping the requests that ran out of time)
+    SolverPool pool;
+    /// opening book consulted by the workers (may be NULL)
+    OpeningBook *book;
+    /// tablebase consulted by the workers (may be NULL)
+    Tablebase *tablebase;
+    /// the cache
+    std::unique_ptr<Shard_t[]> cache;
+
+    /// number of requests served
+    std::atomic<uint64_t> served;
+    /// number of requests rejected
+    std::atomic<uint64_t> rejected;
+    /// number of requests that ran out of time
+    std::atomic<uint64_t> incomplete;
+    /// number of positions found in the cache
+    std::atomic<uint64_t> cacheHits;
+    /// number of positions that had to be solved
+    std::atomic<uint64_t> cacheMisses;
+    /// histogram of the latencies of the requests
+    std::atomic<uint64_t> latencies[LATENCY_BUCKETS];
+
+private:
+    /// The body of a worker thread
+    /// \param worker the worker
+    /// \param solver solver of the worker
+    void workerHandler(SolverPool::Worker_t *worker, Solver &solver);
+
+    /// Analyzes a position within the time budget of the worker
+    /// \param worker the worker
+    /// \param solver solver of the worker
+    /// \param position the position
+    /// \param result the result
+    void analyze(SolverPool::Worker_t *worker, Solver &solver, const Position &position, Result_t &result);
+
+    /// Looks up the score of a position in the cache
+    /// \param key canonical key of the position
+    /// \param score the score
+    /// \return true, if the position is in the cache. Otherwise, false.
+    bool lookup(uint64_t key, int &score);
+
+    /// Stores the score of a position in the cache
+    /// \param key canonical key of the position
+    /// \param score the score
+    void store(uint64_t key, int score);
+
+    /// Returns the bucket of the histogram of latencies
+    /// \param micros the latency in microseconds
+    /// \return the bucket
+    static int toBucket(uint64_t micros);
+
+    /// Returns the highest latency falling into a bucket of the histogram
+    /// \param bucket the bucket
+    /// \return the latency in microseconds
+    static uint64_t bucketLimit(int bucket);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// Nothing is analyzed until it is opened (see #open).
+    Analyzer();
+
+    /// Destructor of the class - stops the threads (see #close)
+    ~Analyzer();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Analyzer(const Analyzer&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Analyzer&) = delete;
+
+    /// Starts the worker threads
+    /// \param threads number of worker threads
+    /// \param book opening book consulted before searching (may be NULL)
+    /// \param tablebase tablebase consulted before searching (may be NULL)
+    void open(int threads = DEFAULT_THREADS, OpeningBook *book = NULL, Tablebase *tablebase = NULL);
+
+    /// Stops the threads (the requests still queued are dropped)
+    void close();
+
+    /// Queues a request for the analysis of a position
+    /// \param owner nick of the client who sent it (they can have only one request queued at a time)
+    /// \param position the position
+    /// \param budget the time budget
+    /// \param done called with the result (from a worker thread)
+    /// \return false, if the request has been rejected. Otherwise, true.
+    bool submit(const std::string &owner, const Position &position, std::chrono::milliseconds budget, Callback_t done);
+
+    /// Returns the statistics of the analysis
+    /// \return statistics of the analysis
+    Stats_t getStats();
+};
+
+#endif
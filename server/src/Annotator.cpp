@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "Annotator.h"
+#include "Logger.h"
+
+Annotator::Annotator(GameStore &store) : store(store), pool(TABLE_SIZE) {
+    busy = 0;
+    running = false;
+    book = NULL;
+    memset(&stats, 0, sizeof(stats));
+}
+
+Annotator::~Annotator() {
+    close();
+}
+
+void Annotator::open(int threads, OpeningBook *book) {
+    queueMtx.lock();
+    if (running) {
+        queueMtx.unlock();
+        return;
+    }
+    this->book = book;
+    running = true;
+    pool.open(threads, book, [this](SolverPool::Worker_t *worker, Solver &solver) { workerHandler(worker, solver); });
+    queueMtx.unlock();
+}
+
+void Annotator::close() {
+    queueMtx.lock();
+    if (!running) {
+        queueMtx.unlock();
+        return;
+    }
+    running = false;
+    games.clear();
+    deferred.clear();
+    tasks.clear();
+    queueMtx.unlock();
+    queueCv.notify_all();
+    idleCv.notify_all();
+    pool.close();
+}
+
+void Annotator::submit(uint64_t id, const std::string &moves) {
+    queueMtx.lock();
+    stats.submitted++;
+    if (games.size() < MAX_QUEUED_GAMES) {
+        std::shared_ptr<Job_t> job = std::make_shared<Job_t>();
+        job->id = id;
+        job->moves = moves;
+        games.push_back(job);
+    }
+    else if (deferred.size() < MAX_DEFERRED_GAMES) {
+        deferred.push_back(id);
+        stats.deferred++;
+    }
+    else stats.dropped++;
+    queueMtx.unlock();
+    queueCv.notify_one();
+}
+
+void Annotator::drain() {
+    std::unique_lock<std::mutex> lock(queueMtx);
+    idleCv.wait(lock, [&]() { return !running || (games.empty() && deferred.empty() && tasks.empty() && busy == 0); });
+}
+
+bool Annotator::nextTask(std::unique_lock<std::mutex> &lock, Task_t &task) {
+    if (tasks.empty()) {
+        std::shared_ptr<Job_t> job;
+        while (job == nullptr && !games.empty()) {
+            job = games.front();
+            games.pop_front();
+        }
+        // the deferred games are read back from the store (counted as busy, so #drain waits for them)
+        while (job == nullptr && !deferred.empty() && running) {
+            GameStore::Game_t game;
+            uint64_t id = deferred.front();
+            deferred.pop_front();
+            busy++;
+            lock.unlock();
+            bool found = store.getGame(id, game);
+            lock.lock();
+            busy--;
+            if (found) {
+                job = std::make_shared<Job_t>();
+                job->id = id;
+                job->moves = game.moves;
+            }
+        }
+        if (job == nullptr || !running)
+            return false;
+        // the moves are split into tasks (so a long game is analyzed by several workers at once)
+        int moves = (int)job->moves.size();
+        job->annotations.assign(moves, 0);
+        job->remaining = std::max(1, (moves + TASK_MOVES - 1) / TASK_MOVES);
+        if (moves == 0)
+            tasks.push_back({job, 0, 0});
+        for (int from = 0; from < moves; from += TASK_MOVES)
+            tasks.push_back({job, from, std::min(moves, from + TASK_MOVES)});
+        if (tasks.size() > 1)
+            queueCv.notify_all();
+    }
+    task = tasks.front();
+    tasks.pop_front();
+    return true;
+}
+
+void Annotator::workerHandler(SolverPool::Worker_t *worker, Solver &solver) {
+    while (1) {
+        Task_t task;
+        {
+            std::unique_lock<std::mutex> lock(queueMtx);
+            queueCv.wait(lock, [&]() { return !running || !tasks.empty() || !games.empty() || !deferred.empty(); });
+            if (!running)
+                return;
+            if (!nextTask(lock, task)) {
+                if (busy == 0)
+                    idleCv.notify_all();
+                continue;
+            }
+            busy++;
+        }
+
+        Job_t &job = *task.job;
+        Position position;
+        position.play(job.moves.substr(0, task.from));
+        uint64_t moves = 0, blunders = 0, skipped = 0;
+        for (int i = task.from; i < task.to; i++) {
+            int column = job.moves[i] - '0';
+            if (column < 0 || column >= Position::WIDTH || !position.canPlay(column))
+                break;
+            bool blunder = false;
+            job.annotations[i] = annotate(worker, solver, position, column, blunder);
+            if (job.annotations[i] != 0) {
+                moves++;
+                blunders += blunder;
+            }
+            else skipped++;
+            if (position.isWinningMove(column))
+                break;
+            position.playCol(column);
+        }
+
+        // the last task of the game writes the annotations into the store
+        bool last = --job.remaining == 0;
+        if (last && !store.annotate(job.id, job.annotations))
+            LOG_WARNING("the annotations of game " + std::to_string(job.id) + " could not be stored");
+
+        queueMtx.lock();
+        stats.moves += moves;
+        stats.blunders += blunders;
+        stats.skipped += skipped;
+        if (last)
+            stats.annotated++;
+        busy--;
+        bool idle = busy == 0 && tasks.empty() && games.empty() && deferred.empty();
+        queueMtx.unlock();
+        if (idle)
+            idleCv.notify_all();
+    }
+}
+
+uint8_t Annotator::annotate(SolverPool::Worker_t *worker, Solver &solver, const Position &position, int column, bool &blunder) {
+    // the positions after the move have to be in the book
+    if (position.nbMoves() < FIRST_ANALYZED_MOVE && (book == NULL || position.nbMoves() + 1 > book->getMaxMoves()))
+        return 0;
+    pool.startBudget(worker, std::chrono::steady_clock::now() + std::chrono::milliseconds(MOVE_BUDGET_MS));
+
+    // the score of every possible move (from the point of view of the player who is up)
+    int best = Position::MIN_SCORE - 1, worst = Position::MAX_SCORE + 1, played = 0;
+    bool solved = true;
+    for (int col = 0; col < Position::WIDTH && solved; col++) {
+        if (!position.canPlay(col))
+            continue;
+        int score;
+        if (position.isWinningMove(col))
+            score = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+        else {
+            Position child(position);
+            child.playCol(col);
+            score = -solver.solve(child);
+            solved = !worker->stop;
+        }
+        best = std::max(best, score);
+        worst = std::min(worst, score);
+        if (col == column)
+            played = score;
+    }
+    pool.endBudget(worker);
+    if (!solved)
+        return 0;
+
+    blunder = (best > 0 && played <= 0) || (best == 0 && played < 0);
+    int accuracy = best == worst ? 100 : (100 * (played - worst) + (best - worst) / 2) / (best - worst);
+    return (uint8_t)((accuracy + 1) | (blunder ? GameStore::ANNOTATION_BLUNDER : 0));
+}
+
+Annotator::Stats_t Annotator::getStats() {
+    queueMtx.lock();
+    Stats_t current = stats;
+    current.queued = games.size();
+    current.waiting = deferred.size();
+    queueMtx.unlock();
+    return current;
+}
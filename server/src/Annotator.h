@@ -0,0 +1,176 @@
+#ifndef ANNOTATOR_H
+#define ANNOTATOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+#include "Position.h"
+#include "Solver.h"
+#include "SolverPool.h"
+#include "OpeningBook.h"
+#include "GameStore.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Post-game analysis of the finished games (accuracy and blunders of every move).
+///
+/// A finished game is handed over by #submit, which never waits: the game is put
+/// into a queue of at most #MAX_QUEUED_GAMES games. When the queue is full, only
+/// the id of the game is kept (deferred) and the moves are read back from the
+/// store once there is room; when even the deferred ids reach #MAX_DEFERRED_GAMES,
+/// the game is dropped (it is simply never annotated).
+///
+/// The worker threads (#SolverPool) split every game into tasks of #TASK_MOVES moves, so
+/// the moves of one long game are analyzed in parallel as well as different
+/// games. A move is analyzed by solving the position after every possible move
+/// (within #MOVE_BUDGET_MS, a move that could not be solved in time is not
+/// annotated, neither are the opening moves the opening book does not cover).
+/// Once the last task of a game is done, the annotations are written into
+/// the store (see #GameStore::annotate).
+///
+/// The accuracy of a move is the position of its score between the worst
+/// and the best move (100 - the best move); a blunder is a move turning a won
+/// position into a draw or a loss, or a drawn one into a loss.
+class Annotator {
+public:
+    /// default number of worker threads
+    static const int DEFAULT_THREADS = 1;
+    /// the most games waiting in the queue (with their moves)
+    static const size_t MAX_QUEUED_GAMES = 256;
+    /// the most ids of games deferred because the queue was full
+    static const size_t MAX_DEFERRED_GAMES = 4096;
+    /// number of moves of one task
+    static const int TASK_MOVES = 6;
+    /// amount of milliseconds the analysis of one move may take
+    static const int MOVE_BUDGET_MS = 200;
+    /// the moves played before this many moves are analyzed only if the opening book
+    /// covers them (they would take far longer than #MOVE_BUDGET_MS otherwise)
+    static const int FIRST_ANALYZED_MOVE = 10;
+    /// number of entries of the transposition table shared by the workers (a prime number)
+    static const uint64_t TABLE_SIZE = 1048583;
+
+    /// Statistics of the analysis
+    struct Stats_t {
+        uint64_t submitted; ///< number of games submitted
+        uint64_t deferred;  ///< number of games deferred (the queue was full)
+        uint64_t dropped;   ///< number of games dropped (even the deferred ones were too many)
+        uint64_t annotated; ///< number of games annotated
+        uint64_t moves;     ///< number of moves annotated
+        uint64_t blunders;  ///< number of blunders found
+        uint64_t skipped;   ///< number of moves that have not been analyzed (out of time, not in the book)
+        uint64_t queued;    ///< number of games waiting in the queue at the moment
+        uint64_t waiting;   ///< number of deferred games at the moment
+    };
+
+private:
+    /// One game being analyzed
+    struct Job_t {
+        uint64_t id;                      ///< id of the game in the store
+        std::string moves;                ///< the moves (columns '0' - '6')
+        std::vector<uint8_t> annotations; ///< annotation of every move (every task fills in its own moves)
+        std::atomic<int> remaining;       ///< number of tasks that have not been done yet
+    };
+
+    /// One task - a range of moves of a game
+    struct Task_t {
+        std::shared_ptr<Job_t> job; ///< the game
+        int from;                   ///< the first move
+        int to;                     ///< the move after the last one
+    };
+
+    /// store of the games (the annotations are written into it)
+    GameStore &store;
+
+    /// lock used when accessing the queues
+    std::mutex queueMtx;
+    /// used to wake up the workers
+    std::condition_variable queueCv;
+    /// games waiting to be split into tasks
+    std::deque<std::shared_ptr<Job_t>> games;
+    /// ids of the games deferred because #games was full
+    std::deque<uint64_t> deferred;
+    /// tasks waiting to be done
+    std::deque<Task_t> tasks;
+    /// number of tasks being done at the moment
+    int busy;
+    /// used to wake up the threads waiting for all the games to be annotated (see #drain)
+    std::condition_variable idleCv;
+    /// indication of whether or not the workers should keep running
+    bool running;
+    /// statistics of the analysis (the counters are locked by #queueMtx)
+    Stats_t stats;
+
+    /// the workers (and the watchdog stopping the analysis of the moves that ran out of time)
+    SolverPool pool;
+    /// opening book consulted by the workers (may be NULL)
+    OpeningBook *book;
+
+private:
+    /// The body of a worker thread
+    /// \param worker the worker
+    /// \param solver solver of the worker
+    void workerHandler(SolverPool::Worker_t *worker, Solver &solver);
+
+    /// Takes the next task (#queueMtx must be locked). If there are no tasks,
+    /// the next game is split into tasks (deferred games are read from the store,
+    /// with #queueMtx unlocked meanwhile, so #submit does not wait for the disk).
+    /// \param lock the lock of #queueMtx
+    /// \param task the task
+    /// \return false, if there is nothing to do. Otherwise, true.
+    bool nextTask(std::unique_lock<std::mutex> &lock, Task_t &task);
+
+    /// Analyzes one move of a game
+    /// \param worker the worker
+    /// \param solver solver of the worker
+    /// \param position the position before the move
+    /// \param column the column played
+    /// \param blunder set to true, if the move is a blunder
+    /// \return annotation of the move (0 if it has not been analyzed)
+    uint8_t annotate(SolverPool::Worker_t *worker, Solver &solver, const Position &position, int column, bool &blunder);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// Nothing is analyzed until it is opened (see #open).
+    /// \param store store of the games the annotations are written into
+    explicit Annotator(GameStore &store);
+
+    /// Destructor of the class - stops the threads (see #close)
+    ~Annotator();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Annotator(const Annotator&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Annotator&) = delete;
+
+    /// Starts the worker threads
+    /// \param threads number of worker threads
+    /// \param book opening book consulted before searching (may be NULL)
+    void open(int threads = DEFAULT_THREADS, OpeningBook *book = NULL);
+
+    /// Stops the threads (the games that have not been annotated are dropped)
+    void close();
+
+    /// Hands a finished game over for the analysis (never waits)
+    /// \param id id of the game in the store
+    /// \param moves the moves of the game
+    void submit(uint64_t id, const std::string &moves);
+
+    /// Waits until all the games submitted so far are annotated (or dropped)
+    void drain();
+
+    /// Returns the statistics of the analysis
+    /// \return statistics of the analysis
+    Stats_t getStats();
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "Bot.h"
+
+Bot::Bot(Level level, uint64_t seed, OpeningBook *book, Tablebase *tablebase) : rng(seed) {
+    this->level = level;
+    this->book = book;
+    this->tablebase = tablebase;
+}
+
+int Bot::randomColumn(uint64_t moves) {
+    int columns[Position::WIDTH];
+    int count = 0;
+    for (int col = 0; col < Position::WIDTH; col++)
+        if (moves & Position::columnMask(col))
+            columns[count++] = col;
+    return columns[rng() % count];
+}
+
+int Bot::chooseMove(const Position &position) {
+    uint64_t playable = 0;
+    for (int col = 0; col < Position::WIDTH; col++)
+        if (position.canPlay(col))
+            playable |= Position::columnMask(col);
+
+    if (level == RANDOM)
+        return randomColumn(playable);
+
+    for (int col = 0; col < Position::WIDTH; col++)
+        if (position.canPlay(col) && position.isWinningMove(col))
+            return col;
+
+    int score, column;
+    if (tablebase != NULL && tablebase->bestMove(position, column, score))
+        return column;
+    if (book != NULL && book->lookup(position, score, column))
+        return column;
+
+    // the opponent wins anyway - play anything
+    uint64_t moves = position.possibleNonLosingMoves();
+    return randomColumn(moves ? moves : playable);
+}
+
+bool Bot::parseLevel(const std::string &name, Level &level) {
+    if (name == "random")
+        level = RANDOM;
+    else if (name == "greedy")
+        level = GREEDY;
+    else return false;
+    return true;
+}
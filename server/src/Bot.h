@@ -0,0 +1,70 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <string>
+#include <random>
+#include <cstdint>
+
+#include "Position.h"
+#include "OpeningBook.h"
+#include "Tablebase.h"
+
+/// \author silhavyj A17B0362P
+///
+/// A computer player used for bot-vs-bot self-play (see the selfplay tool).
+///
+/// The bot never searches, so it is fast enough to play millions
+/// of games. Depending on its level, it picks a random move or
+/// it plays a winning move, blocks the opponent, follows the
+/// opening book/endgame tablebase (if given) and otherwise picks
+/// a random move that does not lose right away.
+/// Each bot has its own random number generator, so a game
+/// only depends on the seeds of the bots.
+class Bot {
+public:
+    /// How well the bot plays
+    enum Level {
+        RANDOM, ///< any random move
+        GREEDY  ///< wins/blocks, uses the book and the tablebase, otherwise a random non-losing move
+    };
+
+private:
+    /// how well the bot plays
+    Level level;
+    /// random number generator used when choosing among equal moves
+    std::mt19937_64 rng;
+    /// opening book the bot follows (NULL if none)
+    OpeningBook *book;
+    /// endgame tablebase the bot follows (NULL if none)
+    Tablebase *tablebase;
+
+private:
+    /// Picks a random column out of the moves given as a bitmap
+    /// \param moves bitmap of the moves (see #Position::possibleNonLosingMoves)
+    /// \return index of the column
+    int randomColumn(uint64_t moves);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// \param level how well the bot plays
+    /// \param seed seed of the random number generator
+    /// \param book opening book the bot follows (NULL if none)
+    /// \param tablebase endgame tablebase the bot follows (NULL if none)
+    Bot(Level level, uint64_t seed, OpeningBook *book = NULL, Tablebase *tablebase = NULL);
+
+    /// Chooses the column the bot plays in the position given as a parameter
+    ///
+    /// The position must not be over (there is at least one free column).
+    ///
+    /// \param position the current position (the bot is up)
+    /// \return index of the column (0 - #Position::WIDTH-1)
+    int chooseMove(const Position &position);
+
+    /// Parses the name of a level ("random" or "greedy")
+    /// \param name name of the level
+    /// \param level the parsed level
+    /// \return true, if the name is valid. Otherwise, false.
+    static bool parseLevel(const std::string &name, Level &level);
+};
+
+#endif
@@ -6,6 +6,7 @@ Client::Client(int socket, std::string ip, std::string protocolId) {
     this->socket = socket;
     this->ip = ip;
     this->protocolId = protocolId;
+    this->sendMtx = std::make_shared<std::mutex>();
 
     this->state = NICK;
 
@@ -14,6 +15,7 @@ Client::Client(int socket, std::string ip, std::string protocolId) {
 }
 
 Client::~Client() {
+    shutdown(socket, SHUT_RDWR);
     close(socket);  // closes the socket
 }
 
@@ -26,7 +28,7 @@ std::string Client::leftAlign(int n) const {
 
 void Client::sendMessage(std::string msg) const {
     msg = protocolId + leftAlign(msg.length()) + msg;
-    LOG_MSG("sending a message to client " + toStr() + ": '" + msg + "'");
+    LOG_MSG_F("sending a message to client {}: '{}'", toStr(), msg);
     msg += "\r\n"; //add '\r\n' at the end of every message
   
     if (msg.length() > BUFF_SIZE) {
@@ -34,17 +36,25 @@ void Client::sendMessage(std::string msg) const {
         return;
     }
 
+    static Metrics::Gauge &sending = Metrics::getInstance()->gauge("connect4_outbound_sends", "Number of messages being sent off to the clients (including the ones waiting for the socket)");
+    static Metrics::Histogram &latency = Metrics::getInstance()->histogram("connect4_send_seconds", "Time it takes to send off a message to a client (including waiting for the socket)");
+    Metrics::GaugeScope inFlight(sending);
+    Metrics::Timer timer(latency);
+    Tracer::Span sendingSpan("send", "socket");
+
     char buff[BUFF_SIZE];
     strcpy(buff, msg.c_str());
 
     size_t len = strlen(buff);
     char *pos = buff;
-    ssize_t numberOfSentBytes;
+    ssize_t numberOfSentBytes = 0;
 
+    Tracer::lock(*sendMtx, "wait sendMtx");
     while (len > 0 && (numberOfSentBytes = send(socket, pos, len, 0)) > 0) {
         pos += numberOfSentBytes;
         len -= (size_t)numberOfSentBytes;
     }
+    sendMtx->unlock();
     if (len > 0 || numberOfSentBytes < 0) {
         LOG_ERR("error when sending a message to client " + nick + ": " + msg);
     }
@@ -62,6 +72,14 @@ int Client::getSocket() const {
     return socket;
 }
 
+std::shared_ptr<std::mutex> Client::getSendMtx() const {
+    return sendMtx;
+}
+
+std::string Client::getIp() const {
+    return ip;
+}
+
 std::string Client::getNick() const {
     return nick;
 }
@@ -2,6 +2,8 @@
 #define CLIENT_H
 
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <unistd.h>
 #include <cstring>
 
@@ -9,6 +11,8 @@
 #include <sys/socket.h>
 
 #include "Logger.h"
+#include "Metrics.h"
+#include "Tracer.h"
 
 /// \author silhavyj A17B0362P
 ///
@@ -32,6 +36,7 @@ public:
         SENT_RQ,    ///< the client sent a game request and is waiting for a response from their opponent
         RECV_RQ,    ///< the client received a game request and is supposed to reply to it (accept/reject)
         GAME,       ///< the client is now playing a game
+        QUEUED,     ///< the client is in the matchmaking queue waiting for an opponent
         KILL_THREAD ///< temporary state used for killing all threads associated with the client
     };
 
@@ -52,6 +57,9 @@ private:
     bool receivedPing;
     /// id of the protocol
     std::string protocolId;
+    /// lock used when sending messages to the client, so the messages
+    /// do not get mixed up (it is shared with the downloads, which may outlive the client)
+    std::shared_ptr<std::mutex> sendMtx;
 
 public:
     /// Constructor of the class - creates an instance of it
@@ -61,7 +69,9 @@ public:
     /// \param protocolId id of the protocol
     Client(int socket, std::string ip, std::string protocolId);
 
-    /// Destructor of the class - closes the socket used for communication with the server
+    /// Destructor of the class - shuts down and closes the socket
+    /// used for communication with the server (the downloads sending
+    /// through a duplicate of the socket fail from then on)
     ~Client();
 
     /// Sends a message to the client (from the server)
@@ -81,6 +91,10 @@ public:
     /// \return the socket of the client
     int getSocket() const;
 
+    /// Getter of the lock used when sending messages to the client
+    /// \return the lock (shared)
+    std::shared_ptr<std::mutex> getSendMtx() const;
+
     /// Getter of the current state of the client
     /// \return the state of the client
     State getState() const;
@@ -93,6 +107,10 @@ public:
     /// \return nick of the client
     std::string getNick() const;
 
+    /// Getter of the ip address of the client
+    /// \return the ip address of the client
+    std::string getIp() const;
+
     /// Setter of the nick of the client
     /// \param nick - the new nick of the client
     void setNick(std::string nick);
@@ -1,9 +1,15 @@
 #include "Connect4.h"
 
-Connect4::Connect4(std::string player1, std::string player2, Server *server) {
+std::vector<std::vector<std::pair<int,int>>> Connect4::rows;
+std::vector<std::vector<std::pair<int,int>>> Connect4::columns;
+std::vector<std::vector<std::pair<int,int>>> Connect4::diagonal1;
+std::vector<std::vector<std::pair<int,int>>> Connect4::diagonal2;
+
+Connect4::Connect4(std::string player1, std::string player2, Server *server, uint64_t id, bool restored) {
     this->player1 = player1;
     this->player2 = player2;
     this->server = server;
+    this->id = id;
 
     // initialize variables for
     // checking if the player who is up
@@ -12,30 +18,52 @@ Connect4::Connect4(std::string player1, std::string player2, Server *server) {
     justPlayed = false;
     justPlayedMtx.unlock();
 
+    // a headless game has no one to wait for
     runThreadMtx.lock();
-    runThread = true;
+    runThread = !isHeadless();
     runThreadMtx.unlock();
-    setWatchingThreadOnHold(false);
-
-    // run the thread waiting for the client
-    // that is up to play
-    std::thread clientHandler(&Connect4::waitingPlayerToPlayHandler, this);
-    clientHandler.detach();
+    waitingForOtherClientToConnectBack = restored;
+    watchingThreadStarted = false;
 
     player1IsUp = true;
     memset(board, FREE, sizeof(board));
+    announcedOutcome = CONTINUE;
 
     // store all rows, columns, diagonals
-    // into vectors
-    storeAllRows();
-    storeAllColumns();
-    storeDiagonal1();
-    storeDiagonal2();
+    // into vectors (only once - they are the same for every game)
+    static std::once_flag sequencesStored;
+    std::call_once(sequencesStored, []() {
+        storeAllRows();
+        storeAllColumns();
+        storeDiagonal1();
+        storeDiagonal2();
+    });
+
+    // run the thread waiting for the client
+    // that is up to play (a restored game waits
+    // for both players to connect back first)
+    if (!isHeadless() && !restored)
+        setWatchingThreadOnHold(false);
+    if (!isHeadless())
+        gameRoomsGauge().inc();
+}
+
+Metrics::Gauge &Connect4::gameRoomsGauge() {
+    static Metrics::Gauge &gauge = Metrics::getInstance()->gauge("connect4_game_rooms", "Number of games being played at the moment");
+    return gauge;
 }
 
 Connect4::~Connect4() {
+    if (isHeadless())
+        return;
+    gameRoomsGauge().dec();
+    server->getSpectators().publishEnd(id);
     stopWaitingPlayerToPlayThread();
-    sleep(2); // waits for the thread to notice
+    waitingForOtherClientToConnectBackMtx.lock();
+    bool started = watchingThreadStarted;
+    waitingForOtherClientToConnectBackMtx.unlock();
+    if (started)
+        sleep(2); // waits for the thread to notice
 }
 
 void Connect4::storeAllRows() {
@@ -130,23 +158,40 @@ std::vector<std::pair<int,int>> Connect4::getWinningTiles(std::vector<std::vecto
     return winningTiles;
 }
 
+std::vector<std::pair<int,int>> Connect4::getWinningTiles() {
+    std::vector<std::pair<int,int>> winningTiles = getWinningTiles(rows);
+    if (winningTiles.empty())
+        winningTiles = getWinningTiles(columns);
+    if (winningTiles.empty())
+        winningTiles = getWinningTiles(diagonal1);
+    if (winningTiles.empty())
+        winningTiles = getWinningTiles(diagonal2);
+    return winningTiles;
+}
+
 void Connect4::setWatchingThreadOnHold(bool value) {
     LOG_GAME("thread checking the game between '" + player1 + "' and '" + player2 + "' was " + (value ? "resumed" : "paused"));
     waitingForOtherClientToConnectBackMtx.lock();
     waitingForOtherClientToConnectBack = value;
+    bool startThread = !value && !watchingThreadStarted && !isHeadless();
+    if (startThread)
+        watchingThreadStarted = true;
     waitingForOtherClientToConnectBackMtx.unlock();
+
+    if (startThread) {
+        std::thread clientHandler(&Connect4::waitingPlayerToPlayHandler, this);
+        clientHandler.detach();
+    }
 }
 
 bool Connect4::isDraw() {
-    for (int i = 0; i < ROWS; i++)
-        for (int j = 0; j < COLUMNS; j++)
-            if (board[i][j] == FREE)
-                return false;
-    return true;
+    return position.nbMoves() == ROWS * COLUMNS;
 }
 
 Connect4::GameState Connect4::announceWinner(std::vector<std::pair<int, int> > &winningTiles, std::string player) {
     GameState gameState = board[winningTiles[0].first][winningTiles[0].second] == PLAYER_1 ? PLAYER_1_WINS : PLAYER_2_WINS;
+    if (isHeadless())
+        return gameState;
     server->sendMessage(player1, server->O_GAME_GAME_RESULT + " You " + (player == player1 ? "won" : "lost"));
     server->sendMessage(player2, server->O_GAME_GAME_RESULT + " You " + (player == player2 ? "won" : "lost"));
 
@@ -157,63 +202,58 @@ Connect4::GameState Connect4::announceWinner(std::vector<std::pair<int, int> > &
     winningSpots.pop_back();
     server->sendMessage(player1, server->O_GAME_WINNING_TILES + " " + winningSpots);
     server->sendMessage(player2, server->O_GAME_WINNING_TILES + " " + winningSpots);
+    server->getSpectators().publishResult(id, player + " " + winningSpots);
+    server->getRatings().submit(player1, player2, player == player1 ? 1.0 : 0.0);
     return gameState;
 }
 
 void Connect4::sendMsgMoveToPlayers(int y, int x, std::string player) {
+    if (isHeadless())
+        return;
     std::string msgToPlayers = server->O_GAME_PLAY + " " + player + " " + std::to_string(y) + " " + std::to_string(x);
     server->sendMessage(player1, msgToPlayers);
     server->sendMessage(player2, msgToPlayers);
+    server->getSpectators().publishMove(id, player, y, x);
 }
 
 void Connect4::announceDraw() {
     stopWaitingPlayerToPlayThread();
+    if (isHeadless())
+        return;
     server->sendMessage(player1, server->O_GAME_GAME_RESULT + " draw");
     server->sendMessage(player2, server->O_GAME_GAME_RESULT + " draw");
+    server->getSpectators().publishResult(id, "draw");
+    server->getRatings().submit(player1, player2, 0.5);
 }
 
 Connect4::GameState Connect4::play(std::string player, int x) {
+    Tracer::Span playing("Connect4::play", "engine");
     if ((player == player1 && player1IsUp == false) ||
         (player == player2 && player1IsUp == true)) {
-        server->sendMessage(player, server->O_GAME_MESSAGE + " it is not your turn");
+        if (!isHeadless())
+            server->sendMessage(player, server->O_GAME_MESSAGE + " it is not your turn");
         return CONTINUE;
     }
     if (board[0][x] != FREE) {
-        server->sendMessage(player, server->O_GAME_MESSAGE + " this column is full. Choose another one");
+        if (!isHeadless())
+            server->sendMessage(player, server->O_GAME_MESSAGE + " this column is full. Choose another one");
         return CONTINUE;
     }
     justPlayedMtx.lock();
     justPlayed = true;
     justPlayedMtx.unlock();
 
-    int y = 0;
-    while (y+1 < ROWS && board[y+1][x] == FREE)
-        y++;
-
-    board[y][x] = player1IsUp ? PLAYER_1 : PLAYER_2;
+    int y = dropDisk(x);
     sendMsgMoveToPlayers(y, x, player);
     printBoard();
-    std::vector<std::pair<int,int>> winningTiles;
-
-    // rows
-    winningTiles = getWinningTiles(rows);
-    if (winningTiles.empty() == false)
-        return announceWinner(winningTiles, player);
-
-    // columns
-    winningTiles = getWinningTiles(columns);
-    if (winningTiles.empty() == false)
-        return announceWinner(winningTiles, player);
 
-    // diagonal1
-    winningTiles = getWinningTiles(diagonal1);
-    if (winningTiles.empty() == false)
-        return announceWinner(winningTiles, player);
-
-    // diagonal2
-    winningTiles = getWinningTiles(diagonal2);
-    if (winningTiles.empty() == false)
+    // tiles of the player who just played
+    if (Position::hasAlignment(position.getCurrentPosition() ^ position.getMask())) {
+        if (isHeadless())
+            return player1IsUp ? PLAYER_1_WINS : PLAYER_2_WINS;
+        std::vector<std::pair<int,int>> winningTiles = getWinningTiles();
         return announceWinner(winningTiles, player);
+    }
 
     // is draw
     if (isDraw()) {
@@ -223,9 +263,59 @@ Connect4::GameState Connect4::play(std::string player, int x) {
     }
 
     player1IsUp = !player1IsUp;
+    announceForcedOutcome();
     return CONTINUE;
 }
 
+int Connect4::dropDisk(int x) {
+    int y = 0;
+    while (y+1 < ROWS && board[y+1][x] == FREE)
+        y++;
+
+    board[y][x] = player1IsUp ? PLAYER_1 : PLAYER_2;
+    position.playCol(x);
+    moves.push_back((char)('0' + x));
+    return y;
+}
+
+bool Connect4::replay(const std::string &moves) {
+    for (char move : moves) {
+        int x = move - '0';
+        if (x < 0 || x >= COLUMNS || board[0][x] != FREE || isOver())
+            return false;
+        dropDisk(x);
+        if (isOver())
+            return false;
+        player1IsUp = !player1IsUp;
+    }
+    return true;
+}
+
+void Connect4::announceForcedOutcome() {
+    if (isHeadless())
+        return;
+    int score;
+    if (!Tablebase::getDefault()->probe(position, score))
+        return;
+
+    // the score is given from the point of view of the player who is up
+    GameState outcome = DRAW;
+    if (score > 0)
+        outcome = player1IsUp ? PLAYER_1_WINS : PLAYER_2_WINS;
+    else if (score < 0)
+        outcome = player1IsUp ? PLAYER_2_WINS : PLAYER_1_WINS;
+    if (outcome == announcedOutcome)
+        return;
+    announcedOutcome = outcome;
+
+    std::string msg = server->O_GAME_MESSAGE;
+    if (outcome == DRAW)
+        msg += " the game is a forced draw";
+    else msg += " forced win for " + (outcome == PLAYER_1_WINS ? player1 : player2);
+    server->sendMessage(player1, msg);
+    server->sendMessage(player2, msg);
+}
+
 void Connect4::stopWaitingPlayerToPlayThread() {
     runThreadMtx.lock();
     runThread = false;
@@ -233,6 +323,8 @@ void Connect4::stopWaitingPlayerToPlayThread() {
 }
 
 void Connect4::printBoard() {
+    if (isHeadless())
+        return;
     std::cout << "[GAME BETWEEN '" + player1 + "' and '" + player2 + "']\n";
     for (int i = 0; i < ROWS; i++) {
         for (int j = 0; j < COLUMNS; j++)
@@ -241,30 +333,47 @@ void Connect4::printBoard() {
     }
 }
 
-std::string Connect4::getCurrentStateOfGameForRecovery() {
-    std::stringstream ss;
-    for (int i = 0; i < ROWS; i++)
-        for (int j = 0; j < COLUMNS; j++)
-            ss << board[i][j] << " ";
-    std::string currentState = ss.str();
-    currentState.pop_back();
-    return currentState;
+const Position &Connect4::getPosition() const {
+    return position;
+}
+
+bool Connect4::isOver() const {
+    // the tiles of the player who played last
+    return position.nbMoves() == ROWS * COLUMNS || Position::hasAlignment(position.getCurrentPosition() ^ position.getMask());
+}
+
+bool Connect4::isHeadless() const {
+    return server == NULL;
+}
+
+const std::string &Connect4::getMoves() const {
+    return moves;
+}
+
+std::string Connect4::getCurrentStateOfGameForRecovery(int from) {
+    if (from < 0 || from > (int)moves.size())
+        from = moves.size();
+    if (from == (int)moves.size())
+        return std::to_string(from);
+    return std::to_string(from) + " " + moves.substr(from);
 }
 
 void Connect4::waitingPlayerToPlayHandler() {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"turn\""));
     int timeCounter = 0;
     while (1) {
-        int remainingSeconds = SECONDS_WAITING_FOR_CLIENT_TO_PLAY - timeCounter;
+        int seconds = server->getTimeouts().clientToPlay;
+        int remainingSeconds = seconds - timeCounter;
 
         waitingForOtherClientToConnectBackMtx.lock();
         if (waitingForOtherClientToConnectBack == true)
             timeCounter = 0;
-        else LOG_COUNTDOWN("counter of the game between '" + player1 + "' and '" + player2 + "': " + std::to_string(remainingSeconds) + "s");
+        else LOG_COUNTDOWN_F("counter of the game between '{}' and '{}': {}s", player1, player2, remainingSeconds);
         waitingForOtherClientToConnectBackMtx.unlock();
 
         runThreadMtx.lock();
         if (runThread == false) {
-            LOG_COUNTDOWN("counter of the game between '" + player1 + "' and '" + player2 + "' was interrupted (end of the game)");
+            LOG_COUNTDOWN_F("counter of the game between '{}' and '{}' was interrupted (end of the game)", player1, player2);
             return;
         }
         runThreadMtx.unlock();
@@ -277,10 +386,10 @@ void Connect4::waitingPlayerToPlayHandler() {
         }
         justPlayedMtx.unlock();
 
-        if (timeCounter == SECONDS_WAITING_FOR_CLIENT_TO_PLAY) {
-            server->deleteGameRoom(player1IsUp ? player1 : player2, "your opponent hasn't played for " + std::to_string(SECONDS_WAITING_FOR_CLIENT_TO_PLAY) + "s", true);
+        if (timeCounter >= seconds) {
+            server->deleteGameRoom(player1IsUp ? player1 : player2, "your opponent hasn't played for " + std::to_string(seconds) + "s", true);
             server->sendMessage(player1IsUp ? player1 : player2, server->O_GAME_CANCELED + " the game has been terminated due to you not playing");
-            LOG_WARNING("counter of the game between '" + player1 + "' and '" + player2 + "' was interrupted (nobody's played in " + std::to_string(SECONDS_WAITING_FOR_CLIENT_TO_PLAY) + "s)");
+            LOG_WARNING("counter of the game between '" + player1 + "' and '" + player2 + "' was interrupted (nobody's played in " + std::to_string(seconds) + "s)");
             return;
         }
         sleep(1);
@@ -9,6 +9,8 @@
 #include <mutex>
 
 #include "Server.h"
+#include "Position.h"
+#include "Tablebase.h"
 
 // forward declaration
 class Server;
@@ -18,7 +20,9 @@ class Server;
 /// The purpose of this class is to handle
 /// the logic of the game Connect4 - https://en.wikipedia.org/wiki/Connect_Four.
 /// This class is directly used by class #Server when two
-/// players decide to play a game.
+/// players decide to play a game. If no server is given,
+/// the game runs headless (no messages, no watching thread),
+/// which is used for bot-vs-bot self-play.
 class Connect4 {
 public:
     /// number of rows on the grid
@@ -49,6 +53,14 @@ private:
 
     /// grid of the game (board)
     State board[ROWS][COLUMNS];
+    /// bitboard representation of the grid used for checking
+    /// the end of the game and probing the endgame tablebase
+    Position position;
+    /// all the moves played so far (columns '0' - '6')
+    std::string moves;
+    /// the outcome of the game (under perfect play) that was
+    /// last announced to the players (#CONTINUE if none has been yet)
+    GameState announcedOutcome;
     /// indication of who's turn it is
     bool player1IsUp;
     /// nick of player1 (client1)
@@ -58,51 +70,58 @@ private:
     /// Reference to the server that
     /// is used for sending messages to both clients
     /// (who's up, if the other client lost their connection, etc.)
+    /// NULL if the game runs headless
     Server *server;
+    /// id of the game in the journal (the spectators of the game are told it)
+    uint64_t id;
 
     /// lock used when accessing variable #justPlayed
-    std::mutex justPlayedMtx;
+    ProfiledMutex justPlayedMtx{"Connect4::justPlayedMtx"};
     /// indication that either of the clients
     /// just played - the counter of 30s is set back down to 0
     bool justPlayed;
 
     /// lock used when accessing variable #runThread
-    std::mutex runThreadMtx;
+    ProfiledMutex runThreadMtx{"Connect4::runThreadMtx"};
     /// indication of whether or not the thread
     /// checking if the player who is up played within
     /// 30s should be terminated
     bool runThread;
 
     /// lock used when accessing variable #waitingForOtherClientToConnectBack
-    std::mutex waitingForOtherClientToConnectBackMtx;
+    ProfiledMutex waitingForOtherClientToConnectBackMtx{"Connect4::waitingForOtherClientToConnectBackMtx"};
     /// When this variable is true, the counter checking if the player
     /// whose turn it is played within 30s will be set back down to 0.
     /// This indicates that one of the players has lost their connection.
     bool waitingForOtherClientToConnectBack;
+    /// indication of whether or not the thread waiting for the player
+    /// who is up to play has been started (it is started once the game
+    /// is not on hold - a restored game waits for both players first)
+    bool watchingThreadStarted;
 
-    /// a vector of all the rows of the grid
-    std::vector<std::vector<std::pair<int,int>>> rows;
-    /// a vector of all the columns of the grid
-    std::vector<std::vector<std::pair<int,int>>> columns;
-    /// a vector of all the diagonals of the grid (first direction)
-    std::vector<std::vector<std::pair<int,int>>> diagonal1;
-    /// a vector of all the diagonals of the grid (second direction)
-    std::vector<std::vector<std::pair<int,int>>> diagonal2;
+    /// a vector of all the rows of the grid (shared by all the games)
+    static std::vector<std::vector<std::pair<int,int>>> rows;
+    /// a vector of all the columns of the grid (shared by all the games)
+    static std::vector<std::vector<std::pair<int,int>>> columns;
+    /// a vector of all the diagonals of the grid (first direction, shared by all the games)
+    static std::vector<std::vector<std::pair<int,int>>> diagonal1;
+    /// a vector of all the diagonals of the grid (second direction, shared by all the games)
+    static std::vector<std::vector<std::pair<int,int>>> diagonal2;
 
 private:
     /// Stores positions (y,x) of all the rows into #rows
-    void storeAllRows();
+    static void storeAllRows();
 
     /// Stores positions (y,x) of all the columns into #columns
-    void storeAllColumns();
+    static void storeAllColumns();
 
     /// Stores positions (y,x) of all the diagonals
     /// running in the first direction into #diagonal1
-    void storeDiagonal1();
+    static void storeDiagonal1();
 
     /// Stores positions (y,x) of all the diagonals
     /// running in the second direction into #diagonal2
-    void storeDiagonal2();
+    static void storeDiagonal2();
 
     /// Check is there is a winning sequence of four tiles in a row
     ///
@@ -145,6 +164,20 @@ private:
     /// \param player nick of the player who just played
     void sendMsgMoveToPlayers(int y, int x, std::string player);
 
+    /// Puts a disk of the player who is up into the column given as a parameter
+    /// (the column must not be full)
+    /// \param x x position on the grid (column)
+    /// \return y position the disk fell to
+    int dropDisk(int x);
+
+    /// Probes the endgame tablebase and announces a forced win/draw
+    ///
+    /// If the current position is in the tablebase (#Tablebase::getDefault),
+    /// both players are told the outcome of the game under perfect play.
+    /// The outcome is only announced when it changes (either of the
+    /// players makes a mistake).
+    void announceForcedOutcome();
+
     /// Announced draw of the game
     ///
     /// This method sends a message to both clients
@@ -169,9 +202,13 @@ public:
     /// \param player1 nick of the player1 (client1)
     /// \param player2 nick of the player2 (client2)
     /// \param server a reference to the server used for sending messages to he clients
-    Connect4(std::string player1, std::string player2, Server *server);
+    /// (NULL - headless game, nothing is sent or printed out)
+    /// \param id id of the game in the journal
+    /// \param restored true, if the game is being restored after a restart of the server
+    /// (the game is on hold until #setWatchingThreadOnHold is called with false)
+    Connect4(std::string player1, std::string player2, Server *server, uint64_t id = 0, bool restored = false);
 
-    /// Destructor of the class
+    /// Destructor of the class - the spectators of the game stop watching it
     ~Connect4();
 
     /// Plays one turn.
@@ -186,15 +223,65 @@ public:
     /// \return state of the game #GameState
     GameState play(std::string player, int x);
 
+    /// Plays the moves of a game that is being restored
+    ///
+    /// Nothing is sent to the players. The moves must not
+    /// finish the game (only games in progress are restored).
+    ///
+    /// \param moves the moves (columns '0' - '6') played so far
+    /// \return false, if the moves are not valid. Otherwise, true.
+    bool replay(const std::string &moves);
+
+    /// Returns all the moves played so far
+    /// \return the moves as a string of columns ('0' - '6')
+    const std::string &getMoves() const;
+
     /// Returns the current state of the game formatted
     /// so it could be send off to the client who just got reconnected
     /// back to the server (was in the game before and lost their connection)
+    ///
+    /// The state is the index of the first move followed by the moves
+    /// from that one on as a string of columns, for example "2 3341"
+    /// (nothing follows the index if there are no such moves).
+    /// The first move was played by player1, the second one by player2, etc.
+    /// so a client that has already seen the first n moves only
+    /// needs the moves from the n-th one on.
+    ///
+    /// \param from index of the first move the client has not seen yet
     /// \return current state of the game appropriately formatted
-    std::string getCurrentStateOfGameForRecovery();
+    std::string getCurrentStateOfGameForRecovery(int from = 0);
+
+    /// Looks for a winning sequence of four tiles anywhere on the grid
+    ///
+    /// This is the slow path - #play only calls it once a bitboard check
+    /// found out the last move won the game, so the clients can be sent
+    /// the positions of the winning tiles.
+    ///
+    /// \return either an empty vector or a vector containing the positions of winning tiles
+    std::vector<std::pair<int,int>> getWinningTiles();
+
+    /// Returns the bitboard representation of the current state of the game
+    /// \return current position (the player who is up is to move)
+    const Position &getPosition() const;
+
+    /// Checks if the game is over (someone won or the grid is full)
+    /// \return true, if no more moves can be played. Otherwise, false.
+    bool isOver() const;
+
+    /// Checks if the game runs without a server (see #Connect4)
+    /// \return true, if the game is headless. Otherwise, false.
+    bool isHeadless() const;
+
+    /// Returns the gauge of the games being played (the games of the server, not the headless ones)
+    /// \return the gauge
+    static Metrics::Gauge &gameRoomsGauge();
 
     /// Pauses/runs the thread waiting for the player who is up
     /// to play because either of the clients just lost their
     /// connection - waiting for them to reconnect back to the server
+    ///
+    /// The thread is started the first time the game is not on hold.
+    ///
     /// \param value true/false whether the thread should be paused
     void setWatchingThreadOnHold(bool value);
 };
@@ -0,0 +1,510 @@
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <cstdlib>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "GameStore.h"
+#include "Logger.h"
+
+const std::string GameStore::DEFAULT_DIR = "history";
+
+// name of the index file
+static const char *INDEX_FILE = "players.idx";
+// identification (and version) of the format of the index file
+static const char INDEX_MAGIC[] = "C4IX0001";
+// number of slots of a new index
+static const uint64_t INITIAL_INDEX_CAPACITY = 1 << 16;
+// name of a data file: games-20261018.dat
+static const char *DATA_PREFIX = "games-";
+static const char *DATA_SUFFIX = ".dat";
+// number of seconds in a day
+static const uint64_t SECONDS_PER_DAY = 24 * 60 * 60;
+
+GameStore::GameStore(std::string dir) {
+    this->dir = dir;
+    currentDay = 0;
+    indexFd = -1;
+    index = NULL;
+    memset(&stats, 0, sizeof(stats));
+}
+
+GameStore::~GameStore() {
+    close();
+}
+
+std::string GameStore::getPath(uint32_t day) const {
+    time_t time = (time_t)day * SECONDS_PER_DAY;
+    struct tm tm;
+    gmtime_r(&time, &tm);
+    char name[32];
+    strftime(name, sizeof(name), "%Y%m%d", &tm);
+    return dir + "/" + DATA_PREFIX + name + DATA_SUFFIX;
+}
+
+bool GameStore::parseDate(const std::string &date, uint32_t &day) {
+    if (date.size() != 8 || date.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = atoi(date.substr(0, 4).c_str()) - 1900;
+    tm.tm_mon = atoi(date.substr(4, 2).c_str()) - 1;
+    tm.tm_mday = atoi(date.substr(6, 2).c_str());
+    if (tm.tm_year < 70 || tm.tm_mon > 11 || tm.tm_mday < 1 || tm.tm_mday > 31)
+        return false;
+    day = (uint32_t)(timegm(&tm) / SECONDS_PER_DAY);
+    return true;
+}
+
+uint64_t GameStore::hashNick(const std::string &nick) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : nick) {
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+uint32_t GameStore::checksum(const RecordHeader_t *header) {
+    uint32_t hash = 2166136261u;
+    auto add = [&hash](const char *data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            hash ^= (uint8_t)data[i];
+            hash *= 16777619u;
+        }
+    };
+    // everything but the checksum itself and the annotations (they are filled in later)
+    add((const char *)&header->size, sizeof(header->size));
+    add((const char *)&header->journalId, offsetof(RecordHeader_t, annotations) - offsetof(RecordHeader_t, journalId));
+    add((const char *)(header + 1), header->player1Size + header->player2Size + header->nbMoves);
+    return hash;
+}
+
+void GameStore::toGame(uint64_t id, const RecordHeader_t *header, Game_t &game) {
+    const char *payload = (const char *)(header + 1);
+    game.id = id;
+    game.journalId = header->journalId;
+    game.player1.assign(payload, header->player1Size);
+    game.player2.assign(payload + header->player1Size, header->player2Size);
+    game.moves.assign(payload + header->player1Size + header->player2Size, header->nbMoves);
+    game.result = (Result)header->result;
+    game.startTime = header->startTime;
+    game.endTime = header->endTime;
+}
+
+GameStore::File_t *GameStore::getFile(uint32_t day, bool create) {
+    auto it = files.find(day);
+    if (it != files.end())
+        return &it->second;
+
+    std::string path = getPath(day);
+    int fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return NULL;
+    }
+    File_t file = {fd, NULL, (uint64_t)st.st_size, 0};
+    // a file that is appended into grows by whole steps
+    if (create && file.mapped % FILE_GROWTH != 0)
+        file.mapped += FILE_GROWTH - file.mapped % FILE_GROWTH;
+    if (create && file.mapped == 0)
+        file.mapped = FILE_GROWTH;
+    if (file.mapped != (uint64_t)st.st_size && ftruncate(fd, file.mapped) < 0) {
+        LOG_ERR("resizing '" + path + "' failed");
+        ::close(fd);
+        return NULL;
+    }
+    if (file.mapped > 0) {
+        void *data = mmap(NULL, file.mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            LOG_ERR("mapping '" + path + "' failed");
+            ::close(fd);
+            return NULL;
+        }
+        file.data = (char *)data;
+    }
+
+    // the records end where the (zeroed) unused space begins
+    while (file.used + sizeof(RecordHeader_t) <= file.mapped) {
+        const RecordHeader_t *header = (const RecordHeader_t *)(file.data + file.used);
+        if (header->size < sizeof(RecordHeader_t) || file.used + header->size > file.mapped)
+            break;
+        file.used += header->size;
+    }
+    return &(files[day] = file);
+}
+
+void GameStore::closeFile(File_t &file, bool truncate) {
+    if (file.data != NULL)
+        munmap(file.data, file.mapped);
+    if (truncate && ftruncate(file.fd, file.used) < 0)
+        LOG_WARNING("truncating a data file of the store of games failed");
+    ::close(file.fd);
+}
+
+const GameStore::RecordHeader_t *GameStore::getRecord(uint64_t id) {
+    uint64_t offset = id & ((1ull << OFFSET_BITS) - 1);
+    File_t *file = getFile((uint32_t)(id >> OFFSET_BITS), false);
+    if (file == NULL || offset % 8 != 0 || offset + sizeof(RecordHeader_t) > file->used)
+        return NULL;
+    const RecordHeader_t *header = (const RecordHeader_t *)(file->data + offset);
+    if (header->size < sizeof(RecordHeader_t) || offset + header->size > file->used || checksum(header) != header->checksum)
+        return NULL;
+    return header;
+}
+
+GameStore::IndexSlot_t *GameStore::getSlots() const {
+    return (IndexSlot_t *)(index + 1);
+}
+
+bool GameStore::mapIndex(uint64_t capacity) {
+    if (index != NULL)
+        munmap(index, sizeof(IndexHeader_t) + index->capacity * sizeof(IndexSlot_t));
+    index = NULL;
+    size_t size = sizeof(IndexHeader_t) + capacity * sizeof(IndexSlot_t);
+    if (ftruncate(indexFd, size) < 0)
+        return false;
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    index = (IndexHeader_t *)data;
+    index->capacity = capacity;
+    return true;
+}
+
+GameStore::IndexSlot_t *GameStore::findSlot(uint64_t hash) const {
+    IndexSlot_t *slots = getSlots();
+    uint64_t mask = index->capacity - 1;
+    uint64_t i = hash & mask;
+    while (slots[i].hash != 0 && slots[i].hash != hash)
+        i = (i + 1) & mask;
+    return &slots[i];
+}
+
+void GameStore::growIndex() {
+    std::vector<IndexSlot_t> slots;
+    slots.reserve(index->count);
+    for (uint64_t i = 0; i < index->capacity; i++)
+        if (getSlots()[i].hash != 0)
+            slots.push_back(getSlots()[i]);
+
+    // if the server stops in the middle of this, the index is built from scratch
+    uint64_t lastId = index->lastId;
+    index->lastId = 0;
+    if (!mapIndex(index->capacity * 2)) {
+        LOG_ERR("growing the index of the store of games failed");
+        return;
+    }
+    memset(getSlots(), 0, index->capacity * sizeof(IndexSlot_t));
+    for (const IndexSlot_t &slot : slots)
+        *findSlot(slot.hash) = slot;
+    index->count = slots.size();
+    index->lastId = lastId;
+}
+
+void GameStore::setHead(const std::string &nick, uint64_t id) {
+    uint64_t hash = hashNick(nick);
+    IndexSlot_t *slot = findSlot(hash);
+    if (slot->hash == 0) {
+        if ((index->count + 1) * 10 > index->capacity * 7) {
+            growIndex();
+            if (index == NULL)
+                return;
+            slot = findSlot(hash);
+        }
+        slot->hash = hash;
+        index->count++;
+    }
+    slot->head = id;
+}
+
+void GameStore::catchUpIndex() {
+    std::vector<uint32_t> days;
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        uint32_t day;
+        if (name.size() != strlen(DATA_PREFIX) + 8 + strlen(DATA_SUFFIX) || name.compare(0, strlen(DATA_PREFIX), DATA_PREFIX) != 0 ||
+            !parseDate(name.substr(strlen(DATA_PREFIX), 8), day))
+            continue;
+        days.push_back(day);
+    }
+    closedir(d);
+    std::sort(days.begin(), days.end());
+
+    uint32_t lastDay = (uint32_t)(index->lastId >> OFFSET_BITS);
+    uint64_t indexed = 0;
+    for (uint32_t day : days) {
+        if (day < lastDay)
+            continue;
+        File_t *file = getFile(day, false);
+        if (file == NULL)
+            continue;
+        uint64_t offset = 0;
+        if (day == lastDay) {
+            const RecordHeader_t *last = getRecord(index->lastId);
+            if (last == NULL)
+                continue;
+            offset = (index->lastId & ((1ull << OFFSET_BITS) - 1)) + last->size;
+        }
+        for (; offset < file->used; offset += ((const RecordHeader_t *)(file->data + offset))->size) {
+            uint64_t id = ((uint64_t)day << OFFSET_BITS) | offset;
+            const RecordHeader_t *header = getRecord(id);
+            if (header == NULL)
+                break;
+            const char *payload = (const char *)(header + 1);
+            setHead(std::string(payload, header->player1Size), id);
+            setHead(std::string(payload + header->player1Size, header->player2Size), id);
+            index->lastId = id;
+            indexed++;
+        }
+    }
+    if (indexed > 0)
+        LOG_WARNING(std::to_string(indexed) + " games have been added into the index of the store of games");
+}
+
+bool GameStore::open() {
+    storeMtx.lock();
+    if (index != NULL) {
+        storeMtx.unlock();
+        return true;
+    }
+    mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    std::string path = dir + "/" + INDEX_FILE;
+    indexFd = ::open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (indexFd < 0) {
+        LOG_ERR("opening the index '" + path + "' failed");
+        storeMtx.unlock();
+        return false;
+    }
+
+    // an index that is not valid is built from scratch
+    IndexHeader_t header;
+    struct stat st;
+    bool valid = pread(indexFd, &header, sizeof(header), 0) == sizeof(header) && memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+                 fstat(indexFd, &st) == 0 && (uint64_t)st.st_size == sizeof(header) + header.capacity * sizeof(IndexSlot_t);
+    if (!mapIndex(valid ? header.capacity : INITIAL_INDEX_CAPACITY)) {
+        LOG_ERR("mapping the index '" + path + "' failed");
+        ::close(indexFd);
+        indexFd = -1;
+        storeMtx.unlock();
+        return false;
+    }
+    if (!valid) {
+        memset(getSlots(), 0, index->capacity * sizeof(IndexSlot_t));
+        memcpy(index->magic, INDEX_MAGIC, sizeof(index->magic));
+        index->count = 0;
+        index->lastId = 0;
+    }
+    catchUpIndex();
+    storeMtx.unlock();
+    return true;
+}
+
+void GameStore::close() {
+    storeMtx.lock();
+    for (auto &it : files)
+        closeFile(it.second, it.first == currentDay);
+    files.clear();
+    currentDay = 0;
+    if (index != NULL) {
+        munmap(index, sizeof(IndexHeader_t) + index->capacity * sizeof(IndexSlot_t));
+        index = NULL;
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+        indexFd = -1;
+    }
+    storeMtx.unlock();
+}
+
+uint64_t GameStore::append(Game_t &game) {
+    if (game.player1.empty() || game.player2.empty() || game.player1.size() > MAX_NICK_LENGTH ||
+        game.player2.size() > MAX_NICK_LENGTH || game.moves.size() > (size_t)MAX_MOVES)
+        return 0;
+    size_t payloadSize = game.player1.size() + game.player2.size() + game.moves.size();
+    uint32_t size = (uint32_t)((sizeof(RecordHeader_t) + payloadSize + 7) & ~(size_t)7);
+    uint32_t day = (uint32_t)(game.endTime / SECONDS_PER_DAY);
+
+    storeMtx.lock();
+    if (index == NULL) {
+        storeMtx.unlock();
+        return 0;
+    }
+    // a new day - the data file of the previous one is complete (it stays
+    // mapped, but nothing past the records is ever accessed)
+    if (day != currentDay && files.find(currentDay) != files.end()) {
+        File_t &previous = files[currentDay];
+        if (ftruncate(previous.fd, previous.used) < 0)
+            LOG_WARNING("truncating a data file of the store of games failed");
+    }
+    currentDay = day;
+    File_t *file = getFile(day, true);
+    if (file == NULL || file->used + size >= (1ull << OFFSET_BITS)) {
+        storeMtx.unlock();
+        return 0;
+    }
+    if (file->used + size > file->mapped) {
+        uint64_t mapped = file->mapped + FILE_GROWTH;
+        void *data = MAP_FAILED;
+        if (ftruncate(file->fd, mapped) == 0) {
+            munmap(file->data, file->mapped);
+            data = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+        }
+        if (data == MAP_FAILED) {
+            LOG_ERR("growing a data file of the store of games failed");
+            closeFile(*file, true);
+            files.erase(day);
+            storeMtx.unlock();
+            return 0;
+        }
+        file->data = (char *)data;
+        file->mapped = mapped;
+    }
+
+    uint64_t id = ((uint64_t)day << OFFSET_BITS) | file->used;
+    IndexSlot_t *slot1 = findSlot(hashNick(game.player1));
+    IndexSlot_t *slot2 = findSlot(hashNick(game.player2));
+    RecordHeader_t *header = (RecordHeader_t *)(file->data + file->used);
+    memset(header, 0, size);
+    header->size = size;
+    header->journalId = game.journalId;
+    header->startTime = game.startTime;
+    header->endTime = game.endTime;
+    header->previous1 = slot1->hash != 0 ? slot1->head : 0;
+    header->previous2 = slot2->hash != 0 ? slot2->head : 0;
+    header->result = (uint8_t)game.result;
+    header->nbMoves = (uint8_t)game.moves.size();
+    header->player1Size = (uint8_t)game.player1.size();
+    header->player2Size = (uint8_t)game.player2.size();
+    char *payload = (char *)(header + 1);
+    memcpy(payload, game.player1.data(), game.player1.size());
+    memcpy(payload + game.player1.size(), game.player2.data(), game.player2.size());
+    memcpy(payload + game.player1.size() + game.player2.size(), game.moves.data(), game.moves.size());
+    header->checksum = checksum(header);
+    file->used += size;
+
+    setHead(game.player1, id);
+    setHead(game.player2, id);
+    if (index != NULL)
+        index->lastId = id;
+    stats.games++;
+    stats.bytes += size;
+    storeMtx.unlock();
+
+    game.id = id;
+    return id;
+}
+
+bool GameStore::getGame(uint64_t id, Game_t &game) {
+    storeMtx.lock();
+    const RecordHeader_t *header = getRecord(id);
+    if (header != NULL)
+        toGame(id, header, game);
+    storeMtx.unlock();
+    return header != NULL;
+}
+
+bool GameStore::annotate(uint64_t id, const std::vector<uint8_t> &annotations) {
+    storeMtx.lock();
+    RecordHeader_t *header = (RecordHeader_t *)getRecord(id);
+    if (header != NULL) {
+        size_t count = std::min(annotations.size(), (size_t)header->nbMoves);
+        memcpy(header->annotations, annotations.data(), count);
+    }
+    storeMtx.unlock();
+    return header != NULL;
+}
+
+bool GameStore::getAnnotations(uint64_t id, std::vector<uint8_t> &annotations) {
+    storeMtx.lock();
+    const RecordHeader_t *header = getRecord(id);
+    if (header != NULL)
+        annotations.assign(header->annotations, header->annotations + header->nbMoves);
+    storeMtx.unlock();
+    return header != NULL;
+}
+
+uint64_t GameStore::getHistory(const std::string &nick, uint64_t cursor, size_t count, std::vector<Game_t> &games) {
+    storeMtx.lock();
+    if (index == NULL) {
+        storeMtx.unlock();
+        return 0;
+    }
+    uint64_t id = cursor;
+    if (id == 0) {
+        IndexSlot_t *slot = findSlot(hashNick(nick));
+        id = slot->hash != 0 ? slot->head : 0;
+    }
+    // follow the chain of the games of the player
+    while (id != 0 && games.size() < count) {
+        const RecordHeader_t *header = getRecord(id);
+        if (header == NULL) {
+            id = 0;
+            break;
+        }
+        const char *payload = (const char *)(header + 1);
+        uint64_t previous;
+        if (nick.compare(0, std::string::npos, payload, header->player1Size) == 0)
+            previous = header->previous1;
+        else if (nick.compare(0, std::string::npos, payload + header->player1Size, header->player2Size) == 0)
+            previous = header->previous2;
+        else {
+            // the cursor does not belong to the player (or two nicks share the same hash)
+            id = 0;
+            break;
+        }
+        games.emplace_back();
+        toGame(id, header, games.back());
+        id = previous;
+    }
+    storeMtx.unlock();
+    return id;
+}
+
+bool GameStore::locateGame(uint64_t id, std::string &path, uint64_t &offset, uint64_t &size) {
+    storeMtx.lock();
+    const RecordHeader_t *header = getRecord(id);
+    if (header != NULL) {
+        path = getPath((uint32_t)(id >> OFFSET_BITS));
+        offset = id & ((1ull << OFFSET_BITS) - 1);
+        size = header->size;
+    }
+    storeMtx.unlock();
+    return header != NULL;
+}
+
+bool GameStore::locateDay(const std::string &date, std::string &path, uint64_t &size) {
+    uint32_t day;
+    if (!parseDate(date, day))
+        return false;
+    storeMtx.lock();
+    File_t *file = index != NULL ? getFile(day, false) : NULL;
+    if (file != NULL) {
+        path = getPath(day);
+        size = file->used;
+    }
+    storeMtx.unlock();
+    return file != NULL && size > 0;
+}
+
+GameStore::Stats_t GameStore::getStats() {
+    storeMtx.lock();
+    Stats_t s = stats;
+    s.players = index != NULL ? index->count : 0;
+    storeMtx.unlock();
+    return s;
+}
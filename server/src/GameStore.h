@@ -0,0 +1,280 @@
+#ifndef GAME_STORE_H
+#define GAME_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Persistent store of finished games (players, moves, result, timestamps).
+///
+/// The games are appended into one data file per day (games-YYYYMMDD.dat),
+/// so the primary layout is ordered by the time the games ended. The id
+/// of a game is the number of the day followed by the offset of the game
+/// in the data file (#OFFSET_BITS), so a game is found without any lookup.
+///
+/// Every record also holds the id of the previous game of each of the
+/// players. Together with the secondary index (players.idx) holding
+/// the id of the last game of every player, the games of a player form
+/// a chain from the most recent one back, so paging through them
+/// (#getHistory) never scans anything.
+///
+/// Both the data files and the index are memory-mapped; the current data
+/// file grows by #FILE_GROWTH bytes at a time and the unused rest of it is
+/// cut off when the store is closed. The index is a hash table (open
+/// addressing) of 64-bit hashes of the nicks. It is brought up to date from
+/// the data files when the store is opened, so losing it is not fatal.
+class GameStore {
+public:
+    /// default directory of the store
+    static const std::string DEFAULT_DIR;
+    /// the current data file grows by this many bytes (16MB)
+    static const uint64_t FILE_GROWTH = 16 * 1024 * 1024;
+    /// number of bits of the id of a game taken by the offset in the data file
+    static const int OFFSET_BITS = 40;
+    /// the most moves a game can have
+    static const int MAX_MOVES = 42;
+    /// the longest nick that can be stored
+    static const size_t MAX_NICK_LENGTH = 255;
+
+    /// flag of an annotation of a move - the move threw away a win or a draw
+    static const uint8_t ANNOTATION_BLUNDER = 0x80;
+    /// bits of an annotation of a move holding its accuracy (0 - 100) plus one (0 - not annotated)
+    static const uint8_t ANNOTATION_ACCURACY = 0x7f;
+
+    /// Results of the games (the same as in the journal)
+    enum Result {
+        DRAW = 0,        ///< the game ended in a draw
+        PLAYER_1_WON = 1, ///< player1 won the game
+        PLAYER_2_WON = 2  ///< player2 won the game
+    };
+
+    /// One finished game
+    struct Game_t {
+        uint64_t id;         ///< id of the game in the store (set by #append)
+        uint64_t journalId;  ///< id of the game in the journal
+        std::string player1; ///< nick of player1 (they played the first move)
+        std::string player2; ///< nick of player2
+        std::string moves;   ///< the moves (columns '0' - '6')
+        Result result;       ///< result of the game
+        uint64_t startTime;  ///< when the game started (seconds since the epoch)
+        uint64_t endTime;    ///< when the game ended (seconds since the epoch)
+    };
+
+    /// Header of every record of a data file (the nicks and the moves follow it)
+    struct RecordHeader_t {
+        uint32_t size;        ///< size of the whole record (multiple of 8)
+        uint32_t checksum;    ///< checksum of the rest of the record (but the annotations)
+        uint64_t journalId;   ///< id of the game in the journal
+        uint64_t startTime;   ///< when the game started
+        uint64_t endTime;     ///< when the game ended
+        uint64_t previous1;   ///< id of the previous game of player1 (0 if none)
+        uint64_t previous2;   ///< id of the previous game of player2 (0 if none)
+        uint8_t result;       ///< result of the game (#Result)
+        uint8_t nbMoves;      ///< number of moves
+        uint8_t player1Size;  ///< length of the nick of player1
+        uint8_t player2Size;  ///< length of the nick of player2
+        uint32_t reserved;    ///< padding (zero)
+        uint8_t annotations[MAX_MOVES]; ///< annotation of every move (0 - none), filled in after the game (see #annotate)
+    };
+
+    /// Statistics of the store
+    struct Stats_t {
+        uint64_t games;   ///< number of games appended since the store was opened
+        uint64_t players; ///< number of players in the index
+        uint64_t bytes;   ///< number of bytes appended since the store was opened
+    };
+
+private:
+    /// Header of the index file
+    struct IndexHeader_t {
+        char magic[8];     ///< identification of the file
+        uint64_t capacity; ///< number of slots (power of two)
+        uint64_t count;    ///< number of used slots
+        uint64_t lastId;   ///< id of the last game that has been indexed
+    };
+
+    /// One slot of the index
+    struct IndexSlot_t {
+        uint64_t hash; ///< hash of the nick (0 - empty slot)
+        uint64_t head; ///< id of the last game of the player
+    };
+
+    /// One memory-mapped data file
+    struct File_t {
+        int fd;          ///< file descriptor
+        char *data;      ///< mapped content of the file
+        uint64_t mapped; ///< number of bytes mapped
+        uint64_t used;   ///< number of bytes holding records
+    };
+
+    /// directory of the store
+    std::string dir;
+    /// lock used when accessing the files
+    std::mutex storeMtx;
+    /// data files that have been mapped (the key is the number of the day)
+    std::map<uint32_t, File_t> files;
+    /// the day of the data file games are appended into (0 if none)
+    uint32_t currentDay;
+    /// file descriptor of the index
+    int indexFd;
+    /// mapped index (the slots follow the header)
+    IndexHeader_t *index;
+    /// statistics of the store
+    Stats_t stats;
+
+private:
+    /// Returns the path to the data file of the day given as a parameter
+    /// \param day number of the day (since the epoch)
+    /// \return path to the data file
+    std::string getPath(uint32_t day) const;
+
+    /// Returns the data file of the day given as a parameter
+    /// (it is opened and mapped if it has not been yet)
+    /// \param day number of the day
+    /// \param create true, if the file is going to be appended into
+    /// \return the data file, NULL if it does not exist
+    File_t *getFile(uint32_t day, bool create);
+
+    /// Unmaps and closes the data file given as a parameter
+    /// \param file the data file
+    /// \param truncate true, if the unused rest of the file should be cut off
+    void closeFile(File_t &file, bool truncate);
+
+    /// Returns the header of the game given as a parameter if it is valid
+    /// \param id id of the game
+    /// \return header of the record, NULL if there is no such a game
+    const RecordHeader_t *getRecord(uint64_t id);
+
+    /// Returns the slots of the index
+    /// \return the slots following the header
+    IndexSlot_t *getSlots() const;
+
+    /// Maps the index file with the capacity given as a parameter
+    /// \param capacity number of slots
+    /// \return true, if the index has been mapped. Otherwise, false.
+    bool mapIndex(uint64_t capacity);
+
+    /// Finds the slot of the nick given as a parameter
+    /// \param hash hash of the nick (see #hashNick)
+    /// \return the slot of the nick or the empty slot it would take
+    IndexSlot_t *findSlot(uint64_t hash) const;
+
+    /// Sets the id of the last game of the player given as a parameter
+    /// (the index grows when it is 70% full)
+    /// \param nick nick of the player
+    /// \param id id of the game
+    void setHead(const std::string &nick, uint64_t id);
+
+    /// Doubles the capacity of the index
+    void growIndex();
+
+    /// Indexes all the games ended after the last one in the index
+    /// (the store was not closed properly or the index was lost)
+    void catchUpIndex();
+
+    /// Converts a date to the number of the day
+    /// \param date the date (YYYYMMDD)
+    /// \param day number of the day (since the epoch)
+    /// \return false, if the date is not valid. Otherwise, true.
+    static bool parseDate(const std::string &date, uint32_t &day);
+
+    /// Computes the hash of the nick given as a parameter (FNV-1a, never 0)
+    /// \param nick the nick
+    /// \return hash of the nick
+    static uint64_t hashNick(const std::string &nick);
+
+    /// Computes the checksum of the record given as a parameter (FNV-1a)
+    /// \param header header of the record (followed by the nicks and the moves)
+    /// \return checksum of the record
+    static uint32_t checksum(const RecordHeader_t *header);
+
+    /// Copies the record given as a parameter into a game
+    /// \param id id of the game
+    /// \param header header of the record
+    /// \param game the game
+    static void toGame(uint64_t id, const RecordHeader_t *header, Game_t &game);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// Nothing is read or written until the store is opened (see #open).
+    /// \param dir directory of the store
+    explicit GameStore(std::string dir = DEFAULT_DIR);
+
+    /// Destructor of the class - closes the store (see #close)
+    ~GameStore();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    GameStore(const GameStore&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const GameStore&) = delete;
+
+    /// Opens the store (and brings the index up to date)
+    /// \return true, if the store has been opened. Otherwise, false.
+    bool open();
+
+    /// Unmaps all the files and cuts off the unused rest of the current data file
+    void close();
+
+    /// Appends a finished game into the store
+    /// \param game the game (its #Game_t::id is set)
+    /// \return id of the game, 0 if it could not be stored
+    uint64_t append(Game_t &game);
+
+    /// Returns a finished game
+    /// \param id id of the game
+    /// \param game the game
+    /// \return false, if there is no such a game. Otherwise, true.
+    bool getGame(uint64_t id, Game_t &game);
+
+    /// Returns a page of the finished games of a player (the most recent ones first)
+    /// \param nick nick of the player
+    /// \param cursor id of the first game of the page (0 - the most recent one)
+    /// \param count the most games returned
+    /// \param games the games
+    /// \return cursor of the next page, 0 if there are no more games
+    uint64_t getHistory(const std::string &nick, uint64_t cursor, size_t count, std::vector<Game_t> &games);
+
+    /// Attaches the annotations of the moves to a finished game (they are not
+    /// covered by the checksum, so they can be filled in once the game is stored).
+    /// Every annotation is the accuracy of the move (0 - 100) plus one,
+    /// with #ANNOTATION_BLUNDER set if the move was a blunder (0 - not annotated).
+    /// \param id id of the game
+    /// \param annotations annotation of every move
+    /// \return false, if there is no such a game. Otherwise, true.
+    bool annotate(uint64_t id, const std::vector<uint8_t> &annotations);
+
+    /// Returns the annotations of the moves of a finished game (see #annotate)
+    /// \param id id of the game
+    /// \param annotations annotation of every move
+    /// \return false, if there is no such a game. Otherwise, true.
+    bool getAnnotations(uint64_t id, std::vector<uint8_t> &annotations);
+
+    /// Finds where the record of a game is stored, so it can be
+    /// sent straight from the file (see #RecordHeader_t for the format)
+    /// \param id id of the game
+    /// \param path path to the data file
+    /// \param offset offset of the record in the data file
+    /// \param size size of the record
+    /// \return false, if there is no such a game. Otherwise, true.
+    bool locateGame(uint64_t id, std::string &path, uint64_t &offset, uint64_t &size);
+
+    /// Finds the data file of a day, so it can be sent straight from the disk
+    /// \param date the day (YYYYMMDD)
+    /// \param path path to the data file
+    /// \param size number of bytes holding records (the file can be longer)
+    /// \return false, if no games are stored for the day. Otherwise, true.
+    bool locateDay(const std::string &date, std::string &path, uint64_t &size);
+
+    /// Returns the statistics of the store
+    /// \return statistics of the store
+    Stats_t getStats();
+};
+
+#endif
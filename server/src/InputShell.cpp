@@ -4,10 +4,16 @@ InputShell::InputShell(int argc, char *argv[]) {
     // set all variables to their default values
     port = Server::PORT_DEFAULT;
     maxNumberOfClients = Server::MAX_CLIENTS_DEFAULT;
+    logLevel = LOG_MIN_LEVEL;
+    logSinks = Logger::TEXT;
+    metricsPort = 0;
+    traceSampling = 0;
+    lockProfiling = false;
+    adminSocket = "";
 
     // check the number of arguments
     // the user entered
-    if (argc <= 5 && argc & 1) {
+    if (argc <= 17 && argc & 1) {
         int i = 1;
 
         while (i < argc) {
@@ -33,6 +39,70 @@ InputShell::InputShell(int argc, char *argv[]) {
                     maxNumberOfClients = val;
                     i++;
                 }
+                // -l 2
+                else if (token == LOG_LEVEL_ARG) {
+                    int val = getNum(argv[i]);
+                    if (val == INVALID_NUM_ARG || val > LOG_LEVEL_ERROR) {
+                        valid = false;
+                        return;
+                    }
+                    logLevel = val;
+                    i++;
+                }
+                // -o binary
+                else if (token == LOG_OUTPUT_ARG) {
+                    std::string val(argv[i]);
+                    if (val == "text")
+                        logSinks = Logger::TEXT;
+                    else if (val == "binary")
+                        logSinks = Logger::BINARY;
+                    else if (val == "both")
+                        logSinks = Logger::TEXT | Logger::BINARY;
+                    else {
+                        valid = false;
+                        return;
+                    }
+                    i++;
+                }
+                // -m 9100
+                else if (token == METRICS_PORT_ARG) {
+                    int val = getNum(argv[i]);
+                    if (val == INVALID_NUM_ARG || val > 65535) {
+                        valid = false;
+                        return;
+                    }
+                    metricsPort = val;
+                    i++;
+                }
+                // -t 100
+                else if (token == TRACE_SAMPLING_ARG) {
+                    int val = getNum(argv[i]);
+                    if (val == INVALID_NUM_ARG) {
+                        valid = false;
+                        return;
+                    }
+                    traceSampling = val;
+                    i++;
+                }
+                // -L 1
+                else if (token == LOCK_PROFILING_ARG) {
+                    int val = getNum(argv[i]);
+                    if (val == INVALID_NUM_ARG || val > 1) {
+                        valid = false;
+                        return;
+                    }
+                    lockProfiling = val == 1;
+                    i++;
+                }
+                // -a admin.sock
+                else if (token == ADMIN_SOCKET_ARG) {
+                    adminSocket = argv[i];
+                    if (adminSocket.empty()) {
+                        valid = false;
+                        return;
+                    }
+                    i++;
+                }
                 else {
                     valid = false;
                     return;
@@ -76,12 +146,53 @@ int InputShell::getMaxNumberOfClients() {
     return maxNumberOfClients;
 }
 
+int InputShell::getLogLevel() const {
+    return logLevel;
+}
+
+int InputShell::getLogSinks() const {
+    return logSinks;
+}
+
+int InputShell::getMetricsPort() const {
+    return metricsPort;
+}
+
+int InputShell::getTraceSampling() const {
+    return traceSampling;
+}
+
+bool InputShell::isLockProfiling() const {
+    return lockProfiling;
+}
+
+std::string InputShell::getAdminSocket() const {
+    return adminSocket;
+}
+
 void InputShell::printHelp() const {
     std::cout << PORT_ARG << " Port on which the server will be running.\n";
     std::cout << "   Default value is " + std::to_string(Server::PORT_DEFAULT) << ".\n";
     std::cout << MAX_NUMBER_OF_CLIENTS_ARG << " Maximum number of clients that can be\n";
     std::cout << "   connected to the server at a time.\n";
     std::cout << "   Default value is " + std::to_string(Server::MAX_CLIENTS_DEFAULT) << ".\n";
+    std::cout << LOG_LEVEL_ARG << " Minimum level of the messages that are logged\n";
+    std::cout << "   (0 countdown, 1 msg, 2 game, 3 info, 4 warning, 5 booting, 6 error).\n";
+    std::cout << "   Default value is " + std::to_string(LOG_MIN_LEVEL) << ".\n";
+    std::cout << LOG_OUTPUT_ARG << " Where the messages are logged - text, binary or both\n";
+    std::cout << "   (the binary log is turned into text by the logdecode tool).\n";
+    std::cout << "   Default value is text.\n";
+    std::cout << METRICS_PORT_ARG << " Port of the local host on which the metrics are served\n";
+    std::cout << "   (Prometheus text format, e.g. curl http://127.0.0.1:9100/metrics).\n";
+    std::cout << "   Default value is 0 (the metrics are not served).\n";
+    std::cout << TRACE_SAMPLING_ARG << " Every n-th message is traced (the spans are written into the 'log'\n";
+    std::cout << "   directory as Chrome trace JSON, open it in chrome://tracing or Perfetto).\n";
+    std::cout << "   Default value is 0 (nothing is traced).\n";
+    std::cout << LOCK_PROFILING_ARG << " Profiling of the locks of the server - 1 on, 0 off (the contention\n";
+    std::cout << "   report is rewritten in log/locks.txt every " << ProfiledMutex::REPORT_INTERVAL_SECONDS << "s).\n";
+    std::cout << "   Default value is 0.\n";
+    std::cout << ADMIN_SOCKET_ARG << " Path of the admin control socket (e.g. ./adminctl -s admin.sock help).\n";
+    std::cout << "   Default value is none (there is no socket).\n";
 }
 
 bool InputShell::isValid() const {
@@ -32,6 +32,49 @@ public:
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     const std::string MAX_NUMBER_OF_CLIENTS_ARG = "-c";
 
+    /// parameter l that allows the user to set the
+    /// minimum level of the messages that are logged
+    /// (0 - everything, 6 - errors only)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -l 2
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string LOG_LEVEL_ARG = "-l";
+
+    /// parameter o that allows the user to choose where
+    /// the messages are logged (text, binary or both)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -o binary
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string LOG_OUTPUT_ARG = "-o";
+
+    /// parameter m that allows the user to set a port of the local
+    /// host on which the metrics are served (0 - not served)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -m 9100
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string METRICS_PORT_ARG = "-m";
+
+    /// parameter t that allows the user to trace every n-th
+    /// message the server receives (0 - nothing is traced)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -t 100
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string TRACE_SAMPLING_ARG = "-t";
+
+    /// parameter L that allows the user to turn on the profiling
+    /// of the locks of the server (1 - on, 0 - off)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -L 1
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string LOCK_PROFILING_ARG = "-L";
+
+    /// parameter a that allows the user to set a path of the
+    /// admin control socket (see #Admin)
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// ./server -a admin.sock
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    const std::string ADMIN_SOCKET_ARG = "-a";
+
     /// indication of an invalid number used
     /// when parsing the number of maximum clients or
     /// the port number
@@ -49,6 +92,24 @@ private:
     /// connected to the server at a time
     int maxNumberOfClients;
 
+    /// minimum level of the messages that are logged
+    int logLevel;
+
+    /// where the messages are logged (#Logger::Sink)
+    int logSinks;
+
+    /// port on which the metrics are served (0 - not served)
+    int metricsPort;
+
+    /// every n-th message is traced (0 - nothing is traced)
+    int traceSampling;
+
+    /// indication of whether or not the locks are profiled
+    bool lockProfiling;
+
+    /// path of the admin control socket (empty - no socket)
+    std::string adminSocket;
+
 private:
     /// Returns a number (an integer) from the string given as a parameter
     ///
@@ -88,6 +149,50 @@ public:
     /// \return the maximum number of clients
     int getMaxNumberOfClients();
 
+    /// Returns the minimum level of the messages that are logged
+    ///
+    /// This may be either the number the user put into the
+    /// terminal or #LOG_MIN_LEVEL (everything is logged).
+    ///
+    /// \return the minimum level of the logged messages
+    int getLogLevel() const;
+
+    /// Returns where the messages are logged
+    ///
+    /// This may be either the output the user put into the
+    /// terminal or the text log only.
+    ///
+    /// \return a combination of #Logger::Sink flags
+    int getLogSinks() const;
+
+    /// Returns the port of the local host on which the metrics are served
+    ///
+    /// This may be either the number the user put into the
+    /// terminal or 0 (the metrics are not served).
+    ///
+    /// \return the port, 0 if the metrics are not served
+    int getMetricsPort() const;
+
+    /// Returns how many of the messages are traced
+    ///
+    /// This may be either the number the user put into the
+    /// terminal or 0 (nothing is traced).
+    ///
+    /// \return every n-th message is traced, 0 if nothing is traced
+    int getTraceSampling() const;
+
+    /// Returns whether or not the locks of the server are profiled
+    /// \return true, if the user turned the profiling on. Otherwise, false.
+    bool isLockProfiling() const;
+
+    /// Returns the path of the admin control socket
+    ///
+    /// This may be either the path the user put into the
+    /// terminal or an empty string (there is no socket).
+    ///
+    /// \return the path of the socket, empty if there is no socket
+    std::string getAdminSocket() const;
+
     /// Prints out the help fro the user if they
     /// enter invalid parameters when running the program.
     void printHelp() const;
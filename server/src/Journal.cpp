@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "Journal.h"
+#include "Logger.h"
+
+const std::string Journal::DEFAULT_DIR = "journal";
+
+// name of a segment: segment-00000001.log
+static const char *SEGMENT_PREFIX = "segment-";
+static const char *SEGMENT_SUFFIX = ".log";
+
+// number of bits of a game id taken by the counter (the rest is the start time)
+static const int GAME_ID_COUNTER_BITS = 20;
+
+Journal::Journal(std::string dir, uint64_t segmentSize, int flushIntervalMs, int groupCommitRecords) {
+    this->dir = dir;
+    this->segmentSize = segmentSize;
+    this->flushIntervalMs = flushIntervalMs;
+    this->groupCommitRecords = groupCommitRecords;
+    pendingRecords = 0;
+    nextLsn = 1;
+    durableLsn = 0;
+    failed = false;
+    running = false;
+    memset(&stats, 0, sizeof(stats));
+    fd = -1;
+    segmentNumber = 0;
+    segmentOffset = 0;
+    gameIdCounter = (uint64_t)time(NULL) << GAME_ID_COUNTER_BITS;
+}
+
+Journal::~Journal() {
+    close();
+}
+
+std::vector<std::string> Journal::listSegments(const std::string &dir) {
+    std::vector<std::string> segments;
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL)
+        return segments;
+    struct dirent *entry;
+    size_t prefix = strlen(SEGMENT_PREFIX);
+    size_t suffix = strlen(SEGMENT_SUFFIX);
+    while ((entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        if (name.size() > prefix + suffix && name.compare(0, prefix, SEGMENT_PREFIX) == 0 &&
+            name.compare(name.size() - suffix, suffix, SEGMENT_SUFFIX) == 0)
+            segments.push_back(dir + "/" + name);
+    }
+    closedir(d);
+
+    // the numbers are zero-padded, so the names sort in the order of writing
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+bool Journal::readSegment(const std::string &path, const std::function<void(const RecordHeader_t&, const std::string&)> &callback) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (file.fail())
+        return false;
+    RecordHeader_t header;
+    std::string payload;
+    while (file.read((char *)&header, sizeof(header))) {
+        // the preallocated (zeroed) rest of the segment or a torn write
+        if (header.lsn == 0 || header.size > MAX_PAYLOAD_SIZE)
+            break;
+        payload.resize(header.size);
+        if (!file.read(&payload[0], header.size))
+            break;
+        if (checksum(header, payload.data(), payload.size()) != header.checksum)
+            break;
+        callback(header, payload);
+    }
+    return true;
+}
+
+bool Journal::open() {
+    bufferMtx.lock();
+    if (running) {
+        bufferMtx.unlock();
+        return true;
+    }
+    mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+    // continue after the last segment (and its last record) - the last
+    // segments may be empty if the server stopped right after creating them,
+    // so the last record is looked for further back (otherwise the sequence
+    // numbers would start from 1 again and repeat the ones already written)
+    std::vector<std::string> segments = listSegments(dir);
+    if (!segments.empty()) {
+        const std::string &last = segments.back();
+        segmentNumber = (uint32_t)strtoul(last.c_str() + last.size() - strlen(SEGMENT_SUFFIX) - 8, NULL, 10);
+    }
+    for (auto it = segments.rbegin(); it != segments.rend() && nextLsn == 1; ++it) {
+        readSegment(*it, [&](const RecordHeader_t &header, const std::string &) {
+            nextLsn = header.lsn + 1;
+        });
+    }
+    durableLsn = nextLsn - 1;
+    if (!rollSegment()) {
+        bufferMtx.unlock();
+        return false;
+    }
+    running = true;
+    writer = std::thread(&Journal::writerHandler, this);
+    bufferMtx.unlock();
+    return true;
+}
+
+void Journal::close() {
+    bufferMtx.lock();
+    if (!running) {
+        bufferMtx.unlock();
+        return;
+    }
+    running = false;
+    bufferMtx.unlock();
+    bufferCv.notify_one();
+    writer.join();
+
+    // cut off the preallocated space that has not been used
+    if (fd >= 0) {
+        if (ftruncate(fd, segmentOffset) < 0)
+            LOG_WARNING("truncating segment " + std::to_string(segmentNumber) + " of the journal failed");
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool Journal::isOpen() {
+    bufferMtx.lock();
+    bool open = running;
+    bufferMtx.unlock();
+    return open;
+}
+
+uint32_t Journal::checksum(const RecordHeader_t &header, const char *payload, size_t size) {
+    uint32_t hash = 2166136261u;
+    auto add = [&hash](const char *data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            hash ^= (uint8_t)data[i];
+            hash *= 16777619u;
+        }
+    };
+    // everything but the checksum itself
+    add((const char *)&header.size, sizeof(header.size));
+    add((const char *)&header.lsn, sizeof(header) - offsetof(RecordHeader_t, lsn));
+    add(payload, size);
+    return hash;
+}
+
+uint64_t Journal::append(Event type, uint64_t gameId, const std::string &payload) {
+    RecordHeader_t header;
+    header.size = (uint32_t)std::min<size_t>(payload.size(), MAX_PAYLOAD_SIZE);
+    header.gameId = gameId;
+    header.type = type;
+    header.reserved = 0;
+
+    bufferMtx.lock();
+    if (!running) {
+        bufferMtx.unlock();
+        return 0;
+    }
+    header.lsn = nextLsn++;
+    header.checksum = checksum(header, payload.data(), header.size);
+    buffer.append((const char *)&header, sizeof(header));
+    buffer.append(payload.data(), header.size);
+    bool wakeUpWriter = ++pendingRecords == groupCommitRecords;
+    bufferMtx.unlock();
+
+    if (wakeUpWriter)
+        bufferCv.notify_one();
+    return header.lsn;
+}
+
+bool Journal::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(bufferMtx);
+    durableCv.wait(lock, [&]() { return durableLsn >= lsn || failed || !running; });
+    return durableLsn >= lsn;
+}
+
+uint64_t Journal::getDurableLsn() {
+    bufferMtx.lock();
+    uint64_t lsn = durableLsn;
+    bufferMtx.unlock();
+    return lsn;
+}
+
+uint64_t Journal::getLastLsn() {
+    bufferMtx.lock();
+    uint64_t lsn = nextLsn - 1;
+    bufferMtx.unlock();
+    return lsn;
+}
+
+Journal::Stats_t Journal::getStats() {
+    bufferMtx.lock();
+    Stats_t s = stats;
+    bufferMtx.unlock();
+    return s;
+}
+
+uint64_t Journal::nextGameId() {
+    return ++gameIdCounter;
+}
+
+bool Journal::rollSegment() {
+    if (fd >= 0) {
+        if (ftruncate(fd, segmentOffset) < 0)
+            LOG_WARNING("truncating segment " + std::to_string(segmentNumber) + " of the journal failed");
+        ::close(fd);
+        fd = -1;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%s%08u%s", SEGMENT_PREFIX, ++segmentNumber, SEGMENT_SUFFIX);
+    std::string path = dir + "/" + name;
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        if (!failed)
+            LOG_ERR("creating segment '" + path + "' of the journal failed");
+        return false;
+    }
+    // preallocate the whole segment, so appending does not change the size of the file
+    if (fallocate(fd, 0, 0, segmentSize) < 0)
+        LOG_WARNING("preallocating segment '" + path + "' of the journal failed");
+
+    // make the new file itself durable
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+    segmentOffset = 0;
+    stats.segments++;
+    return true;
+}
+
+bool Journal::writeBatch(const std::string &batch) {
+    // only the first failure in a row is logged, the write is retried until it succeeds
+    // (failed is changed by the writer only, so it is read without the lock)
+    // a new segment is also created if creating the current one failed
+    if ((segmentOffset > 0 && segmentOffset + batch.size() > segmentSize) || fd < 0)
+        if (!rollSegment())
+            return false;
+
+    size_t written = 0;
+    while (written < batch.size()) {
+        ssize_t n = pwrite(fd, batch.data() + written, batch.size() - written, segmentOffset + written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (!failed)
+                LOG_ERR("writing into segment " + std::to_string(segmentNumber) + " of the journal failed");
+            return false;
+        }
+        written += n;
+    }
+    // the offset moves on only once the records are durable, so a failed batch
+    // is written again over the same place (the pages of the failed write cannot be trusted)
+    if (fdatasync(fd) < 0) {
+        if (!failed)
+            LOG_ERR("fdatasync of segment " + std::to_string(segmentNumber) + " of the journal failed");
+        return false;
+    }
+    segmentOffset += written;
+    return true;
+}
+
+void Journal::writerHandler() {
+    std::string batch;
+    int retryMs = 0;       // delay before the records of a failed group commit are written again
+    uint64_t failures = 0; // group commits that failed in a row
+    std::unique_lock<std::mutex> lock(bufferMtx);
+    while (1) {
+        // the pending records of a failed group commit would wake the writer up right away
+        if (failed)
+            bufferCv.wait_for(lock, std::chrono::milliseconds(retryMs), [&]() { return !running; });
+        else {
+            bufferCv.wait_for(lock, std::chrono::milliseconds(flushIntervalMs), [&]() {
+                return !running || pendingRecords >= groupCommitRecords;
+            });
+        }
+        if (buffer.empty()) {
+            if (!running)
+                return;
+            continue;
+        }
+        // take all the pending records at once (group commit)
+        batch.swap(buffer);
+        buffer.clear();
+        uint64_t records = pendingRecords;
+        uint64_t lastLsn = nextLsn - 1;
+        pendingRecords = 0;
+        lock.unlock();
+
+        bool written = writeBatch(batch);
+
+        lock.lock();
+        if (!written) {
+            stats.failures++;
+            if (!running) {
+                LOG_ERR("the journal is being closed - " + std::to_string(records) + " records could not be written");
+                failed = true;
+                durableCv.notify_all();
+                return;
+            }
+            // put the records back in front of the ones appended meanwhile and try again next time
+            batch.append(buffer);
+            buffer.swap(batch);
+            pendingRecords += records;
+            retryMs = failed ? std::min(2 * retryMs, (int)MAX_RETRY_INTERVAL_MS) : std::max(flushIntervalMs, 1);
+            failures++;
+            failed = true;
+            durableCv.notify_all();
+            continue;
+        }
+        if (failed)
+            LOG_INFO("the journal is being written again after " + std::to_string(failures) + " failed group commits");
+        failures = 0;
+        failed = false;
+        durableLsn = lastLsn;
+        stats.records += records;
+        stats.bytes += batch.size();
+        stats.syncs++;
+        stats.maxBatch = std::max(stats.maxBatch, records);
+        durableCv.notify_all();
+    }
+}
@@ -0,0 +1,227 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Append-only binary journal of game events (start of a game,
+/// every move, its result or cancellation).
+///
+/// #append only copies the record into an in-memory buffer, so the
+/// threads handling clients never wait for the disk. A background
+/// writer takes the whole buffer at once, writes it into the current
+/// segment and calls fdatasync (group commit) - every #flushIntervalMs
+/// milliseconds or as soon as #groupCommitRecords records are pending.
+///
+/// The journal is split into segments (segment-00000001.log, ...) of
+/// #segmentSize bytes that are preallocated with fallocate, so appending
+/// to them does not have to update the metadata of the file. A record
+/// never spans two segments. Every record starts with #RecordHeader_t
+/// followed by its payload; a zeroed or corrupted header marks the end
+/// of the records of a segment (see #readSegment).
+///
+/// If a group commit fails (the disk is full, ...), its records are kept
+/// and written again (at the same place of the segment) after a delay that
+/// doubles with every failure in a row, up to #MAX_RETRY_INTERVAL_MS (only
+/// the first failure of a row is logged). Until then, the journal is failed
+/// and #waitDurable does not wait for them.
+class Journal {
+public:
+    /// default directory of the journal
+    static const std::string DEFAULT_DIR;
+    /// default size of a segment (64MB)
+    static const uint64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+    /// default period of the group commit
+    static const int DEFAULT_FLUSH_INTERVAL_MS = 10;
+    /// default number of pending records that triggers a group commit right away
+    static const int DEFAULT_GROUP_COMMIT_RECORDS = 4096;
+    /// maximum size of the payload of a record
+    static const uint32_t MAX_PAYLOAD_SIZE = 1024;
+    /// the longest delay before the records of a failed group commit are written again
+    static const int MAX_RETRY_INTERVAL_MS = 5000;
+
+    /// Types of the journaled events
+    enum Event {
+        GAME_START = 1, ///< a game started (payload: "player1 player2")
+        GAME_MOVE,      ///< a move was played (payload: the column '0' - '6')
+        GAME_RESULT,    ///< a game ended (payload: "1" - player1 won, "2" - player2 won, "0" - draw)
+        GAME_CANCELED   ///< a game was canceled before it ended (payload: the reason)
+    };
+
+    /// Header of every record
+    struct RecordHeader_t {
+        uint32_t size;     ///< size of the payload
+        uint32_t checksum; ///< checksum of the rest of the header and the payload
+        uint64_t lsn;      ///< log sequence number (1, 2, 3, ...)
+        uint64_t gameId;   ///< id of the game the event belongs to
+        uint32_t type;     ///< type of the event (#Event)
+        uint32_t reserved; ///< padding (zero)
+    };
+
+    /// Statistics of the journal
+    struct Stats_t {
+        uint64_t records;  ///< number of records written to the disk
+        uint64_t bytes;    ///< number of bytes written to the disk
+        uint64_t syncs;    ///< number of group commits (fdatasync calls)
+        uint64_t segments; ///< number of segments created
+        uint64_t maxBatch; ///< the most records written by one group commit
+        uint64_t failures; ///< number of group commits that failed (their records are written again)
+    };
+
+private:
+    /// directory of the segments
+    std::string dir;
+    /// size of a segment
+    uint64_t segmentSize;
+    /// period of the group commit
+    int flushIntervalMs;
+    /// number of pending records that triggers a group commit right away
+    uint64_t groupCommitRecords;
+
+    /// lock used when accessing the buffer and the sequence numbers
+    std::mutex bufferMtx;
+    /// used to wake up the writer when enough records are pending
+    std::condition_variable bufferCv;
+    /// used to wake up the threads waiting for their records to be durable
+    std::condition_variable durableCv;
+    /// records waiting to be written
+    std::string buffer;
+    /// number of records in #buffer
+    uint64_t pendingRecords;
+    /// sequence number of the next record
+    uint64_t nextLsn;
+    /// all the records up to this sequence number are on the disk
+    uint64_t durableLsn;
+    /// true, if the last group commit failed (its records are still pending)
+    bool failed;
+    /// indication of whether or not the writer should keep running
+    bool running;
+    /// statistics of the journal
+    Stats_t stats;
+    /// the background writer
+    std::thread writer;
+
+    /// file descriptor of the current segment (-1 if none)
+    int fd;
+    /// number of the current segment
+    uint32_t segmentNumber;
+    /// number of bytes written into the current segment
+    uint64_t segmentOffset;
+
+    /// counter used to generate ids of games
+    std::atomic<uint64_t> gameIdCounter;
+
+private:
+    /// The body of the background writer (group commit)
+    void writerHandler();
+
+    /// Writes a batch of records into the current segment
+    /// (a new segment is created if it does not fit in)
+    /// and makes it durable
+    /// \param batch the records
+    /// \return true, if the records are on the disk. Otherwise, false.
+    bool writeBatch(const std::string &batch);
+
+    /// Closes the current segment and creates a new one
+    /// \return true, if the segment has been created. Otherwise, false.
+    bool rollSegment();
+
+    /// Computes the checksum of the record given as a parameter (FNV-1a)
+    /// \param header header of the record
+    /// \param payload payload of the record
+    /// \param size size of the payload
+    /// \return checksum of the record
+    static uint32_t checksum(const RecordHeader_t &header, const char *payload, size_t size);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// Nothing is written until the journal is opened (see #open).
+    ///
+    /// \param dir directory of the segments
+    /// \param segmentSize size of a segment
+    /// \param flushIntervalMs period of the group commit
+    /// \param groupCommitRecords number of pending records that triggers a group commit right away
+    explicit Journal(std::string dir = DEFAULT_DIR, uint64_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                     int flushIntervalMs = DEFAULT_FLUSH_INTERVAL_MS, int groupCommitRecords = DEFAULT_GROUP_COMMIT_RECORDS);
+
+    /// Destructor of the class - flushes all the pending records (see #close)
+    ~Journal();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Journal(const Journal&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Journal&) = delete;
+
+    /// Opens the journal - creates a new segment following the existing
+    /// ones (the sequence numbers continue where they stopped)
+    /// and starts the background writer
+    /// \return true, if the journal has been opened. Otherwise, false.
+    bool open();
+
+    /// Writes all the pending records, stops the background
+    /// writer and closes the current segment
+    void close();
+
+    /// Checks if the journal is open
+    /// \return true, if records are being written. Otherwise, false.
+    bool isOpen();
+
+    /// Adds a record into the journal. The method does not wait
+    /// for the record to be written (see #waitDurable).
+    /// \param type type of the event
+    /// \param gameId id of the game (see #nextGameId)
+    /// \param payload payload of the event (at most #MAX_PAYLOAD_SIZE bytes)
+    /// \return sequence number of the record, 0 if the journal is not open
+    uint64_t append(Event type, uint64_t gameId, const std::string &payload);
+
+    /// Waits until the record with the sequence number given
+    /// as a parameter (and all the ones before it) is on the disk
+    /// \param lsn sequence number of the record
+    /// \return true, if the record is on the disk. false, if writing
+    /// it failed (it is being retried) or the journal was closed.
+    bool waitDurable(uint64_t lsn);
+
+    /// Returns the sequence number of the last record that is on the disk
+    /// \return sequence number of the last durable record
+    uint64_t getDurableLsn();
+
+    /// Returns the sequence number of the last record appended
+    /// (it does not have to be on the disk yet)
+    /// \return sequence number of the last record, 0 if there is none
+    uint64_t getLastLsn();
+
+    /// Returns the statistics of the journal
+    /// \return statistics of the journal
+    Stats_t getStats();
+
+    /// Generates a new id of a game. The ids are unique
+    /// across restarts of the server (they start at the current time).
+    /// \return id of a game
+    uint64_t nextGameId();
+
+    /// Returns the paths to all the segments of the journal in the directory
+    /// given as a parameter in the order they were written
+    /// \param dir directory of the journal
+    /// \return paths to the segments
+    static std::vector<std::string> listSegments(const std::string &dir);
+
+    /// Reads all the records of a segment
+    /// \param path path to the segment
+    /// \param callback function called for every record (header and payload)
+    /// \return false, if the segment cannot be read. Otherwise, true.
+    static bool readSegment(const std::string &path, const std::function<void(const RecordHeader_t&, const std::string&)> &callback);
+};
+
+#endif
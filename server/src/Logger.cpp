@@ -1,45 +1,500 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
 #include "Logger.h"
 
-Logger *Logger::instance = NULL;
+const std::string Logger::BINARY_MAGIC = "C4LOG001";
+const std::string Logger::BINARY_FILE_TYPE = ".bin";
+std::atomic<bool> Logger::disabled[Logger::TYPES];
+thread_local Logger::ThreadRing_t Logger::threadRing;
+
+Logger::ThreadRing_t::~ThreadRing_t() {
+    if (ring != NULL)
+        ring->abandoned.store(true, std::memory_order_release);
+}
+
+/// Writes all the pending messages when the program exits
+static void stopLogger() {
+    Logger::getInstance()->stop();
+}
 
 Logger *Logger::getInstance() {
-    if (instance == NULL)
-        instance = new Logger;
+    // the initialization of a local static variable is thread-safe
+    static Logger *instance = []() {
+        Logger *logger = new Logger;
+        atexit(stopLogger);
+        return logger;
+    }();
     return instance;
 }
 
+void Logger::setEnabled(Type type, bool enabled) {
+    disabled[type].store(!enabled, std::memory_order_relaxed);
+}
+
+void Logger::setMinLevel(int level) {
+    for (int type = 0; type < TYPES; type++)
+        setEnabled((Type)type, getLevel((Type)type) >= level);
+}
+
+int Logger::getLevel(Type type) {
+    switch (type) {
+        case ERROR:     return LOG_LEVEL_ERROR;
+        case INFO:      return LOG_LEVEL_INFO;
+        case COUNTDOWN: return LOG_LEVEL_COUNTDOWN;
+        case BOOTING:   return LOG_LEVEL_BOOTING;
+        case WARNING:   return LOG_LEVEL_WARNING;
+        case GAME:      return LOG_LEVEL_GAME;
+        case MSG:       return LOG_LEVEL_MSG;
+    }
+    return LOG_LEVEL_ERROR;
+}
+
 Logger::Logger() {
     logFileName = getCurrentDateTime();
     // creates a folder 'log' where
     // all the log files will be stored
     mkdir(logDirectory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    std::string file = logDirectory + "/" + logFileName + logFileType;
+    fd = open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0)
+        std::cerr << "the log file " << file << " cannot be opened: " << std::strerror(errno) << std::endl;
+
+    for (int i = 0; i < TYPES; i++)
+        overflow[i] = BLOCK;
+    // a countdown is logged every second, losing some of them does not matter
+    overflow[COUNTDOWN] = DROP;
+    rounds = 0;
+    dropped = 0;
+    reportedDrops = 0;
+    blocked = 0;
+    written = 0;
+    batches = 0;
+    textBytes = 0;
+    binaryBytes = 0;
+    cachedSecond = -1;
+    binaryFd = -1;
+    sinks = TEXT;
+    formatCount = 0;
+    formatsStored = 0;
+    realTimeAnchor = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    monotonicAnchor = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    running = true;
+    writer = std::thread(&Logger::writerHandler, this);
+}
+
+Logger::Ring_t *Logger::getRing() {
+    if (threadRing.ring == NULL) {
+        std::unique_ptr<Ring_t> ring(new Ring_t);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->abandoned = false;
+        ring->thread = (uint32_t)syscall(SYS_gettid);
+        threadRing.ring = ring.get();
+        ringsMtx.lock();
+        rings.push_back(std::move(ring));
+        ringsMtx.unlock();
+    }
+    return threadRing.ring;
 }
 
 void Logger::log(int lineNumber, Type type, std::string msg) {
-    // attaches the appropriate color to
-    // the message given as a parameter by its type
+    Entry_t *entry = reserve(lineNumber, type);
+    if (entry == NULL)
+        return;
+    entry->format = 0;
+    entry->msg = std::move(msg);
+    commit();
+}
+
+Logger::Entry_t *Logger::reserve(int lineNumber, Type type) {
+    Ring_t *ring = getRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    bool direct = !running.load(std::memory_order_acquire);
+
+    if (!direct && head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        if (overflow[type] == DROP) {
+            dropped++;
+            return NULL;
+        }
+        blocked++;
+        while (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY && running) {
+            writerCv.notify_one();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        direct = !running;
+    }
+    // the writer has stopped - the message is written right away (see #commit)
+    if (direct) {
+        batchMtx.lock();
+        if (ring->head - ring->tail >= RING_CAPACITY)
+            writeBatch();
+    }
+    threadRing.direct = direct;
+
+    Entry_t *entry = &ring->entries[head & (RING_CAPACITY - 1)];
+    entry->time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    entry->lineNumber = lineNumber;
+    entry->type = type;
+    entry->thread = ring->thread;
+    entry->size = 0;
+    return entry;
+}
+
+void Logger::commit() {
+    Ring_t *ring = threadRing.ring;
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+    if (threadRing.direct) {
+        writeBatch();
+        batchMtx.unlock();
+        return;
+    }
+    // the writer is woken up before the ring gets full
+    if (head + 1 - ring->tail.load(std::memory_order_relaxed) == RING_CAPACITY / 2)
+        writerCv.notify_one();
+}
+
+uint16_t Logger::registerFormat(int lineNumber, Type type, const char *text) {
+    Logger *logger = getInstance();
+    logger->formatsMtx.lock();
+    size_t count = logger->formatCount.load(std::memory_order_relaxed);
+    uint16_t id = 0;
+    if (count < MAX_FORMATS) {
+        logger->formats[count] = {lineNumber, type, text};
+        logger->formatCount.store(count + 1, std::memory_order_release);
+        id = (uint16_t)(count + 1);
+    }
+    logger->formatsMtx.unlock();
+    return id;
+}
+
+void Logger::encodeInt(Entry_t &entry, int64_t value) {
+    if (entry.size + 1 + sizeof(value) > ARGS_CAPACITY) {
+        entry.truncated = true;
+        return;
+    }
+    entry.args[entry.size++] = 'i';
+    memcpy(entry.args + entry.size, &value, sizeof(value));
+    entry.size += sizeof(value);
+}
+
+void Logger::encodeString(Entry_t &entry, const char *data, size_t size) {
+    if (entry.size + 1 + sizeof(uint16_t) + size > ARGS_CAPACITY) {
+        entry.truncated = true;
+        return;
+    }
+    uint16_t length = (uint16_t)size;
+    entry.args[entry.size++] = 's';
+    memcpy(entry.args + entry.size, &length, sizeof(length));
+    entry.size += sizeof(length);
+    memcpy(entry.args + entry.size, data, length);
+    entry.size += length;
+}
+
+bool Logger::decodeArgs(const char *data, size_t size, std::vector<Arg_t> &args) {
+    size_t offset = 0;
+    while (offset < size) {
+        Arg_t arg;
+        arg.value = 0;
+        char tag = data[offset++];
+        if (tag == 'i' && offset + sizeof(int64_t) <= size) {
+            arg.isString = false;
+            memcpy(&arg.value, data + offset, sizeof(int64_t));
+            offset += sizeof(int64_t);
+        }
+        else if (tag == 's' && offset + sizeof(uint16_t) <= size) {
+            uint16_t length;
+            memcpy(&length, data + offset, sizeof(length));
+            offset += sizeof(length);
+            if (offset + length > size)
+                return false;
+            arg.isString = true;
+            arg.text.assign(data + offset, length);
+            offset += length;
+        }
+        else return false;
+        args.push_back(std::move(arg));
+    }
+    return true;
+}
+
+std::string Logger::render(const char *format, const char *data, size_t size) {
+    std::vector<Arg_t> args;
+    decodeArgs(data, size, args);
+    std::vector<std::string> values;
+    for (const Arg_t &arg : args)
+        values.push_back(arg.isString ? arg.text : std::to_string(arg.value));
+    return render(format, values);
+}
+
+std::string Logger::render(const char *format, const std::vector<std::string> &values) {
+    std::string msg;
+    size_t next = 0;
+    for (const char *c = format; *c != '\0'; c++) {
+        if (c[0] == '{' && c[1] == '}' && next < values.size()) {
+            msg += values[next++];
+            c++;
+        }
+        else msg += *c;
+    }
+    for (; next < values.size(); next++) {
+        if (!msg.empty())
+            msg += ' ';
+        msg += values[next];
+    }
+    return msg;
+}
+
+const char *Logger::getTypeName(Type type) {
     switch (type) {
-        case ERROR:     log(lineNumber, "ERROR_LOG", RED, msg);        break;
-        case INFO:      log(lineNumber, "INFO_LOG", GREEN, msg);       break;
-        case COUNTDOWN: log(lineNumber, "COUNTDOWN_LOG", CYAN, msg);   break;
-        case BOOTING:   log(lineNumber, "BOOTING_LOG", MAGENTA, msg);  break;
-        case WARNING:   log(lineNumber, "WARNING_LOG", YELLOW, msg);   break;
-        case GAME:      log(lineNumber, "GAME_LOG", WHITE, msg);       break;
-        case MSG:       log(lineNumber, "MSG_LOG", BLUE, msg);         break;
+        case ERROR:     return "ERROR_LOG";
+        case INFO:      return "INFO_LOG";
+        case COUNTDOWN: return "COUNTDOWN_LOG";
+        case BOOTING:   return "BOOTING_LOG";
+        case WARNING:   return "WARNING_LOG";
+        case GAME:      return "GAME_LOG";
+        case MSG:       return "MSG_LOG";
+    }
+    return "";
+}
+
+void Logger::setSinks(int sinks) {
+    this->sinks = sinks;
+}
+
+void Logger::setOverflow(Type type, Overflow policy) {
+    overflow[type] = policy;
+}
+
+void Logger::writerHandler() {
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(writerMtx);
+            writerCv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        }
+        bool stop = !running.load(std::memory_order_acquire);
+        batchMtx.lock();
+        writeBatch();
+        batchMtx.unlock();
+
+        writerMtx.lock();
+        rounds++;
+        writerMtx.unlock();
+        flushedCv.notify_all();
+        if (stop)
+            return;
+    }
+}
+
+size_t Logger::writeBatch() {
+    std::vector<Ring_t *> current;
+    ringsMtx.lock();
+    // the rings of the threads that have finished are freed once they are empty
+    rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::unique_ptr<Ring_t> &ring) {
+        return ring->abandoned.load(std::memory_order_acquire) &&
+               ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+    }), rings.end());
+    for (auto &ring : rings)
+        current.push_back(ring.get());
+    ringsMtx.unlock();
+
+    // the messages are taken out of the rings and put in the order they were logged
+    std::vector<Entry_t> entries;
+    for (Ring_t *ring : current) {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++)
+            entries.push_back(std::move(ring->entries[tail & (RING_CAPACITY - 1)]));
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    uint64_t drops = dropped;
+    if (entries.empty() && drops == reportedDrops)
+        return 0;
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry_t &a, const Entry_t &b) {
+        return a.time < b.time;
+    });
+    if (drops != reportedDrops) {
+        Entry_t entry;
+        entry.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        entry.lineNumber = __LINE__;
+        entry.type = WARNING;
+        entry.thread = (uint32_t)syscall(SYS_gettid);
+        entry.format = 0;
+        entry.size = 0;
+        entry.msg = std::to_string(drops - reportedDrops) + " log messages have been dropped";
+        entries.push_back(std::move(entry));
+        reportedDrops = drops;
+    }
+
+    int targets = sinks;
+    if (targets & BINARY) {
+        std::string binary;
+        for (const Entry_t &entry : entries)
+            store(entry, binary);
+        if (openBinary()) {
+            writeAll(binaryFd, binary);
+            binaryBytes += binary.size();
+        }
+    }
+    if (targets & TEXT) {
+        std::string terminal, file;
+        for (Entry_t &entry : entries) {
+            // the structured messages are put together only now
+            if (entry.format != 0)
+                entry.msg = render(formats[entry.format - 1].text, entry.args, entry.size);
+            format(entry, terminal, file);
+        }
+        writeAll(STDOUT_FILENO, terminal);
+        if (fd >= 0) {
+            writeAll(fd, file);
+            textBytes += file.size();
+        }
     }
+    written += entries.size();
+    batches++;
+    return entries.size();
 }
 
-void Logger::log(int lineNumber, std::string type, std::string color, std::string msg) {
-    // prints out the message
-    std::stringstream  ss;
-    ss << "[#" << lineNumber << "]";
-    ss << "[" << getCurrentDateTime() << "]";
-    ss << "[" << type << "]";
-    ss << " " << msg;
-    std::cout << color << ss.str() << RESET << std::endl;
+void Logger::store(const Entry_t &entry, std::string &binary) {
+    BinaryRecord_t record;
+    // the formats registered since the last batch are stored before the messages using them
+    size_t count = formatCount.load(std::memory_order_acquire);
+    for (; formatsStored < count; formatsStored++) {
+        const Format_t &format = formats[formatsStored];
+        memset(&record, 0, sizeof(record));
+        record.kind = FORMAT_RECORD;
+        record.type = (uint8_t)format.type;
+        record.format = (uint16_t)(formatsStored + 1);
+        record.line = (uint32_t)format.lineNumber;
+        record.size = (uint32_t)strlen(format.text);
+        binary.append((const char *)&record, sizeof(record));
+        binary.append(format.text, record.size);
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.kind = MESSAGE_RECORD;
+    record.type = (uint8_t)entry.type;
+    record.format = entry.format;
+    record.line = (uint32_t)entry.lineNumber;
+    record.thread = entry.thread;
+    record.time = entry.time;
+    if (entry.format != 0) {
+        record.size = entry.size;
+        binary.append((const char *)&record, sizeof(record));
+        binary.append(entry.args, entry.size);
+        return;
+    }
+    // a plain message is stored as a single string argument
+    uint16_t length = (uint16_t)std::min<size_t>(entry.msg.size(), UINT16_MAX);
+    record.size = 1 + sizeof(length) + length;
+    binary.append((const char *)&record, sizeof(record));
+    binary += 's';
+    binary.append((const char *)&length, sizeof(length));
+    binary.append(entry.msg, 0, length);
+}
+
+bool Logger::openBinary() {
+    if (binaryFd >= 0)
+        return true;
+    std::string file = logDirectory + "/" + logFileName + BINARY_FILE_TYPE;
+    binaryFd = open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (binaryFd < 0)
+        return false;
+    BinaryHeader_t header;
+    memcpy(header.magic, BINARY_MAGIC.data(), sizeof(header.magic));
+    header.realTime = realTimeAnchor;
+    header.monotonic = monotonicAnchor;
+    writeAll(binaryFd, std::string((const char *)&header, sizeof(header)));
+    return true;
+}
 
-    // appends it to the end of the file
-    addToLogFile(ss.str());
+void Logger::format(const Entry_t &entry, std::string &terminal, std::string &file) {
+    // the timestamp is formatted only once per second
+    int64_t second = (realTimeAnchor + entry.time - monotonicAnchor) / 1000000000;
+    if (second != cachedSecond) {
+        time_t current_time = (time_t)second;
+        struct tm time_info;
+        char buffer[80];
+        localtime_r(&current_time, &time_info);
+        strftime(buffer, sizeof(buffer), "%d-%m-%Y_%H-%M-%S", &time_info);
+        cachedTime = buffer;
+        cachedSecond = second;
+    }
+    const char *type = getTypeName(entry.type);
+    const std::string *color = &RESET;
+    switch (entry.type) {
+        case ERROR:     color = &RED;     break;
+        case INFO:      color = &GREEN;   break;
+        case COUNTDOWN: color = &CYAN;    break;
+        case BOOTING:   color = &MAGENTA; break;
+        case WARNING:   color = &YELLOW;  break;
+        case GAME:      color = &WHITE;   break;
+        case MSG:       color = &BLUE;    break;
+    }
+    size_t start = file.size();
+    file += "[#";
+    file += std::to_string(entry.lineNumber);
+    file += "][";
+    file += cachedTime;
+    file += "][";
+    file += type;
+    file += "] ";
+    file += entry.msg;
+    terminal += *color;
+    terminal.append(file, start, std::string::npos);
+    terminal += RESET;
+    terminal += '\n';
+    file += '\n';
+}
+
+void Logger::writeAll(int fd, const std::string &data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n = write(fd, data.data() + offset, data.size() - offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        offset += (size_t)n;
+    }
+}
+
+void Logger::flush() {
+    if (!running)
+        return;
+    std::unique_lock<std::mutex> lock(writerMtx);
+    // the current round may have started before the messages were logged
+    uint64_t target = rounds + 2;
+    writerCv.notify_one();
+    flushedCv.wait(lock, [&]() { return rounds >= target || !running; });
+}
+
+void Logger::stop() {
+    if (!running.exchange(false))
+        return;
+    writerCv.notify_one();
+    writer.join();
+    flushedCv.notify_all();
+}
+
+Logger::Stats_t Logger::getStats() {
+    Stats_t stats;
+    stats.written = written;
+    stats.dropped = dropped;
+    stats.blocked = blocked;
+    stats.batches = batches;
+    stats.textBytes = textBytes;
+    stats.binaryBytes = binaryBytes;
+    ringsMtx.lock();
+    stats.rings = rings.size();
+    ringsMtx.unlock();
+    return stats;
 }
 
 std::string Logger::getCurrentDateTime() const {
@@ -54,17 +509,6 @@ std::string Logger::getCurrentDateTime() const {
     return std::string(buffer);
 }
 
-void Logger::addToLogFile(std::string log) const {
-    std::ofstream logFile;
-    std::string file = logDirectory + "/" + logFileName + logFileType;
-    logFile.open(file, std::ios::out | std::ios::app);
-    if (logFile.fail())
-        throw std::ios_base::failure(std::strerror(errno));
-    logFile.exceptions(logFile.exceptions() | std::ios::failbit | std::ifstream::badbit);
-    logFile << log << std::endl;
-    logFile.close();
-}
-
 void Logger::testAllTypes() {
     LOG_ERR("This is an error message");
     LOG_INFO("This is an info message");
@@ -73,4 +517,4 @@ void Logger::testAllTypes() {
     LOG_WARNING("This is a warning message");
     LOG_GAME("This is a game message");
     LOG_MSG("This is a received message");
-}
\ No newline at end of file
+}
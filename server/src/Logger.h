@@ -6,22 +6,119 @@
 #include <fstream>
 #include <cstring>
 #include <ctime>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
 #include <sys/stat.h>
 
+/// the messages of a level below this one are stripped at compile time
+/// (they are neither evaluated nor logged), for example make LOG_MIN_LEVEL=2
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+/// level of the countdown messages (the least important ones)
+#define LOG_LEVEL_COUNTDOWN 0
+/// level of the "msg from a client" messages
+#define LOG_LEVEL_MSG       1
+/// level of the game messages
+#define LOG_LEVEL_GAME      2
+/// level of the info messages
+#define LOG_LEVEL_INFO      3
+/// level of the warning messages
+#define LOG_LEVEL_WARNING   4
+/// level of the booting messages
+#define LOG_LEVEL_BOOTING   5
+/// level of the error messages (the most important ones)
+#define LOG_LEVEL_ERROR     6
+
+/// logs a message if its type is enabled (the message is not evaluated otherwise)
+#define LOG_IF_ENABLED(type, msg) do { if (Logger::isEnabled(type)) Logger::getInstance()->log(__LINE__, (type), (msg)); } while (0)
+/// a message stripped at compile time (it is still compiled, but never evaluated)
+#define LOG_STRIPPED(type, msg)   do { if (0) Logger::getInstance()->log(__LINE__, (type), (msg)); } while (0)
+/// logs a structured message if its type is enabled - the format is registered
+/// once per call site and the arguments are only copied (see #Logger::logEvent)
+#define LOG_EVENT_IF_ENABLED(type, fmt, ...) do { if (Logger::isEnabled(type)) { \
+    static const uint16_t logFormat = Logger::registerFormat(__LINE__, (type), (fmt)); \
+    Logger::getInstance()->logEvent(__LINE__, (type), logFormat, __VA_ARGS__); } } while (0)
+/// a structured message stripped at compile time
+#define LOG_EVENT_STRIPPED(type, fmt, ...) do { if (0) Logger::getInstance()->logEvent(__LINE__, (type), 0, __VA_ARGS__); } while (0)
+
+#if LOG_LEVEL_ERROR >= LOG_MIN_LEVEL
 /// logs error message
-#define LOG_ERR(msg)       (Logger::getInstance()->log(__LINE__, Logger::ERROR,     (msg)))
+#define LOG_ERR(msg)       LOG_IF_ENABLED(Logger::ERROR,     msg)
+/// logs error message (a format with {} replaced by the arguments)
+#define LOG_ERR_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::ERROR, fmt, __VA_ARGS__)
+#else
+#define LOG_ERR(msg)       LOG_STRIPPED(Logger::ERROR,       msg)
+#define LOG_ERR_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::ERROR, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_INFO >= LOG_MIN_LEVEL
 /// logs info message
-#define LOG_INFO(msg)      (Logger::getInstance()->log(__LINE__, Logger::INFO,      (msg)))
+#define LOG_INFO(msg)      LOG_IF_ENABLED(Logger::INFO,      msg)
+/// logs info message (a format with {} replaced by the arguments)
+#define LOG_INFO_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::INFO, fmt, __VA_ARGS__)
+#else
+#define LOG_INFO(msg)      LOG_STRIPPED(Logger::INFO,        msg)
+#define LOG_INFO_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::INFO, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_COUNTDOWN >= LOG_MIN_LEVEL
 /// logs countdown message
-#define LOG_COUNTDOWN(msg) (Logger::getInstance()->log(__LINE__, Logger::COUNTDOWN, (msg)))
+#define LOG_COUNTDOWN(msg) LOG_IF_ENABLED(Logger::COUNTDOWN, msg)
+/// logs countdown message (a format with {} replaced by the arguments)
+#define LOG_COUNTDOWN_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::COUNTDOWN, fmt, __VA_ARGS__)
+#else
+#define LOG_COUNTDOWN(msg) LOG_STRIPPED(Logger::COUNTDOWN,   msg)
+#define LOG_COUNTDOWN_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::COUNTDOWN, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_BOOTING >= LOG_MIN_LEVEL
 /// logs booting message
-#define LOG_BOOTING(msg)   (Logger::getInstance()->log(__LINE__, Logger::BOOTING,   (msg)))
+#define LOG_BOOTING(msg)   LOG_IF_ENABLED(Logger::BOOTING,   msg)
+/// logs booting message (a format with {} replaced by the arguments)
+#define LOG_BOOTING_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::BOOTING, fmt, __VA_ARGS__)
+#else
+#define LOG_BOOTING(msg)   LOG_STRIPPED(Logger::BOOTING,     msg)
+#define LOG_BOOTING_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::BOOTING, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_WARNING >= LOG_MIN_LEVEL
 /// logs warning message
-#define LOG_WARNING(msg)   (Logger::getInstance()->log(__LINE__, Logger::WARNING,   (msg)))
+#define LOG_WARNING(msg)   LOG_IF_ENABLED(Logger::WARNING,   msg)
+/// logs warning message (a format with {} replaced by the arguments)
+#define LOG_WARNING_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::WARNING, fmt, __VA_ARGS__)
+#else
+#define LOG_WARNING(msg)   LOG_STRIPPED(Logger::WARNING,     msg)
+#define LOG_WARNING_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::WARNING, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_GAME >= LOG_MIN_LEVEL
 /// logs game message
-#define LOG_GAME(msg)      (Logger::getInstance()->log(__LINE__, Logger::GAME,      (msg)))
+#define LOG_GAME(msg)      LOG_IF_ENABLED(Logger::GAME,      msg)
+/// logs game message (a format with {} replaced by the arguments)
+#define LOG_GAME_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::GAME, fmt, __VA_ARGS__)
+#else
+#define LOG_GAME(msg)      LOG_STRIPPED(Logger::GAME,        msg)
+#define LOG_GAME_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::GAME, fmt, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL_MSG >= LOG_MIN_LEVEL
 /// logs "msg from a client" message
-#define LOG_MSG(msg)       (Logger::getInstance()->log(__LINE__, Logger::MSG,       (msg)))
+#define LOG_MSG(msg)       LOG_IF_ENABLED(Logger::MSG,       msg)
+/// logs "msg from a client" message (a format with {} replaced by the arguments)
+#define LOG_MSG_F(fmt, ...) LOG_EVENT_IF_ENABLED(Logger::MSG, fmt, __VA_ARGS__)
+#else
+#define LOG_MSG(msg)       LOG_STRIPPED(Logger::MSG,         msg)
+#define LOG_MSG_F(fmt, ...) LOG_EVENT_STRIPPED(Logger::MSG, fmt, __VA_ARGS__)
+#endif
 
 /// \author silhavyj A17B0362P
 ///
@@ -34,6 +131,39 @@
 /// This class also stores everything the is printed out
 /// into a file named with the datetime when the server
 /// was run. This class is written as a singleton.
+///
+/// Logging a message does not format or write anything. Every thread
+/// that logs gets its own ring buffer of #RING_CAPACITY messages (one
+/// producer, one consumer, no locks) and the message is only moved into
+/// it. A background writer drains all the rings every #FLUSH_INTERVAL_MS
+/// milliseconds (or sooner once a ring is half full), formats the messages
+/// in the order they were logged and writes them into the terminal and
+/// the log file with one write call each (the log file stays open). The
+/// timestamp string is formatted once per second.
+///
+/// When the ring of a thread is full, the message is either dropped
+/// (counted, the writer reports the number of dropped messages) or the
+/// thread waits for the writer, depending on the #Overflow policy of the
+/// type of the message (see #setOverflow).
+///
+/// Every type of messages can be disabled at runtime (see #setEnabled and
+/// #setMinLevel); the LOG_ macros check it before the message is evaluated,
+/// so a disabled message costs one relaxed atomic load. The types below
+/// #LOG_MIN_LEVEL are stripped at compile time.
+///
+/// The structured messages (the LOG_X_F macros) are not even put together
+/// by the thread logging them. The call site registers its format once
+/// (e.g. "waiting for client {} ({}s)") and every message holds only the id
+/// of the format and the typed arguments (integers, strings). The writer
+/// renders them into the text log and/or stores them into a binary log
+/// (see #Sink), which keeps the line, type, thread and monotonic time of
+/// every message and is turned back into text or JSON by the logdecode tool.
+///
+/// The binary log (log/datetime.bin) starts with #BinaryHeader_t followed by
+/// records, each a #BinaryRecord_t and #BinaryRecord_t::size bytes: a format
+/// (its text) is stored before the first message using it, a message holds
+/// its arguments ('i' and an int64_t, or 's', a uint16_t length and the bytes;
+/// the plain messages have one string argument and format 0 - "{}").
 class Logger {
 public:
     /// reset color used when printing out into the terminal
@@ -55,6 +185,57 @@ public:
     /// white color used when printing out into the terminal
     const std::string WHITE   = "\033[37m";
 
+    /// number of messages the ring of one thread can hold (power of two)
+    static const uint64_t RING_CAPACITY = 256;
+    /// amount of milliseconds between two batches written by the writer
+    static const int FLUSH_INTERVAL_MS = 20;
+    /// the most bytes of the arguments of a structured message
+    /// (a message with longer ones is put together by the thread logging it)
+    static const size_t ARGS_CAPACITY = 96;
+    /// the most formats of structured messages (call sites)
+    static const size_t MAX_FORMATS = 1024;
+    /// magic number at the beginning of a binary log
+    static const std::string BINARY_MAGIC;
+    /// type of a binary log file
+    static const std::string BINARY_FILE_TYPE;
+
+    /// Where the messages are written (a combination of the flags)
+    enum Sink {
+        TEXT = 1,  ///< the terminal and the text log file
+        BINARY = 2 ///< the binary log file
+    };
+
+    /// Kind of a record of the binary log
+    enum RecordKind {
+        FORMAT_RECORD = 'F', ///< a format of structured messages
+        MESSAGE_RECORD = 'M' ///< a message
+    };
+
+    /// Header of a binary log
+    struct BinaryHeader_t {
+        char magic[8];     ///< #BINARY_MAGIC
+        int64_t realTime;  ///< time of the real-time clock (ns since the epoch) when the log was created
+        int64_t monotonic; ///< time of the monotonic clock (ns) at the same moment
+    };
+
+    /// Header of a record of the binary log
+    struct BinaryRecord_t {
+        uint8_t kind;    ///< kind of the record (#RecordKind)
+        uint8_t type;    ///< type of the message (#Type)
+        uint16_t format; ///< id of the format (0 - a plain message)
+        uint32_t line;   ///< number of the line from which the message was logged
+        uint32_t thread; ///< id of the thread that logged the message
+        uint32_t size;   ///< number of bytes following the header (the arguments, the text of a format)
+        int64_t time;    ///< when the message was logged (ns of the monotonic clock)
+    };
+
+    /// One argument of a structured message
+    struct Arg_t {
+        bool isString;    ///< true, if it is a string
+        int64_t value;    ///< the value of an integer
+        std::string text; ///< the value of a string
+    };
+
     /// Type of a logged message
     enum Type {
         ERROR,     ///< error message (for example, when a client attempts to log with a nick that's already taken)
@@ -65,17 +246,138 @@ public:
         GAME,      ///< game message (when two clients play a game)
         MSG        ///< "msg" message (when a client sends a message to the server)
     };
+    /// number of types of messages
+    static const int TYPES = MSG + 1;
+
+    /// What happens to a message when the ring of the thread is full
+    enum Overflow {
+        BLOCK, ///< the thread waits until the writer makes room
+        DROP   ///< the message is dropped (and counted)
+    };
+
+    /// Statistics of the logger
+    struct Stats_t {
+        uint64_t written;     ///< number of messages written
+        uint64_t dropped;     ///< number of messages dropped (the ring was full)
+        uint64_t blocked;     ///< number of times a thread had to wait for the writer
+        uint64_t batches;     ///< number of batches written
+        uint64_t rings;       ///< number of rings (threads that have logged and are still running)
+        uint64_t textBytes;   ///< number of bytes written into the text log file
+        uint64_t binaryBytes; ///< number of bytes written into the binary log
+    };
 
 private:
+    /// One logged message
+    struct Entry_t {
+        int64_t time;             ///< when it was logged (ns of the monotonic clock)
+        int lineNumber;           ///< number of the line from which it was logged
+        Type type;                ///< type of the message
+        uint32_t thread;          ///< id of the thread that logged it
+        uint16_t format;          ///< id of the format of a structured message (0 - a plain message)
+        uint16_t size;            ///< number of bytes of the arguments
+        bool truncated;           ///< the arguments did not fit in
+        char args[ARGS_CAPACITY]; ///< the arguments of a structured message
+        std::string msg;          ///< the plain message (the rendered one, once taken out of the ring)
+    };
+
+    /// Format of structured messages (one call site)
+    struct Format_t {
+        int lineNumber;   ///< number of the line of the call site
+        Type type;        ///< type of the messages
+        const char *text; ///< the format itself ({} is replaced by an argument)
+    };
+
+    /// Ring of the messages of one thread
+    struct Ring_t {
+        Entry_t entries[RING_CAPACITY];  ///< the messages
+        std::atomic<uint64_t> head;      ///< number of messages put in (written by the thread)
+        std::atomic<uint64_t> tail;      ///< number of messages taken out (written by the writer)
+        std::atomic<bool> abandoned;     ///< the thread has finished (the ring is freed once it is empty)
+        uint32_t thread;                 ///< id of the thread (as given by the kernel)
+    };
+
+    /// Ring of the calling thread (it is abandoned when the thread finishes)
+    struct ThreadRing_t {
+        Ring_t *ring = NULL; ///< the ring (NULL until the thread logs for the first time)
+        bool direct = false; ///< the message being logged is written right away (the writer has stopped)
+
+        /// Destructor of the structure - abandons the ring
+        ~ThreadRing_t();
+    };
+
     /// directory where all the log files are stored
     const std::string logDirectory = "log";
     /// type of a log file
     const std::string logFileType  = ".txt";
 
-    /// the instance of the class
-    static Logger* instance;
+    /// indication of whether or not every type of messages is disabled
+    /// (zero-initialized before any code runs, so everything is enabled at first)
+    static std::atomic<bool> disabled[TYPES];
+    /// ring of the calling thread
+    static thread_local ThreadRing_t threadRing;
     /// the name of the log file (current datetime)
     std::string logFileName;
+    /// file descriptor of the log file (-1 if it could not be opened)
+    int fd;
+    /// file descriptor of the binary log (-1 until it is needed)
+    int binaryFd;
+    /// where the messages are written (#Sink)
+    std::atomic<int> sinks;
+    /// time of the real-time clock (ns since the epoch) when the logger was created
+    int64_t realTimeAnchor;
+    /// time of the monotonic clock (ns) at the same moment
+    int64_t monotonicAnchor;
+
+    /// lock used when registering a format
+    std::mutex formatsMtx;
+    /// the formats of structured messages (the id of a format is its index + 1)
+    Format_t formats[MAX_FORMATS];
+    /// number of formats registered
+    std::atomic<size_t> formatCount;
+    /// number of formats stored into the binary log (locked by #batchMtx)
+    size_t formatsStored;
+
+    /// lock used when accessing the rings
+    std::mutex ringsMtx;
+    /// rings of all the threads that have logged
+    std::vector<std::unique_ptr<Ring_t>> rings;
+    /// lock used by the writer when waiting
+    std::mutex writerMtx;
+    /// used to wake up the writer
+    std::condition_variable writerCv;
+    /// used to wake up the threads waiting for a batch to be written (see #flush)
+    std::condition_variable flushedCv;
+    /// number of batches written (locked by #writerMtx)
+    uint64_t rounds;
+    /// indication of whether or not the writer should keep running
+    std::atomic<bool> running;
+    /// the background writer
+    std::thread writer;
+    /// lock used when taking the messages out of the rings (there is only one consumer
+    /// at a time - the writer or a thread logging after the writer has stopped)
+    std::mutex batchMtx;
+
+    /// overflow policy of every type of messages
+    std::atomic<int> overflow[TYPES];
+    /// number of messages dropped
+    std::atomic<uint64_t> dropped;
+    /// number of dropped messages reported by the writer so far
+    uint64_t reportedDrops;
+    /// number of times a thread had to wait for the writer
+    std::atomic<uint64_t> blocked;
+    /// number of messages written
+    std::atomic<uint64_t> written;
+    /// number of batches written
+    std::atomic<uint64_t> batches;
+    /// number of bytes written into the text log file
+    std::atomic<uint64_t> textBytes;
+    /// number of bytes written into the binary log
+    std::atomic<uint64_t> binaryBytes;
+
+    /// second of the cached timestamp (locked by #batchMtx)
+    int64_t cachedSecond;
+    /// the cached timestamp (formatted #cachedSecond)
+    std::string cachedTime;
 
 public:
     /// Copy constructor of the class.
@@ -88,11 +390,34 @@ public:
     /// within this project.
     void operator=(Logger const &) = delete;
 
-    /// Returns the instance of the class
+    /// Returns the instance of the class (it is created by the first
+    /// call, even if several threads call it at the same time)
     /// \return instance of the class
     static Logger *getInstance();
 
-    /// Logs a message (prints it out and stores it into the log file)
+    /// Checks if the messages of a type are logged
+    /// \param type type of the messages
+    /// \return true, if the messages are logged. Otherwise, false.
+    static bool isEnabled(Type type) {
+        return !disabled[type].load(std::memory_order_relaxed);
+    }
+
+    /// Enables or disables the messages of a type
+    /// \param type type of the messages
+    /// \param enabled true, if the messages should be logged
+    static void setEnabled(Type type, bool enabled);
+
+    /// Enables the messages of the types of the level given as
+    /// a parameter and above, disables the rest (see LOG_LEVEL_)
+    /// \param level the minimum level
+    static void setMinLevel(int level);
+
+    /// Returns the level of a type of messages (see LOG_LEVEL_)
+    /// \param type type of the messages
+    /// \return level of the type
+    static int getLevel(Type type);
+
+    /// Logs a message (it is printed out and stored into the log file by the writer)
     ///
     /// This method also keeps track of the number of the line
     /// from which the method was called so it could be added
@@ -103,6 +428,84 @@ public:
     /// \param msg the log message itself
     void log(int lineNumber, Type type, std::string msg);
 
+    /// Registers a format of structured messages (called once per call site by the LOG_X_F macros)
+    /// \param lineNumber number of the line of the call site
+    /// \param type type of the messages
+    /// \param text the format ({} is replaced by an argument), it has to be a string literal
+    /// \return id of the format (0 if there are too many formats - the messages are logged as plain ones)
+    static uint16_t registerFormat(int lineNumber, Type type, const char *text);
+
+    /// Logs a structured message - only the arguments are copied, the message
+    /// is put together by the writer (if it is written into the text log at all)
+    /// \param lineNumber number of the line from which this log method was called
+    /// \param type type of the log message (#Type)
+    /// \param format id of the format (see #registerFormat)
+    /// \param args the arguments (integers and strings)
+    template<typename... Args>
+    void logEvent(int lineNumber, Type type, uint16_t format, const Args&... args) {
+        Entry_t *entry = reserve(lineNumber, type);
+        if (entry == NULL)
+            return;
+        entry->format = format;
+        entry->truncated = false;
+        encode(*entry, args...);
+        // the arguments do not fit in - the message is put together right away
+        if (format == 0 || entry->truncated) {
+            std::vector<std::string> values;
+            toStrings(values, args...);
+            entry->msg = render(format == 0 ? "" : formats[format - 1].text, values);
+            entry->format = 0;
+        }
+        commit();
+    }
+
+    /// Sets where the messages are written
+    /// \param sinks a combination of #Sink flags
+    void setSinks(int sinks);
+
+    /// Decodes the arguments of a structured message
+    /// \param data the arguments
+    /// \param size number of bytes of the arguments
+    /// \param args the decoded arguments
+    /// \return false, if the arguments are corrupted. Otherwise, true.
+    static bool decodeArgs(const char *data, size_t size, std::vector<Arg_t> &args);
+
+    /// Puts a structured message together - replaces {} of the format with the arguments
+    /// (the arguments that are left over are appended separated by spaces)
+    /// \param format the format
+    /// \param data the arguments
+    /// \param size number of bytes of the arguments
+    /// \return the message
+    static std::string render(const char *format, const char *data, size_t size);
+
+    /// Puts a structured message together - replaces {} of the format with the arguments
+    /// (the arguments that are left over are appended separated by spaces)
+    /// \param format the format
+    /// \param values the arguments converted to strings
+    /// \return the message
+    static std::string render(const char *format, const std::vector<std::string> &values);
+
+    /// Returns the name of a type of messages as it is written into the text log
+    /// \param type type of the messages
+    /// \return name of the type (e.g. INFO_LOG)
+    static const char *getTypeName(Type type);
+
+    /// Sets what happens to the messages of a type when the ring of the thread is full
+    /// \param type type of the messages
+    /// \param policy the overflow policy
+    void setOverflow(Type type, Overflow policy);
+
+    /// Waits until all the messages logged so far are written
+    void flush();
+
+    /// Writes all the pending messages and stops the writer (the messages
+    /// logged after that are written right away by the calling thread)
+    void stop();
+
+    /// Returns the statistics of the logger
+    /// \return statistics of the logger
+    Stats_t getStats();
+
     /// Prints out all different types of log messages
     ///
     /// This method is not used within this project. Its purpose
@@ -113,18 +516,129 @@ public:
 
 private:
     /// Constructor of the class - creates an instance of it
+    /// (opens the log file and starts the writer)
     Logger();
 
-    /// Logs a message (prints it out in color and stores it into the log file)
-    ///
-    /// This method is directly called by method log in which the message gets
-    /// the appropriate color depending on its type.
-    ///
-    /// \param lineNumber number of the line from which this log method was called
-    /// \param type of the log message (#Type)
-    /// \param color in which the message is going to be printed out
-    /// \param msg the log message itself
-    void log(int lineNumber, std::string type, std::string color, std::string msg);
+    /// The body of the background writer
+    void writerHandler();
+
+    /// Takes all the messages out of the rings, formats them and writes them
+    /// (#batchMtx must be locked)
+    /// \return number of messages written
+    size_t writeBatch();
+
+    /// Formats a message into the terminal (in color) and the log file
+    /// \param entry the message
+    /// \param terminal text printed out into the terminal (appended)
+    /// \param file text stored into the log file (appended)
+    void format(const Entry_t &entry, std::string &terminal, std::string &file);
+
+    /// Returns the ring of the calling thread (it is created if it does not exist yet)
+    /// \return ring of the calling thread
+    Ring_t *getRing();
+
+    /// Reserves a slot of the ring of the calling thread for a message (see #commit)
+    /// \param lineNumber number of the line from which the message was logged
+    /// \param type type of the message
+    /// \return the slot, NULL if the message has been dropped
+    Entry_t *reserve(int lineNumber, Type type);
+
+    /// Publishes the message put into the slot returned by #reserve
+    void commit();
+
+    /// Stores a message into the binary log
+    /// \param entry the message
+    /// \param binary the binary log (appended)
+    void store(const Entry_t &entry, std::string &binary);
+
+    /// Opens the binary log (if it has not been opened yet)
+    /// \return true, if it is open. Otherwise, false.
+    bool openBinary();
+
+    /// Copies the arguments of a structured message into a message (the rest of them)
+    /// \param entry the message
+    static void encode(Entry_t &) {
+    }
+
+    /// Copies the arguments of a structured message into a message
+    /// \param entry the message
+    /// \param arg the first argument
+    /// \param args the rest of them
+    template<typename Arg, typename... Args>
+    static void encode(Entry_t &entry, const Arg &arg, const Args&... args) {
+        encodeArg(entry, arg);
+        encode(entry, args...);
+    }
+
+    /// Copies an integer argument into a message
+    /// \param entry the message
+    /// \param value the argument
+    template<typename Int, typename std::enable_if<std::is_integral<Int>::value, int>::type = 0>
+    static void encodeArg(Entry_t &entry, Int value) {
+        encodeInt(entry, (int64_t)value);
+    }
+
+    /// Copies an integer argument into a message
+    /// \param entry the message
+    /// \param value the argument
+    static void encodeInt(Entry_t &entry, int64_t value);
+
+    /// Copies a string argument into a message (see #Entry_t::truncated)
+    /// \param entry the message
+    /// \param value the argument
+    static void encodeArg(Entry_t &entry, const std::string &value) {
+        encodeString(entry, value.data(), value.size());
+    }
+
+    /// Copies a string argument into a message (see #Entry_t::truncated)
+    /// \param entry the message
+    /// \param value the argument
+    static void encodeArg(Entry_t &entry, const char *value) {
+        encodeString(entry, value, strlen(value));
+    }
+
+    /// Copies a string argument into a message (see #Entry_t::truncated)
+    /// \param entry the message
+    /// \param data the string
+    /// \param size length of the string
+    static void encodeString(Entry_t &entry, const char *data, size_t size);
+
+    /// Converts the arguments of a structured message to strings (the rest of them)
+    /// \param values the strings
+    static void toStrings(std::vector<std::string> &) {
+    }
+
+    /// Converts the arguments of a structured message to strings
+    /// \param values the strings (appended)
+    /// \param arg the first argument
+    /// \param args the rest of them
+    template<typename Arg, typename... Args>
+    static void toStrings(std::vector<std::string> &values, const Arg &arg, const Args&... args) {
+        values.push_back(toString(arg));
+        toStrings(values, args...);
+    }
+
+    /// Converts an integer argument to a string
+    /// \param value the argument
+    /// \return the string
+    template<typename Int, typename std::enable_if<std::is_integral<Int>::value, int>::type = 0>
+    static std::string toString(Int value) {
+        return std::to_string((int64_t)value);
+    }
+
+    /// Converts a string argument to a string
+    /// \param value the argument
+    /// \return the string
+    static std::string toString(const std::string &value) {
+        return value;
+    }
+
+    /// Converts a string argument to a string
+    /// \param value the argument
+    /// \return the string
+    static std::string toString(const char *value) {
+        return value;
+    }
 
     /// Returns current datetime.
     ///
@@ -135,9 +649,10 @@ private:
     /// \return current datetime
     std::string getCurrentDateTime() const;
 
-    /// Appends the log message to the end of the log file
-    /// \param log the log message
-    void addToLogFile(std::string log) const;
+    /// Writes the whole buffer given as a parameter into a file
+    /// \param fd file descriptor of the file
+    /// \param data the buffer
+    static void writeAll(int fd, const std::string &data);
 };
 
-#endif
\ No newline at end of file
+#endif
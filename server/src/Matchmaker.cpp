@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "Matchmaker.h"
+
+Matchmaker::Matchmaker() : buckets(NUMBER_OF_BUCKETS) {
+    stats = {0, 0, 0};
+}
+
+int Matchmaker::getWindow(const Player_t &player, std::chrono::steady_clock::time_point now) {
+    int waited = (int)std::chrono::duration_cast<std::chrono::seconds>(now - player.since).count();
+    return std::min(MAX_WINDOW, BASE_WINDOW + std::max(0, waited) * WINDOW_GROWTH);
+}
+
+bool Matchmaker::enqueue(const std::string &nick, int rating, std::chrono::steady_clock::time_point since) {
+    rating = std::max(0, std::min(MAX_RATING - 1, rating));
+    int bucket = rating / BUCKET_WIDTH;
+    poolMtx.lock();
+    bool added = players.find(nick) == players.end();
+    if (added) {
+        buckets[bucket].push_back({nick, rating, since});
+        players[nick] = {bucket, std::prev(buckets[bucket].end())};
+    }
+    poolMtx.unlock();
+    return added;
+}
+
+bool Matchmaker::cancel(const std::string &nick) {
+    poolMtx.lock();
+    auto it = players.find(nick);
+    bool found = it != players.end();
+    if (found) {
+        buckets[it->second.first].erase(it->second.second);
+        players.erase(it);
+    }
+    poolMtx.unlock();
+    return found;
+}
+
+void Matchmaker::match(std::list<Player_t>::iterator first, std::list<Player_t>::iterator second,
+                       std::chrono::steady_clock::time_point now, std::vector<Match_t> &matches) {
+    // the one who has waited longer plays first
+    if (second->since < first->since)
+        std::swap(first, second);
+    matches.push_back({first->nick, second->nick, std::abs(first->rating - second->rating),
+                       std::chrono::duration<double>(now - first->since).count()});
+    int bucket1 = players[first->nick].first;
+    int bucket2 = players[second->nick].first;
+    players.erase(first->nick);
+    players.erase(second->nick);
+    buckets[bucket1].erase(first);
+    buckets[bucket2].erase(second);
+    stats.matches++;
+}
+
+std::vector<Matchmaker::Match_t> Matchmaker::pair(std::chrono::steady_clock::time_point now) {
+    std::vector<Match_t> matches;
+    poolMtx.lock();
+    stats.ticks++;
+
+    // players of the same bucket (the longest waiting ones first)
+    for (std::list<Player_t> &bucket : buckets)
+        while (bucket.size() >= 2)
+            match(bucket.begin(), std::next(bucket.begin()), now, matches);
+
+    // the ones left (at most one per bucket) with their neighbours
+    std::list<Player_t>::iterator pending;
+    bool hasPending = false;
+    for (std::list<Player_t> &bucket : buckets) {
+        if (bucket.empty())
+            continue;
+        std::list<Player_t>::iterator player = bucket.begin();
+        if (hasPending && player->rating - pending->rating <= std::min(getWindow(*pending, now), getWindow(*player, now))) {
+            match(pending, player, now, matches);
+            hasPending = false;
+        }
+        else {
+            // the pending player waits for the next tick (with a wider window by then)
+            pending = player;
+            hasPending = true;
+        }
+    }
+    poolMtx.unlock();
+    return matches;
+}
+
+Matchmaker::Stats_t Matchmaker::getStats() {
+    poolMtx.lock();
+    Stats_t current = stats;
+    current.queued = players.size();
+    poolMtx.unlock();
+    return current;
+}
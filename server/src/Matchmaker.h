@@ -0,0 +1,128 @@
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <utility>
+#include <unordered_map>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Pool of players waiting for an opponent (matchmaking queue).
+///
+/// The players are kept in buckets by their rating (#BUCKET_WIDTH points
+/// each), every bucket in the order the players joined the pool. A player
+/// can be looked up by their nick, so leaving the pool takes constant time.
+///
+/// The players are paired in batches (#pair is called every tick). First,
+/// the two players who have waited the longest in the same bucket are paired
+/// up as long as there are any. At most one player per bucket is left then;
+/// those are paired with their neighbours (by rating) if the difference of
+/// their ratings fits into the search window of both of them. The window
+/// widens the longer a player waits (#BASE_WINDOW, #WINDOW_GROWTH).
+/// A tick therefore costs the number of buckets plus the number of pairs,
+/// no matter how many players are waiting.
+class Matchmaker {
+public:
+    /// rating of a player who has not been rated yet
+    static const int DEFAULT_RATING = 1500;
+    /// range of ratings one bucket covers
+    static const int BUCKET_WIDTH = 50;
+    /// ratings are capped to [0, #MAX_RATING)
+    static const int MAX_RATING = 4000;
+    /// the largest difference of ratings of two players paired up right away
+    static const int BASE_WINDOW = 50;
+    /// the search window widens by this many points every second a player waits
+    static const int WINDOW_GROWTH = 25;
+    /// the widest search window
+    static const int MAX_WINDOW = 600;
+
+    /// Two players paired up (player1 has waited longer)
+    struct Match_t {
+        std::string player1; ///< nick of player1
+        std::string player2; ///< nick of player2
+        int ratingDiff;      ///< difference of their ratings
+        double waited;       ///< how long player1 waited [s]
+    };
+
+    /// Statistics of the pool
+    struct Stats_t {
+        uint64_t queued;  ///< number of players in the pool at the moment
+        uint64_t matches; ///< number of pairs made
+        uint64_t ticks;   ///< number of times #pair has been called
+    };
+
+private:
+    /// One player in the pool
+    struct Player_t {
+        std::string nick;                                ///< nick of the player
+        int rating;                                      ///< rating of the player
+        std::chrono::steady_clock::time_point since;     ///< when they joined the pool
+    };
+
+    /// number of buckets
+    static const int NUMBER_OF_BUCKETS = MAX_RATING / BUCKET_WIDTH;
+
+    /// lock used when accessing the pool
+    std::mutex poolMtx;
+    /// the buckets (players in the order they joined the pool)
+    std::vector<std::list<Player_t>> buckets;
+    /// where every player is (the key is their nick)
+    std::unordered_map<std::string, std::pair<int, std::list<Player_t>::iterator>> players;
+    /// statistics of the pool
+    Stats_t stats;
+
+private:
+    /// Returns the search window of a player
+    /// \param player the player
+    /// \param now the current time
+    /// \return the largest difference of ratings they accept
+    static int getWindow(const Player_t &player, std::chrono::steady_clock::time_point now);
+
+    /// Takes two players out of the pool as a pair (#poolMtx must be locked)
+    /// \param first one of the players
+    /// \param second the other player
+    /// \param now the current time
+    /// \param matches the pairs made
+    void match(std::list<Player_t>::iterator first, std::list<Player_t>::iterator second,
+               std::chrono::steady_clock::time_point now, std::vector<Match_t> &matches);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    Matchmaker();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Matchmaker(const Matchmaker&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Matchmaker&) = delete;
+
+    /// Puts a player into the pool
+    /// \param nick nick of the player
+    /// \param rating rating of the player
+    /// \param since when they joined the pool
+    /// \return false, if they are already in the pool. Otherwise, true.
+    bool enqueue(const std::string &nick, int rating, std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now());
+
+    /// Takes a player out of the pool
+    /// \param nick nick of the player
+    /// \return false, if they are not in the pool (they might have been paired up already). Otherwise, true.
+    bool cancel(const std::string &nick);
+
+    /// Pairs up the players who can play against each other (one tick)
+    /// \param now the current time
+    /// \return the pairs made (the players are no longer in the pool)
+    std::vector<Match_t> pair(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    /// Returns the statistics of the pool
+    /// \return statistics of the pool
+    Stats_t getStats();
+};
+
+#endif
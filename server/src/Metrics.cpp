@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "Metrics.h"
+
+Metrics::Counter::Counter() {
+    for (int i = 0; i < SHARDS; i++)
+        cells[i].value = 0;
+}
+
+uint64_t Metrics::Counter::value() const {
+    uint64_t sum = 0;
+    for (int i = 0; i < SHARDS; i++)
+        sum += cells[i].value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+Metrics::Histogram::Histogram() : buckets(new std::atomic<uint64_t>[SHARDS * HISTOGRAM_BUCKETS]) {
+    for (int i = 0; i < SHARDS * HISTOGRAM_BUCKETS; i++)
+        buckets[i] = 0;
+    for (int i = 0; i < SHARDS; i++)
+        sums[i].value = 0;
+}
+
+int Metrics::Histogram::toBucket(uint64_t ns) {
+    if (ns < (uint64_t)SUB_BUCKETS)
+        return (int)ns;
+    // the power of two and the next log2(SUB_BUCKETS) bits
+    int power = 63 - __builtin_clzll(ns);
+    int shift = power - __builtin_ctz(SUB_BUCKETS);
+    int bucket = (power - __builtin_ctz(SUB_BUCKETS) + 1) * SUB_BUCKETS + (int)((ns >> shift) & (SUB_BUCKETS - 1));
+    return std::min(bucket, HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t Metrics::Histogram::bucketLimit(int bucket) {
+    if (bucket < SUB_BUCKETS)
+        return (uint64_t)bucket + 1;
+    int shift = bucket / SUB_BUCKETS - 1;
+    return (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << shift;
+}
+
+void Metrics::Histogram::snapshot(std::vector<uint64_t> &counts, uint64_t &sum) const {
+    counts.assign(HISTOGRAM_BUCKETS, 0);
+    sum = 0;
+    for (int s = 0; s < SHARDS; s++) {
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+            counts[i] += buckets[s * HISTOGRAM_BUCKETS + i].load(std::memory_order_relaxed);
+        sum += sums[s].value.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t Metrics::Histogram::quantile(double q) const {
+    std::vector<uint64_t> counts;
+    uint64_t sum;
+    snapshot(counts, sum);
+    uint64_t total = 0;
+    for (uint64_t count : counts)
+        total += count;
+    if (total == 0)
+        return 0;
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * total + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return bucketLimit(i);
+    }
+    return bucketLimit(HISTOGRAM_BUCKETS - 1);
+}
+
+Metrics::Metrics() {
+    listenFd = -1;
+    running = false;
+}
+
+Metrics *Metrics::getInstance() {
+    // the initialization of a local static variable is thread-safe
+    static Metrics *instance = new Metrics;
+    return instance;
+}
+
+int Metrics::shard() {
+    static std::atomic<int> nextShard(0);
+    static thread_local int current = nextShard++ % SHARDS;
+    return current;
+}
+
+Metrics::Entry_t &Metrics::find(const std::string &name, const std::string &help, const std::string &labels, Kind kind) {
+    std::lock_guard<std::mutex> lock(registryMtx);
+    for (auto &entry : entries)
+        if (entry->name == name && entry->labels == labels)
+            return *entry;
+    std::unique_ptr<Entry_t> entry(new Entry_t);
+    entry->name = name;
+    entry->labels = labels;
+    entry->help = help;
+    entry->kind = kind;
+    switch (kind) {
+        case COUNTER:   entry->counter.reset(new Counter);     break;
+        case GAUGE:     entry->gauge.reset(new Gauge);         break;
+        case HISTOGRAM: entry->histogram.reset(new Histogram); break;
+        case CALLBACK:  break;
+    }
+    entries.push_back(std::move(entry));
+    return *entries.back();
+}
+
+Metrics::Counter &Metrics::counter(const std::string &name, const std::string &help, const std::string &labels) {
+    return *find(name, help, labels, COUNTER).counter;
+}
+
+Metrics::Gauge &Metrics::gauge(const std::string &name, const std::string &help, const std::string &labels) {
+    return *find(name, help, labels, GAUGE).gauge;
+}
+
+Metrics::Histogram &Metrics::histogram(const std::string &name, const std::string &help, const std::string &labels) {
+    return *find(name, help, labels, HISTOGRAM).histogram;
+}
+
+void Metrics::callback(const std::string &name, const std::string &help, std::function<double()> function, const std::string &labels) {
+    Entry_t &entry = find(name, help, labels, CALLBACK);
+    std::lock_guard<std::mutex> lock(registryMtx);
+    entry.function = function;
+}
+
+std::string Metrics::render() {
+    // the metrics of the same name (with different labels) are put together
+    std::vector<Entry_t *> sorted;
+    std::vector<std::function<double()>> functions;
+    registryMtx.lock();
+    for (auto &entry : entries)
+        sorted.push_back(entry.get());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Entry_t *a, const Entry_t *b) {
+        return a->name < b->name;
+    });
+    for (Entry_t *entry : sorted)
+        functions.push_back(entry->function);
+    registryMtx.unlock();
+
+    std::string text;
+    char buffer[64];
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const Entry_t &entry = *sorted[i];
+        if (i == 0 || sorted[i - 1]->name != entry.name) {
+            static const char *types[] = {"counter", "gauge", "histogram", "gauge"};
+            text += "# HELP " + entry.name + " " + entry.help + "\n";
+            text += "# TYPE " + entry.name + " " + types[entry.kind] + "\n";
+        }
+        std::string labels = entry.labels.empty() ? "" : "{" + entry.labels + "}";
+        switch (entry.kind) {
+            case COUNTER:
+                text += entry.name + labels + " " + std::to_string(entry.counter->value()) + "\n";
+                break;
+            case GAUGE:
+                text += entry.name + labels + " " + std::to_string(entry.gauge->value()) + "\n";
+                break;
+            case CALLBACK:
+                snprintf(buffer, sizeof(buffer), "%.17g", functions[i] ? functions[i]() : 0.0);
+                text += entry.name + labels + " " + buffer + "\n";
+                break;
+            case HISTOGRAM: {
+                std::vector<uint64_t> counts;
+                uint64_t sum;
+                entry.histogram->snapshot(counts, sum);
+                std::string prefix = entry.labels.empty() ? "" : entry.labels + ",";
+                uint64_t cumulative = 0;
+                int bucket = 0;
+                // the buckets below 2^power make up the values lower than 2^power
+                for (int power = FIRST_EXPORTED_POWER; power <= LAST_EXPORTED_POWER; power++) {
+                    for (; bucket < HISTOGRAM_BUCKETS && Histogram::bucketLimit(bucket) <= (1ull << power); bucket++)
+                        cumulative += counts[bucket];
+                    snprintf(buffer, sizeof(buffer), "%.6g", (double)(1ull << power) / 1e9);
+                    text += entry.name + "_bucket{" + prefix + "le=\"" + buffer + "\"} " + std::to_string(cumulative) + "\n";
+                }
+                for (; bucket < HISTOGRAM_BUCKETS; bucket++)
+                    cumulative += counts[bucket];
+                text += entry.name + "_bucket{" + prefix + "le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+                snprintf(buffer, sizeof(buffer), "%.9g", (double)sum / 1e9);
+                text += entry.name + "_sum" + labels + " " + buffer + "\n";
+                text += entry.name + "_count" + labels + " " + std::to_string(cumulative) + "\n";
+                break;
+            }
+        }
+    }
+    return text;
+}
+
+bool Metrics::listen(int port) {
+    if (running)
+        return true;
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+        return false;
+    int opt = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) < 0 || ::listen(listenFd, BACKLOG) < 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    running = true;
+    exporter = std::thread(&Metrics::exporterHandler, this);
+    return true;
+}
+
+void Metrics::close() {
+    if (!running.exchange(false))
+        return;
+    shutdown(listenFd, SHUT_RDWR);
+    exporter.join();
+    ::close(listenFd);
+    listenFd = -1;
+}
+
+void Metrics::exporterHandler() {
+    while (running) {
+        struct pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, REQUEST_TIMEOUT_MS) <= 0)
+            continue;
+        int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        serve(fd);
+        ::close(fd);
+    }
+}
+
+void Metrics::serve(int fd) {
+    // the request itself does not matter (every path gets the exposition),
+    // it is only read up to the end of the headers
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos && request.size() < 8192) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, REQUEST_TIMEOUT_MS) <= 0)
+            return;
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            return;
+        request.append(buffer, n);
+    }
+    static Counter &scrapes = counter("connect4_metrics_scrapes_total", "Number of times the metrics have been scraped");
+    scrapes.inc();
+    std::string body = render();
+    std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    size_t offset = 0;
+    while (offset < response.size()) {
+        ssize_t n = send(fd, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        offset += n;
+    }
+}
@@ -0,0 +1,324 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Registry of the metrics of the server (counters, gauges and histograms)
+/// exposed in the Prometheus text format. This class is written as a singleton.
+///
+/// The metrics are registered once (registering the same name and labels
+/// again returns the same metric) and updated from then on without any lock:
+/// - a counter is split into #SHARDS cells (one cache line each), every thread
+///   adds to its own one and the cells are summed up only when read,
+/// - a gauge is a single atomic value (it changes far less often),
+/// - a histogram keeps #SUB_BUCKETS buckets per power of two of nanoseconds
+///   (HDR-style, the relative error is at most 1/#SUB_BUCKETS), also split
+///   into shards.
+///
+/// The metrics can also be computed when they are read (see #callback), as
+/// long as the function does not take any lock the server holds for long.
+///
+/// The text exposition (see #render) is served over HTTP on a local port
+/// (see #listen) by a thread of its own. It only reads the metrics, so
+/// scraping never takes any lock of the server.
+class Metrics {
+public:
+    /// number of shards of a counter and a histogram
+    static const int SHARDS = 8;
+    /// number of buckets of a histogram per power of two (the precision)
+    static const int SUB_BUCKETS = 8;
+    /// number of buckets of a histogram (covering all 64-bit values)
+    static const int HISTOGRAM_BUCKETS = 62 * SUB_BUCKETS;
+    /// the lowest upper bound of the buckets in the text exposition (2^10 ns = ~1us)
+    static const int FIRST_EXPORTED_POWER = 10;
+    /// the highest upper bound of the buckets in the text exposition (2^36 ns = ~69s)
+    static const int LAST_EXPORTED_POWER = 36;
+    /// number of connections the exposition endpoint keeps waiting
+    static const int BACKLOG = 8;
+    /// amount of milliseconds a scraper has to send its request
+    static const int REQUEST_TIMEOUT_MS = 1000;
+
+    /// One cell of a sharded value (a cache line of its own)
+    struct Cell_t {
+        std::atomic<uint64_t> value; ///< the value
+        char padding[64 - sizeof(std::atomic<uint64_t>)]; ///< keeps the other cells off the cache line
+    };
+
+    /// Monotonically increasing counter
+    class Counter {
+    private:
+        /// the cells (one per shard)
+        Cell_t cells[SHARDS];
+
+    public:
+        /// Constructor of the class - creates an instance of it (zero)
+        Counter();
+
+        /// Adds to the counter
+        /// \param n the amount
+        void inc(uint64_t n = 1) {
+            cells[shard()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// Returns the value of the counter
+        /// \return the value
+        uint64_t value() const;
+    };
+
+    /// Value that goes up and down
+    class Gauge {
+    private:
+        /// the value
+        std::atomic<int64_t> current;
+
+    public:
+        /// Constructor of the class - creates an instance of it (zero)
+        Gauge() : current(0) {
+        }
+
+        /// Adds to the gauge
+        /// \param n the amount (may be negative)
+        void add(int64_t n) {
+            current.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// Increments the gauge
+        void inc() {
+            add(1);
+        }
+
+        /// Decrements the gauge
+        void dec() {
+            add(-1);
+        }
+
+        /// Sets the gauge
+        /// \param value the value
+        void set(int64_t value) {
+            current.store(value, std::memory_order_relaxed);
+        }
+
+        /// Returns the value of the gauge
+        /// \return the value
+        int64_t value() const {
+            return current.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// Distribution of durations in nanoseconds
+    class Histogram {
+    private:
+        /// the buckets of every shard
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        /// sum of the recorded values of every shard
+        Cell_t sums[SHARDS];
+
+    public:
+        /// Constructor of the class - creates an instance of it (empty)
+        Histogram();
+
+        /// Records a value
+        /// \param ns the value (nanoseconds)
+        void record(uint64_t ns) {
+            int s = shard();
+            buckets[s * HISTOGRAM_BUCKETS + toBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+            sums[s].value.fetch_add(ns, std::memory_order_relaxed);
+        }
+
+        /// Returns the number of values in every bucket (all the shards summed up)
+        /// \param counts the numbers of values (#HISTOGRAM_BUCKETS of them)
+        /// \param sum sum of the values
+        void snapshot(std::vector<uint64_t> &counts, uint64_t &sum) const;
+
+        /// Returns a quantile of the recorded values (the upper bound of its bucket)
+        /// \param q the quantile (0 - 1)
+        /// \return the quantile in nanoseconds, 0 if nothing has been recorded
+        uint64_t quantile(double q) const;
+
+        /// Returns the bucket of a value
+        /// \param ns the value
+        /// \return the bucket
+        static int toBucket(uint64_t ns);
+
+        /// Returns the lowest value that does not fall into a bucket any more
+        /// \param bucket the bucket
+        /// \return the upper bound of the bucket (exclusive)
+        static uint64_t bucketLimit(int bucket);
+    };
+
+    /// Increments a gauge for as long as it exists (e.g. a running timer)
+    class GaugeScope {
+    private:
+        /// the gauge
+        Gauge &gauge;
+
+    public:
+        /// Constructor of the class - increments the gauge
+        /// \param gauge the gauge
+        explicit GaugeScope(Gauge &gauge) : gauge(gauge) {
+            gauge.inc();
+        }
+
+        /// Destructor of the class - decrements the gauge
+        ~GaugeScope() {
+            gauge.dec();
+        }
+
+        /// Copy constructor of the class. It was deleted
+        /// because there is no need to use it within this project.
+        GaugeScope(const GaugeScope&) = delete;
+
+        /// Assignment operator of the the class. It was deleted
+        /// because there is no need to use it within this project.
+        void operator=(const GaugeScope&) = delete;
+    };
+
+    /// Records the time it exists for into a histogram (e.g. handling a message)
+    class Timer {
+    private:
+        /// the histogram
+        Histogram &histogram;
+        /// when the timer was created
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        /// Constructor of the class - starts the timer
+        /// \param histogram the histogram
+        explicit Timer(Histogram &histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {
+        }
+
+        /// Destructor of the class - records the time
+        ~Timer() {
+            histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        /// Copy constructor of the class. It was deleted
+        /// because there is no need to use it within this project.
+        Timer(const Timer&) = delete;
+
+        /// Assignment operator of the the class. It was deleted
+        /// because there is no need to use it within this project.
+        void operator=(const Timer&) = delete;
+    };
+
+private:
+    /// Kind of a metric
+    enum Kind {
+        COUNTER,   ///< #Counter
+        GAUGE,     ///< #Gauge
+        HISTOGRAM, ///< #Histogram
+        CALLBACK   ///< a gauge computed when it is read
+    };
+
+    /// One registered metric
+    struct Entry_t {
+        std::string name;                 ///< name of the metric
+        std::string labels;               ///< labels (e.g. type="PING"), may be empty
+        std::string help;                 ///< description of the metric
+        Kind kind;                        ///< kind of the metric
+        std::unique_ptr<Counter> counter; ///< the counter (#COUNTER)
+        std::unique_ptr<Gauge> gauge;     ///< the gauge (#GAUGE)
+        std::unique_ptr<Histogram> histogram; ///< the histogram (#HISTOGRAM)
+        std::function<double()> function; ///< the function computing the value (#CALLBACK)
+    };
+
+    /// lock used when accessing the registered metrics (not when updating them)
+    std::mutex registryMtx;
+    /// the registered metrics
+    std::vector<std::unique_ptr<Entry_t>> entries;
+
+    /// listening socket of the exposition endpoint (-1 if none)
+    int listenFd;
+    /// indication of whether or not the exposition endpoint should keep running
+    std::atomic<bool> running;
+    /// the thread serving the exposition endpoint
+    std::thread exporter;
+
+private:
+    /// Constructor of the class - creates an instance of it
+    Metrics();
+
+    /// Returns the shard of the calling thread
+    /// \return the shard
+    static int shard();
+
+    /// Finds a registered metric or registers a new one
+    /// \param name name of the metric
+    /// \param help description of the metric
+    /// \param labels labels of the metric
+    /// \param kind kind of the metric
+    /// \return the metric
+    Entry_t &find(const std::string &name, const std::string &help, const std::string &labels, Kind kind);
+
+    /// The body of the exposition endpoint thread
+    void exporterHandler();
+
+    /// Serves one scraper (reads its request and sends the exposition)
+    /// \param fd socket of the scraper
+    void serve(int fd);
+
+public:
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Metrics(const Metrics&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Metrics&) = delete;
+
+    /// Returns the instance of the class
+    /// \return instance of the class
+    static Metrics *getInstance();
+
+    /// Returns a counter (it is registered if it does not exist yet)
+    /// \param name name of the metric (e.g. connect4_messages_total)
+    /// \param help description of the metric
+    /// \param labels labels of the metric (e.g. type="PING")
+    /// \return the counter
+    Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    /// Returns a gauge (it is registered if it does not exist yet)
+    /// \param name name of the metric
+    /// \param help description of the metric
+    /// \param labels labels of the metric
+    /// \return the gauge
+    Gauge &gauge(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    /// Returns a histogram of durations (it is registered if it does not exist yet)
+    /// \param name name of the metric (the values are exposed in seconds)
+    /// \param help description of the metric
+    /// \param labels labels of the metric
+    /// \return the histogram
+    Histogram &histogram(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    /// Registers a gauge computed when it is read
+    /// \param name name of the metric
+    /// \param help description of the metric
+    /// \param function the function computing the value
+    /// \param labels labels of the metric
+    void callback(const std::string &name, const std::string &help, std::function<double()> function, const std::string &labels = "");
+
+    /// Returns all the metrics in the Prometheus text format
+    /// \return the exposition
+    std::string render();
+
+    /// Starts serving the exposition over HTTP on a port of the local host
+    /// \param port the port
+    /// \return true, if the endpoint is listening. Otherwise, false.
+    bool listen(int port);
+
+    /// Stops serving the exposition
+    void close();
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "OpeningBook.h"
+
+const std::string OpeningBook::DEFAULT_PATH = "book/opening.book";
+
+OpeningBook::OpeningBook(std::string path) {
+    this->path = path;
+    loaded = false;
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    entries = NULL;
+}
+
+OpeningBook::~OpeningBook() {
+    if (mapping != NULL)
+        munmap(mapping, mappingSize);
+}
+
+OpeningBook *OpeningBook::getDefault() {
+    static OpeningBook book(DEFAULT_PATH);
+    return &book;
+}
+
+void OpeningBook::open() {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Header_t)) {
+        close(fd);
+        return;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return;
+
+    const Header_t *h = (const Header_t *)addr;
+    if (h->magic != MAGIC || sizeof(Header_t) + h->count * sizeof(uint64_t) > (size_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return;
+    }
+    // lookups are binary searches - no point in reading ahead
+    madvise(addr, st.st_size, MADV_RANDOM);
+
+    mapping = addr;
+    mappingSize = st.st_size;
+    header = h;
+    entries = (const uint64_t *)((const char *)addr + sizeof(Header_t));
+    loaded = true;
+}
+
+bool OpeningBook::isAvailable() {
+    std::call_once(openFlag, &OpeningBook::open, this);
+    return loaded;
+}
+
+uint64_t OpeningBook::size() {
+    return isAvailable() ? header->count : 0;
+}
+
+int OpeningBook::getMaxMoves() {
+    return isAvailable() ? (int)header->maxMoves : -1;
+}
+
+bool OpeningBook::covers(const Position &position) {
+    return isAvailable() && position.nbMoves() <= (int)header->maxMoves;
+}
+
+bool OpeningBook::lookup(const Position &position, int &score, int &bestColumn) {
+    if (!covers(position))
+        return false;
+
+    uint64_t key = position.canonicalKey();
+    const uint64_t *first = entries;
+    const uint64_t *last = entries + header->count;
+    const uint64_t *it = std::lower_bound(first, last, key << 11);
+    if (it == last || (*it >> 11) != key)
+        return false;
+
+    score = (int)(*it & 0xff) + Position::MIN_SCORE - 1;
+    bestColumn = (int)((*it >> 8) & 0x7);
+
+    // the entry is stored for the canonical orientation
+    if (key != position.key())
+        bestColumn = Position::WIDTH - 1 - bestColumn;
+    return true;
+}
+
+uint64_t OpeningBook::encode(const Position &position, int score, int bestColumn) {
+    uint64_t key = position.canonicalKey();
+    if (key != position.key())
+        bestColumn = Position::WIDTH - 1 - bestColumn;
+    return (key << 11) | ((uint64_t)bestColumn << 8) | (uint64_t)(score - Position::MIN_SCORE + 1);
+}
+
+bool OpeningBook::write(const std::string &path, int maxMoves, std::vector<uint64_t> &entries) {
+    std::sort(entries.begin(), entries.end());
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (file.fail())
+        return false;
+
+    Header_t h;
+    h.magic = MAGIC;
+    h.maxMoves = maxMoves;
+    h.reserved = 0;
+    h.count = entries.size();
+    file.write((const char *)&h, sizeof(h));
+    file.write((const char *)entries.data(), entries.size() * sizeof(uint64_t));
+    return !file.fail();
+}
@@ -0,0 +1,124 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "Position.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Precomputed exact values of all the positions
+/// up to a certain number of moves (see the bookgen tool).
+///
+/// The book is a file of sorted 64-bit entries, each holding the
+/// canonical (mirror-reduced) key of a position, its best column
+/// and its score, so a position is looked up by a single binary search.
+/// The file is memory-mapped lazily on the first lookup,
+/// so opening a book does not cost anything until it is actually used.
+///
+/// Layout of the file: #Header_t followed by #Header_t::count entries.
+/// An entry is: key (bits 11-63) | best column (bits 8-10) | score (bits 0-7).
+class OpeningBook {
+public:
+    /// default location of the book
+    static const std::string DEFAULT_PATH;
+
+    /// magic number at the beginning of the file ("C4BOOK01")
+    static const uint64_t MAGIC = 0x31304b4f4f423443ULL;
+
+    /// Header of the book file
+    struct Header_t {
+        uint64_t magic;    ///< #MAGIC
+        uint32_t maxMoves; ///< positions with up to this number of moves are stored
+        uint32_t reserved; ///< padding (zero)
+        uint64_t count;    ///< number of entries
+    };
+
+private:
+    /// path to the book file
+    std::string path;
+    /// flag used to map the file only once (on the first lookup)
+    std::once_flag openFlag;
+    /// true, if the file has been successfully mapped
+    bool loaded;
+    /// the mapped file
+    void *mapping;
+    /// size of the mapped file
+    size_t mappingSize;
+    /// header of the book (part of the mapping)
+    const Header_t *header;
+    /// entries of the book (part of the mapping)
+    const uint64_t *entries;
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// The file is not opened until the first lookup.
+    ///
+    /// \param path to the book file
+    explicit OpeningBook(std::string path);
+
+    /// Destructor of the class - unmaps the file
+    ~OpeningBook();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    OpeningBook(OpeningBook &) = delete;
+
+    /// Assignment operator of the the class.
+    /// It was deleted because there is no need to use it
+    /// within this project.
+    void operator=(OpeningBook const &) = delete;
+
+    /// Returns the book stored at #DEFAULT_PATH
+    /// \return the default book
+    static OpeningBook *getDefault();
+
+    /// Looks up the position given as a parameter
+    /// \param position the position we want to know the score of
+    /// \param score the score of the position (output)
+    /// \param bestColumn the best column to play (output)
+    /// \return true, if the position is in the book. Otherwise, false.
+    bool lookup(const Position &position, int &score, int &bestColumn);
+
+    /// Returns whether or not the book can hold the position
+    /// given as a parameter (it has been played few enough moves)
+    /// \param position the position
+    /// \return true, if the position is within the range of the book
+    bool covers(const Position &position);
+
+    /// Returns the maximum number of moves of the positions stored in the book
+    /// \return the maximum number of moves (-1, if the book is not available)
+    int getMaxMoves();
+
+    /// Returns true if the book file exists and is valid
+    /// \return true if the book can be used. Otherwise, false.
+    bool isAvailable();
+
+    /// Returns the number of entries of the book
+    /// \return number of entries (0, if the book is not available)
+    uint64_t size();
+
+    /// Writes a book file
+    /// \param path to the file
+    /// \param maxMoves positions with up to this number of moves are stored
+    /// \param entries encoded entries (they will be sorted)
+    /// \return true, if the file was written successfully. Otherwise, false.
+    static bool write(const std::string &path, int maxMoves, std::vector<uint64_t> &entries);
+
+    /// Encodes an entry of the book
+    /// \param position the position (the key will be canonical)
+    /// \param score the score of the position
+    /// \param bestColumn the best column to play
+    /// \return the encoded entry
+    static uint64_t encode(const Position &position, int score, int bestColumn);
+
+private:
+    /// Maps the file into memory (called only once)
+    void open();
+};
+
+#endif
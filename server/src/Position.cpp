@@ -0,0 +1,210 @@
+#include "Position.h"
+
+// bitmap of the bottom tile of every column
+static const uint64_t BOTTOM_MASK = []() {
+    uint64_t mask = 0;
+    for (int col = 0; col < Position::WIDTH; col++)
+        mask |= UINT64_C(1) << (col * (Position::HEIGHT + 1));
+    return mask;
+}();
+
+// bitmap of all the tiles of the grid
+static const uint64_t BOARD_MASK = BOTTOM_MASK * ((UINT64_C(1) << Position::HEIGHT) - 1);
+
+Position::Position() {
+    currentPosition = 0;
+    mask = 0;
+    moves = 0;
+}
+
+bool Position::canPlay(int col) const {
+    return (mask & topMask(col)) == 0;
+}
+
+void Position::playCol(int col) {
+    play((mask + bottomMask(col)) & columnMask(col));
+}
+
+void Position::play(uint64_t move) {
+    currentPosition ^= mask;
+    mask |= move;
+    moves++;
+}
+
+unsigned int Position::play(const std::string &seq) {
+    for (unsigned int i = 0; i < seq.size(); i++) {
+        int col = seq[i] - '0';
+        if (col < 0 || col >= WIDTH || !canPlay(col) || isWinningMove(col))
+            return i;
+        playCol(col);
+    }
+    return seq.size();
+}
+
+bool Position::isWinningMove(int col) const {
+    return winningPosition() & possible() & columnMask(col);
+}
+
+bool Position::canWinNext() const {
+    return winningPosition() & possible();
+}
+
+int Position::nbMoves() const {
+    return moves;
+}
+
+uint64_t Position::key() const {
+    return currentPosition + mask;
+}
+
+uint64_t Position::mirrorKey() const {
+    return mirror(currentPosition) + mirror(mask);
+}
+
+uint64_t Position::canonicalKey() const {
+    uint64_t k = key();
+    uint64_t m = mirrorKey();
+    return k < m ? k : m;
+}
+
+bool Position::isSymmetric() const {
+    return key() == mirrorKey();
+}
+
+uint64_t Position::possibleNonLosingMoves() const {
+    uint64_t possibleMask = possible();
+    uint64_t opponentWin = opponentWinningPosition();
+    uint64_t forcedMoves = possibleMask & opponentWin;
+    if (forcedMoves) {
+        // the opponent has more than one winning spot - nothing can be done
+        if (forcedMoves & (forcedMoves - 1))
+            return 0;
+        possibleMask = forcedMoves;
+    }
+    // do not play right below a winning spot of the opponent
+    return possibleMask & ~(opponentWin >> 1);
+}
+
+int Position::moveScore(uint64_t move) const {
+    return popcount(computeWinningPosition(currentPosition | move, mask));
+}
+
+uint64_t Position::getCurrentPosition() const {
+    return currentPosition;
+}
+
+uint64_t Position::getMask() const {
+    return mask;
+}
+
+Position Position::fromKey(uint64_t key) {
+    // every column of the key holds currentPosition + mask, where the
+    // mask is 2^height - 1, so (column + 1) has its highest bit at
+    // the height of the column and the tiles of the player below it
+    Position position;
+    for (int col = 0; col < WIDTH; col++) {
+        uint64_t column = ((key >> (col * (HEIGHT + 1))) & ((UINT64_C(1) << (HEIGHT + 1)) - 1)) + 1;
+        int height = 63 - __builtin_clzll(column);
+        uint64_t occupied = (UINT64_C(1) << height) - 1;
+        position.mask |= occupied << (col * (HEIGHT + 1));
+        position.currentPosition |= (column - (UINT64_C(1) << height)) << (col * (HEIGHT + 1));
+        position.moves += height;
+    }
+    return position;
+}
+
+bool Position::hasAlignment(uint64_t pos) {
+    // horizontal
+    uint64_t m = pos & (pos >> (HEIGHT + 1));
+    if (m & (m >> (2 * (HEIGHT + 1))))
+        return true;
+
+    // diagonal 1
+    m = pos & (pos >> HEIGHT);
+    if (m & (m >> (2 * HEIGHT)))
+        return true;
+
+    // diagonal 2
+    m = pos & (pos >> (HEIGHT + 2));
+    if (m & (m >> (2 * (HEIGHT + 2))))
+        return true;
+
+    // vertical
+    m = pos & (pos >> 1);
+    if (m & (m >> 2))
+        return true;
+
+    return false;
+}
+
+uint64_t Position::columnMask(int col) {
+    return ((UINT64_C(1) << HEIGHT) - 1) << (col * (HEIGHT + 1));
+}
+
+int Position::bitIndex(int y, int x) {
+    return x * (HEIGHT + 1) + (HEIGHT - 1 - y);
+}
+
+uint64_t Position::possible() const {
+    return (mask + BOTTOM_MASK) & BOARD_MASK;
+}
+
+uint64_t Position::winningPosition() const {
+    return computeWinningPosition(currentPosition, mask);
+}
+
+uint64_t Position::opponentWinningPosition() const {
+    return computeWinningPosition(currentPosition ^ mask, mask);
+}
+
+uint64_t Position::computeWinningPosition(uint64_t position, uint64_t mask) {
+    // vertical
+    uint64_t r = (position << 1) & (position << 2) & (position << 3);
+
+    // horizontal
+    uint64_t p = (position << (HEIGHT + 1)) & (position << 2 * (HEIGHT + 1));
+    r |= p & (position << 3 * (HEIGHT + 1));
+    r |= p & (position >> (HEIGHT + 1));
+    p = (position >> (HEIGHT + 1)) & (position >> 2 * (HEIGHT + 1));
+    r |= p & (position << (HEIGHT + 1));
+    r |= p & (position >> 3 * (HEIGHT + 1));
+
+    // diagonal 1
+    p = (position << HEIGHT) & (position << 2 * HEIGHT);
+    r |= p & (position << 3 * HEIGHT);
+    r |= p & (position >> HEIGHT);
+    p = (position >> HEIGHT) & (position >> 2 * HEIGHT);
+    r |= p & (position << HEIGHT);
+    r |= p & (position >> 3 * HEIGHT);
+
+    // diagonal 2
+    p = (position << (HEIGHT + 2)) & (position << 2 * (HEIGHT + 2));
+    r |= p & (position << 3 * (HEIGHT + 2));
+    r |= p & (position >> (HEIGHT + 2));
+    p = (position >> (HEIGHT + 2)) & (position >> 2 * (HEIGHT + 2));
+    r |= p & (position << (HEIGHT + 2));
+    r |= p & (position >> 3 * (HEIGHT + 2));
+
+    return r & (BOARD_MASK ^ mask);
+}
+
+uint64_t Position::mirror(uint64_t bitboard) {
+    uint64_t mirrored = 0;
+    for (int col = 0; col < WIDTH; col++) {
+        uint64_t column = (bitboard >> (col * (HEIGHT + 1))) & ((UINT64_C(1) << (HEIGHT + 1)) - 1);
+        mirrored |= column << ((WIDTH - 1 - col) * (HEIGHT + 1));
+    }
+    return mirrored;
+}
+
+uint64_t Position::topMask(int col) {
+    return (UINT64_C(1) << (HEIGHT - 1)) << (col * (HEIGHT + 1));
+}
+
+uint64_t Position::bottomMask(int col) {
+    return UINT64_C(1) << (col * (HEIGHT + 1));
+}
+
+int Position::popcount(uint64_t m) {
+    return __builtin_popcountll(m);
+}
@@ -0,0 +1,186 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <string>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Compact bitboard representation of a Connect4 position.
+///
+/// This class is the engine the solver (and everything built on top of it)
+/// works with. Unlike class #Connect4, it does not know anything
+/// about players, the server or the network, so it can be copied
+/// millions of times per second during a search.
+///
+/// Each column is stored as #HEIGHT + 1 bits (the extra bit on top
+/// is always zero), the bit at index column * (#HEIGHT + 1) + row
+/// represents the tile at the given column and row (row 0 is the
+/// bottom of the grid). Two bitboards are held - the tiles of the player
+/// who is up and a mask of all the occupied tiles.
+class Position {
+public:
+    /// number of columns on the grid
+    static const int WIDTH = 7;
+    /// number of rows on the grid
+    static const int HEIGHT = 6;
+    /// the lowest possible score of a position
+    static const int MIN_SCORE = -(WIDTH * HEIGHT) / 2 + 3;
+    /// the highest possible score of a position
+    static const int MAX_SCORE = (WIDTH * HEIGHT + 1) / 2 - 3;
+
+private:
+    /// tiles of the player who is up
+    uint64_t currentPosition;
+    /// all the occupied tiles (both players)
+    uint64_t mask;
+    /// number of moves played since the beginning of the game
+    int moves;
+
+public:
+    /// Constructor of the class - creates an empty grid
+    Position();
+
+    /// Checks if a tile can be put into the column given as a parameter
+    /// \param col index of the column (0 - #WIDTH-1)
+    /// \return true, if the column is not full. Otherwise, false.
+    bool canPlay(int col) const;
+
+    /// Puts a tile of the player who is up into the column given as a parameter
+    ///
+    /// The column must be playable (see #canPlay).
+    ///
+    /// \param col index of the column (0 - #WIDTH-1)
+    void playCol(int col);
+
+    /// Plays a move given as a bitmap with a single bit set
+    /// (one of the moves returned by #possibleNonLosingMoves)
+    /// \param move the move that is going to be played
+    void play(uint64_t move);
+
+    /// Plays a sequence of moves given as a string of column
+    /// indexes, for example "3344".
+    ///
+    /// The method stops at the first invalid move (invalid
+    /// character, full column or a move that wins the game).
+    ///
+    /// \param seq sequence of the moves
+    /// \return number of moves that were played successfully
+    unsigned int play(const std::string &seq);
+
+    /// Checks if the player who is up would win the game by playing
+    /// into the column given as a parameter
+    /// \param col index of the column (0 - #WIDTH-1)
+    /// \return true, if the move wins the game. Otherwise, false.
+    bool isWinningMove(int col) const;
+
+    /// Checks if the player who is up can win with their next move
+    /// \return true, if they can win right away. Otherwise, false.
+    bool canWinNext() const;
+
+    /// Returns the number of moves played since the beginning of the game
+    /// \return number of moves
+    int nbMoves() const;
+
+    /// Returns a unique key of the position (#currentPosition + #mask)
+    /// \return key of the position
+    uint64_t key() const;
+
+    /// Returns the key of the position mirrored around the middle column
+    /// \return key of the mirrored position
+    uint64_t mirrorKey() const;
+
+    /// Returns the key shared by the position and its mirror image
+    /// (the smaller of #key and #mirrorKey). This is used for symmetry
+    /// reduction - both positions have the same value.
+    /// \return canonical key of the position
+    uint64_t canonicalKey() const;
+
+    /// Checks if the position is the same as its mirror image
+    /// \return true, if the position is symmetric. Otherwise, false.
+    bool isSymmetric() const;
+
+    /// Returns a bitmap of all the moves that do not let the opponent
+    /// win with their next move. The method expects the player who is
+    /// up cannot win right away (see #canWinNext).
+    /// \return bitmap of the non-losing moves (zero if every move loses)
+    uint64_t possibleNonLosingMoves() const;
+
+    /// Returns a score of the move used for move ordering
+    /// (the number of winning spots the move creates)
+    /// \param move the move (bitmap with a single bit set)
+    /// \return score of the move
+    int moveScore(uint64_t move) const;
+
+    /// Returns tiles of the player who is up
+    /// \return bitboard of the player who is up
+    uint64_t getCurrentPosition() const;
+
+    /// Returns all the occupied tiles
+    /// \return bitboard of both players
+    uint64_t getMask() const;
+
+    /// Rebuilds a position from its key (see #key)
+    /// \param key the key of the position
+    /// \return the position
+    static Position fromKey(uint64_t key);
+
+    /// Checks if there are four aligned tiles in the bitboard given as a parameter
+    /// \param pos bitboard of one player
+    /// \return true, if there is a winning sequence. Otherwise, false.
+    static bool hasAlignment(uint64_t pos);
+
+    /// Returns a bitmap of the column given as a parameter
+    /// \param col index of the column (0 - #WIDTH-1)
+    /// \return bitmap of the whole column
+    static uint64_t columnMask(int col);
+
+    /// Returns the index of the bit representing the tile at the
+    /// position (y,x) used by class #Connect4 (y = 0 is the top row)
+    /// \param y y position of the tile
+    /// \param x x position of the tile
+    /// \return index of the bit
+    static int bitIndex(int y, int x);
+
+private:
+    /// Returns a bitmap of the moves the player who is up can play
+    /// \return bitmap of the possible moves
+    uint64_t possible() const;
+
+    /// Returns a bitmap of the spots where the player who is up would win
+    /// \return bitmap of the winning spots
+    uint64_t winningPosition() const;
+
+    /// Returns a bitmap of the spots where the opponent would win
+    /// \return bitmap of the winning spots of the opponent
+    uint64_t opponentWinningPosition() const;
+
+    /// Returns a bitmap of all the empty spots that would complete
+    /// an alignment of four tiles in the bitboard given as a parameter
+    /// \param position bitboard of one player
+    /// \param mask all the occupied tiles
+    /// \return bitmap of the winning spots
+    static uint64_t computeWinningPosition(uint64_t position, uint64_t mask);
+
+    /// Mirrors the bitboard given as a parameter around the middle column
+    /// \param bitboard that is going to be mirrored
+    /// \return mirrored bitboard
+    static uint64_t mirror(uint64_t bitboard);
+
+    /// Returns a bitmap of the top tile of the column given as a parameter
+    /// \param col index of the column (0 - #WIDTH-1)
+    /// \return bitmap with the top tile set
+    static uint64_t topMask(int col);
+
+    /// Returns a bitmap of the bottom tile of the column given as a parameter
+    /// \param col index of the column (0 - #WIDTH-1)
+    /// \return bitmap with the bottom tile set
+    static uint64_t bottomMask(int col);
+
+    /// Returns the number of bits set in the bitmap given as a parameter
+    /// \param m bitmap
+    /// \return number of bits set
+    static int popcount(uint64_t m);
+};
+
+#endif
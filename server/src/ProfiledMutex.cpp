@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+#include "ProfiledMutex.h"
+
+std::atomic<bool> ProfiledMutex::enabled(false);
+std::atomic<bool> ProfiledMutex::reporting(false);
+
+ProfiledMutex::ProfiledMutex(const std::string &name) {
+    profile = getProfile(name);
+    holdStart = 0;
+    holder = -1;
+}
+
+std::vector<std::unique_ptr<ProfiledMutex::Profile_t>> &ProfiledMutex::getProfiles(std::mutex *&profilesMtx) {
+    // the initialization of a local static variable is thread-safe
+    static std::mutex mtx;
+    static std::vector<std::unique_ptr<Profile_t>> profiles;
+    profilesMtx = &mtx;
+    return profiles;
+}
+
+ProfiledMutex::Profile_t *ProfiledMutex::getProfile(const std::string &name) {
+    std::mutex *profilesMtx;
+    std::vector<std::unique_ptr<Profile_t>> &profiles = getProfiles(profilesMtx);
+    std::lock_guard<std::mutex> lock(*profilesMtx);
+    for (auto &profile : profiles)
+        if (profile->name == name)
+            return profile.get();
+    std::unique_ptr<Profile_t> profile(new Profile_t);
+    profile->name = name;
+    profile->waitName = "wait " + name;
+    profile->acquisitions = 0;
+    profile->contended = 0;
+    profile->maxHoldNs = 0;
+    profile->maxHoldSite = -1;
+    profile->siteCount = 0;
+
+    Metrics *metrics = Metrics::getInstance();
+    std::string labels = "mutex=\"" + name + "\"";
+    Profile_t *registered = profile.get();
+    profile->wait = &metrics->histogram("connect4_lock_wait_seconds", "Time spent waiting for a contended lock (while the locks are profiled)", labels);
+    profile->hold = &metrics->histogram("connect4_lock_hold_seconds", "Time a lock has been held (while the locks are profiled)", labels);
+    metrics->callback("connect4_lock_acquisitions_total", "Number of acquisitions of a lock (while the locks are profiled)",
+                      [registered]() { return (double)registered->acquisitions.load(std::memory_order_relaxed); }, labels);
+    metrics->callback("connect4_lock_contended_total", "Number of contended acquisitions of a lock (while the locks are profiled)",
+                      [registered]() { return (double)registered->contended.load(std::memory_order_relaxed); }, labels);
+    profiles.push_back(std::move(profile));
+    return registered;
+}
+
+int ProfiledMutex::getSite(const char *function, int line) {
+    // the sites are only ever added, so the published ones can be read without the lock
+    int count = profile->siteCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        if (profile->sites[i].line == line && profile->sites[i].function == function)
+            return i;
+
+    std::lock_guard<std::mutex> lock(profile->sitesMtx);
+    count = profile->siteCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++)
+        if (profile->sites[i].line == line && profile->sites[i].function == function)
+            return i;
+    if (count == MAX_SITES)
+        return MAX_SITES - 1;
+    Site_t &site = profile->sites[count];
+    site.function = function;
+    site.line = line;
+    site.acquisitions = 0;
+    site.contended = 0;
+    site.waitNs = 0;
+    site.holdNs = 0;
+    site.maxHoldNs = 0;
+    site.blockedNs = 0;
+    profile->siteCount.store(count + 1, std::memory_order_release);
+
+    // the time others spent waiting for the site is the cost of the contention it causes
+    Site_t *registered = &site;
+    Metrics::getInstance()->callback("connect4_lock_blocked_seconds_total", "Time the other threads spent waiting for a lock held by a call site",
+                                     [registered]() { return (double)registered->blockedNs.load(std::memory_order_relaxed) / 1e9; },
+                                     "mutex=\"" + profile->name + "\",site=\"" + function + ":" + std::to_string(line) + "\"");
+    return count;
+}
+
+void ProfiledMutex::lockProfiled(const char *function, int line) {
+    Tracer::Span waiting(profile->waitName.c_str(), "lock");
+    if (!enabled.load(std::memory_order_relaxed)) {
+        mtx.lock();
+        return;
+    }
+    int site = getSite(function, line);
+    Site_t &current = profile->sites[site];
+    if (!mtx.try_lock()) {
+        // the site holding the mutex at the moment is blamed for the wait
+        int blamed = holder.load(std::memory_order_relaxed);
+        uint64_t start = now();
+        mtx.lock();
+        uint64_t wait = now() - start;
+        profile->wait->record(wait);
+        profile->contended.fetch_add(1, std::memory_order_relaxed);
+        current.contended.fetch_add(1, std::memory_order_relaxed);
+        current.waitNs.fetch_add(wait, std::memory_order_relaxed);
+        if (blamed >= 0)
+            profile->sites[blamed].blockedNs.fetch_add(wait, std::memory_order_relaxed);
+    }
+    profile->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    current.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    holder.store(site, std::memory_order_relaxed);
+    holdStart = now();
+}
+
+void ProfiledMutex::unlockProfiled() {
+    uint64_t hold = now() - holdStart;
+    int site = holder.load(std::memory_order_relaxed);
+    holdStart = 0;
+    holder.store(-1, std::memory_order_relaxed);
+
+    profile->hold->record(hold);
+    Site_t &current = profile->sites[site];
+    current.holdNs.fetch_add(hold, std::memory_order_relaxed);
+    uint64_t longest = current.maxHoldNs.load(std::memory_order_relaxed);
+    while (hold > longest && !current.maxHoldNs.compare_exchange_weak(longest, hold, std::memory_order_relaxed));
+    longest = profile->maxHoldNs.load(std::memory_order_relaxed);
+    while (hold > longest) {
+        if (profile->maxHoldNs.compare_exchange_weak(longest, hold, std::memory_order_relaxed)) {
+            profile->maxHoldSite.store(site, std::memory_order_relaxed);
+            break;
+        }
+    }
+    mtx.unlock();
+}
+
+void ProfiledMutex::setEnabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool ProfiledMutex::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+/// Formats a duration in the most readable unit
+/// \param ns the duration
+/// \return the formatted duration (e.g. 1.25ms)
+static std::string formatDuration(uint64_t ns) {
+    char buffer[32];
+    if (ns < 1000)
+        snprintf(buffer, sizeof(buffer), "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000)
+        snprintf(buffer, sizeof(buffer), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        snprintf(buffer, sizeof(buffer), "%.2fms", ns / 1e6);
+    else snprintf(buffer, sizeof(buffer), "%.2fs", ns / 1e9);
+    return buffer;
+}
+
+std::string ProfiledMutex::report() {
+    std::vector<Profile_t *> sorted;
+    std::mutex *profilesMtx;
+    std::vector<std::unique_ptr<Profile_t>> &profiles = getProfiles(profilesMtx);
+    profilesMtx->lock();
+    for (auto &profile : profiles)
+        sorted.push_back(profile.get());
+    profilesMtx->unlock();
+
+    // the mutexes the threads have waited for the most come first
+    auto totalWait = [](Profile_t *profile) {
+        uint64_t wait = 0;
+        int count = profile->siteCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++)
+            wait += profile->sites[i].waitNs.load(std::memory_order_relaxed);
+        return wait;
+    };
+    std::vector<std::pair<uint64_t, Profile_t *>> byWait;
+    for (Profile_t *profile : sorted)
+        byWait.push_back({totalWait(profile), profile});
+    std::stable_sort(byWait.begin(), byWait.end(), [](const std::pair<uint64_t, Profile_t *> &a, const std::pair<uint64_t, Profile_t *> &b) {
+        return a.first > b.first;
+    });
+
+    std::stringstream ss;
+    ss << "lock profiling is " << (isEnabled() ? "on" : "off") << "\n";
+    for (auto &it : byWait) {
+        Profile_t *profile = it.second;
+        uint64_t acquisitions = profile->acquisitions.load(std::memory_order_relaxed);
+        if (acquisitions == 0)
+            continue;
+        uint64_t contended = profile->contended.load(std::memory_order_relaxed);
+        int longestSite = profile->maxHoldSite.load(std::memory_order_relaxed);
+        ss << "\n" << profile->name << ": acquired " << acquisitions << "x, contended " << contended << "x (";
+        ss << std::fixed << std::setprecision(1) << 100.0 * contended / acquisitions << "%), waited " << formatDuration(it.first);
+        ss << " (p50 " << formatDuration(profile->wait->quantile(0.5)) << ", p99 " << formatDuration(profile->wait->quantile(0.99)) << ")";
+        ss << ", held p50 " << formatDuration(profile->hold->quantile(0.5)) << ", p99 " << formatDuration(profile->hold->quantile(0.99));
+        if (longestSite >= 0) {
+            const Site_t &site = profile->sites[longestSite];
+            ss << ", longest " << formatDuration(profile->maxHoldNs.load(std::memory_order_relaxed)) << " by " << site.function << ":" << site.line;
+        }
+        ss << "\n";
+
+        // the sites making the others wait the most come first
+        std::vector<Site_t *> sites;
+        int count = profile->siteCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++)
+            sites.push_back(&profile->sites[i]);
+        std::stable_sort(sites.begin(), sites.end(), [](Site_t *a, Site_t *b) {
+            return a->blockedNs.load(std::memory_order_relaxed) > b->blockedNs.load(std::memory_order_relaxed);
+        });
+        ss << "  " << std::left << std::setw(44) << "call site" << std::right << std::setw(10) << "acquired" << std::setw(10) << "contended";
+        ss << std::setw(12) << "waited" << std::setw(12) << "held" << std::setw(12) << "max held" << std::setw(16) << "blocked others" << "\n";
+        for (Site_t *site : sites) {
+            std::string name = std::string(site->function) + ":" + std::to_string(site->line);
+            ss << "  " << std::left << std::setw(44) << name << std::right;
+            ss << std::setw(10) << site->acquisitions.load(std::memory_order_relaxed);
+            ss << std::setw(10) << site->contended.load(std::memory_order_relaxed);
+            ss << std::setw(12) << formatDuration(site->waitNs.load(std::memory_order_relaxed));
+            ss << std::setw(12) << formatDuration(site->holdNs.load(std::memory_order_relaxed));
+            ss << std::setw(12) << formatDuration(site->maxHoldNs.load(std::memory_order_relaxed));
+            ss << std::setw(16) << formatDuration(site->blockedNs.load(std::memory_order_relaxed)) << "\n";
+        }
+    }
+    return ss.str();
+}
+
+void ProfiledMutex::startReporting(const std::string &path) {
+    if (reporting.exchange(true))
+        return;
+    std::thread reporter([path]() {
+        while (1) {
+            std::this_thread::sleep_for(std::chrono::seconds(REPORT_INTERVAL_SECONDS));
+            std::ofstream file(path, std::ios::trunc);
+            file << report();
+        }
+    });
+    reporter.detach();
+}
@@ -0,0 +1,168 @@
+#ifndef PROFILED_MUTEX_H
+#define PROFILED_MUTEX_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Metrics.h"
+#include "Tracer.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Mutex that can profile its own contention (used for the locks of #Server and #Connect4).
+///
+/// Every call of #lock records where it has been called from (the function and the
+/// line, filled in by the compiler). When the profiling is turned on (see #setEnabled),
+/// the mutex records:
+/// - number of acquisitions and contended acquisitions (the mutex was held by someone else),
+/// - histograms of the time spent waiting for the mutex and holding it,
+/// - for every call site, how long it waited, how long it held the mutex and how long
+///   the other threads waited while it was holding the mutex (the site is blamed for it),
+/// - the call site that has held the mutex for the longest time.
+///
+/// All the mutexes of the same name (e.g. the mutexes of every game) share one profile.
+/// When the profiling is off, locking costs one more check of a flag than std::mutex.
+/// A thread tracing a message (see #Tracer) records the time spent waiting for the mutex
+/// either way.
+class ProfiledMutex {
+public:
+    /// maximum number of call sites of one profile (the rest are counted as the last one)
+    static const int MAX_SITES = 64;
+    /// number of seconds between two rewrites of the report file (see #startReporting)
+    static const int REPORT_INTERVAL_SECONDS = 10;
+
+    /// Statistics of one call site
+    struct Site_t {
+        const char *function;              ///< the function locking the mutex
+        int line;                          ///< the line of the function
+        std::atomic<uint64_t> acquisitions; ///< number of acquisitions
+        std::atomic<uint64_t> contended;   ///< number of contended acquisitions
+        std::atomic<uint64_t> waitNs;      ///< time spent waiting for the mutex
+        std::atomic<uint64_t> holdNs;      ///< time the mutex has been held
+        std::atomic<uint64_t> maxHoldNs;   ///< the longest time the mutex has been held
+        std::atomic<uint64_t> blockedNs;   ///< time the other threads spent waiting while the site held the mutex
+    };
+
+    /// Profile of all the mutexes of the same name
+    struct Profile_t {
+        std::string name;                   ///< name of the mutexes
+        std::string waitName;               ///< name of the span of the tracer ("wait <name>")
+        std::atomic<uint64_t> acquisitions; ///< number of acquisitions
+        std::atomic<uint64_t> contended;    ///< number of contended acquisitions
+        Metrics::Histogram *wait;           ///< time spent waiting for the mutex (contended acquisitions)
+        Metrics::Histogram *hold;           ///< time the mutex has been held
+        std::atomic<uint64_t> maxHoldNs;    ///< the longest time the mutex has been held
+        std::atomic<int> maxHoldSite;       ///< the site that held the mutex for the longest time (-1 - none)
+        Site_t sites[MAX_SITES];            ///< the call sites
+        std::atomic<int> siteCount;         ///< number of call sites
+        std::mutex sitesMtx;                ///< lock used when adding a call site
+    };
+
+private:
+    /// the mutex itself
+    std::mutex mtx;
+    /// the profile of the mutex
+    Profile_t *profile;
+    /// when the mutex was locked (0 - the acquisition is not profiled)
+    uint64_t holdStart;
+    /// the call site holding the mutex (-1 - none or not profiled)
+    std::atomic<int> holder;
+
+    /// indication of whether or not the mutexes are profiled
+    static std::atomic<bool> enabled;
+    /// indication of whether or not the report file is rewritten
+    static std::atomic<bool> reporting;
+
+private:
+    /// Returns the current time of the monotonic clock
+    /// \return ns of the monotonic clock
+    static uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Returns the profiles of all the mutexes (created when the first mutex is,
+    /// so the mutexes can also be global variables)
+    /// \param profilesMtx lock used when accessing the profiles
+    /// \return the profiles
+    static std::vector<std::unique_ptr<Profile_t>> &getProfiles(std::mutex *&profilesMtx);
+
+    /// Returns the profile of a name (it is created if it does not exist yet)
+    /// \param name name of the mutexes
+    /// \return the profile
+    static Profile_t *getProfile(const std::string &name);
+
+    /// Returns the index of a call site (it is added if it is not known yet)
+    /// \param function the function locking the mutex
+    /// \param line the line of the function
+    /// \return the index of the call site
+    int getSite(const char *function, int line);
+
+    /// Locks the mutex and records the acquisition (the profiling is on or a message is traced)
+    /// \param function the function locking the mutex
+    /// \param line the line of the function
+    void lockProfiled(const char *function, int line);
+
+    /// Records how long the mutex has been held and unlocks it
+    void unlockProfiled();
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// \param name name of the mutex (the mutexes of the same name share one profile)
+    explicit ProfiledMutex(const std::string &name);
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    ProfiledMutex(const ProfiledMutex&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const ProfiledMutex&) = delete;
+
+    /// Locks the mutex
+    /// \param function the function locking the mutex (filled in by the compiler)
+    /// \param line the line of the function (filled in by the compiler)
+    void lock(const char *function = __builtin_FUNCTION(), int line = __builtin_LINE()) {
+        if (!enabled.load(std::memory_order_relaxed) && !Tracer::isTracing()) {
+            mtx.lock();
+            return;
+        }
+        lockProfiled(function, line);
+    }
+
+    /// Unlocks the mutex
+    void unlock() {
+        if (holdStart != 0) {
+            unlockProfiled();
+            return;
+        }
+        mtx.unlock();
+    }
+
+    /// Turns the profiling of all the mutexes on/off
+    /// \param value true - the mutexes are profiled
+    static void setEnabled(bool value);
+
+    /// Returns whether or not the mutexes are profiled
+    /// \return true, if the mutexes are profiled. Otherwise, false.
+    static bool isEnabled();
+
+    /// Returns the report of the contention of all the mutexes
+    ///
+    /// The mutexes are sorted by the time spent waiting for them and their call sites
+    /// by the time the other threads spent waiting while the site held the mutex.
+    ///
+    /// \return the report (a table per mutex)
+    static std::string report();
+
+    /// Starts a thread rewriting the report file every #REPORT_INTERVAL_SECONDS
+    /// \param path path to the file
+    static void startReporting(const std::string &path);
+};
+
+#endif
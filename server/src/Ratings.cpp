@@ -0,0 +1,344 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Ratings.h"
+#include "Logger.h"
+
+const std::string Ratings::DEFAULT_DIR = "ratings";
+const std::string Ratings::FILE_NAME   = "ratings.dat";
+
+// identification (and version) of the format of the file
+static const char MAGIC[] = "C4RT0001";
+static const size_t MAGIC_SIZE = 8;
+
+/// Computes FNV-1a hash of the data given as a parameter
+/// \param data the data
+/// \param size size of the data
+/// \return hash of the data
+static uint32_t fnv1a(const char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// Appends a value in its binary form to the buffer given as a parameter
+/// \param buffer the buffer
+/// \param value the value
+template<typename T>
+static void put(std::string &buffer, T value) {
+    buffer.append((const char *)&value, sizeof(value));
+}
+
+/// Reads a value in its binary form from the buffer given as a parameter
+/// \param buffer the buffer
+/// \param offset position of the value (moved past it)
+/// \param value the value read
+/// \return false, if the buffer is too short. Otherwise, true.
+template<typename T>
+static bool get(const std::string &buffer, size_t &offset, T &value) {
+    if (offset + sizeof(value) > buffer.size())
+        return false;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+Ratings::Ratings(std::string dir) : dir(dir), tree(MAX_RATING + 2, 0), nicks(MAX_RATING + 1) {
+    running = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+Ratings::~Ratings() {
+    close();
+}
+
+bool Ratings::open() {
+    resultsMtx.lock();
+    if (running) {
+        resultsMtx.unlock();
+        return true;
+    }
+    mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    bool loaded = load();
+    running = true;
+    updater = std::thread(&Ratings::updateHandler, this);
+    resultsMtx.unlock();
+    return loaded;
+}
+
+void Ratings::close() {
+    resultsMtx.lock();
+    if (!running) {
+        resultsMtx.unlock();
+        return;
+    }
+    running = false;
+    resultsMtx.unlock();
+    resultsCv.notify_one();
+    updater.join();
+}
+
+void Ratings::submit(const std::string &player1, const std::string &player2, double score) {
+    resultsMtx.lock();
+    results.push_back({player1, player2, score});
+    resultsMtx.unlock();
+    resultsCv.notify_one();
+}
+
+void Ratings::updateHandler() {
+    std::vector<Result_t> batch;
+    bool dirty = false;
+    auto lastSave = std::chrono::steady_clock::now();
+    while (1) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(resultsMtx);
+            auto wakeUp = [&]() { return !running || !results.empty(); };
+            // the changed ratings are written once #SECONDS_BETWEEN_SAVES
+            // have passed since the last write even if no other game ends
+            if (dirty)
+                resultsCv.wait_until(lock, lastSave + std::chrono::seconds(SECONDS_BETWEEN_SAVES), wakeUp);
+            else resultsCv.wait(lock, wakeUp);
+            stop = !running;
+            batch.clear();
+            batch.swap(results);
+        }
+
+        if (!batch.empty()) {
+            ratingsMtx.lock();
+            for (const Result_t &result : batch)
+                apply(result);
+            ratingsMtx.unlock();
+            dirty = true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (dirty && (stop || now - lastSave >= std::chrono::seconds(SECONDS_BETWEEN_SAVES))) {
+            save();
+            dirty = false;
+            lastSave = now;
+        }
+        if (stop)
+            return;
+    }
+}
+
+void Ratings::apply(const Result_t &result) {
+    if (result.player1 == result.player2)
+        return;
+    auto it1 = players.find(result.player1);
+    auto it2 = players.find(result.player2);
+    Player_t player1 = it1 != players.end() ? it1->second : Player_t{(double)DEFAULT_RATING, 0};
+    Player_t player2 = it2 != players.end() ? it2->second : Player_t{(double)DEFAULT_RATING, 0};
+
+    double expected = 1.0 / (1.0 + pow(10.0, (player2.rating - player1.rating) / 400.0));
+    double change = K_FACTOR * (result.score - expected);
+    int from1 = it1 != players.end() ? toBucket(player1.rating) : -1;
+    int from2 = it2 != players.end() ? toBucket(player2.rating) : -1;
+    player1.rating = std::max(0.0, std::min((double)MAX_RATING, player1.rating + change));
+    player2.rating = std::max(0.0, std::min((double)MAX_RATING, player2.rating - change));
+    player1.games++;
+    player2.games++;
+
+    players[result.player1] = player1;
+    players[result.player2] = player2;
+    move(result.player1, from1, toBucket(player1.rating));
+    move(result.player2, from2, toBucket(player2.rating));
+    stats.results++;
+}
+
+void Ratings::move(const std::string &nick, int from, int to) {
+    if (from == to)
+        return;
+    if (from >= 0) {
+        nicks[from].erase(nick);
+        add(from, -1);
+    }
+    nicks[to].insert(nick);
+    add(to, 1);
+}
+
+void Ratings::add(int rating, int64_t delta) {
+    for (size_t i = rating + 1; i < tree.size(); i += i & (~i + 1))
+        tree[i] += delta;
+}
+
+uint64_t Ratings::countUpTo(int rating) const {
+    uint64_t count = 0;
+    for (size_t i = rating + 1; i > 0; i -= i & (~i + 1))
+        count += tree[i];
+    return count;
+}
+
+int Ratings::ratingAt(uint64_t position) const {
+    // the position counting from the worst player
+    uint64_t remaining = players.size() - position + 1;
+    size_t index = 0;
+    size_t step = 1;
+    while (step * 2 < tree.size())
+        step *= 2;
+    for (; step > 0; step /= 2) {
+        if (index + step < tree.size() && tree[index + step] < remaining) {
+            index += step;
+            remaining -= tree[index];
+        }
+    }
+    // index is the last bucket holding fewer players, so the rating is the next one
+    return (int)index;
+}
+
+int Ratings::toBucket(double rating) {
+    return std::max(0, std::min(MAX_RATING, (int)lround(rating)));
+}
+
+int Ratings::getRating(const std::string &nick) {
+    ratingsMtx.lock();
+    auto it = players.find(nick);
+    int rating = it != players.end() ? toBucket(it->second.rating) : DEFAULT_RATING;
+    ratingsMtx.unlock();
+    return rating;
+}
+
+bool Ratings::getRank(const std::string &nick, Entry_t &entry) {
+    ratingsMtx.lock();
+    auto it = players.find(nick);
+    bool found = it != players.end();
+    if (found) {
+        int rating = toBucket(it->second.rating);
+        entry = {nick, players.size() - countUpTo(rating) + 1, rating, it->second.games};
+    }
+    ratingsMtx.unlock();
+    return found;
+}
+
+void Ratings::getTop(size_t count, std::vector<Entry_t> &entries) {
+    count = std::min(count, MAX_TOP);
+    ratingsMtx.lock();
+    uint64_t taken = 0;
+    while (entries.size() < count && taken < players.size()) {
+        int rating = ratingAt(taken + 1);
+        for (const std::string &nick : nicks[rating]) {
+            if (entries.size() == count)
+                break;
+            entries.push_back({nick, taken + 1, rating, players[nick].games});
+        }
+        taken += nicks[rating].size();
+    }
+    ratingsMtx.unlock();
+}
+
+Ratings::Stats_t Ratings::getStats() {
+    ratingsMtx.lock();
+    Stats_t current = stats;
+    current.players = players.size();
+    ratingsMtx.unlock();
+    resultsMtx.lock();
+    current.pending = results.size();
+    resultsMtx.unlock();
+    return current;
+}
+
+bool Ratings::save() {
+    std::string buffer(MAGIC, MAGIC_SIZE);
+    ratingsMtx.lock();
+    buffer.reserve(MAGIC_SIZE + 16 + players.size() * 32);
+    put<uint64_t>(buffer, players.size());
+    for (const auto &player : players) {
+        put<uint16_t>(buffer, player.first.size());
+        buffer += player.first;
+        put<double>(buffer, player.second.rating);
+        put<uint32_t>(buffer, player.second.games);
+    }
+    ratingsMtx.unlock();
+    put<uint32_t>(buffer, fnv1a(buffer.data(), buffer.size()));
+
+    std::string path = dir + "/" + FILE_NAME;
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        LOG_ERR("creating ratings '" + tmpPath + "' failed");
+        return false;
+    }
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            LOG_ERR("writing ratings '" + tmpPath + "' failed");
+            ::close(fd);
+            return false;
+        }
+        written += n;
+    }
+    if (fdatasync(fd) < 0) {
+        LOG_ERR("fdatasync of ratings '" + tmpPath + "' failed");
+        ::close(fd);
+        return false;
+    }
+    ::close(fd);
+
+    // replace the old file atomically
+    if (rename(tmpPath.c_str(), path.c_str()) < 0) {
+        LOG_ERR("renaming ratings '" + tmpPath + "' failed");
+        return false;
+    }
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        ::close(dirFd);
+    }
+    ratingsMtx.lock();
+    stats.saves++;
+    ratingsMtx.unlock();
+    return true;
+}
+
+bool Ratings::load() {
+    std::ifstream file(dir + "/" + FILE_NAME, std::ios::in | std::ios::binary);
+    if (file.fail())
+        return true;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string buffer = ss.str();
+
+    uint32_t checksum;
+    size_t offset = buffer.size() - sizeof(checksum);
+    if (buffer.size() < MAGIC_SIZE + sizeof(uint64_t) + sizeof(checksum) || buffer.compare(0, MAGIC_SIZE, MAGIC) != 0 ||
+        !get(buffer, offset, checksum) || checksum != fnv1a(buffer.data(), buffer.size() - sizeof(checksum))) {
+        LOG_ERR("ratings '" + dir + "/" + FILE_NAME + "' are not valid");
+        return false;
+    }
+    buffer.resize(buffer.size() - sizeof(checksum));
+
+    offset = MAGIC_SIZE;
+    uint64_t count = 0;
+    get(buffer, offset, count);
+    ratingsMtx.lock();
+    for (uint64_t i = 0; i < count; i++) {
+        uint16_t length;
+        Player_t player;
+        if (!get(buffer, offset, length) || offset + length > buffer.size())
+            break;
+        std::string nick(buffer, offset, length);
+        offset += length;
+        if (!get(buffer, offset, player.rating) || !get(buffer, offset, player.games))
+            break;
+        if (players.find(nick) != players.end())
+            continue;
+        players[nick] = player;
+        move(nick, -1, toBucket(player.rating));
+    }
+    ratingsMtx.unlock();
+    return true;
+}
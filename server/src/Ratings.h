@@ -0,0 +1,200 @@
+#ifndef RATINGS_H
+#define RATINGS_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Elo ratings of the players and the leaderboard.
+///
+/// The results of the games are only queued by #submit (called by the thread
+/// handling the players when a game is over); a background thread applies them,
+/// so the players never wait for the ratings to be updated.
+///
+/// The leaderboard is a Fenwick tree over the ratings (one bucket per rating point,
+/// #MAX_RATING + 1 buckets) holding the number of players with each rating.
+/// The rank of a player is the number of players rated higher (plus one), which is
+/// one prefix sum, and the n-th best rating is found by descending the tree, so both
+/// #getRank and every entry of #getTop take O(log #MAX_RATING) no matter how many
+/// players there are. The players sharing a rating share the rank as well.
+///
+/// The ratings are written into a file (#FILE_NAME) at most every
+/// #SECONDS_BETWEEN_SAVES seconds after they change (and when the service
+/// is closed) and read back when the service is opened.
+class Ratings {
+public:
+    /// default directory of the ratings
+    static const std::string DEFAULT_DIR;
+    /// name of the file holding the ratings
+    static const std::string FILE_NAME;
+    /// rating of a player who has not finished any game yet
+    static const int DEFAULT_RATING = 1500;
+    /// the highest rating (the ratings are kept within 0 - #MAX_RATING)
+    static const int MAX_RATING = 4000;
+    /// how much one game can change a rating at most
+    static const int K_FACTOR = 32;
+    /// the most players returned by #getTop
+    static const size_t MAX_TOP = 100;
+    /// the least amount of seconds between two writes of the ratings into the file
+    static const int SECONDS_BETWEEN_SAVES = 5;
+
+    /// One entry of the leaderboard
+    struct Entry_t {
+        std::string nick; ///< nick of the player
+        uint64_t rank;    ///< rank of the player (1 - the best one)
+        int rating;       ///< rating of the player
+        uint32_t games;   ///< number of games the rating is based on
+    };
+
+    /// Statistics of the ratings
+    struct Stats_t {
+        uint64_t players; ///< number of rated players
+        uint64_t results; ///< number of results applied since the service was opened
+        uint64_t pending; ///< number of results waiting to be applied
+        uint64_t saves;   ///< number of times the ratings have been written into the file
+    };
+
+private:
+    /// Rating of one player
+    struct Player_t {
+        double rating;  ///< the rating (rounded when it is put into the leaderboard)
+        uint32_t games; ///< number of games the rating is based on
+    };
+
+    /// Result of one game waiting to be applied
+    struct Result_t {
+        std::string player1; ///< nick of player1
+        std::string player2; ///< nick of player2
+        double score;        ///< score of player1 (1 - won, 0.5 - draw, 0 - lost)
+    };
+
+    /// directory of the ratings
+    std::string dir;
+
+    /// lock used when accessing the ratings and the leaderboard
+    std::mutex ratingsMtx;
+    /// the ratings (the key is the nick of the player)
+    std::unordered_map<std::string, Player_t> players;
+    /// the Fenwick tree - number of players with every rating (1-based, rating r is at r + 1)
+    std::vector<uint64_t> tree;
+    /// nicks of the players with every rating (sorted, so the order of the leaderboard is stable)
+    std::vector<std::set<std::string>> nicks;
+
+    /// lock used when accessing the queued results
+    std::mutex resultsMtx;
+    /// used to wake up the thread applying the results
+    std::condition_variable resultsCv;
+    /// results waiting to be applied
+    std::vector<Result_t> results;
+    /// indication of whether or not the thread applying the results should keep running
+    bool running;
+    /// the thread applying the results
+    std::thread updater;
+    /// statistics of the ratings
+    Stats_t stats;
+
+private:
+    /// The body of the thread applying the queued results
+    void updateHandler();
+
+    /// Applies the result of a game to the ratings of both the players (#ratingsMtx must be locked)
+    /// \param result the result
+    void apply(const Result_t &result);
+
+    /// Moves a player to another rating in the leaderboard (#ratingsMtx must be locked)
+    /// \param nick nick of the player
+    /// \param from the old rating (-1 if the player has not been rated)
+    /// \param to the new rating
+    void move(const std::string &nick, int from, int to);
+
+    /// Adds a value to the number of players with a rating (#ratingsMtx must be locked)
+    /// \param rating the rating
+    /// \param delta the value
+    void add(int rating, int64_t delta);
+
+    /// Returns the number of players with a rating lower than or equal to the one given
+    /// as a parameter (#ratingsMtx must be locked)
+    /// \param rating the rating
+    /// \return number of players
+    uint64_t countUpTo(int rating) const;
+
+    /// Returns the rating of the player at the position given as a parameter
+    /// counting from the best one (#ratingsMtx must be locked)
+    /// \param position the position (1 - the best player)
+    /// \return the rating
+    int ratingAt(uint64_t position) const;
+
+    /// Writes the ratings into the file
+    /// \return true, if the ratings have been written. Otherwise, false.
+    bool save();
+
+    /// Reads the ratings from the file
+    /// \return false, if the file exists but it is not valid. Otherwise, true.
+    bool load();
+
+    /// Converts a rating to the bucket of the leaderboard
+    /// \param rating the rating
+    /// \return the rating rounded and clamped to 0 - #MAX_RATING
+    static int toBucket(double rating);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// Nothing is read or written until the ratings are opened (see #open).
+    /// \param dir directory of the ratings
+    explicit Ratings(std::string dir = DEFAULT_DIR);
+
+    /// Destructor of the class - closes the ratings (see #close)
+    ~Ratings();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Ratings(const Ratings&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Ratings&) = delete;
+
+    /// Reads the ratings from the file and starts the thread applying the results
+    /// \return false, if the file could not be read (everyone starts with #DEFAULT_RATING). Otherwise, true.
+    bool open();
+
+    /// Applies the results waiting to be applied, stops the thread
+    /// and writes the ratings into the file
+    void close();
+
+    /// Queues the result of a game (it is applied in the background)
+    /// \param player1 nick of player1
+    /// \param player2 nick of player2
+    /// \param score score of player1 (1 - won, 0.5 - draw, 0 - lost)
+    void submit(const std::string &player1, const std::string &player2, double score);
+
+    /// Returns the rating of a player
+    /// \param nick nick of the player
+    /// \return the rating, #DEFAULT_RATING if the player has not been rated
+    int getRating(const std::string &nick);
+
+    /// Returns the position of a player in the leaderboard
+    /// \param nick nick of the player
+    /// \param entry the entry of the player
+    /// \return false, if the player has not been rated. Otherwise, true.
+    bool getRank(const std::string &nick, Entry_t &entry);
+
+    /// Returns the best players
+    /// \param count number of players (at most #MAX_TOP)
+    /// \param entries the entries (the best player first)
+    void getTop(size_t count, std::vector<Entry_t> &entries);
+
+    /// Returns the statistics of the ratings
+    /// \return statistics of the ratings
+    Stats_t getStats();
+};
+
+#endif
@@ -1,8 +1,16 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <netinet/tcp.h>
+
 #include "Server.h"
 
 // function prototypes
 bool validNick(const std::vector<std::string>& tokens);
 bool validGameRq(const std::vector<std::string>& tokens);
+bool validWatch(const std::vector<std::string>& tokens);
+bool validUnwatch(const std::vector<std::string>& tokens);
+bool validQueue(const std::vector<std::string>& tokens);
+bool validQueueCancel(const std::vector<std::string>& tokens);
 bool validExit(const std::vector<std::string>& tokens);
 bool validPing(const std::vector<std::string>& tokens);
 bool validGetNick(const std::vector<std::string>& tokens);
@@ -13,11 +21,26 @@ bool validHelp(const std::vector<std::string>& tokens);
 bool validReply(const std::vector<std::string>& tokens);
 bool validGameCanceled(const std::vector<std::string>& tokens);
 bool validGamePlay(const std::vector<std::string>& tokens);
-
-Server::Server(int port, int maxClients) {
+bool validGameResync(const std::vector<std::string>& tokens);
+bool validGetHistory(const std::vector<std::string>& tokens);
+bool validGetGame(const std::vector<std::string>& tokens);
+bool validDownloadGame(const std::vector<std::string>& tokens);
+bool validDownloadDay(const std::vector<std::string>& tokens);
+bool validGetRank(const std::vector<std::string>& tokens);
+bool validGetTop(const std::vector<std::string>& tokens);
+bool validAnalyze(const std::vector<std::string>& tokens);
+bool isNumber(const std::string& str, size_t maxLength);
+
+Server::Server(int port, int maxClients) : annotator(gameStore) {
     this->maxClients = maxClients;
+    timeouts.replyToGameRq = SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ;
+    timeouts.disconnectedPlayer = SECONDS_WAITING_FOR_DISCONNECTED_PLAYER;
+    timeouts.clientEnterNick = SECONDS_WAITING_FOR_CLIENT_ENTER_NICK;
+    timeouts.pingReply = SECONDS_PING_REPLY;
+    timeouts.clientToPlay = Connect4::SECONDS_WAITING_FOR_CLIENT_TO_PLAY;
     conn.port = port;
     numberOfClients = 0;
+    numberOfDownloads = 0;
     srand(time(0));
 
     // initialize the table of commands
@@ -27,19 +50,92 @@ Server::Server(int port, int maxClients) {
     msgValidation["/NICK"] = {I_GET_NICK, &validGetNick, "returns client's nick"};
     msgValidation["/HELP"] = {I_HELP, &validHelp, "prints out help"};
     msgValidation["/ALL_CLIENTS"] = {I_GET_ALL_CLIENTS, &validGetAllClients, "returns nicks of all clients connected to the server"};
+    msgValidation["/HISTORY"] = {I_GET_HISTORY, &validGetHistory, "<nick> [cursor] returns the most recent finished games of the player (one page)"};
+    msgValidation["/GAME"] = {I_GET_GAME, &validGetGame, "<id> returns a finished game"};
+    msgValidation["/DOWNLOAD_GAME"] = {I_DOWNLOAD_GAME, &validDownloadGame, "<id> downloads the record of a finished game"};
+    msgValidation["/DOWNLOAD_DAY"] = {I_DOWNLOAD_DAY, &validDownloadDay, "<YYYYMMDD> downloads all the games finished on the day"};
+    msgValidation["/RANK"] = {I_GET_RANK, &validGetRank, "<nick> returns the rating and the rank of the player"};
+    msgValidation["/TOP"] = {I_GET_TOP, &validGetTop, "<k> returns the k best players (at most 100)"};
+    msgValidation["/ANALYZE"] = {I_ANALYZE, &validAnalyze, "returns the value of every column of the game the client is playing"};
 
     msgValidation["NICK"] = {I_NICK, &validNick, "<nick> sets the client's nick to the value given as a parameter (one word)"};
     msgValidation["RQ"] = {I_GAME_RQ, &validGameRq, "<nick> sends a game request to the client"};
+    msgValidation["WATCH"] = {I_WATCH, &validWatch, "<nick> watches the game the client is playing (in the lobby)"};
+    msgValidation["UNWATCH"] = {I_UNWATCH, &validUnwatch, "stops watching the game"};
+    msgValidation["QUEUE"] = {I_QUEUE, &validQueue, "joins the matchmaking queue (an opponent of a similar rating is found automatically)"};
+    msgValidation["QUEUE_CANCEL"] = {I_QUEUE_CANCEL, &validQueueCancel, "leaves the matchmaking queue"};
     msgValidation["RQ_CANCELED"] = {I_RQ_CANCELED, &validRqCanceled, "<nick> cancels the game request sent to the client"};
     msgValidation["RPL"] = {I_RPL, &validReply, "<nick> <YES/NO> accepts/rejects the game request sent from the client"};
 
     msgValidation["GAME_CANCELED"] = {I_GAME_CANCELED, &validGameCanceled, "exists the current game"};
     msgValidation["GAME_PLAY"] = {I_GAME_PLAY, &validGamePlay, "x plays the game (one move)"};
+    msgValidation["GAME_RESYNC"] = {I_GAME_RESYNC, &validGameResync, "<n> returns the moves of the game from the n-th one on (GAME_RECOVERY)"};
+
+    registerMetrics();
+}
+
+void Server::registerMetrics() {
+    Metrics *metrics = Metrics::getInstance();
+    acceptedConnections = &metrics->counter("connect4_connections_total", "Number of connections accepted", "result=\"accepted\"");
+    rejectedConnections = &metrics->counter("connect4_connections_total", "Number of connections accepted", "result=\"rejected\"");
+    connectedClients = &metrics->gauge("connect4_clients", "Number of clients connected to the server at the moment");
+    reconnectingPlayers = &metrics->gauge("connect4_reconnecting_players", "Number of players the server is waiting for to reconnect");
+
+    // every message is counted under the name it has in the protocol
+    std::string names[UNKNOWN + 1];
+    for (auto &it : msgValidation)
+        names[it.second.msg] = it.first;
+    names[UNKNOWN] = "UNKNOWN";
+    for (int i = 0; i <= UNKNOWN; i++) {
+        std::string labels = "type=\"" + names[i] + "\"";
+        messageMetrics[i].received = &metrics->counter("connect4_messages_total", "Number of messages received from the clients", labels);
+        messageMetrics[i].latency = &metrics->histogram("connect4_message_handling_seconds", "Time it takes to handle a message received from a client", labels);
+    }
+
+    // the services take only their own locks when reporting their stats
+    metrics->callback("connect4_downloads", "Number of downloads running at the moment", [this]() { return (double)numberOfDownloads; });
+    metrics->callback("connect4_journal_records_total", "Number of records written into the journal", [this]() { return (double)journal.getStats().records; });
+    metrics->callback("connect4_journal_syncs_total", "Number of group commits of the journal", [this]() { return (double)journal.getStats().syncs; });
+    metrics->callback("connect4_journal_failures_total", "Number of group commits of the journal that failed", [this]() { return (double)journal.getStats().failures; });
+    metrics->callback("connect4_store_games_total", "Number of games stored since the server started", [this]() { return (double)gameStore.getStats().games; });
+    metrics->callback("connect4_spectators", "Number of clients watching a game", [this]() { return (double)spectators.getStats().spectators; });
+    metrics->callback("connect4_spectator_frames_total", "Number of frames sent off to the spectators", [this]() { return (double)spectators.getStats().sent; });
+    metrics->callback("connect4_matchmaking_queue", "Number of players in the matchmaking queue", [this]() { return (double)matchmaker.getStats().queued; });
+    metrics->callback("connect4_ratings_pending", "Number of results waiting to be applied to the ratings", [this]() { return (double)ratings.getStats().pending; });
+    metrics->callback("connect4_analysis_requests_total", "Number of analysis requests served", [this]() { return (double)analyzer.getStats().requests; });
+    metrics->callback("connect4_analysis_cache_hit_rate", "Hit rate of the cache of analyzed positions", [this]() { return analyzer.getStats().hitRate; });
+    metrics->callback("connect4_reviews_queued", "Number of finished games waiting to be reviewed", [this]() { return (double)annotator.getStats().queued; });
+    metrics->callback("connect4_log_messages_total", "Number of log messages written", []() { return (double)Logger::getInstance()->getStats().written; });
+    metrics->callback("connect4_log_dropped_total", "Number of log messages dropped", []() { return (double)Logger::getInstance()->getStats().dropped; });
 }
 
 void Server::startServer() {
     LOG_BOOTING("<[STARTING SERVER]>");
-    LOG_BOOTING("[port=" + std::to_string(conn.port) + " max clients=" + std::to_string(maxClients) + "]");
+    LOG_BOOTING("[port=" + std::to_string(conn.port) + " max clients=" + std::to_string(maxClients.load()) + "]");
+    LOG_BOOTING("restoring the games in progress");
+    size_t restoredGames = restoreGames();
+    LOG_BOOTING("opening the store of finished games");
+    if (!gameStore.open())
+        LOG_WARNING("the store of finished games could not be opened - games will not be stored");
+    else annotator.open(Annotator::DEFAULT_THREADS, OpeningBook::getDefault());
+    spectators.open(PROTOCOL_ID);
+    analyzer.open(Analyzer::DEFAULT_THREADS, OpeningBook::getDefault(), Tablebase::getDefault());
+    LOG_BOOTING("loading the ratings of the players");
+    if (!ratings.open())
+        LOG_WARNING("the ratings could not be loaded - everyone starts with the default rating");
+    std::thread matchmakingThread(&Server::matchmakingHandler, this);
+    matchmakingThread.detach();
+    LOG_BOOTING("opening the journal of games");
+    if (!journal.open())
+        LOG_WARNING("the journal could not be opened - games will not be journaled");
+    else {
+        std::thread snapshotThread(&Server::snapshotHandler, this);
+        snapshotThread.detach();
+    }
+    if (restoredGames > 0) {
+        std::thread restoredPlayersThread(&Server::waitingForRestoredPlayersHandler, this);
+        restoredPlayersThread.detach();
+    }
     createFileDescriptor();
     attachSocketToPort();
     bindServer();
@@ -47,6 +143,127 @@ void Server::startServer() {
     run();
 }
 
+size_t Server::restoreGames() {
+    std::vector<Snapshot::Room_t> rooms;
+    Snapshot::Stats_t stats;
+    Snapshot::recover(Journal::DEFAULT_DIR, rooms, stats);
+    LOG_BOOTING("snapshot: lsn=" + std::to_string(stats.snapshotLsn) + " games=" + std::to_string(stats.snapshotRooms) +
+                ", journal: " + std::to_string(stats.records) + " records replayed from " + std::to_string(stats.segments) + " segments");
+
+    size_t restored = 0;
+    gameRoomsMtx.lock();
+    reconnectingClientsMtx.lock();
+    for (const Snapshot::Room_t &room : rooms) {
+        if (room.player1 == room.player2 || restoredGameRooms.find(room.player1) != restoredGameRooms.end() ||
+            restoredGameRooms.find(room.player2) != restoredGameRooms.end()) {
+            LOG_WARNING("game " + std::to_string(room.id) + " cannot be restored (either of the players is in another game)");
+            continue;
+        }
+        Connect4 *game = new Connect4(room.player1, room.player2, this, room.id, true);
+        if (!game->replay(room.moves)) {
+            LOG_WARNING("game " + std::to_string(room.id) + " cannot be restored (invalid moves)");
+            delete game;
+            continue;
+        }
+        GameRoom_t *gameRoom = new GameRoom_t{room.player1, room.player2, game, room.id, time(NULL)};
+        restoredGameRooms[room.player1] = gameRoom;
+        restoredGameRooms[room.player2] = gameRoom;
+        reconnectingClients[room.player1] = room.player2;
+        reconnectingClients[room.player2] = room.player1;
+        restored++;
+    }
+    reconnectingPlayers->set(reconnectingClients.size());
+    reconnectingClientsMtx.unlock();
+    gameRoomsMtx.unlock();
+    LOG_BOOTING("restored games: " + std::to_string(restored));
+    return restored;
+}
+
+void Server::waitingForRestoredPlayersHandler() {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"restored\""));
+    for (int i = 0; i < timeouts.disconnectedPlayer; i++) {
+        gameRoomsMtx.lock();
+        size_t waiting = restoredGameRooms.size();
+        gameRoomsMtx.unlock();
+        if (waiting == 0) {
+            LOG_COUNTDOWN("all the players of the restored games have connected back to the server");
+            return;
+        }
+        int remainingSeconds = timeouts.disconnectedPlayer - i;
+        LOG_COUNTDOWN_F("waiting for {} players of the restored games to reconnect back to the server (remaining second: {})", waiting, remainingSeconds);
+        sleep(1);
+    }
+
+    // the games neither of whose players has come back are deleted right away,
+    // the other ones are canceled as if the player lost their connection
+    std::vector<std::string> timedOut;
+    std::vector<GameRoom_t *> abandoned;
+    gameRoomsMtx.lock();
+    reconnectingClientsMtx.lock();
+    for (auto it : restoredGameRooms) {
+        GameRoom_t *gameRoom = it.second;
+        std::string opponent = gameRoom->player1 == it.first ? gameRoom->player2 : gameRoom->player1;
+        if (gameRooms.find(opponent) != gameRooms.end())
+            timedOut.push_back(it.first);
+        else if (gameRoom->player1 == it.first) {
+            reconnectingClients.erase(gameRoom->player1);
+            reconnectingClients.erase(gameRoom->player2);
+            abandoned.push_back(gameRoom);
+        }
+    }
+    restoredGameRooms.clear();
+    reconnectingPlayers->set(reconnectingClients.size());
+    for (GameRoom_t *gameRoom : abandoned) {
+        journal.append(Journal::GAME_CANCELED, gameRoom->id, "neither of the players has been connected back to the server");
+        delete gameRoom->game;
+        delete gameRoom;
+    }
+    reconnectingClientsMtx.unlock();
+    gameRoomsMtx.unlock();
+    LOG_GAME("restored games deleted (neither of the players connected back): " + std::to_string(abandoned.size()));
+
+    for (const std::string &player : timedOut)
+        if (isPlayerOnReconnectingList(player))
+            removePlayerFromReconnectingList(player, false);
+}
+
+void Server::snapshotHandler() {
+    while (1) {
+        writeSnapshot();
+        sleep(SECONDS_BETWEEN_SNAPSHOTS);
+    }
+}
+
+void Server::writeSnapshot() {
+    std::vector<Snapshot::Room_t> rooms;
+    std::unordered_set<GameRoom_t *> seen;
+    gameRoomsMtx.lock();
+    // every change of a game is journaled while holding the lock,
+    // so the games reflect exactly the records up to this one
+    uint64_t lsn = journal.getLastLsn();
+    for (auto *map : {&gameRooms, &restoredGameRooms})
+        for (auto it : *map) {
+            GameRoom_t *gameRoom = it.second;
+            if (!seen.insert(gameRoom).second || gameRoom->game->isOver())
+                continue;
+            rooms.push_back({gameRoom->id, gameRoom->player1, gameRoom->player2, gameRoom->game->getMoves()});
+        }
+    gameRoomsMtx.unlock();
+
+    // the snapshot must not cover records that could still be lost
+    if (!journal.waitDurable(lsn)) {
+        LOG_WARNING("the journal is not being written - no snapshot of the games in progress is taken");
+        return;
+    }
+    if (!Snapshot::write(Journal::DEFAULT_DIR, lsn, rooms)) {
+        LOG_WARNING("the snapshot of the games in progress could not be written");
+        return;
+    }
+    size_t removed = Snapshot::removeCoveredSegments(Journal::DEFAULT_DIR, lsn);
+    if (removed > 0)
+        LOG_INFO(std::to_string(removed) + " segments of the journal covered by the snapshot were deleted");
+}
+
 void Server::createFileDescriptor() {
     LOG_BOOTING("creating a socket file descriptor");
     if ((conn.serverFd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
@@ -80,7 +297,8 @@ void Server::bindServer() {
 
 void Server::setListening() {
     LOG_BOOTING("setting listening");
-    if (listen(conn.serverFd, 5) < 0) {
+    // many clients may connect at once (the connections are reset when the queue overflows)
+    if (listen(conn.serverFd, SOMAXCONN) < 0) {
         LOG_ERR("listening failed");
         exit(EXIT_FAILURE);
     }
@@ -121,63 +339,72 @@ void Server::run() {
         std::string clientIp = ipStr(conn.address);
         LOG_INFO("new client (" + clientIp + ") just got connected to the server");
 
-        if (numberOfClients == maxClients) {
+        if (numberOfClients >= maxClients) {
+            rejectedConnections->inc();
             LOG_WARNING("the maximum number of clients has been reached");
             LOG_WARNING("disconnecting client " + clientIp + " from the server");
             close(socket);
             continue;
         }
+        // the messages are small and often sent right after each other
+        // (e.g. a move and a presence broadcast), so they are not held back
+        // until the client acknowledges the previous one (Nagle's algorithm)
+        int noDelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
         numberOfClients++;
+        acceptedConnections->inc();
+        connectedClients->inc();
         Client *client = new Client(socket, clientIp, PROTOCOL_ID);
         std::thread clientHandler(&Server::handleClient, this, client);
         clientHandler.detach();
-        usleep(100000);
     }
 }
 
 void Server::enteringNickHandler(Client *client) {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"nick\""));
     clientMtx.lock();
     std::string clientStr = client->toStr();
     clientMtx.unlock();
 
-    for (int i = 0; i < SECONDS_WAITING_FOR_CLIENT_ENTER_NICK; i++) {
+    for (int i = 0; i < timeouts.clientEnterNick; i++) {
         clientMtx.lock();
         Client::State state = client->getState();
         clientMtx.unlock();
 
         if (state != Client::NICK) {
-            LOG_COUNTDOWN("waiting for client " + clientStr +" was interrupted");
+            LOG_COUNTDOWN_F("waiting for client {} was interrupted", clientStr);
             return;
         }
-        int remainingSeconds = SECONDS_WAITING_FOR_CLIENT_ENTER_NICK - i;
-        LOG_COUNTDOWN("waiting for client " + clientStr + " to enter their nick (remaining second: " + std::to_string(remainingSeconds) + ")");
+        int remainingSeconds = timeouts.clientEnterNick - i;
+        LOG_COUNTDOWN_F("waiting for client {} to enter their nick (remaining second: {})", clientStr, remainingSeconds);
         sleep(1);
     }
-    LOG_ERR("client " + clientStr + " did not enter their nick within " + std::to_string(SECONDS_WAITING_FOR_CLIENT_ENTER_NICK) + "s");
+    LOG_ERR("client " + clientStr + " did not enter their nick within " + std::to_string(timeouts.clientEnterNick.load()) + "s");
     clientMtx.lock();
     client->setHandlingThreadRunning(false);
     clientMtx.unlock();
 }
 
 void Server::clientPingHandler(Client *client) {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"ping\""));
     int counter = 0;
     int remainingTime;
     std::string clientStr = "UNDEFINED_NICK";
     Client::State state;
     
-    while (counter != SECONDS_PING_REPLY) {
+    while (counter < timeouts.pingReply) {
         clientMtx.lock();
         state = client->getState();
         clientStr = client->toStr();
         clientMtx.unlock();
 
         if (state == Client::KILL_THREAD) {
-            LOG_COUNTDOWN("waiting for client " + clientStr + " to send a PING msg was interrupted");
+            LOG_COUNTDOWN_F("waiting for client {} to send a PING msg was interrupted", clientStr);
             return;
         }
 
-        remainingTime = SECONDS_PING_REPLY - counter;
-        LOG_COUNTDOWN("waiting for client " + clientStr + " to send a PING msg " + std::to_string(remainingTime) + "s");
+        remainingTime = timeouts.pingReply - counter;
+        LOG_COUNTDOWN_F("waiting for client {} to send a PING msg {}s", clientStr, remainingTime);
         clientMtx.lock();
         if (client->getReceivedPing()) {
             client->setReceivedPing(false);
@@ -187,7 +414,7 @@ void Server::clientPingHandler(Client *client) {
         clientMtx.unlock();
         sleep(1);
     }
-    LOG_COUNTDOWN("client " + clientStr +" has not sent a PING within " + std::to_string(SECONDS_PING_REPLY) + "s");
+    LOG_COUNTDOWN_F("client {} has not sent a PING within {}s", clientStr, counter);
     clientMtx.lock();
     client->setHandlingThreadRunning(false);
     clientMtx.unlock();
@@ -195,7 +422,7 @@ void Server::clientPingHandler(Client *client) {
 
 int Server::recvNBytes(int socket, char *buff, ssize_t numberOfBytes) {
     char *pos = buff;
-    ssize_t receivedBytes;
+    ssize_t receivedBytes = 0;
 
     while (numberOfBytes > 0 && (receivedBytes = recv(socket, pos, numberOfBytes, 0)) > 0) {
         pos += receivedBytes;
@@ -240,6 +467,8 @@ void Server::handleClient(Client *client) {
         select(FD_SETSIZE, &sockets, NULL, NULL, &timeout);
 
         if (FD_ISSET(client->getSocket(), &sockets)) {
+                Tracer::Message traced;
+                Tracer::Span reading("read", "socket");
                 msgLen = recvNBytes(client->getSocket(), buffer, PROTOCOL_ID.length());
                 if (msgLen != 0) {
                     LOG_ERR("Client ('" + client->getNick() + "') Receiving the protocol id failed");
@@ -271,13 +500,22 @@ void Server::handleClient(Client *client) {
                 }
                 receivedMsg = std::string(buffer);
                 receivedMsg.pop_back();
+                reading.end();
                 if (receivedMsg == "")
                     continue;
 
-                LOG_MSG("received message from client " + client->toStr() + ": '" + receivedMsg + "'");
+                LOG_MSG_F("received message from client {}: '{}'", client->toStr(), receivedMsg);
 
+                Tracer::Span parsing("parse", "message");
                 tokens = split(receivedMsg, MSG_SEPARATOR);
                 msg = getTypeOfMessage(tokens);
+                parsing.end();
+                messageMetrics[msg].received->inc();
+                Metrics::Timer handling(*messageMetrics[msg].latency);
+                // the type of the message and the state of the client (the case it is handled by)
+                Tracer::Span dispatching("dispatch", "message");
+                if (Tracer::isTracing())
+                    dispatching.setDetail((msg == UNKNOWN ? std::string("UNKNOWN") : tokens[0]) + " state=" + std::to_string(client->getState()));
 
                 if (msg == UNKNOWN) {
                     client->sendMessage(O_INVALID_PROTOCOL + " unknown message");
@@ -334,6 +572,18 @@ void Server::handleClient(Client *client) {
                     client->sendMessage(getNicksAllClients());
                 else if (msg == I_GET_NICK)
                     client->sendMessage(client->getNick());
+                else if (msg == I_GET_HISTORY)
+                    sendHistory(client, tokens);
+                else if (msg == I_GET_GAME)
+                    sendStoredGame(client, strtoull(tokens[1].c_str(), NULL, 10));
+                else if (msg == I_DOWNLOAD_GAME || msg == I_DOWNLOAD_DAY)
+                    startDownload(client, msg, tokens[1]);
+                else if (msg == I_GET_RANK)
+                    sendRank(client, tokens[1]);
+                else if (msg == I_GET_TOP)
+                    sendTop(client, strtoul(tokens[1].c_str(), NULL, 10));
+                else if (msg == I_ANALYZE)
+                    analyzeGame(client);
                 else if (msg == I_HELP)
                     client->sendMessage(getHelp());
                 else {
@@ -366,6 +616,26 @@ void Server::handleClient(Client *client) {
                                 removePlayerFromReconnectingList(client->getNick(), true);
                             break;
                         case Client::LOBBY:
+                            if (msg == I_WATCH) {
+                                watchGame(client, tokens[1]);
+                                break;
+                            }
+                            if (msg == I_UNWATCH) {
+                                spectators.unwatch(client->getNick());
+                                client->sendMessage(O_ACKNOWLEDGE_MSG);
+                                break;
+                            }
+                            if (msg == I_QUEUE) {
+                                client->setState(Client::QUEUED);
+                                matchmaker.enqueue(client->getNick(), ratings.getRating(client->getNick()));
+                                client->sendMessage(O_ACKNOWLEDGE_MSG);
+                                sendMessageToAllClients(client->getNick(), O_GAME_PLAYER_STATE + " " + client->getNick() + " OFF", true);
+                                LOG_INFO("client '" + client->getNick() + "' joined the matchmaking queue");
+                                break;
+                            }
+                            // a resync sent just before the game ended (the client is already in the lobby)
+                            if (msg == I_GAME_RESYNC)
+                                break;
                             if (msg != I_GAME_RQ) {
                                 LOG_ERR("client " + client->toStr() + " is in the lobby and not sending a game request to another client");
                                 client->sendMessage(O_INVALID_PROTOCOL + " in the lobby, you're supposed to send a game request to another player");
@@ -394,15 +664,16 @@ void Server::handleClient(Client *client) {
                             client->setState(Client::SENT_RQ);
                             setClientState(receiver, Client::RECV_RQ);
 
+                            // the request is recorded before the receiver is told about it, so they can reply right away
+                            addGameRequest(client->getNick(), receiver);
+                            addGameRequest(receiver, client->getNick());
+
                             client->sendMessage(O_ACKNOWLEDGE_MSG);
                             sendMessage(receiver, O_RQ_RECEIVED + " " + client->getNick());
 
                             sendMessageToAllClients(client->getNick(), O_GAME_PLAYER_STATE + " " + client->getNick() + " OFF", true);
                             sendMessageToAllClients(receiver, O_GAME_PLAYER_STATE + " " + receiver + " OFF", true);
 
-                            addGameRequest(client->getNick(), receiver);
-                            addGameRequest(receiver, client->getNick());
-
                             clientWaitingClientHandler = std::thread(&Server::waitingForReplyToGameRQHandler, this, client->getNick(), receiver);
                             clientWaitingClientHandler.detach();
                             break;
@@ -485,14 +756,43 @@ void Server::handleClient(Client *client) {
                             if (msg == I_GAME_PLAY) {
                                 xPosition = stoi(tokens[1]);
                                 gameRoomsMtx.lock();
-                                Connect4 *game = gameRooms[client->getNick()]->game;
-                                Connect4::GameState gameState = game->play(client->getNick(), xPosition);
+                                auto room = gameRooms.find(client->getNick());
+                                if (room == gameRooms.end()) {
+                                    // the opponent has just ended the game (the client is being moved to the lobby)
+                                    gameRoomsMtx.unlock();
+                                    break;
+                                }
+                                GameRoom_t *gameRoom = room->second;
+                                int movesPlayed = gameRoom->game->getPosition().nbMoves();
+                                Connect4::GameState gameState = gameRoom->game->play(client->getNick(), xPosition);
+                                if (gameRoom->game->getPosition().nbMoves() != movesPlayed) {
+                                    Tracer::Span journaling("journal", "storage");
+                                    journal.append(Journal::GAME_MOVE, gameRoom->id, tokens[1]);
+                                }
+                                GameStore::Game_t game;
+                                if (gameState != Connect4::CONTINUE) {
+                                    GameStore::Result result = gameState == Connect4::DRAW ? GameStore::DRAW :
+                                                               (gameState == Connect4::PLAYER_1_WINS ? GameStore::PLAYER_1_WON : GameStore::PLAYER_2_WON);
+                                    journal.append(Journal::GAME_RESULT, gameRoom->id, std::to_string(result));
+                                    game = {0, gameRoom->id, gameRoom->player1, gameRoom->player2, gameRoom->game->getMoves(),
+                                            result, (uint64_t)gameRoom->startTime, (uint64_t)time(NULL)};
+                                }
                                 gameRoomsMtx.unlock();
                                 if (gameState != Connect4::CONTINUE) {
+                                    // the game is stored without holding the lock of the games (it writes to the disk)
+                                    if (gameStore.append(game) != 0)
+                                        annotator.submit(game.id, game.moves);
                                     deleteGameRoom(client->getNick(), "the game is over", true);
                                     client->sendMessage(O_GAME_CANCELED + " the game is over");
                                 }
                             }
+                            else if (msg == I_GAME_RESYNC) {
+                                gameRoomsMtx.lock();
+                                auto room = gameRooms.find(client->getNick());
+                                if (room != gameRooms.end())
+                                    client->sendMessage(O_GAME_RECOVERY + " " + room->second->game->getCurrentStateOfGameForRecovery(stoi(tokens[1])));
+                                gameRoomsMtx.unlock();
+                            }
                             else if (msg == I_GAME_CANCELED) {
                                 LOG_GAME("client '" + client->getNick() + "' canceled the game");
                                 deleteGameRoom(client->getNick(), "your opponent canceled the game", true);
@@ -506,6 +806,22 @@ void Server::handleClient(Client *client) {
                                 return;
                             }
                             break;
+                        case Client::QUEUED:
+                            if (msg != I_QUEUE_CANCEL) {
+                                LOG_ERR("client " + client->toStr() + " is in the matchmaking queue and not following the protocol");
+                                matchmaker.cancel(client->getNick());
+                                client->sendMessage(O_INVALID_PROTOCOL + " in the matchmaking queue, you're supposed to wait for an opponent or leave the queue");
+                                removeClient(client);
+                                return;
+                            }
+                            // if they are not in the queue anymore, they have just been paired up (GAME_START follows)
+                            if (matchmaker.cancel(client->getNick())) {
+                                client->setState(Client::LOBBY);
+                                client->sendMessage(O_ACKNOWLEDGE_MSG);
+                                sendMessageToAllClients(client->getNick(), O_GAME_PLAYER_STATE + " " + client->getNick() + " ON", true);
+                                LOG_INFO("client '" + client->getNick() + "' left the matchmaking queue");
+                            }
+                            break;
                         case Client::KILL_THREAD:
                             break;
                     }
@@ -564,7 +880,7 @@ void Server::handleClient(Client *client) {
         removePlayerFromGameRoom(client->getNick());
 
         if (stillHasOpponent) {
-            LOG_GAME("client '" + client->getNick() + "' lost their connection. Waiting for them " + std::to_string(SECONDS_WAITING_FOR_DISCONNECTED_PLAYER) + "s");
+            LOG_GAME("client '" + client->getNick() + "' lost their connection. Waiting for them " + std::to_string(timeouts.disconnectedPlayer.load()) + "s");
             addPlayerToReconnectingList(client->getNick(), opponent);
             clientReconnectingHandler = std::thread(&Server::waitingForPlayerToConnectBackHandler, this, client->getNick(), opponent);
             clientReconnectingHandler.detach();
@@ -608,14 +924,15 @@ void Server::deleteGameRequest(std::string client) {
 }
 
 void Server::waitingForPlayerToConnectBackHandler(std::string player, std::string opponent) {
-    for (int i = 0; i < SECONDS_WAITING_FOR_DISCONNECTED_PLAYER; i++) {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"reconnect\""));
+    for (int i = 0; i < timeouts.disconnectedPlayer; i++) {
         if (!isPlayerStillInGame(opponent) || !isPlayerOnReconnectingList(player)) {
-            LOG_COUNTDOWN("waiting for client '" + player + "' to reconnect back to the server was interrupted");
+            LOG_COUNTDOWN_F("waiting for client '{}' to reconnect back to the server was interrupted", player);
             removeBothPlayersFromTheReconnectingList(player, opponent);
             return;
         }
-        int remainingSeconds = SECONDS_WAITING_FOR_DISCONNECTED_PLAYER - i;
-        LOG_COUNTDOWN("waiting for client '" + player + "' to reconnect back to the server (remaining second: " + std::to_string(remainingSeconds) + ")");
+        int remainingSeconds = timeouts.disconnectedPlayer - i;
+        LOG_COUNTDOWN_F("waiting for client '{}' to reconnect back to the server (remaining second: {})", player, remainingSeconds);
         sleep(1);
     }
     removePlayerFromReconnectingList(player, false);
@@ -641,6 +958,7 @@ void Server::removeBothPlayersFromTheReconnectingList(std::string player1, std::
         reconnectingClients.erase(player1);
     if (reconnectingClients.find(player2) != reconnectingClients.end())
         reconnectingClients.erase(player2);
+    reconnectingPlayers->set(reconnectingClients.size());
     reconnectingClientsMtx.unlock();
 }
 
@@ -653,37 +971,54 @@ void Server::removePlayerFromReconnectingList(std::string player, bool successfu
         LOG_GAME("client '" + player + "' has been successfully added back to the game against client '" + opponent + "'");
     }
     else {
-        sendMessage(opponent, O_GAME_CANCELED + " the other player has not been connected back to the server within " + std::to_string(SECONDS_WAITING_FOR_DISCONNECTED_PLAYER) + "s");
-        deleteGameRoom(opponent, "", false);
+        sendMessage(opponent, O_GAME_CANCELED + " the other player has not been connected back to the server within " + std::to_string(timeouts.disconnectedPlayer.load()) + "s");
+        deleteGameRoom(opponent, "the other player has not been connected back to the server", false);
         setClientState(opponent, Client::LOBBY);
         LOG_GAME("client '" + player + "' has NOT yet been connected back to the server - ending the game against client '" + opponent + "'");
     }
     reconnectingClients.erase(player);
+    reconnectingPlayers->set(reconnectingClients.size());
     reconnectingClientsMtx.unlock();
 }
 
 void Server::addPlayerToReconnectingList(std::string player, std::string opponent) {
     reconnectingClientsMtx.lock();
     reconnectingClients[player] = opponent;
+    reconnectingPlayers->set(reconnectingClients.size());
     reconnectingClientsMtx.unlock();
 }
 
 void Server::addToGameRoom(std::string player, std::string opponent) {
     gameRoomsMtx.lock();
-    gameRooms[player] = gameRooms[opponent];
+    bool opponentInGame = gameRooms.find(opponent) != gameRooms.end();
+    auto restored = restoredGameRooms.find(player);
+    if (restored != restoredGameRooms.end()) {
+        gameRooms[player] = restored->second;
+        restoredGameRooms.erase(restored);
+    }
+    else gameRooms[player] = gameRooms[opponent];
     setClientState(player, Client::GAME);
     sendMessage(player, O_START_GAME + " " + opponent);
     sendMessage(player, O_GAME_MESSAGE + " you've been successfully added back to the game against " + opponent);
     sendMessage(player, O_GAME_RECOVERY + " " + gameRooms[player]->game->getCurrentStateOfGameForRecovery());
-    sendMessage(opponent, O_GAME_MESSAGE + " your opponent is back in the game");
-    gameRooms[player]->game->setWatchingThreadOnHold(false);
+    if (opponentInGame) {
+        sendMessage(opponent, O_GAME_MESSAGE + " your opponent is back in the game");
+        gameRooms[player]->game->setWatchingThreadOnHold(false);
+    }
+    else sendMessage(player, O_GAME_MESSAGE + " waiting for " + opponent + " to connect back to the server");
     gameRoomsMtx.unlock();
 }
 
 void Server::addGameRoom(std::string player1, std::string player2) {
+    // players do not watch other games while playing their own one
+    spectators.unwatch(player1);
+    spectators.unwatch(player2);
+
     gameRoomsMtx.lock();
-    Connect4 *game = new Connect4(player1, player2, this);
-    GameRoom_t *gameRoom = new GameRoom_t{player1, player2, game};
+    uint64_t id = journal.nextGameId();
+    Connect4 *game = new Connect4(player1, player2, this, id);
+    GameRoom_t *gameRoom = new GameRoom_t{player1, player2, game, id, time(NULL)};
+    journal.append(Journal::GAME_START, gameRoom->id, player1 + " " + player2);
 
     gameRooms[player1] = gameRoom;
     gameRooms[player2] = gameRoom;
@@ -705,38 +1040,53 @@ void Server::deleteGameRoom(std::string player, std::string msgToOtherPlayer, bo
         if (lockReconnectingClients)
             reconnectingClientsMtx.lock();
         reconnectingClients.erase(opponent);
+        reconnectingPlayers->set(reconnectingClients.size());
         if (lockReconnectingClients)
             reconnectingClientsMtx.unlock();
+        restoredGameRooms.erase(opponent);
     }
     if (gameRooms.find(player) == gameRooms.end()) {
         gameRoomsMtx.unlock();
         return;
     }
-    delete gameRooms[player]->game;
-    delete gameRooms[player];
+    GameRoom_t *gameRoom = gameRooms[player];
+    if (!gameRoom->game->isOver())
+        journal.append(Journal::GAME_CANCELED, gameRoom->id, msgToOtherPlayer);
     gameRooms.erase(player);
     setClientState(player, Client::LOBBY);
     sendMessageToAllClients(player, O_GAME_PLAYER_STATE + " " + player + " ON", true);
 
     gameRoomsMtx.unlock();
+    // the game waits for its thread to finish (2s), so it is deleted
+    // without holding the lock every other game needs to play a move
+    delete gameRoom->game;
+    delete gameRoom;
     LOG_GAME("the game between " + player + " and " + opponent + " is over");
 }
 
 void Server::removePlayerFromGameRoom(std::string player) {
+    GameRoom_t *deletedRoom = NULL;
     gameRoomsMtx.lock();
     std::string opponent = getPlayersOpponent(player, false);
     if (gameRooms.find(opponent) == gameRooms.end()) {
         LOG_GAME("the opponent of player '" + player + "' is not connected to the server either -> deleting the game");
         removeBothPlayersFromTheReconnectingList(player, opponent);
-        delete gameRooms[player]->game;
-        delete gameRooms[player];
+        restoredGameRooms.erase(opponent);
+        deletedRoom = gameRooms[player];
+        if (!deletedRoom->game->isOver())
+            journal.append(Journal::GAME_CANCELED, deletedRoom->id, "both players lost their connection");
     }
     else {
-        sendMessage(opponent, O_GAME_MESSAGE + " other player lost their connection. Waiting for him " + std::to_string(SECONDS_WAITING_FOR_DISCONNECTED_PLAYER) + "s");
+        sendMessage(opponent, O_GAME_MESSAGE + " other player lost their connection. Waiting for him " + std::to_string(timeouts.disconnectedPlayer.load()) + "s");
         gameRooms[opponent]->game->setWatchingThreadOnHold(true);
     }
     gameRooms.erase(player);
     gameRoomsMtx.unlock();
+    // deleted without the lock (see #deleteGameRoom)
+    if (deletedRoom != NULL) {
+        delete deletedRoom->game;
+        delete deletedRoom;
+    }
 }
 
 bool Server::playerStillHasOpponentInGame(std::string player) {
@@ -781,10 +1131,11 @@ std::string Server::getGameRequestSender(std::string receiver) {
 }
 
 void Server::waitingForReplyToGameRQHandler(std::string sender, std::string receiver) {
+    Metrics::GaugeScope running(Metrics::getInstance()->gauge("connect4_timers", "Number of timers running at the moment", "kind=\"game_request\""));
     bool clientLostConnection = false;
-    for (int i = 0; i < SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ; i++) {
+    for (int i = 0; i < timeouts.replyToGameRq; i++) {
         if (!existsClient(sender) || !existsClient(receiver)) {
-            LOG_COUNTDOWN("waiting of client '" + sender + "' for client '" + receiver + "' was interrupted. One of the clients is no longer connected to the server");
+            LOG_COUNTDOWN_F("waiting of client '{}' for client '{}' was interrupted. One of the clients is no longer connected to the server", sender, receiver);
             clientLostConnection = true;
             break;
         }
@@ -792,12 +1143,12 @@ void Server::waitingForReplyToGameRQHandler(std::string sender, std::string rece
             LOG_COUNTDOWN("waiting (countdown) of client '" + sender + "' for client ' to reply to the game request" + receiver + "' was interrupted");
             return;
         }
-        int remainingSeconds = SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ - i;
-        LOG_COUNTDOWN("client '" + sender + "' is waiting for client '" + receiver + "' to reply to their game request (remaining second: " + std::to_string(remainingSeconds) + ")");
+        int remainingSeconds = timeouts.replyToGameRq - i;
+        LOG_COUNTDOWN_F("client '{}' is waiting for client '{}' to reply to their game request (remaining second: {})", sender, receiver, remainingSeconds);
         sleep(1);
     }
     if (!clientLostConnection) {
-        LOG_COUNTDOWN("countdown of client '" + sender + "' is waiting for client '" + receiver + "' is over ");
+        LOG_COUNTDOWN_F("countdown of client '{}' is waiting for client '{}' is over ", sender, receiver);
     }
     setClientState(sender, Client::LOBBY);
     setClientState(receiver, Client::LOBBY);
@@ -865,6 +1216,7 @@ std::string Server::getNicksAllClients() {
 
 void Server::removeClient(Client *client) {
     numberOfClients--;
+    connectedClients->dec();
     if (client->getState() == Client::NICK)
         removeClientByReference(client);
     else removeClientByNick(client->getNick());
@@ -876,6 +1228,8 @@ void Server::removeClientByReference(Client *client) {
 }
 
 void Server::removeClientByNick(std::string nick) {
+    spectators.unwatch(nick);
+    matchmaker.cancel(nick);
     clientMtx.lock();
     sendMessageToAllClients(nick, O_REMOVE_CLIENT + " " + nick, false);
     removeClientByReference(clients[nick]);
@@ -893,6 +1247,371 @@ void Server::sendMessageToAllClients(std::string sender, std::string message, bo
         clientMtx.unlock();
 }
 
+void Server::sendHistory(Client *client, const std::vector<std::string>& tokens) {
+    std::vector<GameStore::Game_t> games;
+    uint64_t cursor = tokens.size() == 3 ? strtoull(tokens[2].c_str(), NULL, 10) : 0;
+    cursor = gameStore.getHistory(tokens[1], cursor, HISTORY_PAGE_SIZE, games);
+    for (const GameStore::Game_t &game : games)
+        client->sendMessage(O_HISTORY + " " + std::to_string(game.id) + " " + game.player1 + " " + game.player2 + " " + std::to_string(game.result) +
+                            " " + std::to_string(game.moves.size()) + " " + std::to_string(game.endTime));
+    client->sendMessage(O_HISTORY_END + " " + std::to_string(cursor));
+}
+
+void Server::sendStoredGame(Client *client, uint64_t id) {
+    GameStore::Game_t game;
+    if (!gameStore.getGame(id, game)) {
+        client->sendMessage(O_GAME_INFO + " " + std::to_string(id) + " NOT_FOUND");
+        return;
+    }
+    client->sendMessage(O_GAME_INFO + " " + std::to_string(id) + " " + game.player1 + " " + game.player2 + " " + std::to_string(game.result) +
+                        " " + std::to_string(game.startTime) + " " + std::to_string(game.endTime));
+    client->sendMessage(O_GAME_MOVES + " " + std::to_string(id) + " " + game.moves);
+
+    std::vector<uint8_t> annotations;
+    gameStore.getAnnotations(id, annotations);
+    std::string review = O_GAME_REVIEW + " " + std::to_string(id);
+    for (uint8_t annotation : annotations) {
+        if (annotation == 0)
+            review += " -";
+        else review += " " + std::to_string((annotation & GameStore::ANNOTATION_ACCURACY) - 1) +
+                       ((annotation & GameStore::ANNOTATION_BLUNDER) ? "??" : "");
+    }
+    client->sendMessage(review);
+}
+
+void Server::sendRank(Client *client, const std::string &nick) {
+    Ratings::Entry_t entry;
+    if (!ratings.getRank(nick, entry)) {
+        client->sendMessage(O_RANK + " " + nick + " NOT_FOUND");
+        return;
+    }
+    client->sendMessage(O_RANK + " " + nick + " " + std::to_string(entry.rank) + " " + std::to_string(entry.rating) +
+                        " " + std::to_string(entry.games));
+}
+
+void Server::sendTop(Client *client, size_t count) {
+    std::vector<Ratings::Entry_t> entries;
+    ratings.getTop(count, entries);
+    for (const Ratings::Entry_t &entry : entries)
+        client->sendMessage(O_TOP + " " + std::to_string(entry.rank) + " " + entry.nick + " " + std::to_string(entry.rating) +
+                            " " + std::to_string(entry.games));
+    client->sendMessage(O_TOP_END + " " + std::to_string(entries.size()));
+}
+
+void Server::analyzeGame(Client *client) {
+    std::string nick = client->getNick();
+    gameRoomsMtx.lock();
+    auto it = gameRooms.find(nick);
+    if (it == gameRooms.end()) {
+        gameRoomsMtx.unlock();
+        client->sendMessage(O_ANALYSIS + " NOT_PLAYING");
+        return;
+    }
+    Position position = it->second->game->getPosition();
+    gameRoomsMtx.unlock();
+
+    bool queued = analyzer.submit(nick, position, std::chrono::milliseconds(Analyzer::DEFAULT_BUDGET_MS), [this, nick](const Analyzer::Result_t &result) {
+        std::string msg = O_ANALYSIS + " " + std::to_string(result.nbMoves);
+        for (int score : result.scores) {
+            if (score == Solver::INVALID_MOVE)
+                msg += " -";
+            else if (score == Analyzer::UNKNOWN_SCORE)
+                msg += " ?";
+            else msg += " " + std::to_string(score);
+        }
+        sendMessage(nick, msg);
+        LOG_INFO("analysis for client '" + nick + "' took " + std::to_string(result.micros) + "us (" +
+                 std::to_string(result.cached) + " columns cached" + (result.complete ? ")" : ", out of time)"));
+    });
+    if (!queued)
+        client->sendMessage(O_ANALYSIS + " BUSY");
+}
+
+void Server::startDownload(Client *client, IncomingMsg msg, const std::string &what) {
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    bool found = msg == I_DOWNLOAD_GAME ? gameStore.locateGame(strtoull(what.c_str(), NULL, 10), path, offset, size)
+                                        : gameStore.locateDay(what, path, size);
+    if (!found) {
+        client->sendMessage(O_DOWNLOAD_FAILED + " " + what + " NOT_FOUND");
+        return;
+    }
+    if (++numberOfDownloads > MAX_DOWNLOADS) {
+        numberOfDownloads--;
+        client->sendMessage(O_DOWNLOAD_FAILED + " " + what + " BUSY");
+        return;
+    }
+    int socket = dup(client->getSocket());
+    if (socket < 0) {
+        numberOfDownloads--;
+        LOG_ERR("duplicating the socket of client " + client->toStr() + " for a download failed");
+        client->sendMessage(O_DOWNLOAD_FAILED + " " + what + " ERROR");
+        return;
+    }
+    LOG_INFO("client " + client->toStr() + " is downloading " + what + " (" + std::to_string(size) + " bytes)");
+    std::thread downloadThread(&Server::downloadHandler, this, socket, client->getSendMtx(), client->getNick(), what, path, offset, size);
+    downloadThread.detach();
+}
+
+void Server::downloadHandler(int socket, std::shared_ptr<std::mutex> sendMtx, std::string nick, std::string what, std::string path, uint64_t offset, uint64_t size) {
+    // sends data without blocking, waiting (poll) for the client to take it at most
+    // #SECONDS_WAITING_FOR_DOWNLOAD seconds (the socket is shared with the other threads,
+    // so neither its options nor its flags can be changed)
+    bool broken = false; // true, if a message has been sent only partially
+    auto sendWithin = [&](const char *data, size_t length, int flags) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SECONDS_WAITING_FOR_DOWNLOAD);
+        size_t sent = 0;
+        while (sent < length) {
+            ssize_t n = send(socket, data + sent, length - sent, flags | MSG_DONTWAIT);
+            if (n > 0) {
+                sent += (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            struct pollfd pfd = {socket, POLLOUT, 0};
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) || remaining <= 0 || poll(&pfd, 1, remaining) < 0) {
+                broken = sent > 0;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // sends a whole message (framed as defined by the protocol)
+    auto sendMessage = [&](const std::string &msg) {
+        char length[16];
+        snprintf(length, sizeof(length), "%04zu", msg.length());
+        std::string frame = PROTOCOL_ID + length + msg + "\r\n";
+        sendMtx->lock();
+        bool sent = sendWithin(frame.data(), frame.size(), 0);
+        sendMtx->unlock();
+        return sent;
+    };
+
+    // moves a region of the file into the socket through a pipe without copying it into
+    // user space (splice). SPLICE_F_NONBLOCK only concerns the pipe, the socket itself blocks,
+    // so no more is handed over at once than the free space the socket has when poll reports
+    // it writable (at least a third of its send buffer), which keeps splice from blocking
+    int fd = open(path.c_str(), O_RDONLY);
+    int pipeFds[2] = {-1, -1};
+    auto spliceWithin = [&](uint64_t position, size_t length) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SECONDS_WAITING_FOR_DOWNLOAD);
+        size_t inPipe = 0;
+        while (length > 0) {
+            if (inPipe == 0) {
+                loff_t from = (loff_t)position;
+                ssize_t n = splice(fd, &from, pipeFds[1], NULL, length, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                position += (uint64_t)n;
+                inPipe = (size_t)n;
+            }
+            int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            struct pollfd pfd = {socket, POLLOUT, 0};
+            if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0 || (pfd.revents & (POLLERR | POLLHUP)))
+                return false;
+            int sendBuffer = 0;
+            socklen_t optionLength = sizeof(sendBuffer);
+            getsockopt(socket, SOL_SOCKET, SO_SNDBUF, &sendBuffer, &optionLength);
+            size_t room = std::max<size_t>(sendBuffer / 4, 1);
+            ssize_t n = splice(pipeFds[0], NULL, socket, NULL, std::min(inPipe, room), SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (n <= 0)
+                return false;
+            inPipe -= (size_t)n;
+            length -= (size_t)n;
+        }
+        return true;
+    };
+
+    bool ok = fd >= 0 && pipe2(pipeFds, O_CLOEXEC) == 0;
+    if (ok) {
+        posix_fadvise(fd, offset, size, POSIX_FADV_SEQUENTIAL);
+        ok = sendMessage(O_DOWNLOAD_START + " " + what + " " + std::to_string(size));
+    }
+
+    uint64_t position = offset;
+    uint64_t end = offset + size;
+    while (ok && position < end) {
+        size_t chunk = std::min(end - position, (uint64_t)DOWNLOAD_CHUNK_SIZE);
+
+        // wait for the client to take the data sent so far without holding the lock
+        struct pollfd pfd = {socket, POLLOUT, 0};
+        if (poll(&pfd, 1, SECONDS_WAITING_FOR_DOWNLOAD * 1000) <= 0 || (pfd.revents & (POLLERR | POLLHUP))) {
+            ok = false;
+            break;
+        }
+
+        char header[BUFF_SIZE];
+        int headerLength = snprintf(header, sizeof(header), "%s%04zu%s ", PROTOCOL_ID.c_str(), O_DOWNLOAD_DATA.length() + 1 + chunk, O_DOWNLOAD_DATA.c_str());
+
+        // the lock is held only while this one message is being sent (the header, the data straight
+        // from the page cache and the end of the message)
+        sendMtx->lock();
+        ok = sendWithin(header, headerLength, MSG_MORE);
+        if (ok && !(spliceWithin(position, chunk) && sendWithin("\r\n", 2, 0))) {
+            // the header has been sent, so the message cannot be taken back
+            ok = false;
+            broken = true;
+        }
+        sendMtx->unlock();
+        position += chunk;
+    }
+
+    if (ok) {
+        sendMessage(O_DOWNLOAD_END + " " + what);
+        LOG_INFO("client " + nick + " has downloaded " + what);
+    } else {
+        LOG_ERR("download of " + what + " by client " + nick + " failed");
+        if (broken)
+            shutdown(socket, SHUT_RDWR); // the client cannot tell where the next message starts anymore
+        else
+            sendMessage(O_DOWNLOAD_FAILED + " " + what + " ERROR");
+    }
+    if (fd >= 0)
+        close(fd);
+    if (pipeFds[0] >= 0) {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+    }
+    close(socket);
+    numberOfDownloads--;
+}
+
+void Server::watchGame(Client *client, const std::string &player) {
+    gameRoomsMtx.lock();
+    auto it = gameRooms.find(player);
+    int socket = -1;
+    if (it != gameRooms.end() && !it->second->game->isOver())
+        socket = dup(client->getSocket());
+    if (socket < 0) {
+        gameRoomsMtx.unlock();
+        client->sendMessage(O_WATCH_FAILED + " " + player);
+        return;
+    }
+    // the game is locked, so no move gets published before it is joined
+    GameRoom_t *gameRoom = it->second;
+    uint64_t gameId = gameRoom->id;
+    std::string player1 = gameRoom->player1;
+    std::string player2 = gameRoom->player2;
+    spectators.join(gameId, player1, player2, gameRoom->game->getMoves());
+    gameRoomsMtx.unlock();
+
+    // the spectator is added without holding the lock of the games, so the moves never wait for the spectators
+    if (!spectators.watch(client->getNick(), socket, client->getSendMtx(), gameId)) {
+        close(socket);
+        client->sendMessage(O_WATCH_FAILED + " " + player);
+        return;
+    }
+    LOG_INFO("client " + client->toStr() + " is watching the game between '" + player1 + "' and '" + player2 + "'");
+}
+
+void Server::matchmakingHandler() {
+    while (1) {
+        usleep(MATCHMAKING_TICK_MS * 1000);
+        for (const Matchmaker::Match_t &match : matchmaker.pair())
+            startMatchedGame(match);
+    }
+}
+
+bool Server::startMatchedGame(const Matchmaker::Match_t &match) {
+    clientMtx.lock();
+    auto player1 = clients.find(match.player1);
+    auto player2 = clients.find(match.player2);
+    bool waiting1 = player1 != clients.end() && player1->second->getState() == Client::QUEUED;
+    bool waiting2 = player2 != clients.end() && player2->second->getState() == Client::QUEUED;
+    if (waiting1 && waiting2) {
+        player1->second->setState(Client::GAME);
+        player2->second->setState(Client::GAME);
+    }
+    clientMtx.unlock();
+
+    if (!waiting1 || !waiting2) {
+        if (waiting1)
+            matchmaker.enqueue(match.player1, ratings.getRating(match.player1));
+        if (waiting2)
+            matchmaker.enqueue(match.player2, ratings.getRating(match.player2));
+        return false;
+    }
+    sendMessage(match.player1, O_START_GAME + " " + match.player2);
+    sendMessage(match.player2, O_START_GAME + " " + match.player1);
+    addGameRoom(match.player1, match.player2);
+    LOG_GAME("a game between clients '" + match.player1 + "' and '" + match.player2 + "' just started (matchmaking, rating difference " +
+             std::to_string(match.ratingDiff) + ", waited " + std::to_string((int)match.waited) + "s)");
+    return true;
+}
+
+Ratings &Server::getRatings() {
+    return ratings;
+}
+
+Server::Timeouts_t &Server::getTimeouts() {
+    return timeouts;
+}
+
+void Server::setMaxClients(int value) {
+    maxClients = value;
+}
+
+int Server::getMaxClients() const {
+    return maxClients;
+}
+
+void Server::publishState() {
+    std::shared_ptr<State_t> current = std::make_shared<State_t>();
+
+    clientMtx.lock();
+    for (auto it : clients)
+        current->clients.push_back({it.first, it.second->getIp(), it.second->getState()});
+    clientMtx.unlock();
+
+    std::unordered_set<GameRoom_t *> seen;
+    gameRoomsMtx.lock();
+    for (auto *map : {&gameRooms, &restoredGameRooms})
+        for (auto it : *map) {
+            GameRoom_t *gameRoom = it.second;
+            if (!seen.insert(gameRoom).second)
+                continue;
+            current->games.push_back({gameRoom->id, gameRoom->player1, gameRoom->player2, gameRoom->game->getMoves(),
+                                      gameRoom->startTime, map == &restoredGameRooms});
+        }
+    gameRoomsMtx.unlock();
+
+    // the requests are kept for both of the players and never removed,
+    // so only the ones the receiver has not replied to yet are pending
+    std::unordered_set<std::string> receivers;
+    for (const ClientInfo_t &client : current->clients)
+        if (client.state == Client::RECV_RQ)
+            receivers.insert(client.nick);
+    gameRequestsMtx.lock();
+    for (auto it : gameRequests)
+        if (receivers.count(it.first) != 0)
+            current->gameRequests.push_back({it.second, it.first});
+    gameRequestsMtx.unlock();
+
+    reconnectingClientsMtx.lock();
+    for (auto it : reconnectingClients)
+        current->reconnectingClients.push_back(it);
+    reconnectingClientsMtx.unlock();
+
+    current->taken = std::chrono::steady_clock::now();
+    std::atomic_store(&state, std::shared_ptr<const State_t>(current));
+}
+
+std::shared_ptr<const Server::State_t> Server::getState() const {
+    return std::atomic_load(&state);
+}
+
+Spectators &Server::getSpectators() {
+    return spectators;
+}
+
 std::string Server::getHelp() const {
     std::stringstream ss;
     ss << "\r\n";
@@ -956,6 +1675,22 @@ bool validReply(const std::vector<std::string>& tokens) {
     return tokens[2] == "YES" || tokens[2] == "NO";
 }
 
+bool validWatch(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2;
+}
+
+bool validUnwatch(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1;
+}
+
+bool validQueue(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1;
+}
+
+bool validQueueCancel(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1;
+}
+
 bool validGameCanceled(const std::vector<std::string>& tokens) {
     return tokens.size() == 1;
 }
@@ -981,4 +1716,45 @@ bool validGamePlay(const std::vector<std::string>& tokens) {
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+bool isNumber(const std::string& str, size_t maxLength) {
+    if (str.empty() || str.size() > maxLength)
+        return false;
+    for (char c : str)
+        if (c < '0' || c > '9')
+            return false;
+    return true;
+}
+
+bool validGameResync(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2 && isNumber(tokens[1], 2);
+}
+
+bool validGetHistory(const std::vector<std::string>& tokens) {
+    return (tokens.size() == 2 || tokens.size() == 3) && (tokens.size() == 2 || isNumber(tokens[2], 19));
+}
+
+bool validGetGame(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2 && isNumber(tokens[1], 19);
+}
+
+bool validDownloadGame(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2 && isNumber(tokens[1], 19);
+}
+
+bool validDownloadDay(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2 && tokens[1].size() == 8 && isNumber(tokens[1], 8);
+}
+
+bool validGetRank(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2;
+}
+
+bool validGetTop(const std::vector<std::string>& tokens) {
+    return tokens.size() == 2 && isNumber(tokens[1], 3);
+}
+
+bool validAnalyze(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1;
+}
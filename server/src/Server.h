@@ -9,6 +9,10 @@
 #include <map>
 #include <utility>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <atomic>
+#include <chrono>
 
 #include <unistd.h>
 #include <netinet/in.h>
@@ -19,7 +23,18 @@
 
 #include "Client.h"
 #include "Logger.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "ProfiledMutex.h"
 #include "Connect4.h"
+#include "Journal.h"
+#include "Snapshot.h"
+#include "GameStore.h"
+#include "Spectators.h"
+#include "Matchmaker.h"
+#include "Ratings.h"
+#include "Analyzer.h"
+#include "Annotator.h"
 
 // forward declaration
 class Client;
@@ -66,6 +81,28 @@ public:
     /// the server after they lose their connection while playing a game
     static const int SECONDS_WAITING_FOR_DISCONNECTED_PLAYER = 60;
 
+    /// amount of seconds between two snapshots of the games in progress
+    /// (the journal is replayed from the last one when the server boots up)
+    static const int SECONDS_BETWEEN_SNAPSHOTS = 10;
+
+    /// amount of milliseconds between two rounds of pairing up
+    /// the players in the matchmaking queue (#I_QUEUE)
+    static const int MATCHMAKING_TICK_MS = 500;
+
+    /// number of games sent to a client on one page of their history (#I_GET_HISTORY)
+    static const int HISTORY_PAGE_SIZE = 10;
+
+    /// the most downloads of finished games that can run at a time
+    /// (#I_DOWNLOAD_GAME, #I_DOWNLOAD_DAY)
+    static const int MAX_DOWNLOADS = 4;
+
+    /// the most bytes of a file sent in one #O_DOWNLOAD_DATA message
+    static const int DOWNLOAD_CHUNK_SIZE = 8192;
+
+    /// amount of seconds of waiting for a client to take
+    /// the data of a download (after that, the download is aborted)
+    static const int SECONDS_WAITING_FOR_DOWNLOAD = 10;
+
     /// amount of seconds of waiting for a client to enter their nick
     static const int SECONDS_WAITING_FOR_CLIENT_ENTER_NICK = 10;
 
@@ -78,6 +115,43 @@ public:
     /// that checks if there is some data ready to read off the socket
     static const int U_SECONDS_SOCKETS_TIMEOUT = 10000;
 
+    /// timeouts that can be changed while the server is running (see #Admin),
+    /// every timer reads its timeout once a second
+    struct Timeouts_t {
+        std::atomic<int> replyToGameRq;      ///< #SECONDS_WAITING_FOR_REPLY_TO_GAME_RQ
+        std::atomic<int> disconnectedPlayer; ///< #SECONDS_WAITING_FOR_DISCONNECTED_PLAYER
+        std::atomic<int> clientEnterNick;    ///< #SECONDS_WAITING_FOR_CLIENT_ENTER_NICK
+        std::atomic<int> pingReply;          ///< #SECONDS_PING_REPLY
+        std::atomic<int> clientToPlay;       ///< Connect4::SECONDS_WAITING_FOR_CLIENT_TO_PLAY
+    };
+
+    /// information about a client (see #State_t)
+    struct ClientInfo_t {
+        std::string nick;    ///< nick of the client
+        std::string ip;      ///< ip address of the client
+        Client::State state; ///< state of the client
+    };
+
+    /// information about a game in progress (see #State_t)
+    struct GameInfo_t {
+        uint64_t id;         ///< id of the game
+        std::string player1; ///< nick of player 1
+        std::string player2; ///< nick of player 2
+        std::string moves;   ///< the moves played so far (columns '0' - '6')
+        time_t startTime;    ///< when the game started
+        bool restored;       ///< the game was restored and not all the players are back
+    };
+
+    /// copy of the state of the server (the clients, games, requests
+    /// and reconnecting clients) taken at one moment (see #publishState)
+    struct State_t {
+        std::chrono::steady_clock::time_point taken; ///< when the copy was taken
+        std::vector<ClientInfo_t> clients;           ///< the clients connected to the server
+        std::vector<GameInfo_t> games;               ///< the games in progress
+        std::vector<std::pair<std::string, std::string>> gameRequests;        ///< pending game requests (sender, receiver)
+        std::vector<std::pair<std::string, std::string>> reconnectingClients; ///< players waiting for (player, opponent)
+    };
+
     /// types of incoming messages from a client
     enum IncomingMsg {
         I_EXIT,            ///< client wants to leave the server
@@ -86,14 +160,26 @@ public:
         I_GET_NICK,        ///< client requires to find out what their nick actually is
         I_GET_ALL_CLIENTS, ///< client requires to get a list of all the clients connected to the server
         I_GET_STATE,       ///< client requires to find out their current state
+        I_GET_HISTORY,     ///< client requires a page of the finished games of a player
+        I_GET_GAME,        ///< client requires a finished game
+        I_DOWNLOAD_GAME,   ///< client requires the record of a finished game (as it is stored)
+        I_DOWNLOAD_DAY,    ///< client requires the data file of all the games finished on a day
+        I_GET_RANK,        ///< client requires the rating and the rank of a player
+        I_GET_TOP,         ///< client requires the best players (the leaderboard)
+        I_ANALYZE,         ///< client requires the value of every column of the game they are playing
 
         I_NICK,            ///< client sets their nick
         I_GAME_RQ,         ///< client sends a game request to another client
+        I_WATCH,           ///< client starts watching the game of another client
+        I_UNWATCH,         ///< client stops watching a game
+        I_QUEUE,           ///< client joins the matchmaking queue (they are paired up with an opponent automatically)
+        I_QUEUE_CANCEL,    ///< client leaves the matchmaking queue
         I_RQ_CANCELED,     ///< client cancels their own game request
         I_RPL,             ///< client accepts/rejects a game request received from another client
 
         I_GAME_CANCELED,   ///< client cancels the game
         I_GAME_PLAY,       ///< client plays the game
+        I_GAME_RESYNC,     ///< client requires the moves of the game they have not seen yet
 
         UNKNOWN            ///< message not specified within the protocol
     };
@@ -118,7 +204,8 @@ public:
     const std::string O_GAME_PLAY          = "GAME_PLAY";
     /// message sent to a client from the server - message fro the game
     const std::string O_GAME_MESSAGE       = "GAME_MSG";
-    /// message sent to a client from the server - game recovery (client just got back connected to the server after they'd lost their connection)
+    /// message sent to a client from the server - game recovery (client just got back connected to the server after they'd lost their connection
+    /// or asked for the moves they missed). Format: GAME_RECOVERY <index of the first move> [moves as a string of columns]
     const std::string O_GAME_RECOVERY      = "GAME_RECOVERY";
     /// message sent to a client from the server - change state of another client (free/busy playing a game)
     const std::string O_GAME_PLAYER_STATE  = "GAME_PLAYER_STATE";
@@ -126,6 +213,50 @@ public:
     const std::string O_GAME_WINNING_TILES = "GAME_WINNING_TAILS";
     /// message sent to a client from the server - result of the game (either you've lost or won)
     const std::string O_GAME_GAME_RESULT   = "GAME_RESULT";
+    /// message sent to a client from the server - one finished game of a player.
+    /// Format: HISTORY <id> <player1> <player2> <result 0/1/2> <number of moves> <end time>
+    const std::string O_HISTORY            = "HISTORY";
+    /// message sent to a client from the server - end of a page of the history of a player.
+    /// Format: HISTORY_END <cursor of the next page> (0 if there are no more games)
+    const std::string O_HISTORY_END        = "HISTORY_END";
+    /// message sent to a client from the server - a finished game.
+    /// Format: GAME_INFO <id> <player1> <player2> <result 0/1/2> <start time> <end time> or GAME_INFO <id> NOT_FOUND
+    const std::string O_GAME_INFO          = "GAME_INFO";
+    /// message sent to a client from the server - moves of a finished game.
+    /// Format: GAME_MOVES <id> <moves as a string of columns>
+    const std::string O_GAME_MOVES         = "GAME_MOVES";
+    /// message sent to a client from the server - review of the moves of a finished game (accuracy 0 - 100,
+    /// "??" appended to a blunder, "-" - the move has not been analyzed). Format: GAME_REVIEW <id> <move 1> <move 2> ...
+    const std::string O_GAME_REVIEW        = "GAME_REVIEW";
+    /// message sent to a client from the server - start of a download.
+    /// Format: DOWNLOAD_START <game id/day> <number of bytes>
+    const std::string O_DOWNLOAD_START     = "DOWNLOAD_START";
+    /// message sent to a client from the server - a part of a download.
+    /// Format: DOWNLOAD_DATA <bytes of the file as they are> (the length of the message tells how many)
+    const std::string O_DOWNLOAD_DATA      = "DOWNLOAD_DATA";
+    /// message sent to a client from the server - end of a download.
+    /// Format: DOWNLOAD_END <game id/day>
+    const std::string O_DOWNLOAD_END       = "DOWNLOAD_END";
+    /// message sent to a client from the server - a download cannot be done or it was aborted.
+    /// Format: DOWNLOAD_FAILED <game id/day> <NOT_FOUND/BUSY/ERROR>
+    const std::string O_DOWNLOAD_FAILED    = "DOWNLOAD_FAILED";
+    /// message sent to a client from the server - the player they want to watch is not playing a game.
+    /// Format: WATCH_FAILED <nick>. The game itself is sent by #Spectators (WATCH_STATE, WATCH_PLAY, ...)
+    const std::string O_WATCH_FAILED       = "WATCH_FAILED";
+    /// message sent to a client from the server - rating and rank of a player.
+    /// Format: RANK <nick> <rank> <rating> <number of games> or RANK <nick> NOT_FOUND
+    const std::string O_RANK               = "RANK";
+    /// message sent to a client from the server - one entry of the leaderboard.
+    /// Format: TOP <rank> <nick> <rating> <number of games>
+    const std::string O_TOP                = "TOP";
+    /// message sent to a client from the server - end of the leaderboard.
+    /// Format: TOP_END <number of entries sent>
+    const std::string O_TOP_END            = "TOP_END";
+    /// message sent to a client from the server - value of every column of the game they are playing
+    /// (from the point of view of the player who is up; a positive value wins, "-" - the column is full,
+    /// "?" - it has not been solved in time). Format: ANALYSIS <number of moves> <value of column 0> ... <value of column 6>
+    /// or ANALYSIS NOT_PLAYING/BUSY
+    const std::string O_ANALYSIS           = "ANALYSIS";
 
 private:
     /// connection of the server
@@ -149,10 +280,16 @@ private:
         std::string player1; ///< player 1
         std::string player2; ///< player 2
         Connect4 *game;      ///< reference to the game itself
+        uint64_t id;         ///< id of the game in the journal
+        time_t startTime;    ///< when the game started (when it was restored for restored games)
     };
 
     /// maximum number of clients that can be connected to the server at a time
-    int maxClients;
+    std::atomic<int> maxClients;
+    /// timeouts of the timers (they can be changed while the server is running)
+    Timeouts_t timeouts;
+    /// the last copy of the state of the server (see #publishState)
+    std::shared_ptr<const State_t> state;
     /// current number of clients connected to the server
     int numberOfClients;
     /// map where the key is an incoming message (as a string)
@@ -161,31 +298,69 @@ private:
     std::map<std::string, IncomingMsgInfo> msgValidation;
 
     /// lock used when accessing clients
-    std::mutex clientMtx;
+    ProfiledMutex clientMtx{"clientMtx"};
     /// map holding all the clients connected to the server
     /// where the key is their nick and the value is a reference to them
     std::unordered_map<std::string, Client *> clients;
 
     /// lock used when accessing game requests
-    std::mutex gameRequestsMtx;
+    ProfiledMutex gameRequestsMtx{"gameRequestsMtx"};
     /// map holding information on who sent a game request to whom
     std::unordered_map<std::string, std::string> gameRequests;
 
     /// lock used when accessing game rooms
     /// (two players playing a game)
-    std::mutex gameRoomsMtx;
+    ProfiledMutex gameRoomsMtx{"gameRoomsMtx"};
     /// map holding information on which player
     /// is in which game room
     std::unordered_map<std::string, GameRoom_t *> gameRooms;
+    /// map holding the games restored when the server booted up where
+    /// the key is a player who has not connected back yet (also locked
+    /// by #gameRoomsMtx). Once they do so, they are moved to #gameRooms.
+    std::unordered_map<std::string, GameRoom_t *> restoredGameRooms;
 
     /// lock used when the list of reconnecting clients
     /// (clients who lost their connection while playing a game)
-    std::mutex reconnectingClientsMtx;
+    ProfiledMutex reconnectingClientsMtx{"reconnectingClientsMtx"};
     /// map where the key is the player for whom the server is
     /// waiting to reconnect (they lost their connection while playing a game)
     /// and the value their opponent
     std::unordered_map<std::string, std::string> reconnectingClients;
 
+    /// journal of all the game events (start, moves, result, cancellation)
+    Journal journal;
+    /// store of the finished games
+    GameStore gameStore;
+    /// number of downloads running at the moment
+    std::atomic<int> numberOfDownloads;
+    /// clients watching games of other clients
+    Spectators spectators;
+    /// players waiting in the matchmaking queue
+    Matchmaker matchmaker;
+    /// ratings of the players and the leaderboard
+    Ratings ratings;
+    /// analysis of the positions of the games (#I_ANALYZE)
+    Analyzer analyzer;
+    /// post-game analysis of the finished games (the reviews are stored with them)
+    Annotator annotator;
+
+    /// metrics of one type of incoming messages
+    struct MessageMetrics_t {
+        Metrics::Counter *received;   ///< number of messages received
+        Metrics::Histogram *latency;  ///< time it takes to handle a message
+    };
+
+    /// metrics of every type of incoming messages (indexed by #IncomingMsg)
+    MessageMetrics_t messageMetrics[UNKNOWN + 1];
+    /// number of connections accepted
+    Metrics::Counter *acceptedConnections;
+    /// number of connections rejected (the maximum number of clients has been reached)
+    Metrics::Counter *rejectedConnections;
+    /// number of clients connected (the same as #numberOfClients)
+    Metrics::Gauge *connectedClients;
+    /// number of players on the list of reconnecting clients (#reconnectingClients)
+    Metrics::Gauge *reconnectingPlayers;
+
 public:
     /// Constructor of the class - creates an instance of it
     /// \param port the port number the server runs on
@@ -195,6 +370,16 @@ public:
     /// Boots up the server
     void startServer();
 
+    /// Restores the games that were in progress when the server
+    /// stopped (see #Snapshot::recover)
+    ///
+    /// Both players of every restored game are put on the list
+    /// of clients waiting to reconnect, so they can continue
+    /// the game once they connect with the same nick.
+    ///
+    /// \return number of restored games
+    size_t restoreGames();
+
     /// Copy constructor of the class. It was deleted
     /// because there is no need to use it within this project.
     Server(Server &) = delete;
@@ -213,6 +398,67 @@ public:
     /// \param msg the message itself
     void sendMessage(std::string nick, std::string msg);
 
+    /// Returns the spectators of the games
+    ///
+    /// This method is used from the outside of the class
+    /// by class #Connect4 when publishing the moves and
+    /// the result of a game to its spectators.
+    ///
+    /// \return the spectators
+    Spectators &getSpectators();
+
+    /// Returns the ratings of the players
+    ///
+    /// This method is used from the outside of the class
+    /// by class #Connect4 when submitting the result of a game.
+    ///
+    /// \return the ratings
+    Ratings &getRatings();
+
+    /// Returns the timeouts of the timers
+    ///
+    /// This method is used from the outside of the class by class
+    /// #Connect4 (the timer of a turn) and by class #Admin that
+    /// changes them while the server is running.
+    ///
+    /// \return the timeouts
+    Timeouts_t &getTimeouts();
+
+    /// Sets the maximum number of clients that can be connected to the server at a time
+    /// (the clients connected already are not disconnected)
+    /// \param value the maximum number of clients
+    void setMaxClients(int value);
+
+    /// Returns the maximum number of clients that can be connected to the server at a time
+    /// \return the maximum number of clients
+    int getMaxClients() const;
+
+    /// Takes a copy of the state of the server and publishes it (see #getState)
+    ///
+    /// The locks are taken one at a time and held only while
+    /// the data is copied (no message is sent while holding them).
+    void publishState();
+
+    /// Returns the last published copy of the state of the server
+    ///
+    /// No lock is taken, so the state can be read as often as needed
+    /// without making the threads handling the clients wait.
+    ///
+    /// \return the state, NULL if it has not been published yet
+    std::shared_ptr<const State_t> getState() const;
+
+    /// Returns a message type from the tokens given as a parameter.
+    ///
+    /// The tokens make up the entire message the client sent off
+    /// to the server split up by #MSG_SEPARATOR. The type of
+    /// the message should be at position 0.
+    ///
+    /// It is public so that tools/bench.cpp can measure it.
+    ///
+    /// \param tokens split up message sent by a client
+    /// \return the type of the message (#IncomingMsg) including #UNKNOWN
+    IncomingMsg getTypeOfMessage(const std::vector<std::string>& tokens) const;
+
     /// Deletes a game room
     ///
     /// This method is called from the outside of the class
@@ -235,6 +481,8 @@ private:
     void setListening();
     /// Runs the thread accepting connections from clients
     void run();
+    /// Registers the metrics of the server (when the server is created)
+    void registerMetrics();
 
     /// Thread that handles the client given as a parameter
     /// \param client reference to the client the thread will take care of
@@ -259,16 +507,6 @@ private:
     /// \param client reference to the client that is supposed to enter their nick
     void enteringNickHandler(Client *client);
 
-    /// Returns a message type from the tokens given as a parameter.
-    ///
-    /// The tokens make up the entire message the client sent off
-    /// to the server split up by #MSG_SEPARATOR. The type of
-    /// the message should be at position 0.
-    ///
-    /// \param tokens split up message sent by a client
-    /// \return the type of the message (#IncomingMsg) including #UNKNOWN
-    IncomingMsg getTypeOfMessage(const std::vector<std::string>& tokens) const;
-
     /// Removes the client given as a parameter from the
     /// the data structure holding all clients connected to the server.
     ///
@@ -336,6 +574,74 @@ private:
     /// \param state the new state of the client
     void setClientState(std::string nick, Client::State state);
 
+    /// Sends a page of the finished games of a player to a client (#I_GET_HISTORY)
+    /// \param client the client the page will be sent to
+    /// \param tokens the message (the nick of the player and optionally the cursor of the page)
+    void sendHistory(Client *client, const std::vector<std::string>& tokens);
+
+    /// Sends a finished game to a client (#I_GET_GAME)
+    /// \param client the client the game will be sent to
+    /// \param id id of the game in the store
+    void sendStoredGame(Client *client, uint64_t id);
+
+    /// Sends the rating and the rank of a player to a client (#I_GET_RANK)
+    /// \param client the client
+    /// \param nick nick of the player
+    void sendRank(Client *client, const std::string &nick);
+
+    /// Sends the best players to a client (#I_GET_TOP)
+    /// \param client the client
+    /// \param count number of players
+    void sendTop(Client *client, size_t count);
+
+    /// Queues the analysis of the game a client is playing (#I_ANALYZE)
+    /// The result is sent to them once it is ready.
+    /// \param client the client
+    void analyzeGame(Client *client);
+
+    /// Starts a download of a finished game (#I_DOWNLOAD_GAME)
+    /// or all the games finished on a day (#I_DOWNLOAD_DAY)
+    /// \param client the client the data will be sent to
+    /// \param msg type of the download
+    /// \param what id of the game or the day (YYYYMMDD)
+    void startDownload(Client *client, IncomingMsg msg, const std::string &what);
+
+    /// Thread pairing up the players in the matchmaking queue
+    /// every #MATCHMAKING_TICK_MS milliseconds
+    void matchmakingHandler();
+
+    /// Starts a game between two players paired up by the matchmaking
+    ///
+    /// If either of them is no longer waiting (they left the queue or the server
+    /// in the meantime), the other one is put back into the queue.
+    ///
+    /// \param match the players
+    /// \return true, if the game has started. Otherwise, false.
+    bool startMatchedGame(const Matchmaker::Match_t &match);
+
+    /// Makes a client (in the lobby) a spectator of the game a player is playing (#I_WATCH)
+    /// \param client the client
+    /// \param player nick of the player
+    void watchGame(Client *client, const std::string &player);
+
+    /// Thread sending a region of a file of the store of the finished games to a client.
+    ///
+    /// The data is sent in #O_DOWNLOAD_DATA messages of #DOWNLOAD_CHUNK_SIZE bytes. The lock used
+    /// when sending messages to the client is held only while one of them is being sent, so the other
+    /// messages (lobby, game) get through in between. The thread uses a duplicate of the socket and
+    /// the lock is shared, so it does not matter if the client gets removed meanwhile. The duplicate
+    /// shares the options and the flags with the socket of the client, so they are left untouched;
+    /// the headers are sent without blocking instead (MSG_DONTWAIT), waiting for the client in poll,
+    /// and the data is spliced from the page cache through a pipe, never more than the socket can take.
+    /// \param socket duplicate of the socket of the client (closed by the thread)
+    /// \param sendMtx lock used when sending messages to the client
+    /// \param nick nick of the client
+    /// \param what id of the game or the day (YYYYMMDD)
+    /// \param path path to the file
+    /// \param offset offset of the region in the file
+    /// \param size size of the region
+    void downloadHandler(int socket, std::shared_ptr<std::mutex> sendMtx, std::string nick, std::string what, std::string path, uint64_t offset, uint64_t size);
+
     /// Returns help (a set of commands with their descriptions
     /// the user can perform).
     /// \return the help
@@ -392,6 +698,9 @@ private:
     /// get re-connected back to the server, they will be put back in the game,
     /// so they can continue playing it.
     ///
+    /// If the opponent has not connected back yet either (a restored game), the game
+    /// stays on hold until they do so.
+    ///
     /// \param player the client who just got re-connected
     /// \param opponent the client's opponent who was waiting for them to get re-connected
     void addToGameRoom(std::string player, std::string opponent);
@@ -442,6 +751,21 @@ private:
     /// \param opponent client's opponent that is still waiting in the game
     void waitingForPlayerToConnectBackHandler(std::string player, std::string opponent);
 
+    /// Thread waiting for the players of the restored games (#restoreGames)
+    /// to re-connect back to the server.
+    ///
+    /// One thread waits for all of them for 60s (#SECONDS_WAITING_FOR_DISCONNECTED_PLAYER).
+    /// Then, the games neither of whose players has come back are deleted and
+    /// the players who have not come back are treated as if they lost their connection.
+    void waitingForRestoredPlayersHandler();
+
+    /// Thread writing a snapshot of the games in progress
+    /// every 10s (#SECONDS_BETWEEN_SNAPSHOTS)
+    void snapshotHandler();
+
+    /// Writes a snapshot of the games in progress (see #Snapshot::write)
+    void writeSnapshot();
+
     /// Removes the client given as a parameter from the list of clients
     /// waiting to get re-connected to the server.
     ///
@@ -527,6 +851,30 @@ private:
     /// \return true if the message is valid, false otherwise.
     friend bool validGameRq(const std::vector<std::string>& tokens);
 
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_WATCH message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validWatch(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_UNWATCH message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validUnwatch(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_QUEUE message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validQueue(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_QUEUE_CANCEL message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validQueueCancel(const std::vector<std::string>& tokens);
+
     /// Checks if the message split up into tokens given as a parameter
     /// if a valid #I_GAME_RQ message.
     /// \param tokens message sent by a client split up into tokens
@@ -557,6 +905,54 @@ private:
     /// \return true if the message is valid, false otherwise.
     friend bool validGamePlay(const std::vector<std::string>& tokens);
 
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_GAME_RESYNC message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validGameResync(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_GET_HISTORY message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validGetHistory(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_GET_GAME message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validGetGame(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_DOWNLOAD_GAME message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validDownloadGame(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_DOWNLOAD_DAY message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validDownloadDay(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_GET_RANK message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validGetRank(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_GET_TOP message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validGetTop(const std::vector<std::string>& tokens);
+
+    /// Checks if the message split up into tokens given as a parameter
+    /// if a valid #I_ANALYZE message.
+    /// \param tokens message sent by a client split up into tokens
+    /// \return true if the message is valid, false otherwise.
+    friend bool validAnalyze(const std::vector<std::string>& tokens);
+
     /// Receives len bytes from the socket given as a parameter
     /// \param socket sockent we want to read data from
     /// \param buff buffer
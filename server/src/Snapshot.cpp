@@ -0,0 +1,257 @@
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Snapshot.h"
+#include "Logger.h"
+
+const std::string Snapshot::FILE_NAME = "snapshot.dat";
+
+// identification (and version) of the format of the file
+static const char MAGIC[] = "C4SN0001";
+static const size_t MAGIC_SIZE = 8;
+
+/// Computes FNV-1a hash of the data given as a parameter
+/// \param data the data
+/// \param size size of the data
+/// \return hash of the data
+static uint32_t fnv1a(const char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/// Appends a value in its binary form to the buffer given as a parameter
+/// \param buffer the buffer
+/// \param value the value
+template<typename T>
+static void put(std::string &buffer, T value) {
+    buffer.append((const char *)&value, sizeof(value));
+}
+
+/// Reads a value in its binary form from the buffer given as a parameter
+/// \param buffer the buffer
+/// \param offset position of the value (moved past it)
+/// \param value the value read
+/// \return false, if the buffer is too short. Otherwise, true.
+template<typename T>
+static bool get(const std::string &buffer, size_t &offset, T &value) {
+    if (offset + sizeof(value) > buffer.size())
+        return false;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+/// Reads a string prefixed by its length from the buffer given as a parameter
+/// \param buffer the buffer
+/// \param offset position of the string (moved past it)
+/// \param value the string read
+/// \return false, if the buffer is too short. Otherwise, true.
+template<typename Length>
+static bool getString(const std::string &buffer, size_t &offset, std::string &value) {
+    Length length;
+    if (!get(buffer, offset, length) || offset + length > buffer.size())
+        return false;
+    value.assign(buffer, offset, length);
+    offset += length;
+    return true;
+}
+
+/// Returns the sequence number of the first record of a segment of the journal
+/// \param path path to the segment
+/// \return sequence number of the first record, 0 if the segment is empty
+static uint64_t firstLsn(const std::string &path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    Journal::RecordHeader_t header;
+    if (!file.read((char *)&header, sizeof(header)))
+        return 0;
+    return header.lsn;
+}
+
+bool Snapshot::write(const std::string &dir, uint64_t lsn, const std::vector<Room_t> &rooms) {
+    std::string buffer(MAGIC, MAGIC_SIZE);
+    put<uint64_t>(buffer, lsn);
+    put<uint64_t>(buffer, rooms.size());
+    for (const Room_t &room : rooms) {
+        put<uint64_t>(buffer, room.id);
+        put<uint16_t>(buffer, room.player1.size());
+        buffer += room.player1;
+        put<uint16_t>(buffer, room.player2.size());
+        buffer += room.player2;
+        put<uint8_t>(buffer, room.moves.size());
+        buffer += room.moves;
+    }
+    put<uint32_t>(buffer, fnv1a(buffer.data(), buffer.size()));
+
+    std::string path = dir + "/" + FILE_NAME;
+    std::string tmpPath = path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+        LOG_ERR("creating snapshot '" + tmpPath + "' failed");
+        return false;
+    }
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            LOG_ERR("writing snapshot '" + tmpPath + "' failed");
+            close(fd);
+            return false;
+        }
+        written += n;
+    }
+    if (fdatasync(fd) < 0) {
+        LOG_ERR("fdatasync of snapshot '" + tmpPath + "' failed");
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    // replace the old snapshot atomically
+    if (rename(tmpPath.c_str(), path.c_str()) < 0) {
+        LOG_ERR("renaming snapshot '" + tmpPath + "' failed");
+        return false;
+    }
+    int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
+size_t Snapshot::removeCoveredSegments(const std::string &dir, uint64_t lsn) {
+    std::vector<std::string> segments = Journal::listSegments(dir);
+    std::vector<uint64_t> first(segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+        first[i] = firstLsn(segments[i]);
+
+    // a segment is covered if the next segment holding any record starts right after the snapshot (or before it)
+    size_t removed = 0;
+    uint64_t nextFirst = 0;
+    std::vector<bool> covered(segments.size(), false);
+    for (size_t i = segments.size(); i-- > 0;) {
+        covered[i] = nextFirst != 0 && nextFirst - 1 <= lsn;
+        if (first[i] != 0)
+            nextFirst = first[i];
+    }
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!covered[i])
+            continue;
+        if (unlink(segments[i].c_str()) < 0) {
+            LOG_WARNING("deleting segment '" + segments[i] + "' of the journal failed");
+            continue;
+        }
+        removed++;
+    }
+    if (removed > 0) {
+        int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+    return removed;
+}
+
+bool Snapshot::read(const std::string &dir, uint64_t &lsn, std::vector<Room_t> &rooms) {
+    std::ifstream file(dir + "/" + FILE_NAME, std::ios::in | std::ios::binary);
+    if (file.fail())
+        return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string buffer = ss.str();
+
+    uint32_t checksum;
+    if (buffer.size() < MAGIC_SIZE + sizeof(checksum) || buffer.compare(0, MAGIC_SIZE, MAGIC) != 0)
+        return false;
+    memcpy(&checksum, buffer.data() + buffer.size() - sizeof(checksum), sizeof(checksum));
+    buffer.resize(buffer.size() - sizeof(checksum));
+    if (fnv1a(buffer.data(), buffer.size()) != checksum)
+        return false;
+
+    size_t offset = MAGIC_SIZE;
+    uint64_t count;
+    if (!get(buffer, offset, lsn) || !get(buffer, offset, count))
+        return false;
+    rooms.clear();
+    rooms.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        Room_t room;
+        if (!get(buffer, offset, room.id) || !getString<uint16_t>(buffer, offset, room.player1) ||
+            !getString<uint16_t>(buffer, offset, room.player2) || !getString<uint8_t>(buffer, offset, room.moves))
+            return false;
+        rooms.push_back(std::move(room));
+    }
+    return true;
+}
+
+void Snapshot::recover(const std::string &dir, std::vector<Room_t> &rooms, Stats_t &stats) {
+    memset(&stats, 0, sizeof(stats));
+    std::vector<Room_t> snapshot;
+    if (!read(dir, stats.snapshotLsn, snapshot)) {
+        stats.snapshotLsn = 0;
+        snapshot.clear();
+    }
+    stats.snapshotRooms = snapshot.size();
+
+    std::unordered_map<uint64_t, Room_t> live;
+    live.reserve(snapshot.size());
+    for (Room_t &room : snapshot)
+        live[room.id] = std::move(room);
+
+    // the records following the snapshot start in the last segment
+    // beginning at (or before) the first record the snapshot does not cover
+    std::vector<std::string> segments = Journal::listSegments(dir);
+    size_t first = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        uint64_t lsn = firstLsn(segments[i]);
+        if (lsn != 0 && lsn <= stats.snapshotLsn + 1)
+            first = i;
+    }
+    stats.lastLsn = stats.snapshotLsn;
+    for (size_t i = first; i < segments.size(); i++) {
+        stats.segments++;
+        Journal::readSegment(segments[i], [&](const Journal::RecordHeader_t &header, const std::string &payload) {
+            if (header.lsn <= stats.snapshotLsn)
+                return;
+            stats.records++;
+            stats.lastLsn = header.lsn;
+            switch (header.type) {
+                case Journal::GAME_START: {
+                    size_t separator = payload.find(' ');
+                    if (separator == std::string::npos)
+                        return;
+                    live[header.gameId] = {header.gameId, payload.substr(0, separator), payload.substr(separator + 1), ""};
+                    break;
+                }
+                case Journal::GAME_MOVE: {
+                    auto room = live.find(header.gameId);
+                    if (room != live.end() && payload.size() == 1)
+                        room->second.moves += payload[0];
+                    break;
+                }
+                case Journal::GAME_RESULT:
+                case Journal::GAME_CANCELED:
+                    live.erase(header.gameId);
+                    break;
+            }
+        });
+    }
+
+    rooms.clear();
+    rooms.reserve(live.size());
+    for (auto &it : live)
+        rooms.push_back(std::move(it.second));
+}
@@ -0,0 +1,84 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Journal.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Compact snapshot of all the games in progress used to restore
+/// them after the server has been restarted (or has crashed).
+///
+/// The snapshot only holds the players and the moves of every live game
+/// together with the sequence number of the last record of the journal
+/// it covers. The games are restored (#recover) by loading the snapshot
+/// and replaying the records of the journal written after it, so only
+/// the tail of the journal needs to be read.
+///
+/// The file (#FILE_NAME in the directory of the journal) is written
+/// into a temporary file first and then renamed, so there is always
+/// either the old or the new snapshot on the disk, never a torn one.
+class Snapshot {
+public:
+    /// name of the snapshot file (in the directory of the journal)
+    static const std::string FILE_NAME;
+
+    /// One game in progress
+    struct Room_t {
+        uint64_t id;         ///< id of the game in the journal
+        std::string player1; ///< nick of player1 (they played the first move)
+        std::string player2; ///< nick of player2
+        std::string moves;   ///< the moves played so far (columns '0' - '6')
+    };
+
+    /// Statistics of one recovery
+    struct Stats_t {
+        uint64_t snapshotLsn;    ///< last sequence number covered by the snapshot (0 if none)
+        uint64_t snapshotRooms;  ///< number of games loaded from the snapshot
+        uint64_t segments;       ///< number of segments of the journal that were read
+        uint64_t records;        ///< number of records replayed (written after the snapshot)
+        uint64_t lastLsn;        ///< sequence number of the last record of the journal
+    };
+
+    /// Writes a snapshot of the games given as a parameter
+    ///
+    /// All the records up to the sequence number given as a parameter must
+    /// already be on the disk (see #Journal::waitDurable). Otherwise, the journal
+    /// could lose records the snapshot claims to cover.
+    ///
+    /// \param dir directory of the journal
+    /// \param lsn sequence number of the last record reflected in the games
+    /// \param rooms the games in progress
+    /// \return true, if the snapshot has been written. Otherwise, false.
+    static bool write(const std::string &dir, uint64_t lsn, const std::vector<Room_t> &rooms);
+
+    /// Reads the snapshot stored in the directory given as a parameter
+    /// \param dir directory of the journal
+    /// \param lsn sequence number of the last record covered by the snapshot
+    /// \param rooms the games stored in the snapshot
+    /// \return false, if there is no (valid) snapshot. Otherwise, true.
+    static bool read(const std::string &dir, uint64_t &lsn, std::vector<Room_t> &rooms);
+
+    /// Deletes the segments of the journal whose records are all covered by the snapshot
+    ///
+    /// The last records of a segment are told by the first record of the segment following it,
+    /// so the last segment holding any record is always kept (the journal continues the sequence
+    /// numbers after it when it is opened, see #Journal::open).
+    ///
+    /// \param dir directory of the journal
+    /// \param lsn sequence number of the last record covered by the snapshot (see #write)
+    /// \return number of segments deleted
+    static size_t removeCoveredSegments(const std::string &dir, uint64_t lsn);
+
+    /// Restores all the games that were in progress - loads the snapshot
+    /// and replays the records of the journal written after it
+    /// \param dir directory of the journal
+    /// \param rooms the games in progress
+    /// \param stats statistics of the recovery
+    static void recover(const std::string &dir, std::vector<Room_t> &rooms, Stats_t &stats);
+};
+
+#endif
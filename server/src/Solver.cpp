@@ -0,0 +1,215 @@
+#include "Solver.h"
+
+// value offsets used when storing bounds into the transposition table
+// upper bound: score - MIN_SCORE + 1, lower bound: score + LOWER_BOUND_OFFSET
+static const int UPPER_BOUND_MAX = Position::MAX_SCORE - Position::MIN_SCORE + 1;
+static const int LOWER_BOUND_OFFSET = Position::MAX_SCORE - 2 * Position::MIN_SCORE + 2;
+
+void Solver::MoveSorter_t::add(uint64_t move, int score) {
+    int pos = size++;
+    for (; pos && entries[pos - 1].score > score; pos--)
+        entries[pos] = entries[pos - 1];
+    entries[pos].move = move;
+    entries[pos].score = score;
+}
+
+uint64_t Solver::MoveSorter_t::getNext() {
+    if (size)
+        return entries[--size].move;
+    return 0;
+}
+
+Solver::Solver(TranspositionTable *table, int variant, std::atomic<bool> *stopFlag) {
+    this->table = table;
+    ownStopFlag.store(false);
+    this->stopFlag = stopFlag != NULL ? stopFlag : &ownStopFlag;
+    book = NULL;
+    bookMaxMoves = -1;
+    nodeCount = 0;
+
+    // center columns first (3 2 4 1 5 0 6), other variants
+    // rotate the order so the helper threads diverge
+    int centerFirst[Position::WIDTH];
+    for (int i = 0; i < Position::WIDTH; i++)
+        centerFirst[i] = Position::WIDTH / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2;
+    for (int i = 0; i < Position::WIDTH; i++)
+        columnOrder[i] = centerFirst[(i + variant) % Position::WIDTH];
+}
+
+int Solver::negamax(const Position &position, int alpha, int beta) {
+    nodeCount++;
+    if (stopFlag->load(std::memory_order_relaxed))
+        return 0;
+
+    uint64_t possible = position.possibleNonLosingMoves();
+    if (possible == 0)
+        return -(Position::WIDTH * Position::HEIGHT - position.nbMoves()) / 2;
+    if (position.nbMoves() >= Position::WIDTH * Position::HEIGHT - 2)
+        return 0;
+
+    int min = -(Position::WIDTH * Position::HEIGHT - 2 - position.nbMoves()) / 2;
+    if (alpha < min) {
+        alpha = min;
+        if (alpha >= beta)
+            return alpha;
+    }
+    int max = (Position::WIDTH * Position::HEIGHT - 1 - position.nbMoves()) / 2;
+    if (beta > max) {
+        beta = max;
+        if (alpha >= beta)
+            return beta;
+    }
+
+    int bookScore, bookColumn;
+    if (position.nbMoves() <= bookMaxMoves && book->lookup(position, bookScore, bookColumn))
+        return bookScore;
+
+    uint64_t key = position.canonicalKey();
+    int value = table->get(key);
+    if (value) {
+        if (value > UPPER_BOUND_MAX) {
+            min = value - LOWER_BOUND_OFFSET;
+            if (alpha < min) {
+                alpha = min;
+                if (alpha >= beta)
+                    return alpha;
+            }
+        }
+        else {
+            max = value + Position::MIN_SCORE - 1;
+            if (beta > max) {
+                beta = max;
+                if (alpha >= beta)
+                    return beta;
+            }
+        }
+    }
+
+    // mirrored moves of a symmetric position lead to the same score
+    int lastColumn = Position::WIDTH - 1;
+    if (position.nbMoves() < SYMMETRY_MAX_MOVES && position.isSymmetric())
+        lastColumn = Position::WIDTH / 2;
+
+    MoveSorter_t moves;
+    moves.size = 0;
+    for (int i = Position::WIDTH - 1; i >= 0; i--) {
+        if (columnOrder[i] > lastColumn)
+            continue;
+        uint64_t move = possible & Position::columnMask(columnOrder[i]);
+        if (move)
+            moves.add(move, position.moveScore(move));
+    }
+
+    while (uint64_t next = moves.getNext()) {
+        Position child(position);
+        child.play(next);
+        int score = -negamax(child, -beta, -alpha);
+        if (stopFlag->load(std::memory_order_relaxed))
+            return 0;
+        if (score >= beta) {
+            table->put(key, (uint8_t)(score + LOWER_BOUND_OFFSET));
+            return score;
+        }
+        if (score > alpha)
+            alpha = score;
+    }
+    table->put(key, (uint8_t)(alpha - Position::MIN_SCORE + 1));
+    return alpha;
+}
+
+int Solver::solve(const Position &position, bool weak) {
+    if (position.canWinNext())
+        return (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+
+    int min = -(Position::WIDTH * Position::HEIGHT - position.nbMoves()) / 2;
+    int max = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+    if (weak) {
+        min = -1;
+        max = 1;
+    }
+    int bookScore, bookColumn;
+    if (position.nbMoves() <= bookMaxMoves && book->lookup(position, bookScore, bookColumn))
+        return weak ? (bookScore > 0) - (bookScore < 0) : bookScore;
+    // iterative deepening with a null window
+    while (min < max && !isStopped()) {
+        int med = min + (max - min) / 2;
+        if (med <= 0 && min / 2 < med)
+            med = min / 2;
+        else if (med >= 0 && max / 2 > med)
+            med = max / 2;
+        int r = negamax(position, med, med + 1);
+        if (r <= med)
+            max = r;
+        else min = r;
+    }
+    return min;
+}
+
+std::vector<int> Solver::analyze(const Position &position, bool weak) {
+    std::vector<int> scores(Position::WIDTH, INVALID_MOVE);
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (!position.canPlay(col))
+            continue;
+        if (position.isWinningMove(col)) {
+            scores[col] = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+            continue;
+        }
+        Position child(position);
+        child.playCol(col);
+        scores[col] = -solve(child, weak);
+    }
+    return scores;
+}
+
+void Solver::setBook(OpeningBook *book) {
+    this->book = book;
+    bookMaxMoves = book != NULL ? book->getMaxMoves() : -1;
+}
+
+uint64_t Solver::getNodeCount() const {
+    return nodeCount;
+}
+
+void Solver::resetNodeCount() {
+    nodeCount = 0;
+}
+
+bool Solver::isStopped() const {
+    return stopFlag->load(std::memory_order_relaxed);
+}
+
+int Solver::solveParallel(const Position &position, int threads, TranspositionTable &table, uint64_t &nodeCount, bool weak, OpeningBook *book) {
+    if (threads < 1)
+        threads = 1;
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> solved(false);
+    std::atomic<int> result(0);
+    std::vector<uint64_t> nodes(threads, 0);
+    std::vector<std::thread> helpers;
+
+    auto search = [&](int variant) {
+        Solver solver(&table, variant, &stop);
+        solver.setBook(book);
+        int score = solver.solve(position, weak);
+        nodes[variant] = solver.getNodeCount();
+
+        // the first thread to finish the search publishes the score
+        bool expected = false;
+        if (!solver.isStopped() && solved.compare_exchange_strong(expected, true)) {
+            result.store(score);
+            stop.store(true);
+        }
+    };
+
+    for (int i = 1; i < threads; i++)
+        helpers.emplace_back(search, i);
+    search(0);
+    for (auto &helper : helpers)
+        helper.join();
+
+    nodeCount = 0;
+    for (uint64_t n : nodes)
+        nodeCount += n;
+    return result.load();
+}
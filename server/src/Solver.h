@@ -0,0 +1,139 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "Position.h"
+#include "TranspositionTable.h"
+#include "OpeningBook.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Perfect Connect4 solver (negamax with alpha-beta pruning).
+///
+/// The solver returns the exact score of a position - a positive score
+/// means the player who is up wins, a negative score means they lose
+/// and zero means draw. The sooner the win, the higher the score
+/// (#Position::MAX_SCORE is a win with the player's fourth tile).
+///
+/// The search uses a #TranspositionTable keyed by the canonical
+/// (mirror-reduced) key of the position, move ordering by the number
+/// of winning spots a move creates and symmetry reduction of symmetric
+/// positions. Multiple instances may share the same table and search
+/// the same position in parallel (lazy SMP - see #solveParallel).
+/// If an #OpeningBook is set, the positions it covers are not searched at all.
+class Solver {
+public:
+    /// score returned by #analyze for a column that is full
+    static const int INVALID_MOVE = -1000;
+
+    /// positions with fewer moves than this are checked
+    /// for symmetry (only half of the moves is explored)
+    static const int SYMMETRY_MAX_MOVES = 12;
+
+private:
+    /// Helper structure sorting the moves of a position
+    /// by their score (insertion sort - there are at most 7 moves)
+    struct MoveSorter_t {
+        /// number of moves stored
+        int size;
+        /// the moves with their scores
+        struct {
+            uint64_t move; ///< the move (bitmap with a single bit set)
+            int score;     ///< score of the move
+        } entries[Position::WIDTH];
+
+        /// Adds a move, keeping the entries sorted by their score
+        /// \param move the move itself
+        /// \param score the score of the move
+        void add(uint64_t move, int score);
+
+        /// Returns the next best move
+        /// \return the move or 0, if there are no more moves
+        uint64_t getNext();
+    };
+
+    /// table shared by all the solvers searching the same position
+    TranspositionTable *table;
+    /// flag telling the solver to stop searching (shared with other solvers)
+    std::atomic<bool> *stopFlag;
+    /// flag used when no shared flag is given
+    std::atomic<bool> ownStopFlag;
+    /// opening book consulted before searching (may be NULL)
+    OpeningBook *book;
+    /// maximum number of moves of the positions stored in the book
+    int bookMaxMoves;
+    /// number of explored positions
+    uint64_t nodeCount;
+    /// order in which the columns are explored
+    int columnOrder[Position::WIDTH];
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// Different variants explore the columns in different orders,
+    /// so the threads of lazy SMP do not all search the same subtree.
+    ///
+    /// \param table transposition table used by the solver
+    /// \param variant the variant of the column order (0 = center first)
+    /// \param stopFlag flag shared by all the solvers searching the same position (may be NULL)
+    Solver(TranspositionTable *table, int variant = 0, std::atomic<bool> *stopFlag = NULL);
+
+    /// Returns the exact score of the position
+    /// \param position the position that is going to be solved
+    /// \param weak true, if only the sign of the score is important (win/draw/loss)
+    /// \return score of the position (undefined if the search was stopped)
+    int solve(const Position &position, bool weak = false);
+
+    /// Returns the score of every column of the position
+    /// (the score of the position after playing into the column, from
+    /// the point of view of the player who is up)
+    /// \param position the position that is going to be analyzed
+    /// \param weak true, if only the sign of the scores is important (win/draw/loss)
+    /// \return scores of the columns (#INVALID_MOVE for the full ones)
+    std::vector<int> analyze(const Position &position, bool weak = false);
+
+    /// Sets the opening book consulted before searching a position
+    /// \param book the opening book (NULL to stop using a book)
+    void setBook(OpeningBook *book);
+
+    /// Returns the number of positions explored so far
+    /// \return number of explored positions
+    uint64_t getNodeCount() const;
+
+    /// Sets the number of explored positions back down to zero
+    void resetNodeCount();
+
+    /// Returns whether the search has been stopped
+    /// \return true, if the search has been stopped. Otherwise, false.
+    bool isStopped() const;
+
+    /// Solves the position using multiple threads sharing the same
+    /// transposition table (lazy SMP). The first thread to finish
+    /// stops the others.
+    /// \param position the position that is going to be solved
+    /// \param threads number of threads
+    /// \param table transposition table shared by the threads
+    /// \param nodeCount the total number of explored positions (output)
+    /// \param weak true, if only the sign of the score is important (win/draw/loss)
+    /// \param book opening book consulted by the threads (may be NULL)
+    /// \return score of the position
+    static int solveParallel(const Position &position, int threads, TranspositionTable &table, uint64_t &nodeCount, bool weak = false, OpeningBook *book = NULL);
+
+private:
+    /// Negamax search with alpha-beta pruning
+    ///
+    /// The position must not be winnable by the player who
+    /// is up in their next move.
+    ///
+    /// \param position the position that is being searched
+    /// \param alpha lower bound of the window
+    /// \param beta upper bound of the window
+    /// \return score of the position within the window
+    int negamax(const Position &position, int alpha, int beta);
+};
+
+#endif
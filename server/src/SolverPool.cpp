@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include "SolverPool.h"
+
+SolverPool::SolverPool(uint64_t tableSize) {
+    this->tableSize = tableSize;
+    running = false;
+}
+
+SolverPool::~SolverPool() {
+    close();
+}
+
+void SolverPool::open(int threads, OpeningBook *book, Body_t body) {
+    if (running)
+        return;
+    if (table == nullptr)
+        table.reset(new TranspositionTable(tableSize));
+    running = true;
+    for (int i = 0; i < std::max(1, threads); i++) {
+        std::unique_ptr<Worker_t> worker(new Worker_t);
+        worker->stop = false;
+        worker->deadline = 0;
+        Worker_t *w = worker.get();
+        worker->thread = std::thread([this, w, book, body]() {
+            Solver solver(table.get(), 0, &w->stop);
+            solver.setBook(book);
+            body(w, solver);
+        });
+        workers.push_back(std::move(worker));
+    }
+    watchdog = std::thread(&SolverPool::watchdogHandler, this);
+}
+
+void SolverPool::close() {
+    if (!running)
+        return;
+    running = false;
+    // the searches in progress are stopped (and no budget started from now on lets them search)
+    for (auto &worker : workers) {
+        worker->budgetMtx.lock();
+        worker->stop = true;
+        worker->budgetMtx.unlock();
+    }
+    for (auto &worker : workers)
+        worker->thread.join();
+    watchdog.join();
+    workers.clear();
+}
+
+void SolverPool::startBudget(Worker_t *worker, std::chrono::steady_clock::time_point deadline) {
+    worker->budgetMtx.lock();
+    worker->stop = !running;
+    worker->deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    worker->budgetMtx.unlock();
+}
+
+void SolverPool::endBudget(Worker_t *worker) {
+    worker->budgetMtx.lock();
+    worker->deadline = 0;
+    worker->budgetMtx.unlock();
+}
+
+void SolverPool::watchdogHandler() {
+    while (running) {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        for (auto &worker : workers) {
+            // the deadline cannot be replaced by the one of the next budget meanwhile
+            worker->budgetMtx.lock();
+            if (worker->deadline != 0 && now >= worker->deadline)
+                worker->stop = true;
+            worker->budgetMtx.unlock();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCHDOG_INTERVAL_MS));
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef SOLVER_POOL_H
+#define SOLVER_POOL_H
+
+#include <vector>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Solver.h"
+#include "TranspositionTable.h"
+#include "OpeningBook.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Fixed number of worker threads solving positions within time budgets
+/// (shared by #Analyzer and #Annotator).
+///
+/// Every worker has its own solver; the solvers share one transposition table
+/// (kept when the pool is closed and opened again) and the opening book. What
+/// the workers do is up to the owner of the pool (the body of a worker), the pool
+/// only runs them and stops their searches once they run out of time: a worker
+/// starts a budget before it searches (#startBudget) and ends it afterwards
+/// (#endBudget), and a watchdog stops the solver of a worker whose budget has
+/// run out. The watchdog stops a solver holding the same lock a budget is
+/// started and ended with, so it never stops the search of the next budget
+/// because of the one that has just ended.
+class SolverPool {
+public:
+    /// amount of milliseconds between two checks of the time budgets by the watchdog
+    static const int WATCHDOG_INTERVAL_MS = 5;
+
+    /// One worker thread
+    struct Worker_t {
+        std::thread thread;     ///< the thread
+        std::mutex budgetMtx;   ///< lock used when starting, ending and stopping a budget
+        std::atomic<bool> stop; ///< tells the solver of the worker to stop searching
+        int64_t deadline;       ///< when the current budget runs out (ns of the steady clock, 0 - none)
+    };
+
+    /// body of a worker thread - it returns once the owner of the pool is being closed
+    typedef std::function<void(Worker_t *worker, Solver &solver)> Body_t;
+
+private:
+    /// number of entries of the transposition table
+    uint64_t tableSize;
+    /// transposition table shared by the workers
+    std::unique_ptr<TranspositionTable> table;
+    /// the workers
+    std::vector<std::unique_ptr<Worker_t>> workers;
+    /// the watchdog stopping the searches that ran out of time
+    std::thread watchdog;
+    /// indication of whether or not the threads should keep running
+    std::atomic<bool> running;
+
+private:
+    /// The body of the watchdog thread
+    void watchdogHandler();
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// No thread is started until it is opened (see #open).
+    /// \param tableSize number of entries of the transposition table (a prime number)
+    explicit SolverPool(uint64_t tableSize);
+
+    /// Destructor of the class - stops the threads (see #close)
+    ~SolverPool();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    SolverPool(const SolverPool&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const SolverPool&) = delete;
+
+    /// Starts the worker threads and the watchdog
+    /// \param threads number of worker threads (at least one is started)
+    /// \param book opening book consulted by the solvers (may be NULL)
+    /// \param body body of every worker thread
+    void open(int threads, OpeningBook *book, Body_t body);
+
+    /// Stops the searches and waits for the threads. The owner has to make
+    /// the bodies of the workers return first (no budget is started anymore).
+    void close();
+
+    /// Starts the time budget of a worker (its solver is stopped once it runs out)
+    /// \param worker the worker
+    /// \param deadline when the budget runs out
+    void startBudget(Worker_t *worker, std::chrono::steady_clock::time_point deadline);
+
+    /// Ends the time budget of a worker (its solver is not stopped anymore)
+    /// \param worker the worker
+    void endBudget(Worker_t *worker);
+};
+
+#endif
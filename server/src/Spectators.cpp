@@ -0,0 +1,338 @@
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "Spectators.h"
+#include "Logger.h"
+
+const std::string Spectators::WATCH_STATE  = "WATCH_STATE";
+const std::string Spectators::WATCH_PLAY   = "WATCH_PLAY";
+const std::string Spectators::WATCH_RESULT = "WATCH_RESULT";
+const std::string Spectators::WATCH_END    = "WATCH_END";
+
+Spectators::Spectators() {
+    running = false;
+    memset(&stats, 0, sizeof(stats));
+}
+
+Spectators::~Spectators() {
+    close();
+}
+
+void Spectators::open(const std::string &protocolId) {
+    eventsMtx.lock();
+    if (running) {
+        eventsMtx.unlock();
+        return;
+    }
+    this->protocolId = protocolId;
+    running = true;
+    delivery = std::thread(&Spectators::deliveryHandler, this);
+    eventsMtx.unlock();
+}
+
+void Spectators::close() {
+    eventsMtx.lock();
+    if (!running) {
+        eventsMtx.unlock();
+        return;
+    }
+    running = false;
+    eventsMtx.unlock();
+    eventsCv.notify_one();
+    delivery.join();
+
+    spectatorsMtx.lock();
+    while (!spectators.empty())
+        remove(spectators.begin()->second);
+    spectatorsMtx.unlock();
+}
+
+std::shared_ptr<const std::string> Spectators::encode(const std::string &msg) const {
+    char length[16];
+    snprintf(length, sizeof(length), "%04zu", msg.length());
+    return std::make_shared<const std::string>(protocolId + length + msg + "\r\n");
+}
+
+void Spectators::snapshot(Spectator_t *spectator, const Game_t &game) {
+    std::string id = std::to_string(spectator->gameId);
+    spectator->queue.clear();
+    spectator->queue.push_back(encode(WATCH_STATE + " " + id + " " + game.player1 + " " + game.player2 + " " +
+                                      std::to_string(game.moves.size()) + (game.moves.empty() ? "" : " " + game.moves)));
+    if (!game.result.empty())
+        spectator->queue.push_back(encode(WATCH_RESULT + " " + id + " " + game.result));
+    spectator->covered = game.frames;
+}
+
+void Spectators::remove(Spectator_t *spectator) {
+    auto it = watchers.find(spectator->gameId);
+    if (it != watchers.end()) {
+        std::vector<Spectator_t *> &list = it->second;
+        for (size_t i = 0; i < list.size(); i++)
+            if (list[i] == spectator) {
+                list[i] = list.back();
+                list.pop_back();
+                break;
+            }
+        // nobody is watching the game anymore - it does not have to be published
+        if (list.empty()) {
+            watchers.erase(it);
+            eventsMtx.lock();
+            auto game = games.find(spectator->gameId);
+            if (game != games.end() && game->second.joining == 0)
+                games.erase(game);
+            eventsMtx.unlock();
+        }
+    }
+    spectators.erase(spectator->nick);
+    // the delivery thread is sending them the frames - it deletes them once it is done
+    if (spectator->flushing) {
+        spectator->removed = true;
+        return;
+    }
+    ::close(spectator->socket);
+    delete spectator;
+}
+
+void Spectators::join(uint64_t gameId, const std::string &player1, const std::string &player2, const std::string &moves) {
+    eventsMtx.lock();
+    auto game = games.find(gameId);
+    if (game == games.end())
+        game = games.insert({gameId, Game_t{player1, player2, moves, "", 0, 0}}).first;
+    game->second.joining++;
+    eventsMtx.unlock();
+}
+
+bool Spectators::watch(const std::string &nick, int socket, std::shared_ptr<std::mutex> sendMtx, uint64_t gameId) {
+    spectatorsMtx.lock();
+    auto it = spectators.find(nick);
+    if (it != spectators.end())
+        remove(it->second);
+
+    // the moves published since the game was joined are already in its state
+    eventsMtx.lock();
+    auto game = games.find(gameId);
+    if (game == games.end()) {
+        eventsMtx.unlock();
+        spectatorsMtx.unlock();
+        return false;
+    }
+    game->second.joining--;
+    Spectator_t *spectator = new Spectator_t{nick, socket, sendMtx, gameId, 0, {}, false, false, false};
+    spectators[nick] = spectator;
+    watchers[gameId].push_back(spectator);
+    snapshot(spectator, game->second);
+    eventsMtx.unlock();
+    spectatorsMtx.unlock();
+    eventsCv.notify_one();
+    return true;
+}
+
+bool Spectators::unwatch(const std::string &nick) {
+    spectatorsMtx.lock();
+    auto it = spectators.find(nick);
+    bool watching = it != spectators.end();
+    if (watching)
+        remove(it->second);
+    spectatorsMtx.unlock();
+    return watching;
+}
+
+void Spectators::push(uint64_t gameId, Game_t &game, const std::string &msg, bool end) {
+    events.push_back({gameId, ++game.frames, encode(msg), end});
+    stats.published++;
+}
+
+void Spectators::publishMove(uint64_t gameId, const std::string &player, int y, int x) {
+    eventsMtx.lock();
+    auto game = games.find(gameId);
+    if (game == games.end()) {
+        eventsMtx.unlock();
+        return;
+    }
+    game->second.moves += (char)('0' + x);
+    push(gameId, game->second, WATCH_PLAY + " " + std::to_string(gameId) + " " + std::to_string(game->second.moves.size()) + " " +
+                               player + " " + std::to_string(y) + " " + std::to_string(x), false);
+    eventsMtx.unlock();
+    eventsCv.notify_one();
+}
+
+void Spectators::publishResult(uint64_t gameId, const std::string &result) {
+    eventsMtx.lock();
+    auto game = games.find(gameId);
+    if (game == games.end()) {
+        eventsMtx.unlock();
+        return;
+    }
+    game->second.result = result;
+    push(gameId, game->second, WATCH_RESULT + " " + std::to_string(gameId) + " " + result, false);
+    eventsMtx.unlock();
+    eventsCv.notify_one();
+}
+
+void Spectators::publishEnd(uint64_t gameId) {
+    eventsMtx.lock();
+    auto game = games.find(gameId);
+    if (game == games.end()) {
+        eventsMtx.unlock();
+        return;
+    }
+    push(gameId, game->second, WATCH_END + " " + std::to_string(gameId), true);
+    eventsMtx.unlock();
+    eventsCv.notify_one();
+}
+
+bool Spectators::flush(Spectator_t *spectator, uint64_t &sent) {
+    // the client is being sent another message - they will be sent the frames next time
+    if (!spectator->sendMtx->try_lock())
+        return true;
+    bool ok = true;
+    while (ok && !spectator->queue.empty()) {
+        const std::string &frame = *spectator->queue.front();
+        ssize_t n = send(spectator->socket, frame.data(), frame.size(), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            ok = errno == EAGAIN || errno == EWOULDBLOCK;
+            break;
+        }
+        // the rest of the frame has to follow, otherwise the
+        // client could not tell where the next message starts
+        size_t done = (size_t)n;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(PARTIAL_FRAME_TIMEOUT_MS);
+        while (ok && done < frame.size()) {
+            int remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            struct pollfd pfd = {spectator->socket, POLLOUT, 0};
+            n = -1;
+            if (remaining > 0 && poll(&pfd, 1, remaining) >= 0)
+                n = send(spectator->socket, frame.data() + done, frame.size() - done, MSG_DONTWAIT);
+            if (n > 0)
+                done += (size_t)n;
+            else if (remaining <= 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                shutdown(spectator->socket, SHUT_RDWR);
+                ok = false;
+            }
+        }
+        if (ok) {
+            spectator->queue.pop_front();
+            sent++;
+        }
+    }
+    spectator->sendMtx->unlock();
+    return ok;
+}
+
+void Spectators::deliveryHandler() {
+    std::vector<Event_t> batch;
+    std::vector<Spectator_t *> ready;
+    std::vector<bool> results;
+    bool pending = false;
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(eventsMtx);
+            auto wakeUp = [&]() { return !running || !events.empty(); };
+            if (pending)
+                eventsCv.wait_for(lock, std::chrono::milliseconds(RETRY_INTERVAL_MS), wakeUp);
+            else eventsCv.wait(lock, wakeUp);
+            if (!running)
+                return;
+            batch.clear();
+            batch.swap(events);
+        }
+
+        spectatorsMtx.lock();
+        // fan the frames out (a spectator who has fallen too far behind gets a snapshot instead)
+        for (const Event_t &event : batch) {
+            auto it = watchers.find(event.gameId);
+            if (it != watchers.end()) {
+                for (Spectator_t *spectator : it->second) {
+                    if (event.number <= spectator->covered && !event.end)
+                        continue;
+                    if (spectator->queue.size() >= MAX_QUEUED_FRAMES) {
+                        eventsMtx.lock();
+                        auto game = games.find(event.gameId);
+                        if (game != games.end())
+                            snapshot(spectator, game->second);
+                        eventsMtx.unlock();
+                        stats.snapshots++;
+                        if (event.number <= spectator->covered && !event.end)
+                            continue;
+                    }
+                    spectator->queue.push_back(event.frame);
+                }
+                // the game is over - its spectators are removed once they are sent the rest of the frames
+                if (event.end) {
+                    for (Spectator_t *spectator : it->second) {
+                        spectator->ended = true;
+                        spectator->gameId = 0;
+                    }
+                    watchers.erase(it);
+                }
+            }
+            // the game is forgotten even if nobody is watching it yet, so a client
+            // who has joined it but is not watching it yet is turned away (see #watch)
+            if (event.end) {
+                eventsMtx.lock();
+                games.erase(event.gameId);
+                eventsMtx.unlock();
+            }
+        }
+
+        // pick the spectators who have something to be sent
+        ready.clear();
+        for (auto &it : spectators) {
+            Spectator_t *spectator = it.second;
+            if (spectator->queue.empty() && !spectator->ended)
+                continue;
+            spectator->flushing = true;
+            ready.push_back(spectator);
+        }
+        spectatorsMtx.unlock();
+
+        // send off what they can take (a slow spectator holds up nobody but the delivery thread)
+        uint64_t sent = 0;
+        results.assign(ready.size(), true);
+        for (size_t i = 0; i < ready.size(); i++)
+            results[i] = flush(ready[i], sent);
+
+        spectatorsMtx.lock();
+        stats.sent += sent;
+        pending = false;
+        for (size_t i = 0; i < ready.size(); i++) {
+            Spectator_t *spectator = ready[i];
+            spectator->flushing = false;
+            // they stopped watching meanwhile
+            if (spectator->removed) {
+                ::close(spectator->socket);
+                delete spectator;
+                continue;
+            }
+            if (!results[i]) {
+                LOG_WARNING("spectator '" + spectator->nick + "' is not taking the frames of the game - they stop watching it");
+                stats.dropped++;
+                remove(spectator);
+            }
+            else if (spectator->ended && spectator->queue.empty())
+                remove(spectator);
+            else if (!spectator->queue.empty())
+                pending = true;
+        }
+        spectatorsMtx.unlock();
+    }
+}
+
+Spectators::Stats_t Spectators::getStats() {
+    spectatorsMtx.lock();
+    Stats_t current = stats;
+    current.spectators = spectators.size();
+    current.games = watchers.size();
+    eventsMtx.lock();
+    current.published = stats.published;
+    eventsMtx.unlock();
+    spectatorsMtx.unlock();
+    return current;
+}
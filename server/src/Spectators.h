@@ -0,0 +1,223 @@
+#ifndef SPECTATORS_H
+#define SPECTATORS_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Clients watching games played by other clients (spectators).
+///
+/// The events of a game (moves, result, ...) are published by the thread
+/// handling the players; #publishMove (and the others) only encodes the message into a frame
+/// once and hands it over to a background delivery thread, so the number
+/// of spectators has no effect on how long a move takes. The delivery
+/// thread appends the frame to the queue of every spectator of the game
+/// and sends it off without blocking (through a duplicate of their socket,
+/// holding the lock the client uses when sending messages).
+///
+/// A spectator who does not take the data fast enough is not waited for.
+/// Once more than #MAX_QUEUED_FRAMES frames are waiting for them, the queue
+/// is dropped and replaced with one snapshot of the game (#WATCH_STATE),
+/// which is also what a spectator gets when they start watching. The frames
+/// of a game are numbered, so the ones a snapshot covers are never sent.
+class Spectators {
+public:
+    /// the most frames waiting for a spectator before they are replaced with a snapshot
+    static const size_t MAX_QUEUED_FRAMES = 32;
+    /// amount of milliseconds the delivery thread waits before it tries to send
+    /// the frames a spectator has not taken yet
+    static const int RETRY_INTERVAL_MS = 50;
+    /// amount of milliseconds of waiting for a spectator to take the rest of a frame
+    /// that has been sent only partially (after that, they are disconnected)
+    static const int PARTIAL_FRAME_TIMEOUT_MS = 1000;
+
+    /// message - snapshot of a game.
+    /// Format: WATCH_STATE <game id> <player1> <player2> <number of moves> [moves as a string of columns]
+    static const std::string WATCH_STATE;
+    /// message - one move of a game.
+    /// Format: WATCH_PLAY <game id> <number of the move (1, 2, ...)> <player> <y> <x>
+    static const std::string WATCH_PLAY;
+    /// message - result of a game.
+    /// Format: WATCH_RESULT <game id> <nick of the winner/draw> [winning tiles]
+    static const std::string WATCH_RESULT;
+    /// message - the game is over (or it was canceled) and it is no longer watched.
+    /// Format: WATCH_END <game id>
+    static const std::string WATCH_END;
+
+    /// Statistics of the spectators
+    struct Stats_t {
+        uint64_t spectators; ///< number of clients watching a game at the moment
+        uint64_t games;      ///< number of games being watched at the moment
+        uint64_t published;  ///< number of frames published
+        uint64_t sent;       ///< number of frames sent off to the spectators
+        uint64_t snapshots;  ///< number of snapshots sent off instead of the queued frames
+        uint64_t dropped;    ///< number of spectators disconnected (errors, partially sent frames)
+    };
+
+private:
+    /// Current state of a watched game (used for the snapshots)
+    struct Game_t {
+        std::string player1; ///< nick of player1
+        std::string player2; ///< nick of player2
+        std::string moves;   ///< the moves played so far (columns '0' - '6')
+        std::string result;  ///< the result (#WATCH_RESULT without the type and the id), empty while the game is being played
+        uint64_t frames;     ///< number of frames published
+        int joining;         ///< number of clients about to watch the game (see #join)
+    };
+
+    /// One spectator
+    struct Spectator_t {
+        std::string nick;                      ///< nick of the client
+        int socket;                            ///< duplicate of the socket of the client
+        std::shared_ptr<std::mutex> sendMtx;   ///< lock the client uses when sending messages
+        uint64_t gameId;                       ///< id of the game they are watching
+        uint64_t covered;                      ///< number of frames of the game covered by the last snapshot
+        std::deque<std::shared_ptr<const std::string>> queue; ///< frames waiting to be sent off
+        bool ended;                            ///< true, if the game is over (they are removed once the queue is empty)
+        bool flushing;                         ///< true, while the delivery thread is sending them the frames
+        bool removed;                          ///< true, if they were removed while being sent the frames
+    };
+
+    /// One published frame
+    struct Event_t {
+        uint64_t gameId;                          ///< id of the game
+        uint64_t number;                          ///< number of the frame within the game (1, 2, ...)
+        std::shared_ptr<const std::string> frame; ///< the frame (as it is sent)
+        bool end;                                 ///< true, if it is the last frame of the game
+    };
+
+    /// id of the protocol (used when encoding the frames)
+    std::string protocolId;
+
+    /// lock used when accessing the games and the published events
+    std::mutex eventsMtx;
+    /// used to wake up the delivery thread
+    std::condition_variable eventsCv;
+    /// the games being watched (the key is the id of the game)
+    std::unordered_map<uint64_t, Game_t> games;
+    /// frames published since the delivery thread took them last time
+    std::vector<Event_t> events;
+    /// indication of whether or not the delivery thread should keep running
+    bool running;
+
+    /// lock used when accessing the spectators (always locked before #eventsMtx)
+    std::mutex spectatorsMtx;
+    /// the spectators (the key is their nick)
+    std::unordered_map<std::string, Spectator_t *> spectators;
+    /// the spectators of every game (the key is the id of the game)
+    std::unordered_map<uint64_t, std::vector<Spectator_t *>> watchers;
+    /// statistics of the spectators
+    Stats_t stats;
+    /// the delivery thread
+    std::thread delivery;
+
+private:
+    /// The body of the delivery thread
+    void deliveryHandler();
+
+    /// Sends off as many queued frames to the spectator as they can take without waiting.
+    /// It is called without #spectatorsMtx being locked (the spectator is marked as flushing).
+    /// \param spectator the spectator
+    /// \param sent number of frames sent off (it is increased)
+    /// \return false, if the spectator should be disconnected. Otherwise, true.
+    bool flush(Spectator_t *spectator, uint64_t &sent);
+
+    /// Encodes a message into a frame (as defined by the protocol)
+    /// \param msg the message
+    /// \return the frame
+    std::shared_ptr<const std::string> encode(const std::string &msg) const;
+
+    /// Replaces the frames waiting for the spectator with a snapshot of their game
+    /// (#WATCH_STATE, followed by the result if the game is over). #eventsMtx must be locked.
+    /// \param spectator the spectator
+    /// \param game the game
+    void snapshot(Spectator_t *spectator, const Game_t &game);
+
+    /// Removes the spectator given as a parameter (#spectatorsMtx must be locked).
+    /// If they are being sent the frames at the moment, the delivery thread deletes them afterwards.
+    /// \param spectator the spectator
+    void remove(Spectator_t *spectator);
+
+    /// Hands a frame of a game over to the delivery thread (#eventsMtx must be locked)
+    /// \param gameId id of the game
+    /// \param game the game
+    /// \param msg the message
+    /// \param end true, if it is the last frame of the game
+    void push(uint64_t gameId, Game_t &game, const std::string &msg, bool end);
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// Nothing is delivered until it is opened (see #open).
+    Spectators();
+
+    /// Destructor of the class - stops the delivery thread (see #close)
+    ~Spectators();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Spectators(const Spectators&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Spectators&) = delete;
+
+    /// Starts the delivery thread
+    /// \param protocolId id of the protocol
+    void open(const std::string &protocolId);
+
+    /// Stops the delivery thread and disconnects all the spectators
+    void close();
+
+    /// Starts publishing a game a client is about to watch (see #watch).
+    /// The game has to be locked by the caller, so no move is published meanwhile.
+    /// It does not wait for the spectators, so it can be called while holding the lock.
+    /// \param gameId id of the game
+    /// \param player1 nick of player1
+    /// \param player2 nick of player2
+    /// \param moves the moves played so far
+    void join(uint64_t gameId, const std::string &player1, const std::string &player2, const std::string &moves);
+
+    /// Adds a spectator of a game (if they are watching another one, they stop doing so).
+    /// The game has to be joined first (see #join); the game does not have to be locked anymore.
+    /// \param nick nick of the client
+    /// \param socket duplicate of the socket of the client (closed when they stop watching)
+    /// \param sendMtx lock the client uses when sending messages
+    /// \param gameId id of the game
+    /// \return false, if the game ended meanwhile (the socket is not used then). Otherwise, true.
+    bool watch(const std::string &nick, int socket, std::shared_ptr<std::mutex> sendMtx, uint64_t gameId);
+
+    /// Removes a spectator
+    /// \param nick nick of the client
+    /// \return true, if the client was watching a game. Otherwise, false.
+    bool unwatch(const std::string &nick);
+
+    /// Publishes a move (#WATCH_PLAY)
+    /// \param gameId id of the game
+    /// \param player nick of the player who played the move
+    /// \param y row of the move
+    /// \param x column of the move
+    void publishMove(uint64_t gameId, const std::string &player, int y, int x);
+
+    /// Publishes the result of a game (#WATCH_RESULT)
+    /// \param gameId id of the game
+    /// \param result nick of the winner (or "draw") followed by the winning tiles
+    void publishResult(uint64_t gameId, const std::string &result);
+
+    /// Publishes the end of a game (#WATCH_END) - the spectators stop watching it
+    /// \param gameId id of the game
+    void publishEnd(uint64_t gameId);
+
+    /// Returns the statistics of the spectators
+    /// \return statistics of the spectators
+    Stats_t getStats();
+};
+
+#endif
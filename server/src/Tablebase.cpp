@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Tablebase.h"
+
+const std::string Tablebase::DEFAULT_PATH = "tablebase/endgame.tb";
+
+Tablebase::Tablebase(std::string path) {
+    this->path = path;
+    loaded = false;
+    mapping = NULL;
+    mappingSize = 0;
+    header = NULL;
+    index = NULL;
+}
+
+Tablebase::~Tablebase() {
+    if (mapping != NULL)
+        munmap((void *)mapping, mappingSize);
+}
+
+Tablebase *Tablebase::getDefault() {
+    static Tablebase tablebase(DEFAULT_PATH);
+    return &tablebase;
+}
+
+void Tablebase::open() {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Header_t)) {
+        close(fd);
+        return;
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return;
+
+    const Header_t *h = (const Header_t *)addr;
+    if (h->magic != MAGIC || h->indexOffset + h->blockCount * sizeof(IndexEntry_t) > (uint64_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return;
+    }
+    madvise(addr, st.st_size, MADV_RANDOM);
+
+    mapping = (const uint8_t *)addr;
+    mappingSize = st.st_size;
+    header = h;
+    index = (const IndexEntry_t *)(mapping + h->indexOffset);
+    loaded = true;
+}
+
+bool Tablebase::isAvailable() {
+    std::call_once(openFlag, &Tablebase::open, this);
+    return loaded;
+}
+
+int Tablebase::getMaxEmpty() {
+    return isAvailable() ? (int)header->maxEmpty : -1;
+}
+
+uint64_t Tablebase::size() {
+    return isAvailable() ? header->count : 0;
+}
+
+bool Tablebase::covers(const Position &position) {
+    return isAvailable() && Position::WIDTH * Position::HEIGHT - position.nbMoves() <= (int)header->maxEmpty;
+}
+
+uint64_t Tablebase::blockEnd(uint64_t block) const {
+    return block + 1 < header->blockCount ? index[block + 1].offset : header->indexOffset;
+}
+
+bool Tablebase::readVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        uint8_t byte = *pos++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool Tablebase::probeKey(uint64_t key, int &score) {
+    if (!isAvailable() || header->blockCount == 0)
+        return false;
+
+    // the last block whose first key is not greater than the key
+    const IndexEntry_t *first = index;
+    const IndexEntry_t *last = index + header->blockCount;
+    const IndexEntry_t *it = std::upper_bound(first, last, key, [](uint64_t k, const IndexEntry_t &e) {
+        return k < e.firstKey;
+    });
+    if (it == first)
+        return false;
+    uint64_t block = (it - first) - 1;
+
+    const uint8_t *pos = mapping + index[block].offset;
+    const uint8_t *end = mapping + blockEnd(block);
+    uint64_t current = index[block].firstKey;
+    if (pos >= end)
+        return false;
+    int8_t value = (int8_t)*pos++;
+
+    while (current < key) {
+        uint64_t delta;
+        if (!readVarint(pos, end, delta) || pos >= end)
+            return false;
+        current += delta;
+        value = (int8_t)*pos++;
+    }
+    if (current != key)
+        return false;
+    score = value;
+    return true;
+}
+
+bool Tablebase::probe(const Position &position, int &score) {
+    if (!covers(position))
+        return false;
+    if (position.nbMoves() == Position::WIDTH * Position::HEIGHT) {
+        score = 0;
+        return true;
+    }
+    return probeKey(position.canonicalKey(), score);
+}
+
+bool Tablebase::bestMove(const Position &position, int &column, int &score) {
+    if (!covers(position))
+        return false;
+
+    bool found = false;
+    for (int col = 0; col < Position::WIDTH; col++) {
+        if (!position.canPlay(col))
+            continue;
+        int value;
+        if (position.isWinningMove(col))
+            value = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+        else {
+            Position child(position);
+            child.playCol(col);
+            if (!probe(child, value))
+                return false;
+            value = -value;
+        }
+        if (!found || value > score) {
+            found = true;
+            score = value;
+            column = col;
+        }
+    }
+    return found;
+}
+
+void Tablebase::collectKeys(std::vector<uint64_t> &keys) {
+    if (!isAvailable())
+        return;
+    for (uint64_t block = 0; block < header->blockCount; block++) {
+        const uint8_t *pos = mapping + index[block].offset;
+        const uint8_t *end = mapping + blockEnd(block);
+        uint64_t current = index[block].firstKey;
+        keys.push_back(current);
+        pos++;
+        uint64_t delta;
+        while (pos < end && readVarint(pos, end, delta)) {
+            current += delta;
+            keys.push_back(current);
+            pos++;
+        }
+    }
+}
+
+bool Tablebase::write(const std::string &path, int maxEmpty, const std::vector<std::pair<uint64_t,int8_t>> &entries) {
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (file.fail())
+        return false;
+
+    Header_t h;
+    h.magic = MAGIC;
+    h.maxEmpty = maxEmpty;
+    h.blockSize = BLOCK_SIZE;
+    h.count = entries.size();
+    h.blockCount = (entries.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    h.indexOffset = 0;
+    file.write((const char *)&h, sizeof(h));
+
+    std::vector<IndexEntry_t> blocks;
+    std::string buffer;
+    uint64_t offset = sizeof(h);
+    for (size_t i = 0; i < entries.size(); i += BLOCK_SIZE) {
+        blocks.push_back({entries[i].first, offset});
+        buffer.clear();
+        buffer.push_back((char)entries[i].second);
+        for (size_t j = i + 1; j < entries.size() && j < i + BLOCK_SIZE; j++) {
+            uint64_t delta = entries[j].first - entries[j - 1].first;
+            do {
+                uint8_t byte = delta & 0x7f;
+                delta >>= 7;
+                buffer.push_back((char)(byte | (delta ? 0x80 : 0)));
+            } while (delta);
+            buffer.push_back((char)entries[j].second);
+        }
+        file.write(buffer.data(), buffer.size());
+        offset += buffer.size();
+    }
+
+    // 8-byte alignment of the index
+    while (offset % sizeof(uint64_t)) {
+        file.put(0);
+        offset++;
+    }
+    h.indexOffset = offset;
+    file.write((const char *)blocks.data(), blocks.size() * sizeof(IndexEntry_t));
+    file.seekp(0);
+    file.write((const char *)&h, sizeof(h));
+    return !file.fail();
+}
@@ -0,0 +1,158 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <cstdint>
+
+#include "Position.h"
+
+/// \author silhavyj A17B0362P
+///
+/// Endgame tablebase - exact scores of positions with only a few
+/// empty tiles left, generated offline (see the tbgen tool).
+///
+/// The entries (canonical key + score) are sorted by the key and split
+/// into blocks of #BLOCK_SIZE entries. Within a block, the keys are
+/// delta-encoded as varints, which makes the file several times smaller
+/// than storing the keys as they are. An index of the first key of every
+/// block is stored at the end of the file, so a probe is a binary search
+/// over the index followed by decoding a single block.
+///
+/// The file is memory-mapped lazily on the first probe.
+class Tablebase {
+public:
+    /// default location of the tablebase
+    static const std::string DEFAULT_PATH;
+
+    /// magic number at the beginning of the file ("C4TB0001")
+    static const uint64_t MAGIC = 0x3130303042543443ULL;
+
+    /// number of entries per block
+    static const int BLOCK_SIZE = 256;
+
+    /// Header of the tablebase file
+    struct Header_t {
+        uint64_t magic;       ///< #MAGIC
+        uint32_t maxEmpty;    ///< positions with up to this number of empty tiles are stored
+        uint32_t blockSize;   ///< number of entries per block
+        uint64_t count;       ///< number of entries
+        uint64_t blockCount;  ///< number of blocks
+        uint64_t indexOffset; ///< offset of the index of the blocks
+    };
+
+    /// One entry of the index (one per block)
+    struct IndexEntry_t {
+        uint64_t firstKey; ///< key of the first entry of the block
+        uint64_t offset;   ///< offset of the block within the file
+    };
+
+private:
+    /// path to the tablebase file
+    std::string path;
+    /// flag used to map the file only once (on the first probe)
+    std::once_flag openFlag;
+    /// true, if the file has been successfully mapped
+    bool loaded;
+    /// the mapped file
+    const uint8_t *mapping;
+    /// size of the mapped file
+    size_t mappingSize;
+    /// header of the tablebase (part of the mapping)
+    const Header_t *header;
+    /// index of the blocks (part of the mapping)
+    const IndexEntry_t *index;
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// The file is not opened until the first probe.
+    ///
+    /// \param path to the tablebase file
+    explicit Tablebase(std::string path);
+
+    /// Destructor of the class - unmaps the file
+    ~Tablebase();
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Tablebase(Tablebase &) = delete;
+
+    /// Assignment operator of the the class.
+    /// It was deleted because there is no need to use it
+    /// within this project.
+    void operator=(Tablebase const &) = delete;
+
+    /// Returns the tablebase stored at #DEFAULT_PATH
+    /// \return the default tablebase
+    static Tablebase *getDefault();
+
+    /// Returns true if the tablebase file exists and is valid
+    /// \return true if the tablebase can be used. Otherwise, false.
+    bool isAvailable();
+
+    /// Returns the maximum number of empty tiles of the stored positions
+    /// \return the maximum number of empty tiles (-1, if the tablebase is not available)
+    int getMaxEmpty();
+
+    /// Returns the number of entries of the tablebase
+    /// \return number of entries (0, if the tablebase is not available)
+    uint64_t size();
+
+    /// Returns whether or not the tablebase can hold the position
+    /// given as a parameter (there are few enough empty tiles left)
+    /// \param position the position
+    /// \return true, if the position is within the range of the tablebase
+    bool covers(const Position &position);
+
+    /// Looks up the score of the position given as a parameter
+    /// \param position the position we want to know the score of
+    /// \param score the exact score of the position (output)
+    /// \return true, if the position is in the tablebase. Otherwise, false.
+    bool probe(const Position &position, int &score);
+
+    /// Finds the best column of the position given as a parameter
+    /// (used by bots to play perfect endgames)
+    /// \param position the position
+    /// \param column the best column (output)
+    /// \param score the score of the position (output)
+    /// \return true, if all the moves could be scored. Otherwise, false.
+    bool bestMove(const Position &position, int &column, int &score);
+
+    /// Looks up the score of the position given by its canonical key
+    /// \param key canonical key of the position
+    /// \param score the exact score of the position (output)
+    /// \return true, if the key is in the tablebase. Otherwise, false.
+    bool probeKey(uint64_t key, int &score);
+
+    /// Decodes all the keys stored in the tablebase (used by benchmarks)
+    /// \param keys the decoded keys (output)
+    void collectKeys(std::vector<uint64_t> &keys);
+
+    /// Writes a tablebase file
+    /// \param path to the file
+    /// \param maxEmpty positions with up to this number of empty tiles are stored
+    /// \param entries canonical keys with their scores sorted by the key
+    /// \return true, if the file was written successfully. Otherwise, false.
+    static bool write(const std::string &path, int maxEmpty, const std::vector<std::pair<uint64_t,int8_t>> &entries);
+
+private:
+    /// Maps the file into memory (called only once)
+    void open();
+
+    /// Returns the end of the block given as a parameter
+    /// \param block index of the block
+    /// \return offset of the first byte after the block
+    uint64_t blockEnd(uint64_t block) const;
+
+    /// Reads a varint from the mapping
+    /// \param pos position within the mapping (moved past the varint)
+    /// \param end end of the readable area
+    /// \param value the decoded value (output)
+    /// \return true, if the varint was decoded. Otherwise, false.
+    static bool readVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value);
+};
+
+#endif
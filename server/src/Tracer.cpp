@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "Tracer.h"
+
+std::atomic<int> Tracer::sampling(0);
+thread_local uint64_t Tracer::currentTrace = 0;
+thread_local Tracer::ThreadRing_t Tracer::threadRing;
+
+Tracer::ThreadRing_t::~ThreadRing_t() {
+    if (ring != NULL)
+        ring->abandoned.store(true, std::memory_order_release);
+}
+
+Tracer::Message::Message() {
+    traced = false;
+    int everyNth = sampling.load(std::memory_order_relaxed);
+    if (everyNth == 0)
+        return;
+    Tracer *tracer = getInstance();
+    if (tracer->seen.fetch_add(1, std::memory_order_relaxed) % everyNth != 0)
+        return;
+    currentTrace = ++tracer->messages;
+    traced = true;
+}
+
+Tracer::Message::~Message() {
+    if (traced)
+        currentTrace = 0;
+}
+
+void Tracer::Span::setDetail(const std::string &text) {
+    if (start == 0)
+        return;
+    size_t length = std::min(text.size(), (size_t)DETAIL_LENGTH - 1);
+    memcpy(detail, text.data(), length);
+    detail[length] = '\0';
+}
+
+/// Writes all the pending spans when the program exits
+static void stopTracer() {
+    Tracer::getInstance()->stop();
+}
+
+Tracer *Tracer::getInstance() {
+    // the initialization of a local static variable is thread-safe
+    static Tracer *instance = []() {
+        Tracer *tracer = new Tracer;
+        atexit(stopTracer);
+        return tracer;
+    }();
+    return instance;
+}
+
+Tracer::Tracer() {
+    seen = 0;
+    messages = 0;
+    dropped = 0;
+    written = 0;
+    bytes = 0;
+    fd = -1;
+    first = true;
+    origin = now();
+    running = false;
+}
+
+void Tracer::setSampling(int everyNth) {
+    sampling.store(std::max(everyNth, 0), std::memory_order_relaxed);
+}
+
+Tracer::Ring_t *Tracer::getRing() {
+    if (threadRing.ring == NULL) {
+        std::unique_ptr<Ring_t> ring(new Ring_t);
+        ring->head = 0;
+        ring->tail = 0;
+        ring->abandoned = false;
+        ring->thread = (uint32_t)syscall(SYS_gettid);
+        threadRing.ring = ring.get();
+        ringsMtx.lock();
+        rings.push_back(std::move(ring));
+        ringsMtx.unlock();
+    }
+    return threadRing.ring;
+}
+
+void Tracer::record(const Span &span) {
+    uint64_t end = now();
+    Ring_t *ring = getRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        dropped++;
+        return;
+    }
+    Event_t &event = ring->events[head % RING_CAPACITY];
+    event.name = span.name;
+    event.category = span.category;
+    event.start = span.start;
+    event.duration = end - span.start;
+    event.trace = currentTrace;
+    memcpy(event.detail, span.detail, DETAIL_LENGTH);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+bool Tracer::open() {
+    char buffer[80];
+    time_t current = time(NULL);
+    struct tm info;
+    localtime_r(&current, &info);
+    strftime(buffer, sizeof(buffer), "%d-%m-%Y_%H-%M-%S", &info);
+    mkdir(traceDirectory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    return open(traceDirectory + "/" + buffer + traceFileType);
+}
+
+bool Tracer::open(const std::string &path) {
+    ringsMtx.lock();
+    if (fd >= 0) {
+        ringsMtx.unlock();
+        return true;
+    }
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ringsMtx.unlock();
+        return false;
+    }
+    std::string header = "[\n";
+    if (write(fd, header.data(), header.size()) > 0)
+        bytes += header.size();
+    first = true;
+    ringsMtx.unlock();
+    running = true;
+    writer = std::thread(&Tracer::writerHandler, this);
+    return true;
+}
+
+void Tracer::writerHandler() {
+    while (running) {
+        // sleeps in short steps so the tracer stops quickly
+        for (int i = 0; i < FLUSH_INTERVAL_MS / 50 && running; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        flush();
+    }
+}
+
+void Tracer::flush() {
+    ringsMtx.lock();
+    writeSpans();
+    ringsMtx.unlock();
+}
+
+void Tracer::writeSpans() {
+    if (fd < 0)
+        return;
+    std::string text;
+    char buffer[256];
+    for (auto it = rings.begin(); it != rings.end();) {
+        Ring_t *ring = it->get();
+        // the flag is read first, so no span put in before the thread finished is missed
+        bool abandoned = ring->abandoned.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail < head; tail++) {
+            const Event_t &event = ring->events[tail % RING_CAPACITY];
+            // complete events ("X") with the time in microseconds
+            snprintf(buffer, sizeof(buffer),
+                     "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"trace\":%llu",
+                     first ? "" : ",\n", event.name, event.category, (double)(event.start - origin) / 1000.0,
+                     (double)event.duration / 1000.0, ring->thread, (unsigned long long)event.trace);
+            text += buffer;
+            if (event.detail[0] != '\0') {
+                text += ",\"detail\":\"";
+                for (const char *c = event.detail; *c != '\0'; c++) {
+                    if (*c == '"' || *c == '\\')
+                        text += '\\';
+                    if ((unsigned char)*c >= 0x20)
+                        text += *c;
+                }
+                text += "\"";
+            }
+            text += "}}";
+            first = false;
+            written++;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        if (abandoned)
+            it = rings.erase(it);
+        else ++it;
+    }
+    if (text.empty())
+        return;
+    size_t offset = 0;
+    while (offset < text.size()) {
+        ssize_t n = write(fd, text.data() + offset, text.size() - offset);
+        if (n <= 0)
+            break;
+        offset += n;
+    }
+    bytes += offset;
+}
+
+void Tracer::stop() {
+    if (running.exchange(false))
+        writer.join();
+    ringsMtx.lock();
+    if (fd >= 0) {
+        writeSpans();
+        std::string footer = "\n]\n";
+        if (write(fd, footer.data(), footer.size()) > 0)
+            bytes += footer.size();
+        close(fd);
+        fd = -1;
+    }
+    ringsMtx.unlock();
+}
+
+Tracer::Stats_t Tracer::getStats() {
+    Stats_t stats;
+    stats.messages = messages;
+    stats.dropped = dropped;
+    ringsMtx.lock();
+    stats.spans = written;
+    stats.bytes = bytes;
+    stats.rings = rings.size();
+    ringsMtx.unlock();
+    return stats;
+}
@@ -0,0 +1,267 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Sampled tracing of the messages the server receives. This class is written as a singleton.
+///
+/// Every n-th message (see #setSampling) is traced from being read off the socket
+/// to its reply being sent off. A #Message marks the message on the thread handling
+/// it and every #Span created by the same thread while it exists is recorded (e.g.
+/// parsing the message, waiting for a lock, playing the move, sending the reply).
+/// When the thread is not tracing a message, a span costs one check of a thread-local
+/// variable.
+///
+/// The spans go to a ring of the thread that has recorded them (a span is dropped when
+/// the ring is full, tracing never makes a thread wait). A writer thread takes them
+/// out every #FLUSH_INTERVAL_MS and appends them to a file in the Chrome trace-event
+/// format (JSON array of complete events). The array is not closed until the tracer
+/// stops, which chrome://tracing and Perfetto accept, so the file can be opened while
+/// the server is still running or after it has been killed.
+class Tracer {
+public:
+    /// number of spans a ring of one thread can hold
+    static const int RING_CAPACITY = 1024;
+    /// number of milliseconds between two flushes of the rings
+    static const int FLUSH_INTERVAL_MS = 500;
+    /// maximum length of the detail of a span (e.g. the type of a message)
+    static const int DETAIL_LENGTH = 24;
+
+    /// Statistics of the tracer
+    struct Stats_t {
+        uint64_t messages; ///< number of messages traced
+        uint64_t spans;    ///< number of spans written into the file
+        uint64_t dropped;  ///< number of spans dropped (the ring of the thread was full)
+        uint64_t rings;    ///< number of rings (threads that have traced a message)
+        uint64_t bytes;    ///< number of bytes written into the file
+    };
+
+    /// Marks the message being handled by the calling thread as traced (if it is sampled)
+    class Message {
+    private:
+        /// indication of whether or not the message is traced
+        bool traced;
+
+    public:
+        /// Constructor of the class - decides whether or not the message is traced
+        Message();
+
+        /// Destructor of the class - the thread stops tracing
+        ~Message();
+
+        /// Copy constructor of the class. It was deleted
+        /// because there is no need to use it within this project.
+        Message(const Message&) = delete;
+
+        /// Assignment operator of the the class. It was deleted
+        /// because there is no need to use it within this project.
+        void operator=(const Message&) = delete;
+    };
+
+    /// Part of the handling of a traced message (recorded when it is destroyed)
+    class Span {
+    private:
+        /// name of the span (a string literal)
+        const char *name;
+        /// category of the span (a string literal)
+        const char *category;
+        /// when the span started (ns of the monotonic clock), 0 if it is not recorded
+        uint64_t start;
+        /// the detail of the span (may be empty)
+        char detail[DETAIL_LENGTH];
+
+    public:
+        /// Constructor of the class - starts the span (if the thread is tracing a message)
+        /// \param name name of the span (a string literal)
+        /// \param category category of the span (a string literal)
+        Span(const char *name, const char *category) : name(name), category(category), start(0) {
+            if (isTracing()) {
+                detail[0] = '\0';
+                start = now();
+            }
+        }
+
+        /// Destructor of the class - records the span
+        ~Span() {
+            end();
+        }
+
+        /// Ends the span before it is destroyed (it is recorded right away)
+        void end() {
+            if (start != 0)
+                getInstance()->record(*this);
+            start = 0;
+        }
+
+        /// Sets the detail of the span (shown with it in the trace)
+        /// \param text the detail (it is cut off after #DETAIL_LENGTH - 1 characters)
+        void setDetail(const std::string &text);
+
+        /// Copy constructor of the class. It was deleted
+        /// because there is no need to use it within this project.
+        Span(const Span&) = delete;
+
+        /// Assignment operator of the the class. It was deleted
+        /// because there is no need to use it within this project.
+        void operator=(const Span&) = delete;
+
+        friend class Tracer;
+    };
+
+    /// Locks a mutex and records the time spent waiting for it as a span
+    /// \param mtx the mutex
+    /// \param name name of the span (e.g. "wait gameRoomsMtx")
+    template<class Mutex>
+    static void lock(Mutex &mtx, const char *name) {
+        if (!isTracing()) {
+            mtx.lock();
+            return;
+        }
+        Span wait(name, "lock");
+        mtx.lock();
+    }
+
+    /// Returns whether or not the calling thread is tracing a message
+    /// \return true, if the spans of the thread are recorded. Otherwise, false.
+    static bool isTracing() {
+        return currentTrace != 0;
+    }
+
+private:
+    /// One recorded span
+    struct Event_t {
+        const char *name;          ///< name of the span
+        const char *category;      ///< category of the span
+        uint64_t start;            ///< when the span started (ns of the monotonic clock)
+        uint64_t duration;         ///< how long the span took (ns)
+        uint64_t trace;            ///< id of the traced message
+        char detail[DETAIL_LENGTH]; ///< the detail of the span (may be empty)
+    };
+
+    /// Ring of the spans of one thread
+    struct Ring_t {
+        Event_t events[RING_CAPACITY]; ///< the spans
+        std::atomic<uint64_t> head;    ///< number of spans put in (written by the thread)
+        std::atomic<uint64_t> tail;    ///< number of spans taken out (written by the writer)
+        std::atomic<bool> abandoned;   ///< the thread has finished (the ring is freed once it is empty)
+        uint32_t thread;               ///< id of the thread (as given by the kernel)
+    };
+
+    /// Ring of the calling thread (it is abandoned when the thread finishes)
+    struct ThreadRing_t {
+        Ring_t *ring = NULL; ///< the ring (NULL until the thread traces for the first time)
+
+        /// Destructor of the structure - abandons the ring
+        ~ThreadRing_t();
+    };
+
+    /// directory where the trace files are stored (the same one as the logs)
+    const std::string traceDirectory = "log";
+    /// type of a trace file
+    const std::string traceFileType = ".trace.json";
+
+    /// every n-th message is traced (0 - tracing is off)
+    static std::atomic<int> sampling;
+    /// id of the message traced by the calling thread (0 - none)
+    static thread_local uint64_t currentTrace;
+    /// ring of the calling thread
+    static thread_local ThreadRing_t threadRing;
+
+    /// number of messages seen (the sampling counter)
+    std::atomic<uint64_t> seen;
+    /// number of messages traced (the id of the last one)
+    std::atomic<uint64_t> messages;
+    /// number of spans dropped
+    std::atomic<uint64_t> dropped;
+    /// number of spans written
+    uint64_t written;
+    /// number of bytes written
+    uint64_t bytes;
+
+    /// lock used when accessing the rings and the file
+    std::mutex ringsMtx;
+    /// rings of all the threads that have traced a message
+    std::vector<std::unique_ptr<Ring_t>> rings;
+    /// file descriptor of the trace file (-1 if it is not open)
+    int fd;
+    /// indication of whether or not the first event has been written (no comma before it)
+    bool first;
+    /// time of the monotonic clock (ns) the timestamps in the file are relative to
+    uint64_t origin;
+    /// indication of whether or not the writer thread should keep running
+    std::atomic<bool> running;
+    /// the thread writing the spans into the file
+    std::thread writer;
+
+private:
+    /// Constructor of the class - creates an instance of it
+    Tracer();
+
+    /// Returns the current time of the monotonic clock
+    /// \return ns of the monotonic clock (never 0)
+    static uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() | 1;
+    }
+
+    /// Returns the ring of the calling thread (it is created if it does not exist yet)
+    /// \return the ring
+    Ring_t *getRing();
+
+    /// Puts a finished span into the ring of the calling thread
+    /// \param span the span
+    void record(const Span &span);
+
+    /// Writes the spans of all the rings into the file
+    /// (the caller holds #ringsMtx)
+    void writeSpans();
+
+    /// The body of the writer thread
+    void writerHandler();
+
+public:
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    Tracer(const Tracer&) = delete;
+
+    /// Assignment operator of the the class. It was deleted
+    /// because there is no need to use it within this project.
+    void operator=(const Tracer&) = delete;
+
+    /// Returns the instance of the class
+    /// \return instance of the class
+    static Tracer *getInstance();
+
+    /// Sets how many messages are traced
+    /// \param everyNth every n-th message is traced (0 - tracing is off)
+    static void setSampling(int everyNth);
+
+    /// Opens a new trace file in the 'log' directory and starts the writer thread
+    /// \return true, if the file has been opened. Otherwise, false.
+    bool open();
+
+    /// Opens a trace file and starts the writer thread
+    /// \param path path to the file
+    /// \return true, if the file has been opened. Otherwise, false.
+    bool open(const std::string &path);
+
+    /// Writes all the recorded spans into the file right away
+    void flush();
+
+    /// Stops the writer thread and closes the file (the JSON array is closed)
+    void stop();
+
+    /// Returns the statistics of the tracer
+    /// \return the statistics
+    Stats_t getStats();
+};
+
+#endif
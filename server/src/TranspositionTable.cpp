@@ -0,0 +1,27 @@
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(uint64_t size) {
+    this->size = size;
+    entries.reset(new std::atomic<uint64_t>[size]);
+    reset();
+}
+
+void TranspositionTable::reset() {
+    for (uint64_t i = 0; i < size; i++)
+        entries[i].store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::put(uint64_t key, uint8_t value) {
+    entries[key % size].store((key << 8) | value, std::memory_order_relaxed);
+}
+
+uint8_t TranspositionTable::get(uint64_t key) const {
+    uint64_t entry = entries[key % size].load(std::memory_order_relaxed);
+    if ((entry >> 8) != key)
+        return 0;
+    return (uint8_t)(entry & 0xff);
+}
+
+uint64_t TranspositionTable::getSize() const {
+    return size;
+}
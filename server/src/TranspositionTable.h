@@ -0,0 +1,62 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Lock-free hash table storing the values of already
+/// explored positions (see class #Solver).
+///
+/// The table is meant to be shared by all the threads searching
+/// the same position (lazy SMP). Each entry is a single 64-bit word
+/// holding the key of the position (upper 56 bits) and its value
+/// (lower 8 bits), so it is always read and written atomically
+/// and no locks are needed. When two positions collide, the newer
+/// one simply replaces the older one.
+class TranspositionTable {
+public:
+    /// default number of entries (a prime number, ~8M entries = 64MB)
+    static const uint64_t DEFAULT_SIZE = 8388617;
+
+private:
+    /// number of entries of the table
+    uint64_t size;
+    /// the entries themselves
+    std::unique_ptr<std::atomic<uint64_t>[]> entries;
+
+public:
+    /// Constructor of the class - creates an instance of it
+    /// \param size number of entries (preferably a prime number)
+    explicit TranspositionTable(uint64_t size = DEFAULT_SIZE);
+
+    /// Copy constructor of the class. It was deleted
+    /// because there is no need to use it within this project.
+    TranspositionTable(TranspositionTable &) = delete;
+
+    /// Assignment operator of the the class.
+    /// It was deleted because there is no need to use it
+    /// within this project.
+    void operator=(TranspositionTable const &) = delete;
+
+    /// Empties the table
+    void reset();
+
+    /// Stores a value of the position given as a parameter
+    /// \param key of the position (must fit into 56 bits)
+    /// \param value of the position (1-255, 0 is reserved for empty entries)
+    void put(uint64_t key, uint8_t value);
+
+    /// Returns the value of the position given as a parameter
+    /// \param key of the position
+    /// \return value of the position or 0, if the position is not in the table
+    uint8_t get(uint64_t key) const;
+
+    /// Returns the number of entries of the table
+    /// \return number of entries
+    uint64_t getSize() const;
+};
+
+#endif
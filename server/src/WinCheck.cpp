@@ -0,0 +1,118 @@
+#include "WinCheck.h"
+#include "Position.h"
+
+// the vectorized kernels are only built for x86 (elsewhere everything is scalar)
+#if defined(__x86_64__) || defined(__i386__)
+#define WINCHECK_X86
+#include <immintrin.h>
+#endif
+
+// shifts of the four directions of alignment (see Position::hasAlignment)
+static const int HORIZONTAL = Position::HEIGHT + 1;
+static const int DIAGONAL_1 = Position::HEIGHT;
+static const int DIAGONAL_2 = Position::HEIGHT + 2;
+static const int VERTICAL = 1;
+
+// one bitboard at a time
+static void hasAlignmentScalar(const uint64_t *bitboards, uint8_t *results, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        results[i] = Position::hasAlignment(bitboards[i]);
+}
+
+#ifdef WINCHECK_X86
+// two bitboards per iteration (the rest is checked one at a time)
+__attribute__((target("sse4.1")))
+static void hasAlignmentSse4(const uint64_t *bitboards, uint8_t *results, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i p = _mm_loadu_si128((const __m128i *)(bitboards + i));
+        __m128i m = _mm_and_si128(p, _mm_srli_epi64(p, HORIZONTAL));
+        __m128i r = _mm_and_si128(m, _mm_srli_epi64(m, 2 * HORIZONTAL));
+        m = _mm_and_si128(p, _mm_srli_epi64(p, DIAGONAL_1));
+        r = _mm_or_si128(r, _mm_and_si128(m, _mm_srli_epi64(m, 2 * DIAGONAL_1)));
+        m = _mm_and_si128(p, _mm_srli_epi64(p, DIAGONAL_2));
+        r = _mm_or_si128(r, _mm_and_si128(m, _mm_srli_epi64(m, 2 * DIAGONAL_2)));
+        m = _mm_and_si128(p, _mm_srli_epi64(p, VERTICAL));
+        r = _mm_or_si128(r, _mm_and_si128(m, _mm_srli_epi64(m, 2 * VERTICAL)));
+
+        // a bit of the mask is set for every bitboard without an alignment
+        int none = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(r, zero)));
+        results[i] = !(none & 1);
+        results[i + 1] = !(none & 2);
+    }
+    hasAlignmentScalar(bitboards + i, results + i, count - i);
+}
+
+// four bitboards per iteration (the rest is left to SSE4.1)
+__attribute__((target("avx2")))
+static void hasAlignmentAvx2(const uint64_t *bitboards, uint8_t *results, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i p = _mm256_loadu_si256((const __m256i *)(bitboards + i));
+        __m256i m = _mm256_and_si256(p, _mm256_srli_epi64(p, HORIZONTAL));
+        __m256i r = _mm256_and_si256(m, _mm256_srli_epi64(m, 2 * HORIZONTAL));
+        m = _mm256_and_si256(p, _mm256_srli_epi64(p, DIAGONAL_1));
+        r = _mm256_or_si256(r, _mm256_and_si256(m, _mm256_srli_epi64(m, 2 * DIAGONAL_1)));
+        m = _mm256_and_si256(p, _mm256_srli_epi64(p, DIAGONAL_2));
+        r = _mm256_or_si256(r, _mm256_and_si256(m, _mm256_srli_epi64(m, 2 * DIAGONAL_2)));
+        m = _mm256_and_si256(p, _mm256_srli_epi64(p, VERTICAL));
+        r = _mm256_or_si256(r, _mm256_and_si256(m, _mm256_srli_epi64(m, 2 * VERTICAL)));
+
+        // a bit of the mask is set for every bitboard without an alignment
+        int none = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(r, zero)));
+        results[i] = !(none & 1);
+        results[i + 1] = !(none & 2);
+        results[i + 2] = !(none & 4);
+        results[i + 3] = !(none & 8);
+    }
+    hasAlignmentSse4(bitboards + i, results + i, count - i);
+}
+#endif
+
+void WinCheck::hasAlignment(const uint64_t *bitboards, uint8_t *results, size_t count) {
+    static const Isa isa = getIsa();
+    hasAlignment(isa, bitboards, results, count);
+}
+
+void WinCheck::hasAlignment(Isa isa, const uint64_t *bitboards, uint8_t *results, size_t count) {
+#ifdef WINCHECK_X86
+    switch (isa) {
+        case AVX2: hasAlignmentAvx2(bitboards, results, count); break;
+        case SSE4: hasAlignmentSse4(bitboards, results, count); break;
+        default:   hasAlignmentScalar(bitboards, results, count); break;
+    }
+#else
+    (void)isa;
+    hasAlignmentScalar(bitboards, results, count);
+#endif
+}
+
+WinCheck::Isa WinCheck::getIsa() {
+    if (isSupported(AVX2))
+        return AVX2;
+    if (isSupported(SSE4))
+        return SSE4;
+    return SCALAR;
+}
+
+bool WinCheck::isSupported(Isa isa) {
+#ifdef WINCHECK_X86
+    switch (isa) {
+        case AVX2: return __builtin_cpu_supports("avx2");
+        case SSE4: return __builtin_cpu_supports("sse4.1");
+        default:   return true;
+    }
+#else
+    return isa == SCALAR;
+#endif
+}
+
+const char *WinCheck::getName(Isa isa) {
+    switch (isa) {
+        case AVX2: return "avx2";
+        case SSE4: return "sse4.1";
+        default:   return "scalar";
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef WIN_CHECK_H
+#define WIN_CHECK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// \author silhavyj A17B0362P
+///
+/// Checks many bitboards (see #Position) for four aligned tiles at once.
+///
+/// Each bitboard holds the tiles of one player of one game, so a single
+/// call checks the last move of many games (self-play, all the live games
+/// of the server, ...). The check is vectorized with AVX2 (4 bitboards
+/// per instruction) or SSE4.1 (2 bitboards per instruction). The
+/// implementation is chosen at runtime according to the CPU; if neither
+/// of them is supported (or the target is not x86), the scalar
+/// #Position::hasAlignment is used.
+class WinCheck {
+public:
+    /// Implementation of the check
+    enum Isa {
+        SCALAR, ///< one bitboard at a time
+        SSE4,   ///< two bitboards per instruction
+        AVX2    ///< four bitboards per instruction
+    };
+
+public:
+    /// Checks the bitboards given as a parameter for four aligned tiles
+    /// using the best implementation the CPU supports (see #getIsa)
+    /// \param bitboards the bitboards (one player each)
+    /// \param results results[i] is set to 1 if bitboards[i] has four aligned tiles, 0 otherwise
+    /// \param count number of bitboards
+    static void hasAlignment(const uint64_t *bitboards, uint8_t *results, size_t count);
+
+    /// Checks the bitboards given as a parameter for four aligned tiles
+    /// using the given implementation (it must be supported - see #isSupported)
+    /// \param isa the implementation
+    /// \param bitboards the bitboards (one player each)
+    /// \param results results[i] is set to 1 if bitboards[i] has four aligned tiles, 0 otherwise
+    /// \param count number of bitboards
+    static void hasAlignment(Isa isa, const uint64_t *bitboards, uint8_t *results, size_t count);
+
+    /// Returns the best implementation the CPU supports
+    /// \return the implementation used by #hasAlignment
+    static Isa getIsa();
+
+    /// Checks if the CPU supports the given implementation
+    /// \param isa the implementation
+    /// \return true, if it can be used. Otherwise, false.
+    static bool isSupported(Isa isa);
+
+    /// Returns the name of the given implementation
+    /// \param isa the implementation
+    /// \return name of the implementation
+    static const char *getName(Isa isa);
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "Server.h"
 #include "InputShell.h"
+#include "Admin.h"
 
 /// The entry point of the application
 ///
@@ -14,8 +15,33 @@ int main(int argc, char *argv[]) {
         inputShell.printHelp();
         exit(EXIT_FAILURE);
     }
+    Logger::setMinLevel(inputShell.getLogLevel());
+    Logger::getInstance()->setSinks(inputShell.getLogSinks());
+    if (inputShell.getMetricsPort() != 0) {
+        if (Metrics::getInstance()->listen(inputShell.getMetricsPort()))
+            LOG_BOOTING("the metrics are served on 127.0.0.1:" + std::to_string(inputShell.getMetricsPort()));
+        else LOG_WARNING("the metrics cannot be served on port " + std::to_string(inputShell.getMetricsPort()));
+    }
+    if (inputShell.getTraceSampling() != 0) {
+        if (Tracer::getInstance()->open()) {
+            Tracer::setSampling(inputShell.getTraceSampling());
+            LOG_BOOTING("every " + std::to_string(inputShell.getTraceSampling()) + ". message is traced");
+        }
+        else LOG_WARNING("the trace file cannot be opened - nothing is traced");
+    }
+    if (inputShell.isLockProfiling()) {
+        ProfiledMutex::setEnabled(true);
+        ProfiledMutex::startReporting("log/locks.txt");
+        LOG_BOOTING("the locks are profiled (log/locks.txt)");
+    }
     // run the server
     Server server(inputShell.getPort(), inputShell.getMaxNumberOfClients());
+    Admin admin(server);
+    if (!inputShell.getAdminSocket().empty()) {
+        if (admin.open(inputShell.getAdminSocket()))
+            LOG_BOOTING("the admin socket is listening on " + inputShell.getAdminSocket());
+        else LOG_WARNING("the admin socket cannot be opened (" + inputShell.getAdminSocket() + ")");
+    }
     server.startServer();
     return 0;
 }
\ No newline at end of file
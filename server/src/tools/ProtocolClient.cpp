@@ -0,0 +1,154 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "ProtocolClient.h"
+
+const std::string ProtocolClient::PROTOCOL_ID = "silhavyj";
+
+ProtocolClient::ProtocolClient() {
+    fd = -1;
+    epoch = 0;
+    taken = 0;
+    writing = false;
+}
+
+uint64_t ProtocolClient::getEventData(uint32_t index) const {
+    return ((uint64_t)epoch << 32) | index;
+}
+
+uint32_t ProtocolClient::getIndex(const struct epoll_event &event) {
+    return (uint32_t)(event.data.u64 & 0xffffffff);
+}
+
+bool ProtocolClient::isCurrent(const struct epoll_event &event) const {
+    return (uint32_t)(event.data.u64 >> 32) == epoch && fd >= 0;
+}
+
+bool ProtocolClient::isConnected() const {
+    return fd >= 0;
+}
+
+uint32_t ProtocolClient::getEpoch() const {
+    return epoch;
+}
+
+bool ProtocolClient::isWriting() const {
+    return writing;
+}
+
+bool ProtocolClient::connect(int epollFd, uint32_t index, const struct sockaddr *address, socklen_t length) {
+    epoch++;
+    fd = socket(address->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(fd, address, length) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    // the socket becomes writable once the connection has been established
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = getEventData(index);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    writing = true;
+    return true;
+}
+
+bool ProtocolClient::connected(int epollFd, uint32_t index) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+        return false;
+    watch(epollFd, index, false);
+    return true;
+}
+
+void ProtocolClient::disconnect() {
+    if (fd < 0)
+        return;
+    close(fd);
+    fd = -1;
+    epoch++;
+    in.clear();
+    taken = 0;
+    out.clear();
+    writing = false;
+}
+
+void ProtocolClient::watch(int epollFd, uint32_t index, bool writing) {
+    struct epoll_event event;
+    event.events = writing ? EPOLLIN | EPOLLOUT : (uint32_t)EPOLLIN;
+    event.data.u64 = getEventData(index);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    this->writing = writing;
+}
+
+void ProtocolClient::queue(const std::string &msg) {
+    char header[HEADER_LENGTH + 1];
+    snprintf(header, sizeof(header), "%s%04d", PROTOCOL_ID.c_str(), (int)msg.size());
+    out += header;
+    out += msg;
+    out += '\n';
+}
+
+bool ProtocolClient::flush(int epollFd, uint32_t index) {
+    while (!out.empty()) {
+        ssize_t n = send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            out.erase(0, n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!writing)
+                watch(epollFd, index, true);
+            return true;
+        }
+        return false;
+    }
+    if (writing)
+        watch(epollFd, index, false);
+    return true;
+}
+
+bool ProtocolClient::receive(uint64_t &received) {
+    char buffer[RECEIVE_BUFFER_SIZE];
+    while (1) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            received += n;
+            in.append(buffer, n);
+            if ((size_t)n == sizeof(buffer))
+                continue;
+            return true;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+        return false;
+    }
+}
+
+ProtocolClient::Frame ProtocolClient::next(std::string &msg) {
+    // every message is "silhavyj" + 4 digits of its length + the message + "\r\n"
+    if (in.size() - taken >= HEADER_LENGTH) {
+        if (in.compare(taken, PROTOCOL_ID.size(), PROTOCOL_ID) != 0)
+            return INVALID;
+        size_t length = (size_t)atoi(in.substr(taken + PROTOCOL_ID.size(), 4).c_str());
+        if (in.size() - taken >= HEADER_LENGTH + length + 2) {
+            msg = in.substr(taken + HEADER_LENGTH, length);
+            taken += HEADER_LENGTH + length + 2;
+            return MESSAGE;
+        }
+    }
+    // the messages taken are removed at once when the rest is waited for
+    in.erase(0, taken);
+    taken = 0;
+    return INCOMPLETE;
+}
@@ -0,0 +1,120 @@
+#ifndef PROTOCOL_CLIENT_H
+#define PROTOCOL_CLIENT_H
+
+#include <string>
+#include <cstdint>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+/// \author silhavyj A17B0362P
+///
+/// Non-blocking connection of a simulated client to the server, shared by the tools
+/// driving many clients through one epoll instance (loadgen, movebench).
+///
+/// It frames the outgoing messages the way the server expects them, keeps what the
+/// socket does not take at once until it is writable again, and splits the received
+/// data into messages. The events of epoll carry the index of the client (given by
+/// the tool) and the number of its connection (epoch), so the events left over from
+/// a closed connection are told apart.
+class ProtocolClient {
+public:
+    /// id of the protocol every message starts with
+    static const std::string PROTOCOL_ID;
+    /// length of the header of a message (the protocol id and 4 digits of the length)
+    static const size_t HEADER_LENGTH = 12;
+    /// size of the buffer the data are received into
+    static const size_t RECEIVE_BUFFER_SIZE = 16384;
+
+    /// Result of taking the next message out of the received data
+    enum Frame {
+        MESSAGE,    ///< a whole message has been taken
+        INCOMPLETE, ///< the rest of the message has not been received yet
+        INVALID     ///< the data do not start with the protocol id
+    };
+
+private:
+    int fd;             ///< the socket (-1 - not connected)
+    uint32_t epoch;     ///< incremented with every connection (older events are ignored)
+    std::string in;     ///< received data that do not make a whole message yet
+    size_t taken;       ///< bytes of #in already taken as messages (see #next)
+    std::string out;    ///< data waiting for the socket
+    bool writing;       ///< true, if epoll waits for the socket to be writable
+
+    /// Returns the data of the events of epoll concerning the connection
+    /// \param index index of the client
+    /// \return the epoch and the index
+    uint64_t getEventData(uint32_t index) const;
+
+public:
+    /// Constructor of the class - creates a client that is not connected
+    ProtocolClient();
+
+    /// Returns the index of the client an event of epoll concerns
+    /// \param event the event
+    /// \return index of the client
+    static uint32_t getIndex(const struct epoll_event &event);
+
+    /// Returns whether or not an event of epoll concerns the current connection
+    /// \param event the event
+    /// \return false, if the connection has been closed (and possibly connected again) since
+    bool isCurrent(const struct epoll_event &event) const;
+
+    /// Returns whether or not the client is connected (or connecting)
+    /// \return true, if the client has a socket
+    bool isConnected() const;
+
+    /// Returns the number of the connection
+    /// \return the epoch
+    uint32_t getEpoch() const;
+
+    /// Returns whether or not epoll waits for the socket to be writable
+    /// \return true, if some data are waiting for the socket
+    bool isWriting() const;
+
+    /// Starts connecting to the server (the socket is added to epoll)
+    /// \param epollFd the epoll instance
+    /// \param index index of the client
+    /// \param address address of the server
+    /// \param length length of the address
+    /// \return false, if the connection could not be started
+    bool connect(int epollFd, uint32_t index, const struct sockaddr *address, socklen_t length);
+
+    /// Finishes connecting once the socket has been reported by epoll
+    /// \param epollFd the epoll instance
+    /// \param index index of the client
+    /// \return false, if the connection could not be established
+    bool connected(int epollFd, uint32_t index);
+
+    /// Closes the connection and throws away the data it has not sent or handled
+    void disconnect();
+
+    /// Tells epoll whether or not to wait for the socket to be writable
+    /// \param epollFd the epoll instance
+    /// \param index index of the client
+    /// \param writing true - wait for the socket to be writable as well as readable
+    void watch(int epollFd, uint32_t index, bool writing);
+
+    /// Frames a message and appends it to the data waiting for the socket (see #flush)
+    /// \param msg the message
+    void queue(const std::string &msg);
+
+    /// Sends off as much of the waiting data as the socket takes
+    /// \param epollFd the epoll instance
+    /// \param index index of the client
+    /// \return false, if the connection has broken (the caller closes it)
+    bool flush(int epollFd, uint32_t index);
+
+    /// Reads everything the socket has received
+    /// \param received number of bytes received (it is increased)
+    /// \return false, if the connection has been closed or it has broken (the caller closes it)
+    bool receive(uint64_t &received);
+
+    /// Takes the next whole message out of the received data
+    /// \param msg the message (without the header and the trailing "\r\n")
+    /// \return #MESSAGE, #INCOMPLETE or #INVALID (the caller closes the connection)
+    Frame next(std::string &msg);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " -s socket command [arguments]\n";
+    std::cout << "Sends a command to the admin control socket of a running server\n";
+    std::cout << "(./server -a socket) and prints out the reply, e.g.\n";
+    std::cout << "  " << name << " -s admin.sock games\n";
+    std::cout << "  " << name << " -s admin.sock set SECONDS_PING_REPLY 10\n";
+    std::cout << "-s path of the admin socket\n";
+    std::cout << "The command help lists all the commands.\n";
+}
+
+/// The entry point of the admin client
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    std::string path;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:h")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    struct sockaddr_un address;
+    if (path.empty() || path.size() >= sizeof(address.sun_path) || optind == argc) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string command;
+    for (int i = optind; i < argc; i++)
+        command += std::string(i == optind ? "" : " ") + argv[i];
+    command += "\n";
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        std::cerr << "cannot connect to " << path << ": " << strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+    if (send(fd, command.data(), command.size(), 0) != (ssize_t)command.size()) {
+        std::cerr << "cannot send the command: " << strerror(errno) << "\n";
+        return EXIT_FAILURE;
+    }
+    // the server closes the connection once it has replied to every command
+    shutdown(fd, SHUT_WR);
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        std::cout.write(buffer, n);
+    close(fd);
+    return 0;
+}
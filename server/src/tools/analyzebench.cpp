@@ -0,0 +1,173 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Analyzer.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-g games] [-n openings] [-f moves] [-c clients] [-t threads] [-m ms] [-r seed] [-b book] [-e tablebase]\n";
+    std::cout << "Replays random games, analyzing every position from the given move on the way\n";
+    std::cout << "players would ask for hints (one request at a time per client), and reports the hit rate\n";
+    std::cout << "of the cache of positions and the latency of the analysis.\n";
+    std::cout << "-g number of games (default: 2000)\n";
+    std::cout << "-n number of distinct openings the games start with (default: 50)\n";
+    std::cout << "-f number of moves of the openings, the positions are analyzed from then on (default: 16)\n";
+    std::cout << "-c number of clients asking at a time (default: 16)\n";
+    std::cout << "-t number of worker threads of the analysis (default: 2)\n";
+    std::cout << "-m time budget of one request in milliseconds (default: 500)\n";
+    std::cout << "-r seed of the random number generator (default: 1)\n";
+    std::cout << "-b opening book (default: none)\n";
+    std::cout << "-e endgame tablebase (default: none)\n";
+}
+
+/// Plays random moves from the position given as a parameter
+/// \param position the position
+/// \param moves number of moves
+/// \param rng random number generator
+/// \param moveList the moves played (appended)
+/// \return false, if the game would be over (a winning move or a full board). Otherwise, true.
+bool playRandom(Position &position, int moves, std::mt19937_64 &rng, std::string &moveList) {
+    for (int i = 0; i < moves; i++) {
+        std::vector<int> columns;
+        for (int col = 0; col < Position::WIDTH; col++)
+            if (position.canPlay(col) && !position.isWinningMove(col))
+                columns.push_back(col);
+        if (columns.empty())
+            return false;
+        int col = columns[rng() % columns.size()];
+        position.playCol(col);
+        moveList += (char)('0' + col);
+    }
+    return true;
+}
+
+/// The entry point of the analysis benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int games = 2000;
+    int openingCount = 50;
+    int openingMoves = 16;
+    int clients = 16;
+    int threads = Analyzer::DEFAULT_THREADS;
+    int budgetMs = Analyzer::DEFAULT_BUDGET_MS;
+    uint64_t seed = 1;
+    std::string bookPath, tablebasePath;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:n:f:c:t:m:r:b:e:h")) != -1) {
+        switch (opt) {
+            case 'g': games = atoi(optarg); break;
+            case 'n': openingCount = atoi(optarg); break;
+            case 'f': openingMoves = atoi(optarg); break;
+            case 'c': clients = atoi(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'm': budgetMs = atoi(optarg); break;
+            case 'r': seed = strtoull(optarg, NULL, 10); break;
+            case 'b': bookPath = optarg; break;
+            case 'e': tablebasePath = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (games < 1 || openingCount < 1 || openingMoves < 0 || openingMoves >= Position::WIDTH * Position::HEIGHT ||
+        clients < 1 || threads < 1 || budgetMs < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the openings the games start with (so the same positions keep coming back)
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> openings;
+    while ((int)openings.size() < openingCount) {
+        Position position;
+        std::string moves;
+        if (playRandom(position, openingMoves, rng, moves))
+            openings.push_back(moves);
+    }
+    std::vector<std::string> gameMoves(games);
+    for (int i = 0; i < games; i++) {
+        Position position;
+        gameMoves[i] = openings[rng() % openings.size()];
+        position.play(gameMoves[i]);
+        playRandom(position, Position::WIDTH * Position::HEIGHT, rng, gameMoves[i]);
+    }
+
+    OpeningBook book(bookPath);
+    Tablebase tablebase(tablebasePath);
+    Analyzer analyzer;
+    analyzer.open(threads, bookPath.empty() ? NULL : &book, tablebasePath.empty() ? NULL : &tablebase);
+
+    // every client replays the games one by one, asking for the analysis after every move
+    std::atomic<int> nextGame(0);
+    std::atomic<uint64_t> rejected(0);
+    std::mutex samplesMtx;
+    std::vector<double> samples;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clientThreads;
+    for (int c = 0; c < clients; c++) {
+        clientThreads.emplace_back([&, c]() {
+            std::mutex doneMtx;
+            std::condition_variable doneCv;
+            std::vector<double> latencies;
+            int game;
+            while ((game = nextGame++) < games) {
+                const std::string &moves = gameMoves[game];
+                Position position;
+                position.play(moves.substr(0, openingMoves));
+                for (size_t i = openingMoves; i < moves.size(); i++) {
+                    bool done = false;
+                    bool queued = analyzer.submit("client" + std::to_string(c), position, std::chrono::milliseconds(budgetMs),
+                                                  [&](const Analyzer::Result_t &result) {
+                        std::lock_guard<std::mutex> lock(doneMtx);
+                        latencies.push_back((double)result.micros);
+                        done = true;
+                        doneCv.notify_one();
+                    });
+                    if (queued) {
+                        std::unique_lock<std::mutex> lock(doneMtx);
+                        doneCv.wait(lock, [&]() { return done; });
+                    }
+                    else rejected++;
+                    position.playCol(moves[i] - '0');
+                }
+            }
+            std::lock_guard<std::mutex> lock(samplesMtx);
+            samples.insert(samples.end(), latencies.begin(), latencies.end());
+        });
+    }
+    for (std::thread &thread : clientThreads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Analyzer::Stats_t stats = analyzer.getStats();
+    analyzer.close();
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples.empty() ? 0 : samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "requests=" << stats.requests << " rejected=" << rejected << " out of time=" << stats.incomplete;
+    std::cout << " (" << std::setprecision(2) << seconds << "s, " << std::setprecision(0) << stats.requests / seconds << " requests/s)\n";
+    std::cout << "cache: hits=" << stats.cacheHits << " misses=" << stats.cacheMisses << " hit rate=" << std::setprecision(1);
+    std::cout << stats.hitRate * 100 << "% positions=" << stats.cached << "\n" << std::setprecision(0);
+    std::cout << "latency: p50=" << percentile(0.50) << "us p99=" << percentile(0.99) << "us max=" << (samples.empty() ? 0 : samples.back());
+    std::cout << "us (histogram: p50<=" << stats.p50Micros << "us p99<=" << stats.p99Micros << "us)\n";
+    return 0;
+}
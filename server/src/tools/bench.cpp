@@ -0,0 +1,397 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "../Server.h"
+#include "../Client.h"
+#include "../Connect4.h"
+#include "../Logger.h"
+
+/// One microbenchmark
+struct Benchmark_t {
+    std::string name;                      ///< name of the benchmark (group/case)
+    std::string description;               ///< what is measured
+    std::function<uint64_t(uint64_t)> run; ///< runs the benchmark n times, returns the number of operations done
+};
+
+/// Result of one microbenchmark
+struct Result_t {
+    std::string name;  ///< name of the benchmark
+    double nsPerOp;    ///< median time of an operation over the repetitions
+    double minNsPerOp; ///< the fastest repetition
+    double spread;     ///< (slowest - fastest) / median of the repetitions
+    uint64_t ops;      ///< operations done in every repetition
+};
+
+/// Makes the compiler believe the value is used, so the
+/// code computing it is not optimized away
+template<typename T>
+inline void keep(const T &value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-f filter] [-r repetitions] [-t ms] [-o output] [-b baseline] [-T percent] [-l]\n";
+    std::cout << "Runs the microbenchmarks of the hot paths of the server (parsing the messages,\n";
+    std::cout << "framing the replies, the game engine, the logger) and prints out the time of one\n";
+    std::cout << "operation of every benchmark (the median of the repetitions).\n";
+    std::cout << "-f runs only the benchmarks whose names contain the filter\n";
+    std::cout << "-r number of repetitions of every benchmark (default: 7)\n";
+    std::cout << "-t milliseconds one repetition takes (default: 100)\n";
+    std::cout << "-o writes the results into a JSON file (- for the standard output, the report goes\n";
+    std::cout << "   to the standard error then)\n";
+    std::cout << "-b compares the results against a JSON file written by -o before; the program\n";
+    std::cout << "   fails if a benchmark got slower by more than the threshold (both the median\n";
+    std::cout << "   and the fastest repetition)\n";
+    std::cout << "-T threshold of -b in percent (default: 5)\n";
+    std::cout << "-l lists the benchmarks\n";
+    std::cout << "e.g. " << name << " -o before.json; (change the code); make; " << name << " -b before.json\n";
+}
+
+/// Returns the number of nanoseconds a benchmark takes
+/// \param benchmark the benchmark
+/// \param n number of times it is run
+/// \param ops the number of operations done is stored here
+/// \return number of nanoseconds
+double measure(const Benchmark_t &benchmark, uint64_t n, uint64_t &ops) {
+    auto start = std::chrono::steady_clock::now();
+    ops = benchmark.run(n);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Runs a benchmark - finds out how many times it has to be run so a repetition
+/// takes the given time (which warms it up as well) and then runs the repetitions
+/// \param benchmark the benchmark
+/// \param repetitions number of repetitions
+/// \param ms milliseconds one repetition takes
+/// \return the result
+Result_t runBenchmark(const Benchmark_t &benchmark, int repetitions, int ms) {
+    uint64_t n = 1;
+    uint64_t ops;
+    double ns;
+    while ((ns = measure(benchmark, n, ops)) < ms * 1e6 / 10 && n < (1ull << 40))
+        n *= 10;
+    n = std::max((uint64_t)1, (uint64_t)(n * ms * 1e6 / std::max(ns, 1.0)));
+
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; i++) {
+        ns = measure(benchmark, n, ops);
+        samples.push_back(ns / std::max(ops, (uint64_t)1));
+    }
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+    return {benchmark.name, median, samples.front(), (samples.back() - samples.front()) / median, ops};
+}
+
+/// Returns the results as JSON
+/// \param results the results
+/// \param repetitions number of repetitions of every benchmark
+/// \param ms milliseconds one repetition took
+/// \return the JSON document
+std::string toJson(const std::vector<Result_t> &results, int repetitions, int ms) {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(2);
+    json << "{\n  \"time\": " << time(0) << ",\n  \"repetitions\": " << repetitions << ",\n  \"ms\": " << ms << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        json << "    {\"name\": \"" << results[i].name << "\", \"ns_per_op\": " << results[i].nsPerOp;
+        json << ", \"min_ns_per_op\": " << results[i].minNsPerOp << ", \"spread\": " << std::setprecision(4) << results[i].spread;
+        json << ", \"ops\": " << results[i].ops << std::setprecision(2) << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+/// Reads the results written by #toJson (only the names and the times of an operation)
+/// \param path path of the file
+/// \param baseline the results by the names of the benchmarks are stored here
+/// \return true, if the file could be read. Otherwise, false.
+bool readBaseline(const std::string &path, std::map<std::string, Result_t> &baseline) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    static const std::string NAME = "\"name\": \"";
+    static const std::string NS_PER_OP = "\"ns_per_op\": ";
+    static const std::string MIN_NS_PER_OP = "\"min_ns_per_op\": ";
+    size_t pos = 0;
+    while ((pos = json.find(NAME, pos)) != std::string::npos) {
+        pos += NAME.size();
+        size_t end = json.find('"', pos);
+        size_t value = json.find(NS_PER_OP, pos);
+        size_t min = json.find(MIN_NS_PER_OP, pos);
+        if (end == std::string::npos || value == std::string::npos || min == std::string::npos)
+            return false;
+        Result_t &result = baseline[json.substr(pos, end - pos)];
+        result.nsPerOp = atof(json.c_str() + value + NS_PER_OP.size());
+        result.minNsPerOp = atof(json.c_str() + min + MIN_NS_PER_OP.size());
+        pos = end;
+    }
+    return !baseline.empty();
+}
+
+/// Returns random games (the columns played until either of the players wins or the board is full)
+/// \param count number of games
+/// \return the games
+std::vector<std::vector<int>> randomGames(int count) {
+    std::mt19937 generator(2021);
+    std::vector<std::vector<int>> games;
+    while ((int)games.size() < count) {
+        Connect4 game("p1", "p2", NULL);
+        int heights[Connect4::COLUMNS] = {0};
+        std::vector<int> moves;
+        Connect4::GameState state = Connect4::CONTINUE;
+        while (state == Connect4::CONTINUE && moves.size() < (size_t)(Connect4::ROWS * Connect4::COLUMNS)) {
+            int x = generator() % Connect4::COLUMNS;
+            if (heights[x] == Connect4::ROWS)
+                continue;
+            heights[x]++;
+            state = game.play(moves.size() % 2 == 0 ? "p1" : "p2", x);
+            moves.push_back(x);
+        }
+        games.push_back(moves);
+    }
+    return games;
+}
+
+/// Returns the benchmarks
+/// \param server server used for parsing the messages (it is not booted up)
+/// \return the benchmarks
+std::vector<Benchmark_t> getBenchmarks(Server &server) {
+    std::vector<Benchmark_t> benchmarks;
+
+    // parsing the messages
+    static const std::vector<std::string> messages = {
+        "PING", "GAME_PLAY 3", "NICK silhavyj", "RQ silhavyj", "RPL silhavyj YES",
+        "/HISTORY silhavyj 120", "GAME_PLAY 9", "HELLO world"
+    };
+    static std::vector<std::vector<std::string>> tokens;
+    for (const std::string &msg : messages)
+        tokens.push_back(split(msg, Server::MSG_SEPARATOR));
+
+    for (const std::string &msg : {std::string("PING"), std::string("GAME_PLAY 3"), std::string("RPL silhavyj YES")}) {
+        benchmarks.push_back({"split/" + msg.substr(0, msg.find(' ')), "split() of '" + msg + "'", [msg](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                keep(split(msg, Server::MSG_SEPARATOR));
+            return n;
+        }});
+    }
+    benchmarks.push_back({"message/type", "Server::getTypeOfMessage with the validation of a mix of messages", [&server](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(server.getTypeOfMessage(tokens[i % tokens.size()]));
+        return n;
+    }});
+    benchmarks.push_back({"message/parse", "split() and Server::getTypeOfMessage of a mix of messages", [&server](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(server.getTypeOfMessage(split(messages[i % messages.size()], Server::MSG_SEPARATOR)));
+        return n;
+    }});
+
+    // framing the messages sent off to the clients
+    benchmarks.push_back({"client/send", "Client::sendMessage (framing and sending) into a socketpair", [](uint64_t n) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+            return (uint64_t)0;
+        std::thread reader([fd = fds[1]]() {
+            char buffer[65536];
+            while (read(fd, buffer, sizeof(buffer)) > 0)
+                ;
+            close(fd);
+        });
+        {
+            Client client(fds[0], "127.0.0.1", "silhavyj");
+            for (uint64_t i = 0; i < n; i++)
+                client.sendMessage("GAME_PLAY silhavyj 5 3");
+        }
+        reader.join();
+        return n;
+    }});
+
+    // the game engine
+    static const std::vector<std::vector<int>> games = randomGames(64);
+    benchmarks.push_back({"connect4/play", "Connect4::play of random games (one move)", [](uint64_t n) {
+        uint64_t moves = 0;
+        for (uint64_t i = 0; moves < n; i++) {
+            const std::vector<int> &game = games[i % games.size()];
+            Connect4 connect4("p1", "p2", NULL);
+            for (size_t j = 0; j < game.size(); j++)
+                keep(connect4.play(j % 2 == 0 ? "p1" : "p2", game[j]));
+            moves += game.size();
+        }
+        return moves;
+    }});
+
+    // a finished game with the most moves
+    static const std::vector<int> &longest = *std::max_element(games.begin(), games.end(),
+        [](const std::vector<int> &a, const std::vector<int> &b) { return a.size() < b.size(); });
+    static Connect4 finished("p1", "p2", NULL);
+    for (size_t j = 0; j < longest.size(); j++)
+        finished.play(j % 2 == 0 ? "p1" : "p2", longest[j]);
+
+    benchmarks.push_back({"connect4/winning_tiles", "Connect4::getWinningTiles of a finished game (" + std::to_string(longest.size()) + " moves)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(finished.getWinningTiles());
+        return n;
+    }});
+    benchmarks.push_back({"connect4/recovery_full", "Connect4::getCurrentStateOfGameForRecovery of all the moves", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(finished.getCurrentStateOfGameForRecovery());
+        return n;
+    }});
+    benchmarks.push_back({"connect4/recovery_last", "Connect4::getCurrentStateOfGameForRecovery of the last move", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(finished.getCurrentStateOfGameForRecovery(longest.size() - 1));
+        return n;
+    }});
+
+    // the logger
+    benchmarks.push_back({"logger/log", "Logger::log of a countdown message", [](uint64_t n) {
+        static const std::string client = "127.0.0.1:50000";
+        Logger::setEnabled(Logger::COUNTDOWN, true);
+        for (uint64_t i = 0; i < n; i++)
+            Logger::getInstance()->log(__LINE__, Logger::COUNTDOWN, "waiting for client " + client + " to enter their nick (" + std::to_string(i % 30) + "s)");
+        Logger::setEnabled(Logger::COUNTDOWN, false);
+        return n;
+    }});
+    benchmarks.push_back({"logger/log_f", "LOG_COUNTDOWN_F of a countdown message", [](uint64_t n) {
+        static const std::string client = "127.0.0.1:50000";
+        Logger::setEnabled(Logger::COUNTDOWN, true);
+        for (uint64_t i = 0; i < n; i++)
+            LOG_COUNTDOWN_F("waiting for client {} to enter their nick ({}s)", client, i % 30);
+        Logger::setEnabled(Logger::COUNTDOWN, false);
+        return n;
+    }});
+    benchmarks.push_back({"logger/disabled", "LOG_COUNTDOWN of a disabled type", [](uint64_t n) {
+        static const std::string client = "127.0.0.1:50000";
+        for (uint64_t i = 0; i < n; i++)
+            LOG_COUNTDOWN("waiting for client " + client + " to enter their nick (" + std::to_string(i % 30) + "s)");
+        return n;
+    }});
+    return benchmarks;
+}
+
+/// The entry point of the microbenchmarks
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    std::string filter;
+    int repetitions = 7;
+    int ms = 100;
+    std::string output;
+    std::string baselinePath;
+    double threshold = 5;
+    bool list = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:r:t:o:b:T:lh")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            case 'r': repetitions = atoi(optarg); break;
+            case 't': ms = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            case 'b': baselinePath = optarg; break;
+            case 'T': threshold = atof(optarg); break;
+            case 'l': list = true; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (repetitions < 1 || ms < 1 || threshold < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::map<std::string, Result_t> baseline;
+    if (!baselinePath.empty() && !readBaseline(baselinePath, baseline)) {
+        std::cerr << "cannot read the baseline " << baselinePath << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // the terminal output of the logger is discarded
+    std::cout.flush();
+    int terminal = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (terminal < 0 || null < 0 || dup2(null, STDOUT_FILENO) < 0) {
+        std::cerr << "the terminal output cannot be redirected\n";
+        return EXIT_FAILURE;
+    }
+    close(null);
+
+    // only the logger benchmarks log anything
+    Logger::setMinLevel(LOG_LEVEL_ERROR + 1);
+    Server server(0, 1);
+    std::vector<Benchmark_t> benchmarks = getBenchmarks(server);
+    std::vector<Result_t> results;
+    std::string listing;
+    for (const Benchmark_t &benchmark : benchmarks) {
+        if (benchmark.name.find(filter) == std::string::npos)
+            continue;
+        if (list)
+            listing += benchmark.name + std::string(std::max(1, 26 - (int)benchmark.name.size()), ' ') + benchmark.description + "\n";
+        else results.push_back(runBenchmark(benchmark, repetitions, ms));
+    }
+    Logger::getInstance()->stop();
+    dup2(terminal, STDOUT_FILENO);
+    close(terminal);
+
+    if (list) {
+        std::cout << listing;
+        return 0;
+    }
+    std::string json = toJson(results, repetitions, ms);
+    if (output == "-")
+        std::cout << json;
+    else if (!output.empty()) {
+        std::ofstream file(output);
+        if (!(file << json)) {
+            std::cerr << "cannot write the results into " << output << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+    // the JSON takes the standard output, so the report (and the comparison) goes to the standard error
+    std::ostream &report = output == "-" ? std::cerr : std::cout;
+    int regressions = 0;
+    report << std::fixed << std::setprecision(1);
+    for (const Result_t &result : results) {
+        report << std::left << std::setw(26) << result.name << std::right << std::setw(10) << result.nsPerOp << " ns/op";
+        report << " (min " << result.minNsPerOp << ", spread " << result.spread * 100 << "%)";
+        auto before = baseline.find(result.name);
+        if (before != baseline.end() && before->second.nsPerOp > 0 && before->second.minNsPerOp > 0) {
+            double change = (result.nsPerOp - before->second.nsPerOp) / before->second.nsPerOp * 100;
+            double minChange = (result.minNsPerOp - before->second.minNsPerOp) / before->second.minNsPerOp * 100;
+            report << "  was " << before->second.nsPerOp << " ns/op, " << std::showpos << change << "%" << std::noshowpos;
+            // both the median and the fastest repetition have to move,
+            // so a single noisy repetition is not taken for a change
+            if (change > threshold && minChange > threshold) {
+                report << " SLOWER";
+                regressions++;
+            } else if (change < -threshold && minChange < -threshold)
+                report << " faster";
+        } else if (!baseline.empty())
+            report << "  (not in the baseline)";
+        report << "\n";
+    }
+    if (!baseline.empty())
+        report << regressions << " of " << results.size() << " benchmarks got slower by more than " << threshold << "%\n";
+    return regressions == 0 ? 0 : EXIT_FAILURE;
+}
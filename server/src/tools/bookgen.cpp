@@ -0,0 +1,150 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../Position.h"
+#include "../Solver.h"
+#include "../TranspositionTable.h"
+#include "../OpeningBook.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-d moves] [-t threads] [-o file]\n";
+    std::cout << "Generates an opening book with the exact scores of all the positions\n";
+    std::cout << "that can be reached within the given number of moves.\n";
+    std::cout << "-d maximum number of moves of the stored positions (default: 8)\n";
+    std::cout << "-t number of threads (default: all cores)\n";
+    std::cout << "-o output file (default: " << OpeningBook::DEFAULT_PATH << ")\n";
+}
+
+/// The entry point of the book generator
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int maxMoves = 8;
+    int threads = (int)std::thread::hardware_concurrency();
+    std::string output = OpeningBook::DEFAULT_PATH;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:t:o:h")) != -1) {
+        switch (opt) {
+            case 'd': maxMoves = atoi(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (maxMoves < 0 || maxMoves >= Position::WIDTH * Position::HEIGHT || threads < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // enumerate all unique (mirror-reduced) positions level by level
+    std::vector<std::vector<Position>> levels(maxMoves + 1);
+    levels[0].push_back(Position());
+    for (int ply = 0; ply < maxMoves; ply++) {
+        std::unordered_map<uint64_t, Position> next;
+        for (auto &position : levels[ply])
+            for (int col = 0; col < Position::WIDTH; col++) {
+                if (!position.canPlay(col) || position.isWinningMove(col))
+                    continue;
+                Position child(position);
+                child.playCol(col);
+                next.emplace(child.canonicalKey(), child);
+            }
+        for (auto &it : next)
+            levels[ply + 1].push_back(it.second);
+        std::cerr << "moves=" << ply + 1 << " positions=" << levels[ply + 1].size() << "\n";
+    }
+
+    // score the positions from the deepest level up - only the deepest
+    // level is searched, the others are derived from their children
+    TranspositionTable table;
+    std::vector<uint64_t> entries;
+    std::unordered_map<uint64_t, int> childScores;
+    uint64_t searchedNodes = 0;
+
+    for (int ply = maxMoves; ply >= 0; ply--) {
+        std::vector<Position> &level = levels[ply];
+        std::vector<uint64_t> encoded(level.size());
+        std::vector<int> scores(level.size());
+        std::atomic<size_t> nextIndex(0);
+        std::atomic<uint64_t> nodes(0);
+
+        auto worker = [&](int variant) {
+            Solver solver(&table, variant);
+            size_t i;
+            while ((i = nextIndex.fetch_add(1)) < level.size()) {
+                const Position &position = level[i];
+                std::vector<int> columns(Position::WIDTH, Solver::INVALID_MOVE);
+
+                if (ply == maxMoves)
+                    columns = solver.analyze(position);
+                else {
+                    for (int col = 0; col < Position::WIDTH; col++) {
+                        if (!position.canPlay(col))
+                            continue;
+                        if (position.isWinningMove(col)) {
+                            columns[col] = (Position::WIDTH * Position::HEIGHT + 1 - position.nbMoves()) / 2;
+                            continue;
+                        }
+                        Position child(position);
+                        child.playCol(col);
+                        columns[col] = -childScores.at(child.canonicalKey());
+                    }
+                }
+                int best = 0;
+                for (int col = 1; col < Position::WIDTH; col++)
+                    if (columns[col] > columns[best])
+                        best = col;
+                scores[i] = columns[best];
+                encoded[i] = OpeningBook::encode(position, columns[best], best);
+            }
+            nodes += solver.getNodeCount();
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++)
+            workers.emplace_back(worker, t);
+        worker(0);
+        for (auto &w : workers)
+            w.join();
+
+        childScores.clear();
+        for (size_t i = 0; i < level.size(); i++)
+            childScores[level[i].canonicalKey()] = scores[i];
+        entries.insert(entries.end(), encoded.begin(), encoded.end());
+        searchedNodes += nodes;
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "scored moves=" << ply << " positions=" << level.size() << " elapsed=" << std::fixed << std::setprecision(1) << elapsed << "s\n";
+    }
+
+    size_t slash = output.find_last_of('/');
+    if (slash != std::string::npos)
+        mkdir(output.substr(0, slash).c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    if (!OpeningBook::write(output, maxMoves, entries)) {
+        std::cerr << "writing the book into '" << output << "' failed\n";
+        return EXIT_FAILURE;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "book=" << output << " moves<=" << maxMoves << " entries=" << entries.size();
+    std::cout << " bytes=" << sizeof(OpeningBook::Header_t) + entries.size() * sizeof(uint64_t);
+    std::cout << " nodes=" << searchedNodes << " time=" << std::fixed << std::setprecision(1) << elapsed << "s\n";
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Journal.h"
+
+/// A record whose commit latency is measured
+struct Sample_t {
+    uint64_t lsn;    ///< sequence number of the record
+    double appended; ///< time it was appended [s since the start]
+};
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-r rate] [-d seconds] [-t threads] [-i ms] [-m records] [-s MB] [-o dir]\n";
+    std::cout << "Appends GAME_MOVE records into a journal at a fixed rate and measures\n";
+    std::cout << "the append (hot path) and commit (append -> durable) latencies.\n";
+    std::cout << "-r target number of records per second (default: 100000)\n";
+    std::cout << "-d duration of the benchmark in seconds (default: 5)\n";
+    std::cout << "-t number of threads appending records (default: 4)\n";
+    std::cout << "-i period of the group commit in milliseconds (default: " << Journal::DEFAULT_FLUSH_INTERVAL_MS << ")\n";
+    std::cout << "-m number of pending records that triggers a group commit (default: " << Journal::DEFAULT_GROUP_COMMIT_RECORDS << ")\n";
+    std::cout << "-s size of a segment in MB (default: " << Journal::DEFAULT_SEGMENT_SIZE / (1024 * 1024) << ")\n";
+    std::cout << "-o directory of the journal (default: journalbench)\n";
+}
+
+/// Returns a percentile of the sorted samples given as a parameter
+/// \param samples sorted samples
+/// \param p the percentile (0 - 1)
+/// \return value of the percentile
+double percentile(const std::vector<double> &samples, double p) {
+    if (samples.empty())
+        return 0;
+    return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+}
+
+/// The entry point of the journal benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    // every n-th record of a thread is sampled for the commit latency
+    const int SAMPLE_EVERY = 64;
+    // records are appended in bursts of this size (then the thread sleeps to keep the rate)
+    const int BURST = 16;
+
+    double rate = 100000;
+    double duration = 5;
+    int threads = 4;
+    int flushIntervalMs = Journal::DEFAULT_FLUSH_INTERVAL_MS;
+    int groupCommitRecords = Journal::DEFAULT_GROUP_COMMIT_RECORDS;
+    uint64_t segmentSize = Journal::DEFAULT_SEGMENT_SIZE;
+    std::string dir = "journalbench";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:d:t:i:m:s:o:h")) != -1) {
+        switch (opt) {
+            case 'r': rate = atof(optarg); break;
+            case 'd': duration = atof(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'i': flushIntervalMs = atoi(optarg); break;
+            case 'm': groupCommitRecords = atoi(optarg); break;
+            case 's': segmentSize = strtoull(optarg, NULL, 10) * 1024 * 1024; break;
+            case 'o': dir = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (rate <= 0 || duration <= 0 || threads < 1 || flushIntervalMs < 1 || groupCommitRecords < 1 || segmentSize == 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Journal journal(dir, segmentSize, flushIntervalMs, groupCommitRecords);
+    if (!journal.open()) {
+        std::cerr << "the journal in '" << dir << "' cannot be opened\n";
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto now = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // the durable sequence number over time (used for the commit latency)
+    std::atomic<bool> producing(true);
+    std::vector<std::pair<double,uint64_t>> durable;
+    std::thread monitor([&]() {
+        uint64_t last = 0;
+        while (1) {
+            // read the flag first, so the final durable sequence number is always seen
+            bool stop = !producing;
+            uint64_t lsn = journal.getDurableLsn();
+            if (lsn != last) {
+                durable.push_back({now(), lsn});
+                last = lsn;
+            }
+            if (stop)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    std::vector<std::vector<double>> appendLatencies(threads);
+    std::vector<std::vector<Sample_t>> samples(threads);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++) {
+        producers.emplace_back([&, t]() {
+            double interval = threads * BURST / rate;
+            uint64_t gameId = journal.nextGameId();
+            std::string column = "0";
+            for (uint64_t burst = 0; ; burst++) {
+                double due = burst * interval;
+                if (due >= duration)
+                    break;
+                double wait = due - now();
+                if (wait > 0)
+                    std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+                for (int i = 0; i < BURST; i++) {
+                    column[0] = (char)('0' + i % 7);
+                    double before = now();
+                    uint64_t lsn = journal.append(Journal::GAME_MOVE, gameId, column);
+                    double after = now();
+                    appendLatencies[t].push_back((after - before) * 1e9);
+                    if (appendLatencies[t].size() % SAMPLE_EVERY == 0)
+                        samples[t].push_back({lsn, after});
+                }
+            }
+        });
+    }
+    for (auto &p : producers)
+        p.join();
+    double produced = now();
+    uint64_t lastLsn = journal.append(Journal::GAME_RESULT, 0, "0");
+    journal.waitDurable(lastLsn);
+    double finished = now();
+    producing = false;
+    monitor.join();
+    Journal::Stats_t stats = journal.getStats();
+    journal.close();
+
+    std::vector<double> appendNs;
+    for (auto &a : appendLatencies)
+        appendNs.insert(appendNs.end(), a.begin(), a.end());
+    std::sort(appendNs.begin(), appendNs.end());
+
+    // commit latency = the first time the durable sequence number covered the record
+    std::vector<double> commitMs;
+    for (auto &s : samples)
+        for (auto &sample : s) {
+            auto it = std::lower_bound(durable.begin(), durable.end(), sample.lsn, [](const std::pair<double,uint64_t> &d, uint64_t lsn) {
+                return d.second < lsn;
+            });
+            if (it != durable.end())
+                commitMs.push_back(std::max(0.0, it->first - sample.appended) * 1e3);
+        }
+    std::sort(commitMs.begin(), commitMs.end());
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "journal=" << dir << " threads=" << threads << " target rate=" << rate << " records/s";
+    std::cout << " group commit=" << flushIntervalMs << "ms/" << groupCommitRecords << " records\n";
+    std::cout << "records=" << stats.records << " bytes=" << stats.bytes << " segments=" << stats.segments;
+    std::cout << " syncs=" << stats.syncs << " avg batch=" << (stats.syncs ? (double)stats.records / stats.syncs : 0.0);
+    std::cout << " max batch=" << stats.maxBatch << "\n";
+    std::cout << "achieved rate=" << appendNs.size() / produced << " records/s";
+    std::cout << " durable rate=" << stats.records / finished << " records/s";
+    std::cout << " (" << stats.bytes / finished / (1024 * 1024) << " MB/s)\n";
+    std::cout << "append latency: p50=" << percentile(appendNs, 0.5) << "ns p99=" << percentile(appendNs, 0.99);
+    std::cout << "ns p99.9=" << percentile(appendNs, 0.999) << "ns max=" << (appendNs.empty() ? 0 : appendNs.back()) << "ns\n";
+    std::cout << "commit latency: p50=" << percentile(commitMs, 0.5) << "ms p99=" << percentile(commitMs, 0.99);
+    std::cout << "ms max=" << (commitMs.empty() ? 0 : commitMs.back()) << "ms\n";
+    return 0;
+}
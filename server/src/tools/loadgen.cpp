@@ -0,0 +1,743 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "../Metrics.h"
+#include "../Position.h"
+#include "ProtocolClient.h"
+
+/// the most events a worker takes from epoll at once
+static const int MAX_EVENTS = 256;
+/// the longest time a worker waits for an event (ms)
+static const int POLL_MS = 100;
+/// delay before a session that was disconnected unexpectedly connects again (ms)
+static const int RETRY_DELAY_MS = 1000;
+/// delay before a session that dropped its connection on purpose connects back (ms)
+static const int REJOIN_DELAY_MS = 100;
+
+/// Requests whose replies are timed (the latency is measured per type)
+enum Request {
+    NICK,      ///< NICK <nick> -> OK
+    PING,      ///< PING -> OK
+    RQ,        ///< RQ <nick> -> OK
+    RPL,       ///< RPL <nick> YES -> GAME_START, RPL <nick> NO -> OK
+    GAME_PLAY, ///< GAME_PLAY x -> GAME_PLAY <nick> y x
+    RECOVERY,  ///< connecting back to a game -> GAME_RECOVERY
+    NUMBER_OF_REQUESTS
+};
+
+/// names of the requests in the report
+static const char *REQUEST_NAMES[NUMBER_OF_REQUESTS] = {"NICK", "PING", "RQ", "RPL", "GAME_PLAY", "RECOVERY"};
+
+/// What a session is doing at the moment (as far as it knows)
+enum Phase {
+    OFFLINE,    ///< not connected (waiting to connect)
+    CONNECTING, ///< the connection is being established
+    LOGGING_IN, ///< NICK has been sent, waiting to find out if the server puts the client into a game
+    REJOINING,  ///< NICK has been sent after a drop, waiting to find out if the game is still on
+    LOBBY,      ///< in the lobby
+    SENT_RQ,    ///< waiting for a reply to a game request
+    RECV_RQ,    ///< a game request has been received
+    GAME,       ///< playing a game
+    DROPPED     ///< silent on purpose until the server gives up on the connection
+};
+
+/// Kinds of timers of a session
+enum TimerKind {
+    CONNECT_TIMER, ///< connect (again)
+    PING_TIMER,    ///< send PING
+    ACT_TIMER      ///< send a game request, reply to one or play a move
+};
+
+/// A request waiting for its reply
+struct Pending_t {
+    Request type;       ///< type of the request
+    std::string expect; ///< the reply starts with this
+    uint64_t sentNs;    ///< when the request was sent
+};
+
+/// One simulated client (the connection itself is handled by ProtocolClient,
+/// the timers of an older connection are ignored the same way as its events)
+struct Session_t : public ProtocolClient {
+    std::string nick;                ///< nick of the client
+    int partner;                     ///< index of the session it plays against (-1 - none)
+    bool challenger;                 ///< true - it sends the game requests (player 1), false - it replies to them
+    Phase phase;                     ///< what the session is doing
+    bool rejoin;                     ///< true, if the session connects back to a game
+    uint64_t connectNs;              ///< when the last connection started
+    std::deque<Pending_t> pending;   ///< requests waiting for their replies
+    int heights[Position::WIDTH];    ///< number of discs in every column of the game
+    int moves;                       ///< number of moves played in the game
+    bool movePending;                ///< true, if a move has been sent and not confirmed yet
+    bool awaitingRecovery;           ///< true, if the moves of the game are on their way (GAME_RECOVERY)
+    std::string requester;           ///< nick of the client that sent the game request
+};
+
+/// A timer of a session
+struct Timer_t {
+    uint64_t when;   ///< when the timer goes off (ns)
+    int session;     ///< index of the session
+    TimerKind kind;  ///< what happens
+    uint32_t epoch;  ///< connection the timer belongs to
+
+    bool operator>(const Timer_t &other) const {
+        return when > other.when;
+    }
+};
+
+/// Parameters of the load
+struct Options_t {
+    std::string host;     ///< address of the server
+    std::string port;     ///< port of the server
+    int sessions;         ///< number of simulated clients
+    int threads;          ///< number of worker threads
+    int seconds;          ///< how long the load runs
+    int connectRate;      ///< connections per second (ramp-up)
+    int pingSeconds;      ///< interval between two PINGs of a client
+    int thinkMs;          ///< the longest time a client thinks before it acts
+    double dropChance;    ///< probability that a client drops their connection instead of playing a move
+    double rejectChance;  ///< probability that a game request is rejected
+    std::string prefix;   ///< prefix of the nicks
+    unsigned seed;        ///< seed of the random generators
+};
+
+/// Statistics shared by all the workers
+struct Stats_t {
+    std::atomic<uint64_t> sent[NUMBER_OF_REQUESTS];      ///< requests sent by type
+    std::atomic<uint64_t> replied[NUMBER_OF_REQUESTS];   ///< replies received by type
+    Metrics::Histogram latency[NUMBER_OF_REQUESTS];      ///< latency of the replies by type
+    std::atomic<uint64_t> messagesSent;                  ///< all the messages sent
+    std::atomic<uint64_t> messagesReceived;              ///< all the messages received
+    std::atomic<uint64_t> bytesReceived;                 ///< bytes received
+    std::atomic<int64_t> online;                         ///< sessions connected at the moment
+    std::atomic<uint64_t> connectFailures;               ///< connections that could not be established
+    std::atomic<uint64_t> disconnects;                   ///< connections closed by the server unexpectedly
+    std::atomic<uint64_t> kicked;                        ///< INVALID_PROTOCOL received
+    std::atomic<uint64_t> drops;                         ///< connections dropped on purpose
+    std::atomic<uint64_t> rejoined;                      ///< games the dropped clients got back into
+    std::atomic<uint64_t> restored;                      ///< clients put into a game restored after a restart of the server
+    std::atomic<uint64_t> gamesStarted;                  ///< games started
+    std::atomic<uint64_t> gamesFinished;                 ///< games finished (GAME_RESULT)
+    std::atomic<uint64_t> gamesCanceled;                 ///< games canceled before they were finished
+    std::atomic<uint64_t> rejected;                      ///< game requests rejected
+    std::atomic<uint64_t> moveErrors;                    ///< moves the server did not accept
+};
+
+/// parameters of the load
+Options_t options;
+/// the statistics
+Stats_t stats;
+/// address of the server
+struct sockaddr_storage serverAddress;
+/// length of the address of the server
+socklen_t serverAddressLength;
+/// indication of whether or not the workers should keep running
+std::atomic<bool> running(true);
+
+/// Returns the current time of the monotonic clock
+/// \return ns of the monotonic clock
+uint64_t now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// One thread driving a share of the sessions through its own epoll instance
+struct Worker_t {
+    int epollFd;                      ///< the epoll instance
+    std::vector<Session_t> sessions;  ///< the sessions (a session and its partner are always driven by the same worker)
+    std::priority_queue<Timer_t, std::vector<Timer_t>, std::greater<Timer_t>> timers; ///< timers of the sessions
+    std::mt19937 random;              ///< random generator of the worker
+};
+
+void closeSession(Worker_t &worker, int index);
+
+/// Schedules a timer of a session
+/// \param worker the worker
+/// \param index index of the session
+/// \param kind kind of the timer
+/// \param delayMs when the timer goes off
+void schedule(Worker_t &worker, int index, TimerKind kind, uint64_t delayMs) {
+    worker.timers.push({now() + delayMs * 1000000, index, kind, worker.sessions[index].getEpoch()});
+}
+
+/// Schedules the next action of a session after a random time of thinking
+/// \param worker the worker
+/// \param index index of the session
+void scheduleAct(Worker_t &worker, int index) {
+    schedule(worker, index, ACT_TIMER, std::uniform_int_distribution<int>(0, options.thinkMs)(worker.random));
+}
+
+/// Sends off as much of the buffered data of a session as the socket takes
+/// \param worker the worker
+/// \param index index of the session
+/// \return false, if the connection has been closed
+bool flush(Worker_t &worker, int index) {
+    if (worker.sessions[index].flush(worker.epollFd, index))
+        return true;
+    closeSession(worker, index);
+    return false;
+}
+
+/// Sends a message (framed the way the server expects it)
+/// \param worker the worker
+/// \param index index of the session
+/// \param msg the message
+/// \param type type of the request (NUMBER_OF_REQUESTS - the reply is not timed)
+/// \param expect the reply starts with this
+/// \return false, if the connection has been closed
+bool sendMessage(Worker_t &worker, int index, const std::string &msg, Request type, const std::string &expect) {
+    Session_t &session = worker.sessions[index];
+    session.queue(msg);
+    if (type != NUMBER_OF_REQUESTS) {
+        session.pending.push_back({type, expect, now()});
+        stats.sent[type]++;
+    }
+    stats.messagesSent++;
+    return flush(worker, index);
+}
+
+/// Records the reply to a request if the message is one
+/// \param session the session
+/// \param msg the message received
+/// \return the type of the request, NUMBER_OF_REQUESTS if the message is not a reply
+Request matchReply(Session_t &session, const std::string &msg) {
+    for (auto it = session.pending.begin(); it != session.pending.end(); ++it) {
+        if (msg.compare(0, it->expect.size(), it->expect) != 0)
+            continue;
+        Request type = it->type;
+        stats.latency[type].record(now() - it->sentNs);
+        stats.replied[type]++;
+        session.pending.erase(it);
+        return type;
+    }
+    return NUMBER_OF_REQUESTS;
+}
+
+/// Returns whether or not it is the session's turn in their game
+/// \param session the session
+/// \return true, if the session is supposed to play the next move
+bool isMyTurn(const Session_t &session) {
+    return (session.moves % 2 == 0) == session.challenger;
+}
+
+/// Connects a session to the server
+/// \param worker the worker
+/// \param index index of the session
+void connectSession(Worker_t &worker, int index) {
+    Session_t &session = worker.sessions[index];
+    session.connectNs = now();
+    if (session.connect(worker.epollFd, index, (struct sockaddr *)&serverAddress, serverAddressLength)) {
+        session.phase = CONNECTING;
+        return;
+    }
+    stats.connectFailures++;
+    schedule(worker, index, CONNECT_TIMER, RETRY_DELAY_MS);
+}
+
+/// Logs a session in once its connection has been established
+/// \param worker the worker
+/// \param index index of the session
+void connected(Worker_t &worker, int index) {
+    Session_t &session = worker.sessions[index];
+    if (!session.connected(worker.epollFd, index)) {
+        session.disconnect();
+        session.phase = OFFLINE;
+        stats.connectFailures++;
+        schedule(worker, index, CONNECT_TIMER, RETRY_DELAY_MS);
+        return;
+    }
+    stats.online++;
+    bool rejoining = session.rejoin;
+    session.rejoin = false;
+    schedule(worker, index, PING_TIMER, options.pingSeconds * 1000);
+    session.phase = rejoining ? REJOINING : LOGGING_IN;
+    if (rejoining) {
+        session.pending.push_back({RECOVERY, "GAME_RECOVERY", session.connectNs});
+        stats.sent[RECOVERY]++;
+    }
+    // the server puts the client into a game (the one they lost the connection to or one restored
+    // after a restart of the server) before it replies to the PING, so the client acts only after that
+    if (sendMessage(worker, index, "NICK " + session.nick, NICK, "OK"))
+        sendMessage(worker, index, "PING", PING, "OK");
+}
+
+/// Closes the connection of a session and schedules connecting again
+/// \param worker the worker
+/// \param index index of the session
+void closeSession(Worker_t &worker, int index) {
+    Session_t &session = worker.sessions[index];
+    if (!session.isConnected())
+        return;
+    session.disconnect();
+    stats.online--;
+    session.pending.clear();
+    session.movePending = false;
+    session.awaitingRecovery = false;
+    if (session.phase == DROPPED) {
+        // the server has given up on the connection, the game waits for the player to connect back
+        session.rejoin = true;
+        schedule(worker, index, CONNECT_TIMER, REJOIN_DELAY_MS);
+    }
+    else {
+        if (running)
+            stats.disconnects++;
+        session.rejoin = session.phase == GAME;
+        schedule(worker, index, CONNECT_TIMER, RETRY_DELAY_MS);
+    }
+    session.phase = OFFLINE;
+}
+
+/// Sets up the board of a game from the moves sent by the server
+/// \param session the session
+/// \param recovery the parameters of GAME_RECOVERY (the index of the first move and the moves)
+void recoverGame(Session_t &session, const std::vector<std::string> &recovery) {
+    int from = recovery.size() > 1 ? atoi(recovery[1].c_str()) : 0;
+    std::string moves = recovery.size() > 2 ? recovery[2] : "";
+    if (from == 0) {
+        memset(session.heights, 0, sizeof(session.heights));
+        session.moves = 0;
+    }
+    if (from != session.moves)
+        return;
+    for (char c : moves)
+        if (c >= '0' && c < '0' + Position::WIDTH)
+            session.heights[c - '0']++;
+    session.moves += (int)moves.size();
+}
+
+/// Handles a message received by a session
+/// \param worker the worker
+/// \param index index of the session
+/// \param msg the message
+void handleMessage(Worker_t &worker, int index, const std::string &msg) {
+    Session_t &session = worker.sessions[index];
+    stats.messagesReceived++;
+    if (session.phase == DROPPED)
+        return;
+    Request reply = matchReply(session, msg);
+    std::vector<std::string> tokens;
+    size_t start = 0, end;
+    while ((end = msg.find(' ', start)) != std::string::npos) {
+        tokens.push_back(msg.substr(start, end - start));
+        start = end + 1;
+    }
+    tokens.push_back(msg.substr(start));
+    const std::string &type = tokens[0];
+
+    if (type == "OK") {
+        if (reply == PING && (session.phase == LOGGING_IN || session.phase == REJOINING)) {
+            // the client has not been put into any game
+            session.phase = LOBBY;
+            for (auto it = session.pending.begin(); it != session.pending.end(); ++it) {
+                if (it->type == RECOVERY) {
+                    session.pending.erase(it);
+                    break;
+                }
+            }
+            if (session.challenger)
+                scheduleAct(worker, index);
+        }
+        else if (reply == RPL)
+            session.phase = LOBBY;
+    }
+    else if (type == "RQ" && tokens.size() == 2) {
+        session.phase = RECV_RQ;
+        session.requester = tokens[1];
+        scheduleAct(worker, index);
+    }
+    else if (type == "RQ_CANCELED") {
+        if (session.phase == SENT_RQ) {
+            stats.rejected++;
+            session.phase = LOBBY;
+            scheduleAct(worker, index);
+        }
+        else if (session.phase == RECV_RQ)
+            session.phase = LOBBY;
+    }
+    else if (type == "GAME_START") {
+        memset(session.heights, 0, sizeof(session.heights));
+        session.moves = 0;
+        session.movePending = false;
+        session.awaitingRecovery = session.phase == LOGGING_IN || session.phase == REJOINING;
+        if (session.phase == LOGGING_IN)
+            stats.restored++;
+        else if (session.phase != REJOINING && session.challenger)
+            stats.gamesStarted++;
+        session.phase = GAME;
+        if (!session.awaitingRecovery && isMyTurn(session))
+            scheduleAct(worker, index);
+    }
+    else if (type == "GAME_RECOVERY" && session.phase == GAME) {
+        if (reply == RECOVERY)
+            stats.rejoined++;
+        recoverGame(session, tokens);
+        session.awaitingRecovery = false;
+        if (isMyTurn(session))
+            scheduleAct(worker, index);
+    }
+    else if (type == "GAME_PLAY" && tokens.size() == 4 && session.phase == GAME) {
+        int x = atoi(tokens[3].c_str());
+        if (x >= 0 && x < Position::WIDTH)
+            session.heights[x]++;
+        session.moves++;
+        if (tokens[1] == session.nick)
+            session.movePending = false;
+        else if (isMyTurn(session))
+            scheduleAct(worker, index);
+    }
+    else if (type == "GAME_MSG" && (msg.find("not your turn") != std::string::npos || msg.find("column is full") != std::string::npos)) {
+        stats.moveErrors++;
+        session.movePending = false;
+        for (auto it = session.pending.begin(); it != session.pending.end(); ++it) {
+            if (it->type == GAME_PLAY) {
+                session.pending.erase(it);
+                break;
+            }
+        }
+    }
+    else if (type == "GAME_RESULT") {
+        if (session.challenger)
+            stats.gamesFinished++;
+    }
+    else if (type == "GAME_CANCELED") {
+        if (session.challenger && msg.find("the game is over") == std::string::npos)
+            stats.gamesCanceled++;
+        if (session.phase == GAME) {
+            session.phase = LOBBY;
+            if (session.challenger)
+                scheduleAct(worker, index);
+        }
+    }
+    else if (type == "INVALID_PROTOCOL")
+        stats.kicked++;
+}
+
+/// Reads what has been received by a session and handles the whole messages
+/// \param worker the worker
+/// \param index index of the session
+void receive(Worker_t &worker, int index) {
+    Session_t &session = worker.sessions[index];
+    uint32_t epoch = session.getEpoch();
+    uint64_t received = 0;
+    bool open = session.receive(received);
+    stats.bytesReceived += received;
+    if (!open) {
+        closeSession(worker, index);
+        return;
+    }
+    // a message may close the connection (the rest of the data is thrown away then)
+    std::string msg;
+    while (session.getEpoch() == epoch) {
+        ProtocolClient::Frame frame = session.next(msg);
+        if (frame == ProtocolClient::INCOMPLETE)
+            break;
+        if (frame == ProtocolClient::INVALID) {
+            stats.kicked++;
+            closeSession(worker, index);
+            return;
+        }
+        handleMessage(worker, index, msg);
+    }
+}
+
+/// Makes a session do what it is supposed to do next
+/// \param worker the worker
+/// \param index index of the session
+void act(Worker_t &worker, int index) {
+    Session_t &session = worker.sessions[index];
+    std::uniform_real_distribution<double> chance(0, 1);
+    switch (session.phase) {
+        case LOBBY:
+            if (!session.challenger || session.partner < 0)
+                return;
+            // the partner is driven by the same worker, so its phase is known (a request sent
+            // to a client that is not in the lobby would get the sender kicked out)
+            if (worker.sessions[session.partner].phase != LOBBY) {
+                scheduleAct(worker, index);
+                return;
+            }
+            session.phase = SENT_RQ;
+            sendMessage(worker, index, "RQ " + worker.sessions[session.partner].nick, RQ, "OK");
+            break;
+        case RECV_RQ:
+            if (chance(worker.random) < options.rejectChance)
+                sendMessage(worker, index, "RPL " + session.requester + " NO", RPL, "OK");
+            else sendMessage(worker, index, "RPL " + session.requester + " YES", RPL, "GAME_START");
+            break;
+        case GAME: {
+            if (session.movePending || session.awaitingRecovery || !isMyTurn(session))
+                return;
+            if (chance(worker.random) < options.dropChance) {
+                // a lost connection looks like silence to the server (closing the socket would be leaving
+                // on purpose), so the session stops sending anything until the server gives up on it
+                session.phase = DROPPED;
+                session.pending.clear();
+                stats.drops++;
+                return;
+            }
+            std::vector<int> columns;
+            for (int x = 0; x < Position::WIDTH; x++)
+                if (session.heights[x] < Position::HEIGHT)
+                    columns.push_back(x);
+            if (columns.empty())
+                return;
+            int x = columns[std::uniform_int_distribution<int>(0, (int)columns.size() - 1)(worker.random)];
+            session.movePending = true;
+            sendMessage(worker, index, "GAME_PLAY " + std::to_string(x), GAME_PLAY, "GAME_PLAY " + session.nick + " ");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/// Handles a timer that has gone off
+/// \param worker the worker
+/// \param timer the timer
+void fire(Worker_t &worker, const Timer_t &timer) {
+    Session_t &session = worker.sessions[timer.session];
+    if (timer.epoch != session.getEpoch())
+        return;
+    switch (timer.kind) {
+        case CONNECT_TIMER:
+            if (session.phase == OFFLINE)
+                connectSession(worker, timer.session);
+            break;
+        case PING_TIMER:
+            if (session.phase == DROPPED || session.phase == OFFLINE || session.phase == CONNECTING)
+                break;
+            schedule(worker, timer.session, PING_TIMER, options.pingSeconds * 1000);
+            sendMessage(worker, timer.session, "PING", PING, "OK");
+            break;
+        case ACT_TIMER:
+            act(worker, timer.session);
+            break;
+    }
+}
+
+/// The body of a worker thread
+/// \param worker the worker
+void runWorker(Worker_t &worker) {
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        uint64_t time = now();
+        while (!worker.timers.empty() && worker.timers.top().when <= time) {
+            Timer_t timer = worker.timers.top();
+            worker.timers.pop();
+            fire(worker, timer);
+        }
+        int timeout = POLL_MS;
+        if (!worker.timers.empty())
+            timeout = (int)std::min<uint64_t>(POLL_MS, (worker.timers.top().when - std::min(worker.timers.top().when, now())) / 1000000 + 1);
+        int n = epoll_wait(worker.epollFd, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < n; i++) {
+            int index = (int)ProtocolClient::getIndex(events[i]);
+            Session_t &session = worker.sessions[index];
+            // the session may have been closed (and connected again) by an earlier event
+            if (!session.isCurrent(events[i]))
+                continue;
+            if (session.phase == CONNECTING) {
+                connected(worker, index);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                receive(worker, index);
+            if (session.isConnected() && session.isWriting() && (events[i].events & EPOLLOUT))
+                flush(worker, index);
+        }
+    }
+    for (Session_t &session : worker.sessions)
+        session.disconnect();
+    close(worker.epollFd);
+}
+
+/// Formats a duration in the most readable unit
+/// \param ns the duration
+/// \return the formatted duration (e.g. 1.25ms)
+std::string formatDuration(uint64_t ns) {
+    char buffer[32];
+    if (ns < 1000)
+        snprintf(buffer, sizeof(buffer), "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000)
+        snprintf(buffer, sizeof(buffer), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        snprintf(buffer, sizeof(buffer), "%.2fms", ns / 1e6);
+    else snprintf(buffer, sizeof(buffer), "%.2fs", ns / 1e9);
+    return buffer;
+}
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-H host] [-p port] [-n sessions] [-t threads] [-d seconds] [-r rate]\n";
+    std::cout << "       [-i seconds] [-m ms] [-D chance] [-R chance] [-x prefix] [-s seed]\n";
+    std::cout << "Simulates clients of a running server speaking its protocol. Every client logs in\n";
+    std::cout << "(NICK) and pings the server. The clients are paired up - one of them keeps sending\n";
+    std::cout << "game requests (RQ) to the other one, who accepts or rejects them (RPL), and they\n";
+    std::cout << "play random moves (GAME_PLAY). Now and then a client goes silent in the middle\n";
+    std::cout << "of a game, waits for the server to drop the connection and connects back to the\n";
+    std::cout << "game (GAME_RECOVERY). The clients are driven by epoll from a few threads, so the\n";
+    std::cout << "server has to allow enough clients (./server -c) and the system enough sockets\n";
+    std::cout << "(ulimit -n, net.ipv4.ip_local_port_range).\n";
+    std::cout << "-H address of the server (default: 127.0.0.1)\n";
+    std::cout << "-p port of the server (default: 53333)\n";
+    std::cout << "-n number of clients (default: 100)\n";
+    std::cout << "-t number of threads (default: 1)\n";
+    std::cout << "-d how long the load runs in seconds (default: 30)\n";
+    std::cout << "-r number of connections per second when starting (default: 1000)\n";
+    std::cout << "-i number of seconds between two PINGs of a client (default: 2)\n";
+    std::cout << "-m the longest time a client thinks before it acts in ms (default: 200)\n";
+    std::cout << "-D chance of a client dropping their connection instead of playing a move (default: 0.01)\n";
+    std::cout << "-R chance of a game request being rejected (default: 0.1)\n";
+    std::cout << "-x prefix of the nicks of the clients (default: lg)\n";
+    std::cout << "-s seed of the random generators (default: 1)\n";
+}
+
+/// The entry point of the load generator
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    options = {"127.0.0.1", "53333", 100, 1, 30, 1000, 2, 200, 0.01, 0.1, "lg", 1};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:n:t:d:r:i:m:D:R:x:s:h")) != -1) {
+        switch (opt) {
+            case 'H': options.host = optarg; break;
+            case 'p': options.port = optarg; break;
+            case 'n': options.sessions = atoi(optarg); break;
+            case 't': options.threads = atoi(optarg); break;
+            case 'd': options.seconds = atoi(optarg); break;
+            case 'r': options.connectRate = atoi(optarg); break;
+            case 'i': options.pingSeconds = atoi(optarg); break;
+            case 'm': options.thinkMs = atoi(optarg); break;
+            case 'D': options.dropChance = atof(optarg); break;
+            case 'R': options.rejectChance = atof(optarg); break;
+            case 'x': options.prefix = optarg; break;
+            case 's': options.seed = (unsigned)atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (options.sessions < 1 || options.threads < 1 || options.seconds < 1 || options.connectRate < 1 ||
+        options.pingSeconds < 1 || options.thinkMs < 0 || options.dropChance < 0 || options.rejectChance < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct addrinfo hints, *address;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address) != 0) {
+        std::cerr << "cannot resolve " << options.host << ":" << options.port << "\n";
+        return EXIT_FAILURE;
+    }
+    memcpy(&serverAddress, address->ai_addr, address->ai_addrlen);
+    serverAddressLength = address->ai_addrlen;
+    freeaddrinfo(address);
+
+    // every client needs a socket
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)options.sessions + 64) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, (rlim_t)options.sessions + 64);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < (rlim_t)options.sessions + 64)
+            std::cerr << "warning: only " << limit.rlim_cur << " sockets can be open (ulimit -n)\n";
+    }
+
+    // the pairs of clients are split among the workers, the connections of every worker are spread out evenly
+    int pairs = (options.sessions + 1) / 2;
+    std::vector<std::unique_ptr<Worker_t>> workers;
+    for (int t = 0; t < options.threads; t++) {
+        std::unique_ptr<Worker_t> worker(new Worker_t);
+        worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        worker->random.seed(options.seed + t);
+        int first = (int)((int64_t)pairs * t / options.threads) * 2;
+        int last = std::min(options.sessions, (int)((int64_t)pairs * (t + 1) / options.threads) * 2);
+        for (int i = first; i < last; i++) {
+            Session_t session;
+            session.nick = options.prefix + std::to_string(i);
+            session.challenger = i % 2 == 0;
+            session.partner = i + (session.challenger ? 1 : -1) < last ? (i - first) ^ 1 : -1;
+            session.phase = OFFLINE;
+            session.rejoin = false;
+            session.connectNs = 0;
+            memset(session.heights, 0, sizeof(session.heights));
+            session.moves = 0;
+            session.movePending = false;
+            session.awaitingRecovery = false;
+            worker->sessions.push_back(session);
+        }
+        uint64_t start = now();
+        for (size_t i = 0; i < worker->sessions.size(); i++)
+            worker->timers.push({start + (uint64_t)(i * 1e9 * options.threads / options.connectRate), (int)i, CONNECT_TIMER, 0});
+        workers.push_back(std::move(worker));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &worker : workers)
+        threads.emplace_back(runWorker, std::ref(*worker));
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t lastSent = 0, lastReceived = 0;
+    for (int second = 1; second <= options.seconds; second++) {
+        std::this_thread::sleep_until(start + std::chrono::seconds(second));
+        uint64_t sent = stats.messagesSent, received = stats.messagesReceived;
+        std::cout << "[" << std::setw(4) << second << "s] online " << stats.online << "/" << options.sessions;
+        std::cout << ", sent " << sent - lastSent << "/s, received " << received - lastReceived << "/s";
+        std::cout << ", games " << stats.gamesStarted << " started " << stats.gamesFinished << " finished";
+        std::cout << ", drops " << stats.drops << ", errors " << stats.disconnects + stats.kicked + stats.connectFailures << "\n";
+        lastSent = sent;
+        lastReceived = received;
+    }
+    running = false;
+    for (std::thread &thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n" << options.sessions << " clients, " << options.threads << " threads, " << std::fixed << std::setprecision(1) << seconds << "s\n";
+    std::cout << "messages: sent " << stats.messagesSent << " (" << stats.messagesSent / seconds << "/s), received ";
+    std::cout << stats.messagesReceived << " (" << stats.messagesReceived / seconds << "/s, " << stats.bytesReceived / seconds / 1e6 << " MB/s)\n";
+    std::cout << "games: started " << stats.gamesStarted << ", finished " << stats.gamesFinished << ", canceled " << stats.gamesCanceled;
+    std::cout << ", requests rejected " << stats.rejected << "\n";
+    std::cout << "drops: " << stats.drops << ", rejoined " << stats.rejoined << ", put into restored games " << stats.restored << "\n";
+    std::cout << "errors: connect " << stats.connectFailures << ", disconnected " << stats.disconnects << ", kicked " << stats.kicked;
+    std::cout << ", moves refused " << stats.moveErrors << "\n\n";
+    std::cout << std::left << std::setw(12) << "request" << std::right << std::setw(10) << "sent" << std::setw(10) << "replies";
+    std::cout << std::setw(10) << "per s" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99";
+    std::cout << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+    for (int type = 0; type < NUMBER_OF_REQUESTS; type++) {
+        uint64_t replied = stats.replied[type];
+        std::cout << std::left << std::setw(12) << REQUEST_NAMES[type] << std::right << std::setw(10) << stats.sent[type];
+        std::cout << std::setw(10) << replied << std::setw(10) << std::setprecision(1) << replied / seconds;
+        if (replied == 0) {
+            std::cout << "\n";
+            continue;
+        }
+        for (double q : {0.5, 0.9, 0.99, 0.999, 1.0})
+            std::cout << std::setw(10) << formatDuration(stats.latency[type].quantile(q));
+        std::cout << "\n";
+    }
+    return 0;
+}
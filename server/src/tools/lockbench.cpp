@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../ProfiledMutex.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-t threads] [-n locks] [-s microseconds]\n";
+    std::cout << "Measures the cost of locking a profiled mutex (profiling off and on) compared to\n";
+    std::cout << "std::mutex, then lets several threads contend for one mutex the way the threads\n";
+    std::cout << "handling the clients do - most of the time they look something up, sometimes they\n";
+    std::cout << "send a message while holding the mutex - and prints out the contention report.\n";
+    std::cout << "-t number of threads contending for the mutex (default: 8)\n";
+    std::cout << "-n number of times every thread locks the mutex (default: 2000)\n";
+    std::cout << "-s number of microseconds a send takes (default: 200)\n";
+}
+
+/// the mutex the threads contend for
+ProfiledMutex clientMtx("lockbench::clientMtx");
+
+/// Looks something up while holding the mutex (short)
+void lookUpClient() {
+    clientMtx.lock();
+    volatile int x = 0;
+    for (int i = 0; i < 100; i++)
+        x = x + i;
+    clientMtx.unlock();
+}
+
+/// Sends a message while holding the mutex (long)
+/// \param micros how long the send takes
+void sendUnderLock(int micros) {
+    clientMtx.lock();
+    std::this_thread::sleep_for(std::chrono::microseconds(micros));
+    clientMtx.unlock();
+}
+
+/// Measures the cost of one lock and unlock of a mutex
+/// \param mtx the mutex
+/// \param n number of iterations
+/// \return ns per lock and unlock
+template<class Mutex>
+double measure(Mutex &mtx, int n) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        mtx.lock();
+        mtx.unlock();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+/// The entry point of the lock profiler benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int threads = 8;
+    int locks = 2000;
+    int sendMicros = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:s:h")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'n': locks = atoi(optarg); break;
+            case 's': sendMicros = atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (threads < 1 || locks < 1 || sendMicros < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const int iterations = 10000000;
+    std::mutex plain;
+    ProfiledMutex profiled("lockbench::uncontended");
+    double plainNs = measure(plain, iterations);
+    double disabledNs = measure(profiled, iterations);
+    ProfiledMutex::setEnabled(true);
+    double enabledNs = measure(profiled, iterations / 10);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < locks; i++) {
+                if ((i + t) % 20 == 0)
+                    sendUnderLock(sendMicros);
+                else lookUpClient();
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "lock+unlock: std::mutex " << plainNs << "ns, profiled (off) " << disabledNs << "ns, profiled (on) " << enabledNs << "ns\n";
+    std::cout << "contention: " << threads << " threads x " << locks << " locks in " << std::setprecision(2) << seconds << "s\n";
+    std::cout << ProfiledMutex::report();
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../Logger.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-t threads] [-n messages] [-d] [-f] [-s sinks]\n";
+    std::cout << "Logs countdown-like messages from several threads at once and reports the latency\n";
+    std::cout << "of a log call and the throughput of the logger (the terminal output is discarded,\n";
+    std::cout << "the log file is written into the 'log' directory).\n";
+    std::cout << "-t number of threads logging (default: 8)\n";
+    std::cout << "-n number of messages logged by every thread (default: 100000)\n";
+    std::cout << "-d the messages are dropped when a ring is full (default: the threads wait)\n";
+    std::cout << "-f structured messages (a format and arguments) instead of plain ones\n";
+    std::cout << "-s where the messages are written - text, binary or both (default: text)\n";
+    std::cout << "Then it measures the cost of a log call of a disabled type (the message is not evaluated).\n";
+}
+
+/// The entry point of the logger benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int threads = 8;
+    int messages = 100000;
+    Logger::Overflow policy = Logger::BLOCK;
+    bool structured = false;
+    int sinks = Logger::TEXT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:dfs:h")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'n': messages = atoi(optarg); break;
+            case 'd': policy = Logger::DROP; break;
+            case 'f': structured = true; break;
+            case 's':
+                sinks = strcmp(optarg, "binary") == 0 ? Logger::BINARY :
+                        strcmp(optarg, "both") == 0 ? Logger::TEXT | Logger::BINARY : Logger::TEXT;
+                break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (threads < 1 || messages < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the terminal output of the logger is discarded
+    std::cout.flush();
+    int terminal = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (terminal < 0 || null < 0 || dup2(null, STDOUT_FILENO) < 0) {
+        std::cerr << "the terminal output cannot be redirected\n";
+        return EXIT_FAILURE;
+    }
+    close(null);
+
+    Logger *logger = Logger::getInstance();
+    logger->setOverflow(Logger::COUNTDOWN, policy);
+    logger->setSinks(sinks);
+    std::mutex samplesMtx;
+    std::vector<double> samples;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> loggers;
+    for (int t = 0; t < threads; t++) {
+        loggers.emplace_back([&, t]() {
+            std::vector<double> latencies;
+            latencies.reserve(messages);
+            std::string client = "127.0.0.1:" + std::to_string(50000 + t);
+            for (int i = 0; i < messages; i++) {
+                auto logged = std::chrono::steady_clock::now();
+                if (structured)
+                    LOG_COUNTDOWN_F("waiting for client {} to enter their nick ({}s)", client, i % 30);
+                else LOG_COUNTDOWN("waiting for client " + client + " to enter their nick (" + std::to_string(i % 30) + "s)");
+                latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - logged).count());
+            }
+            std::lock_guard<std::mutex> lock(samplesMtx);
+            samples.insert(samples.end(), latencies.begin(), latencies.end());
+        });
+    }
+    for (std::thread &thread : loggers)
+        thread.join();
+    double logSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logger->flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Logger::Stats_t stats = logger->getStats();
+
+    // the same calls with the countdown messages disabled
+    Logger::setEnabled(Logger::COUNTDOWN, false);
+    std::string client = "127.0.0.1:50000";
+    auto disabledStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < messages; i++)
+        LOG_COUNTDOWN("waiting for client " + client + " to enter their nick (" + std::to_string(i % 30) + "s)");
+    double disabledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - disabledStart).count() / messages;
+    logger->stop();
+
+    dup2(terminal, STDOUT_FILENO);
+    close(terminal);
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    uint64_t total = (uint64_t)threads * messages;
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "log call: p50=" << percentile(0.50) << "ns p99=" << percentile(0.99) << "ns max=" << samples.back() << "ns\n";
+    std::cout << "messages=" << total << " written=" << stats.written << " dropped=" << stats.dropped << " blocked=" << stats.blocked;
+    std::cout << " batches=" << stats.batches << " text bytes=" << stats.textBytes << " binary bytes=" << stats.binaryBytes << "\n";
+    std::cout << "logged in " << std::setprecision(3) << logSeconds << "s, written in " << seconds << "s (";
+    std::cout << std::setprecision(0) << stats.written / seconds << " messages/s)\n";
+    std::cout << "disabled log call: " << std::setprecision(2) << disabledNs << "ns (written=" << logger->getStats().written << ")\n";
+    return 0;
+}
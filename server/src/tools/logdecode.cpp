@@ -0,0 +1,143 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <unistd.h>
+
+#include "../Logger.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-j] [-t] <file.bin>\n";
+    std::cout << "Renders a binary log written by the server as text (the same lines\n";
+    std::cout << "as the text log) or as JSON (one object per line).\n";
+    std::cout << "-j JSON output\n";
+    std::cout << "-t the id of the thread is added to the text output\n";
+}
+
+/// Escapes a string so it could be put into JSON
+/// \param str the string
+/// \return the escaped string (without the quotes)
+std::string escape(const std::string &str) {
+    std::string escaped;
+    for (char c : str) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n";  break;
+            case '\r': escaped += "\\r";  break;
+            case '\t': escaped += "\\t";  break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                }
+                else escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/// Formats a point in time the way the text log does
+/// \param ns ns since the epoch
+/// \return the formatted time
+std::string formatTime(int64_t ns) {
+    time_t seconds = (time_t)(ns / 1000000000);
+    struct tm info;
+    char buffer[80];
+    localtime_r(&seconds, &info);
+    strftime(buffer, sizeof(buffer), "%d-%m-%Y_%H-%M-%S", &info);
+    return buffer;
+}
+
+/// The entry point of the binary log decoder
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    bool json = false;
+    bool threads = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "jth")) != -1) {
+        switch (opt) {
+            case 'j': json = true; break;
+            case 't': threads = true; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(argv[optind], std::ios::binary);
+    Logger::BinaryHeader_t header;
+    if (!file.read((char *)&header, sizeof(header)) ||
+        memcmp(header.magic, Logger::BINARY_MAGIC.data(), sizeof(header.magic)) != 0) {
+        std::cerr << argv[optind] << " is not a binary log\n";
+        return EXIT_FAILURE;
+    }
+
+    // the formats by their ids (the text and the line of the call site)
+    std::vector<std::string> formats(1, "{}");
+    Logger::BinaryRecord_t record;
+    std::vector<char> data;
+    uint64_t messages = 0;
+    while (file.read((char *)&record, sizeof(record))) {
+        data.resize(record.size);
+        if (record.size > 0 && !file.read(data.data(), record.size)) {
+            std::cerr << "the last record is incomplete\n";
+            break;
+        }
+        if (record.kind == Logger::FORMAT_RECORD) {
+            if (formats.size() <= record.format)
+                formats.resize(record.format + 1);
+            formats[record.format].assign(data.data(), record.size);
+            continue;
+        }
+        if (record.kind != Logger::MESSAGE_RECORD || record.type >= Logger::TYPES) {
+            std::cerr << "a corrupted record - decoding stopped\n";
+            return EXIT_FAILURE;
+        }
+
+        std::vector<Logger::Arg_t> args;
+        Logger::decodeArgs(data.data(), record.size, args);
+        const std::string &format = record.format < formats.size() ? formats[record.format] : formats[0];
+        std::string msg = Logger::render(format.c_str(), data.data(), record.size);
+        int64_t time = header.realTime + record.time - header.monotonic;
+        const char *type = Logger::getTypeName((Logger::Type)record.type);
+        messages++;
+
+        if (json) {
+            std::cout << "{\"line\":" << record.line << ",\"time\":\"" << formatTime(time) << "\",\"ns\":" << time;
+            std::cout << ",\"type\":\"" << type << "\",\"thread\":" << record.thread << ",\"format\":";
+            std::cout << (record.format == 0 ? std::string("null") : "\"" + escape(format) + "\"") << ",\"args\":[";
+            for (size_t i = 0; i < args.size(); i++) {
+                if (i > 0)
+                    std::cout << ",";
+                if (args[i].isString)
+                    std::cout << "\"" << escape(args[i].text) << "\"";
+                else std::cout << args[i].value;
+            }
+            std::cout << "],\"msg\":\"" << escape(msg) << "\"}\n";
+        }
+        else {
+            std::cout << "[#" << record.line << "][" << formatTime(time) << "][" << type << "]";
+            if (threads)
+                std::cout << "[" << record.thread << "]";
+            std::cout << " " << msg << "\n";
+        }
+    }
+    std::cerr << messages << " messages decoded\n";
+    return 0;
+}
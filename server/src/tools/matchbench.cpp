@@ -0,0 +1,137 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Matchmaker.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-p players] [-a arrivals] [-t ticks] [-s deviation]\n";
+    std::cout << "Measures the matchmaking queue. First, all the players join the queue at once\n";
+    std::cout << "and are paired up (one tick a second). Then, the queue is run for a number of\n";
+    std::cout << "ticks with a fixed number of players joining it before every tick.\n";
+    std::cout << "-p number of players joining the queue at once (default: 10000)\n";
+    std::cout << "-a number of players joining the queue before every tick (default: 1000)\n";
+    std::cout << "-t number of ticks (default: 100)\n";
+    std::cout << "-s standard deviation of the ratings around " << Matchmaker::DEFAULT_RATING << " (default: 300)\n";
+}
+
+/// Pairs up the players in the queue and accumulates the statistics of the tick
+/// \param matchmaker the queue
+/// \param now the (simulated) current time
+/// \param tickTimes durations of the ticks [us]
+/// \param diffs differences of ratings of the pairs
+/// \param waits how long the players waited [s]
+void tick(Matchmaker &matchmaker, std::chrono::steady_clock::time_point now,
+          std::vector<double> &tickTimes, std::vector<double> &diffs, std::vector<double> &waits) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Matchmaker::Match_t> matches = matchmaker.pair(now);
+    tickTimes.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    for (const Matchmaker::Match_t &match : matches) {
+        diffs.push_back(match.ratingDiff);
+        waits.push_back(match.waited);
+    }
+}
+
+/// Prints out statistics of the samples given as a parameter
+/// \param name name of the samples
+/// \param samples the samples (will be sorted)
+/// \param unit unit of the samples
+void printStats(const std::string &name, std::vector<double> &samples, const std::string &unit) {
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    std::cout << std::fixed << std::setprecision(1) << "  " << name << ": mean=" << sum / samples.size() << unit;
+    std::cout << " p50=" << samples[samples.size() / 2] << unit << " p99=" << samples[samples.size() * 99 / 100] << unit;
+    std::cout << " max=" << samples.back() << unit << "\n";
+}
+
+/// The entry point of the matchmaking benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int players = 10000;
+    int arrivals = 1000;
+    int ticks = 100;
+    double deviation = 300;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:a:t:s:h")) != -1) {
+        switch (opt) {
+            case 'p': players = atoi(optarg); break;
+            case 'a': arrivals = atoi(optarg); break;
+            case 't': ticks = atoi(optarg); break;
+            case 's': deviation = atof(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (players < 0 || arrivals < 0 || ticks < 1 || deviation < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> ratings(Matchmaker::DEFAULT_RATING, deviation);
+    Matchmaker matchmaker;
+    uint64_t nextPlayer = 0;
+    auto join = [&](int count, std::chrono::steady_clock::time_point now) {
+        for (int i = 0; i < count; i++)
+            matchmaker.enqueue("player" + std::to_string(nextPlayer++), (int)ratings(rng), now);
+    };
+
+    // a burst of players - the queue is drained one tick a second
+    std::vector<double> tickTimes, diffs, waits;
+    auto now = std::chrono::steady_clock::now();
+    auto start = std::chrono::steady_clock::now();
+    join(players, now);
+    double joinTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "burst: players=" << players << " join=" << joinTime << "ms\n";
+    // once the windows cannot widen anymore, the players left will not be paired up
+    const int maxTicks = (Matchmaker::MAX_WINDOW - Matchmaker::BASE_WINDOW) / Matchmaker::WINDOW_GROWTH + 2;
+    int drainTicks = 0;
+    std::vector<double> firstTick;
+    while (matchmaker.getStats().queued > 1 && drainTicks < maxTicks) {
+        tick(matchmaker, now, tickTimes, diffs, waits);
+        if (drainTicks == 0)
+            firstTick = tickTimes;
+        now += std::chrono::seconds(1);
+        drainTicks++;
+    }
+    std::cout << "  first tick=" << (firstTick.empty() ? 0 : firstTick[0]) << "us, ticks to drain=" << drainTicks;
+    std::cout << " left=" << matchmaker.getStats().queued << "\n";
+    printStats("rating difference", diffs, "");
+    printStats("wait", waits, "s");
+
+    // steady arrivals
+    tickTimes.clear();
+    diffs.clear();
+    waits.clear();
+    uint64_t queued = 0;
+    for (int i = 0; i < ticks; i++) {
+        join(arrivals, now);
+        queued += matchmaker.getStats().queued;
+        tick(matchmaker, now, tickTimes, diffs, waits);
+        now += std::chrono::seconds(1);
+    }
+    std::cout << "steady: arrivals=" << arrivals << "/tick ticks=" << ticks << " mean queue=" << (double)queued / ticks << "\n";
+    printStats("tick", tickTimes, "us");
+    printStats("rating difference", diffs, "");
+    printStats("wait", waits, "s");
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Metrics.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-t threads] [-n updates] [-l labels]\n";
+    std::cout << "Updates a counter and a histogram from several threads at once (the way the\n";
+    std::cout << "threads handling the clients do) and reports the cost of an update, then\n";
+    std::cout << "measures how long it takes to render all the metrics in the text format.\n";
+    std::cout << "-t number of threads updating the metrics (default: 8)\n";
+    std::cout << "-n number of updates done by every thread (default: 1000000)\n";
+    std::cout << "-l number of labeled counters and histograms registered (default: 25)\n";
+}
+
+/// The entry point of the metrics benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int threads = 8;
+    int updates = 1000000;
+    int labels = 25;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:l:h")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'n': updates = atoi(optarg); break;
+            case 'l': labels = atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (threads < 1 || updates < 1 || labels < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Metrics *metrics = Metrics::getInstance();
+    std::vector<Metrics::Counter *> counters;
+    std::vector<Metrics::Histogram *> histograms;
+    for (int i = 0; i < labels; i++) {
+        std::string label = "type=\"MSG_" + std::to_string(i) + "\"";
+        counters.push_back(&metrics->counter("bench_messages_total", "Number of messages", label));
+        histograms.push_back(&metrics->histogram("bench_handling_seconds", "Time it takes to handle a message", label));
+    }
+
+    auto measure = [&](bool histogram) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                // every thread updates the metrics of the same few types of messages
+                for (int i = 0; i < updates; i++) {
+                    int type = (t + i) % 4;
+                    if (histogram)
+                        histograms[type]->record(1000 + (uint64_t)i % 100000);
+                    else counters[type]->inc();
+                }
+            });
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+    uint64_t total = (uint64_t)threads * updates;
+    double counterNs = measure(false);
+    double histogramNs = measure(true);
+
+    uint64_t counted = 0;
+    for (Metrics::Counter *counter : counters)
+        counted += counter->value();
+
+    const int renders = 100;
+    std::string text;
+    auto renderStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < renders; i++)
+        text = metrics->render();
+    double renderUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - renderStart).count() / renders;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "counter inc: " << counterNs / total << "ns per update (" << threads << " threads, counted=" << counted << "/" << total << ")\n";
+    std::cout << "histogram record: " << histogramNs / total << "ns per update (p50=" << histograms[0]->quantile(0.5);
+    std::cout << "ns p99=" << histograms[0]->quantile(0.99) << "ns)\n";
+    std::cout << "render: " << renderUs << "us (" << text.size() << " bytes, " << 2 * labels << " metrics)\n";
+    return 0;
+}
@@ -0,0 +1,667 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "../Position.h"
+#include "ProtocolClient.h"
+
+/// the most events taken from epoll at once
+static const int MAX_EVENTS = 256;
+/// interval between two PINGs of a player (the server drops clients silent for longer than 6s)
+static const int PING_INTERVAL_MS = 2000;
+/// the longest time the games can take to start (s)
+static const int SETUP_SECONDS = 30;
+
+/// Who a session is
+enum Role {
+    PLAYER, ///< plays one of the measured games
+    CHURNER ///< logs in and leaves right away (background lobby churn)
+};
+
+/// What a session is doing at the moment
+enum Phase {
+    OFFLINE,    ///< not connected
+    CONNECTING, ///< the connection is being established
+    LOGGING_IN, ///< NICK (and PING) have been sent
+    LOBBY,      ///< in the lobby
+    GAME,       ///< playing a game
+    LEAVING     ///< EXIT has been sent, waiting for the server to close the connection
+};
+
+/// What a game is doing at the moment
+enum GameState {
+    SETTING_UP, ///< the players are logging in or the game request is on its way
+    PLAYING,    ///< the moves are being played
+    BROKEN      ///< a player lost their connection (the game is not played any more)
+};
+
+/// One client (the connection itself is handled by ProtocolClient)
+struct Session_t : public ProtocolClient {
+    Role role;          ///< who the session is
+    std::string nick;   ///< nick of the client
+    int game;           ///< index of the game (players only)
+    bool player1;       ///< true - it sends the game requests and plays first
+    Phase phase;        ///< what the session is doing
+    int oks;            ///< OKs received while logging in
+    uint64_t loginNs;   ///< when NICK was sent
+};
+
+/// One measured game (a pair of players)
+struct Game_t {
+    int player1;                  ///< index of the session of player 1
+    int player2;                  ///< index of the session of player 2
+    GameState state;              ///< what the game is doing
+    bool requested;               ///< true, if the game request has been sent
+    int started;                  ///< players who received GAME_START
+    Position position;            ///< the moves played
+    bool over;                    ///< true, if the last move played ended the game
+    uint32_t round;               ///< incremented with every start of the game (older timers are ignored)
+    bool inFlight;                ///< true, if a move has been sent and not echoed to both players yet
+    int echoes;                   ///< players who received the echo of the move in flight
+    uint64_t intendedNs;          ///< when the move in flight was supposed to be sent (by the schedule)
+    uint64_t sentNs;              ///< when it was actually sent
+};
+
+/// Timer of the next move of a game
+struct Timer_t {
+    uint64_t when;  ///< when the move is supposed to be sent (ns)
+    int game;       ///< index of the game
+    uint32_t round; ///< start of the game the timer belongs to
+
+    bool operator>(const Timer_t &other) const {
+        return when > other.when;
+    }
+};
+
+/// Measurements of one step of the sweep (one rate of the churn)
+struct Step_t {
+    int churnRate;                   ///< logins per second
+    double seconds;                  ///< how long the step was measured
+    std::vector<uint64_t> corrected; ///< latency of the moves from when they were supposed to be sent
+    std::vector<uint64_t> measured;  ///< latency of the moves from when they were actually sent
+    std::vector<uint64_t> logins;    ///< latency of the logins of the churners (NICK -> OK)
+    uint64_t skipped;                ///< logins that could not start (no churner was free)
+    uint64_t presence;               ///< lobby messages (ADD_CLIENT, REMOVE_CLIENT, ...) received by the players
+};
+
+/// Parameters of the benchmark
+struct Options_t {
+    std::string host;            ///< address of the server
+    std::string port;            ///< port of the server
+    int games;                   ///< number of games played at once
+    int rate;                    ///< moves per second (all the games together)
+    std::vector<int> churnRates; ///< logins per second of every step of the sweep
+    int warmupSeconds;           ///< seconds of every step that are not measured
+    int seconds;                 ///< seconds of every step that are measured
+    int churners;                ///< number of churners (clients logging in or leaving at most)
+    std::string prefix;          ///< prefix of the nicks
+    unsigned seed;               ///< seed of the random generator
+};
+
+/// parameters of the benchmark
+Options_t options;
+/// the players and the churners
+std::vector<Session_t> sessions;
+/// the games
+std::vector<Game_t> games;
+/// timers of the next moves
+std::priority_queue<Timer_t, std::vector<Timer_t>, std::greater<Timer_t>> timers;
+/// the epoll instance
+int epollFd;
+/// random generator
+std::mt19937 generator;
+/// address of the server
+struct sockaddr_storage serverAddress;
+/// length of the address of the server
+socklen_t serverAddressLength;
+/// the step being measured (NULL - nothing is recorded)
+Step_t *step = NULL;
+/// from when the moves are recorded (the moves supposed to be sent before are not)
+uint64_t windowNs = 0;
+/// number of logins of the churners so far (gives them unique nicks)
+uint64_t churnLogins = 0;
+/// connections of the players lost unexpectedly
+uint64_t lost = 0;
+/// logins of the churners that failed (the connection was closed before they got in)
+uint64_t failedLogins = 0;
+/// INVALID_PROTOCOL received
+uint64_t kicked = 0;
+
+/// Returns the current time of the monotonic clock
+/// \return ns of the monotonic clock
+uint64_t now() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Returns the time between two moves of a game
+/// \return ns between two moves
+uint64_t moveInterval() {
+    return (uint64_t)(1e9 * options.games / options.rate);
+}
+
+void closeSession(int index);
+
+/// Sends off as much of the buffered data of a session as the socket takes
+/// \param index index of the session
+/// \return false, if the connection has been closed
+bool flush(int index) {
+    if (sessions[index].flush(epollFd, index))
+        return true;
+    closeSession(index);
+    return false;
+}
+
+/// Sends a message (framed the way the server expects it)
+/// \param index index of the session
+/// \param msg the message
+/// \return false, if the connection has been closed
+bool sendMessage(int index, const std::string &msg) {
+    sessions[index].queue(msg);
+    return flush(index);
+}
+
+/// Connects a session to the server
+/// \param index index of the session
+/// \return false, if the connection could not be started
+bool connectSession(int index) {
+    Session_t &session = sessions[index];
+    if (!session.connect(epollFd, index, (struct sockaddr *)&serverAddress, serverAddressLength))
+        return false;
+    session.phase = CONNECTING;
+    session.oks = 0;
+    return true;
+}
+
+/// Closes the connection of a session
+///
+/// A player losing their connection breaks their game, a churner
+/// closes its connection on purpose once it has logged in.
+///
+/// \param index index of the session
+void closeSession(int index) {
+    Session_t &session = sessions[index];
+    if (!session.isConnected())
+        return;
+    session.disconnect();
+    if (session.role == PLAYER) {
+        lost++;
+        games[session.game].state = BROKEN;
+    }
+    else if (session.phase != LEAVING)
+        failedLogins++;
+    session.phase = OFFLINE;
+}
+
+/// Logs a session in once its connection has been established
+/// \param index index of the session
+void connected(int index) {
+    Session_t &session = sessions[index];
+    if (!session.connected(epollFd, index)) {
+        closeSession(index);
+        return;
+    }
+    session.phase = LOGGING_IN;
+    session.loginNs = now();
+    if (session.role == CHURNER)
+        sendMessage(index, "NICK " + session.nick);
+    else if (sendMessage(index, "NICK " + session.nick))
+        sendMessage(index, "PING");
+}
+
+/// Sends the game request of a game once both players are in the lobby
+/// \param g index of the game
+void requestGame(int g) {
+    Game_t &game = games[g];
+    if (game.state != SETTING_UP || game.requested || sessions[game.player1].phase != LOBBY || sessions[game.player2].phase != LOBBY)
+        return;
+    game.requested = true;
+    game.started = 0;
+    sendMessage(game.player1, "RQ " + sessions[game.player2].nick);
+}
+
+/// Returns the session of the player who is up in a game
+/// \param game the game
+/// \return index of the session
+int getMover(const Game_t &game) {
+    return game.position.nbMoves() % 2 == 0 ? game.player1 : game.player2;
+}
+
+/// Plays the next move of a game (a random column that is not full)
+/// \param g index of the game
+/// \param intendedNs when the move was supposed to be sent
+void playMove(int g, uint64_t intendedNs) {
+    Game_t &game = games[g];
+    std::vector<int> columns;
+    for (int x = 0; x < Position::WIDTH; x++)
+        if (game.position.canPlay(x))
+            columns.push_back(x);
+    if (columns.empty())
+        return;
+    int x = columns[std::uniform_int_distribution<int>(0, (int)columns.size() - 1)(generator)];
+    game.inFlight = true;
+    game.echoes = 0;
+    game.intendedNs = intendedNs;
+    game.sentNs = now();
+    // the server ends the game right after the echo of its last move, another move
+    // sent in the meantime would get the player kicked out (they are in the lobby)
+    game.over = game.position.isWinningMove(x) || game.position.nbMoves() + 1 == Position::WIDTH * Position::HEIGHT;
+    int mover = getMover(game);
+    game.position.playCol(x);
+    sendMessage(mover, "GAME_PLAY " + std::to_string(x));
+}
+
+/// Records the move in flight of a game once both players received its echo
+/// and schedules the next move (by the schedule, not by when this one finished)
+/// \param g index of the game
+void moveEchoed(int g) {
+    Game_t &game = games[g];
+    uint64_t time = now();
+    if (step != NULL && game.intendedNs >= windowNs) {
+        step->corrected.push_back(time - game.intendedNs);
+        step->measured.push_back(time - game.sentNs);
+    }
+    game.inFlight = false;
+    if (!game.over)
+        timers.push({game.intendedNs + moveInterval(), g, game.round});
+    else {
+        // a new game is requested once both players are back in the lobby (GAME_CANCELED)
+        game.state = SETTING_UP;
+        game.requested = false;
+    }
+}
+
+/// Handles a message received by a player
+/// \param index index of the session
+/// \param tokens the message split up by spaces
+void handlePlayerMessage(int index, const std::vector<std::string> &tokens) {
+    Session_t &session = sessions[index];
+    Game_t &game = games[session.game];
+    const std::string &type = tokens[0];
+
+    if (type == "OK") {
+        // NICK and PING are replied to in this order
+        if (session.phase == LOGGING_IN && ++session.oks == 2) {
+            session.phase = LOBBY;
+            requestGame(session.game);
+        }
+    }
+    else if (type == "RQ" && tokens.size() == 2)
+        sendMessage(index, "RPL " + tokens[1] + " YES");
+    else if (type == "RQ_CANCELED") {
+        if (session.player1 && game.state == SETTING_UP) {
+            game.requested = false;
+            requestGame(session.game);
+        }
+    }
+    else if (type == "GAME_START") {
+        session.phase = GAME;
+        if (++game.started < 2 || game.state == BROKEN)
+            return;
+        game.state = PLAYING;
+        game.round++;
+        game.position = Position();
+        game.over = false;
+        game.inFlight = false;
+        // the first moves of the games are spread out over one interval
+        uint64_t delay = std::uniform_int_distribution<uint64_t>(0, moveInterval())(generator);
+        timers.push({now() + delay, session.game, game.round});
+    }
+    else if (type == "GAME_PLAY" && tokens.size() == 4) {
+        // the move in flight has already been played on the position
+        const Session_t &mover = sessions[game.position.nbMoves() % 2 == 1 ? game.player1 : game.player2];
+        if (game.state == PLAYING && game.inFlight && tokens[1] == mover.nick && ++game.echoes == 2)
+            moveEchoed(session.game);
+    }
+    else if (type == "GAME_CANCELED") {
+        // the game is over (or the opponent left), a new one is requested
+        session.phase = LOBBY;
+        if (game.state == PLAYING) {
+            game.state = SETTING_UP;
+            game.requested = false;
+        }
+        requestGame(session.game);
+    }
+    else if (type == "INVALID_PROTOCOL")
+        kicked++;
+    else if (step != NULL && (type == "ADD_CLIENT" || type == "REMOVE_CLIENT" || type == "GAME_PLAYER_STATE"))
+        step->presence++;
+}
+
+/// Handles a message received by a churner (it leaves as soon as it has logged in)
+/// \param index index of the session
+/// \param tokens the message split up by spaces
+void handleChurnerMessage(int index, const std::vector<std::string> &tokens) {
+    Session_t &session = sessions[index];
+    if (tokens[0] == "INVALID_PROTOCOL")
+        kicked++;
+    if (session.phase != LOGGING_IN || tokens[0] != "OK")
+        return;
+    if (step != NULL)
+        step->logins.push_back(now() - session.loginNs);
+    // the server tells all the clients and closes the connection a while later
+    session.phase = LEAVING;
+    sendMessage(index, "EXIT");
+}
+
+/// Reads what has been received by a session and handles the whole messages
+/// \param index index of the session
+void receive(int index) {
+    Session_t &session = sessions[index];
+    uint32_t epoch = session.getEpoch();
+    uint64_t received = 0;
+    if (!session.receive(received)) {
+        closeSession(index);
+        return;
+    }
+    // a message may close the connection (the rest of the data is thrown away then)
+    std::string msg;
+    while (session.getEpoch() == epoch) {
+        ProtocolClient::Frame frame = session.next(msg);
+        if (frame == ProtocolClient::INCOMPLETE)
+            break;
+        if (frame == ProtocolClient::INVALID) {
+            kicked++;
+            closeSession(index);
+            return;
+        }
+        std::vector<std::string> tokens;
+        std::istringstream stream(msg);
+        std::string token;
+        while (stream >> token)
+            tokens.push_back(token);
+        if (tokens.empty())
+            continue;
+        if (session.role == PLAYER)
+            handlePlayerMessage(index, tokens);
+        else handleChurnerMessage(index, tokens);
+    }
+}
+
+/// Starts the login of a free churner
+/// \return false, if all the churners are busy
+bool churn() {
+    for (size_t i = 2 * options.games; i < sessions.size(); i++) {
+        Session_t &session = sessions[i];
+        if (session.phase != OFFLINE)
+            continue;
+        session.nick = options.prefix + "c" + std::to_string(churnLogins++);
+        return connectSession(i);
+    }
+    return false;
+}
+
+/// Drives the clients until the given time
+/// \param endNs when to stop
+/// \param churnRate logins of the churners per second
+/// \param stopWhenPlaying stop once all the games are being played (setting up)
+void run(uint64_t endNs, int churnRate, bool stopWhenPlaying) {
+    static uint64_t nextPingNs = now() + PING_INTERVAL_MS * 1000000ull;
+    uint64_t churnInterval = churnRate > 0 ? (uint64_t)(1e9 / churnRate) : 0;
+    uint64_t nextChurnNs = now();
+    struct epoll_event events[MAX_EVENTS];
+
+    while (now() < endNs) {
+        uint64_t time = now();
+        while (!timers.empty() && timers.top().when <= time) {
+            Timer_t timer = timers.top();
+            timers.pop();
+            Game_t &game = games[timer.game];
+            if (timer.round == game.round && game.state == PLAYING && !game.inFlight)
+                playMove(timer.game, timer.when);
+        }
+        // the logins are started by their own schedule as well
+        while (churnInterval > 0 && nextChurnNs <= time) {
+            if (!churn() && step != NULL)
+                step->skipped++;
+            nextChurnNs += churnInterval;
+        }
+        if (nextPingNs <= time) {
+            for (int i = 0; i < 2 * options.games; i++)
+                if (sessions[i].phase == LOBBY || sessions[i].phase == GAME)
+                    sendMessage(i, "PING");
+            nextPingNs += PING_INTERVAL_MS * 1000000ull;
+        }
+        if (stopWhenPlaying && std::all_of(games.begin(), games.end(), [](const Game_t &game) { return game.state != SETTING_UP; }))
+            return;
+
+        uint64_t wakeNs = std::min(endNs, nextPingNs);
+        if (!timers.empty())
+            wakeNs = std::min(wakeNs, timers.top().when);
+        if (churnInterval > 0)
+            wakeNs = std::min(wakeNs, nextChurnNs);
+        time = now();
+        int timeout = wakeNs > time ? (int)((wakeNs - time + 999999) / 1000000) : 0;
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+        for (int i = 0; i < n; i++) {
+            int index = (int)ProtocolClient::getIndex(events[i]);
+            Session_t &session = sessions[index];
+            // the session may have been closed by an earlier event
+            if (!session.isCurrent(events[i]))
+                continue;
+            if (session.phase == CONNECTING) {
+                connected(index);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                receive(index);
+            if (session.isConnected() && session.isWriting() && (events[i].events & EPOLLOUT))
+                flush(index);
+        }
+    }
+}
+
+/// Formats a duration in the most readable unit
+/// \param ns the duration
+/// \return the formatted duration (e.g. 1.25ms)
+std::string formatDuration(uint64_t ns) {
+    char buffer[32];
+    if (ns < 1000)
+        snprintf(buffer, sizeof(buffer), "%lluns", (unsigned long long)ns);
+    else if (ns < 1000000)
+        snprintf(buffer, sizeof(buffer), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000)
+        snprintf(buffer, sizeof(buffer), "%.2fms", ns / 1e6);
+    else snprintf(buffer, sizeof(buffer), "%.2fs", ns / 1e9);
+    return buffer;
+}
+
+/// Prints out p50, p99, p99.9 and the maximum of samples
+/// \param samples the samples (they get sorted)
+void printPercentiles(std::vector<uint64_t> &samples) {
+    if (samples.empty()) {
+        std::cout << std::setw(40) << "-";
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    for (double q : {0.5, 0.99, 0.999})
+        std::cout << std::setw(10) << formatDuration(samples[std::min(samples.size() - 1, (size_t)(q * samples.size()))]);
+    std::cout << std::setw(10) << formatDuration(samples.back());
+}
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-H host] [-p port] [-g games] [-r rate] [-c rates] [-w seconds] [-d seconds]\n";
+    std::cout << "       [-n churners] [-x prefix] [-s seed]\n";
+    std::cout << "Measures the latency of a move end to end against a running server: the games are played\n";
+    std::cout << "at once and their moves (GAME_PLAY) are sent by a fixed schedule. The latency of a move is\n";
+    std::cout << "the time until both players have received its echo. It is measured from when the move was\n";
+    std::cout << "supposed to be sent, so a move held back by a slow one before it is not left out\n";
+    std::cout << "(coordinated omission); the latency from when it was actually sent is printed as well.\n";
+    std::cout << "The measurement is repeated for every rate of background lobby churn - clients logging in\n";
+    std::cout << "and leaving right away (EXIT), every one of them makes the server tell all the clients.\n";
+    std::cout << "The server has to allow enough clients (./server -c), 2 per game + the churners\n";
+    std::cout << "(the server keeps a client that has left for 2s).\n";
+    std::cout << "-H address of the server (default: 127.0.0.1)\n";
+    std::cout << "-p port of the server (default: 53333)\n";
+    std::cout << "-g number of games played at once (default: 50)\n";
+    std::cout << "-r moves per second of all the games together (default: 200)\n";
+    std::cout << "-c logins per second of every step, separated by commas (default: 0,10,50)\n";
+    std::cout << "-w seconds of every step that are not measured (default: 2)\n";
+    std::cout << "-d seconds of every step that are measured (default: 10)\n";
+    std::cout << "-n number of churners, i.e. the most clients logging in or leaving at once (default: 256)\n";
+    std::cout << "-x prefix of the nicks (default: mb<pid>)\n";
+    std::cout << "-s seed of the random generator (default: 1)\n";
+}
+
+/// The entry point of the move latency benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    options = {"127.0.0.1", "53333", 50, 200, {0, 10, 50}, 2, 10, 256, "mb" + std::to_string(getpid()), 1};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:g:r:c:w:d:n:x:s:h")) != -1) {
+        switch (opt) {
+            case 'H': options.host = optarg; break;
+            case 'p': options.port = optarg; break;
+            case 'g': options.games = atoi(optarg); break;
+            case 'r': options.rate = atoi(optarg); break;
+            case 'c': {
+                options.churnRates.clear();
+                std::istringstream rates(optarg);
+                std::string rate;
+                while (std::getline(rates, rate, ','))
+                    options.churnRates.push_back(atoi(rate.c_str()));
+                break;
+            }
+            case 'w': options.warmupSeconds = atoi(optarg); break;
+            case 'd': options.seconds = atoi(optarg); break;
+            case 'n': options.churners = atoi(optarg); break;
+            case 'x': options.prefix = optarg; break;
+            case 's': options.seed = (unsigned)atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (options.games < 1 || options.rate < 1 || options.churnRates.empty() || options.warmupSeconds < 0 ||
+        options.seconds < 1 || options.churners < 1 ||
+        std::any_of(options.churnRates.begin(), options.churnRates.end(), [](int rate) { return rate < 0; })) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct addrinfo hints, *address;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address) != 0) {
+        std::cerr << "cannot resolve " << options.host << ":" << options.port << "\n";
+        return EXIT_FAILURE;
+    }
+    memcpy(&serverAddress, address->ai_addr, address->ai_addrlen);
+    serverAddressLength = address->ai_addrlen;
+    freeaddrinfo(address);
+
+    // every client needs a socket
+    rlim_t needed = (rlim_t)(2 * options.games + options.churners + 64);
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed) {
+        limit.rlim_cur = std::min(limit.rlim_max, needed);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    generator.seed(options.seed);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < 2 * options.games + options.churners; i++) {
+        Session_t session;
+        session.role = i < 2 * options.games ? PLAYER : CHURNER;
+        session.nick = session.role == PLAYER ? options.prefix + "p" + std::to_string(i) : "";
+        session.game = session.role == PLAYER ? i / 2 : -1;
+        session.player1 = i % 2 == 0;
+        session.phase = OFFLINE;
+        session.oks = 0;
+        session.loginNs = 0;
+        sessions.push_back(session);
+    }
+    for (int g = 0; g < options.games; g++) {
+        Game_t game;
+        game.player1 = 2 * g;
+        game.player2 = 2 * g + 1;
+        game.state = SETTING_UP;
+        game.requested = false;
+        game.started = 0;
+        game.over = false;
+        game.round = 0;
+        game.inFlight = false;
+        game.echoes = 0;
+        game.intendedNs = 0;
+        game.sentNs = 0;
+        games.push_back(game);
+    }
+
+    // the players log in and start their games
+    for (int i = 0; i < 2 * options.games; i++)
+        if (!connectSession(i))
+            closeSession(i);
+    run(now() + SETUP_SECONDS * 1000000000ull, 0, true);
+    int playing = (int)std::count_if(games.begin(), games.end(), [](const Game_t &game) { return game.state == PLAYING; });
+    if (playing == 0) {
+        std::cerr << "no game has started (lost connections " << lost << ", kicked " << kicked << ")\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << playing << "/" << options.games << " games, " << options.rate << " moves/s (one move of a game every ";
+    std::cout << formatDuration(moveInterval()) << "), " << options.warmupSeconds << "s warm-up + " << options.seconds << "s per step\n";
+
+    std::vector<Step_t> steps;
+    for (int churnRate : options.churnRates)
+        steps.push_back({churnRate, 0, {}, {}, {}, 0, 0});
+    for (Step_t &current : steps) {
+        run(now() + options.warmupSeconds * 1000000000ull, current.churnRate, false);
+        step = &current;
+        windowNs = now();
+        run(windowNs + options.seconds * 1000000000ull, current.churnRate, false);
+        current.seconds = (now() - windowNs) / 1e9;
+        step = NULL;
+    }
+
+    std::cout << "\n" << std::setw(8) << "churn/s" << std::setw(10) << "logins/s" << std::setw(10) << "moves/s" << std::setw(11) << "presence/s";
+    std::cout << " |" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max";
+    std::cout << " |" << std::setw(10) << "sent p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max";
+    std::cout << " |" << std::setw(10) << "login p50" << std::setw(10) << "p99" << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (Step_t &current : steps) {
+        std::cout << std::setw(8) << current.churnRate << std::setw(10) << current.logins.size() / current.seconds;
+        std::cout << std::setw(10) << current.corrected.size() / current.seconds << std::setw(11) << current.presence / current.seconds << " |";
+        printPercentiles(current.corrected);
+        std::cout << " |";
+        printPercentiles(current.measured);
+        std::cout << " |";
+        if (current.logins.empty())
+            std::cout << std::setw(20) << "-";
+        else {
+            std::sort(current.logins.begin(), current.logins.end());
+            std::cout << std::setw(10) << formatDuration(current.logins[current.logins.size() / 2]);
+            std::cout << std::setw(10) << formatDuration(current.logins[std::min(current.logins.size() - 1, (size_t)(0.99 * current.logins.size()))]);
+        }
+        if (current.skipped > 0)
+            std::cout << "  (" << current.skipped << " logins skipped, all the churners were busy)";
+        std::cout << "\n";
+    }
+    std::cout << "\nlatency of a move until both players received it, p50-max from when it was supposed to be sent,\n";
+    std::cout << "sent p50-max from when it was actually sent; lost connections " << lost << ", failed logins " << failedLogins;
+    std::cout << ", kicked " << kicked << "\n";
+    for (Session_t &session : sessions)
+        session.disconnect();
+    close(epollFd);
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include <unistd.h>
+
+#include "../Ratings.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-p players] [-g games] [-q queries] [-k top] [-o dir]\n";
+    std::cout << "Rates players by the results of random games and measures how fast the results\n";
+    std::cout << "are applied and the latency of the leaderboard queries (rank of a player, top k).\n";
+    std::cout << "The answers are checked against a scan of all the players and against the ratings\n";
+    std::cout << "read back from the file.\n";
+    std::cout << "-p number of players (default: 1000000)\n";
+    std::cout << "-g number of games (default: 2000000)\n";
+    std::cout << "-q number of queries of each kind (default: 100000)\n";
+    std::cout << "-k number of players returned by one top query (default: 100)\n";
+    std::cout << "-o directory of the ratings (default: rankbench-ratings)\n";
+}
+
+/// Prints out latency statistics of the samples given as a parameter
+/// \param name name of the measurement
+/// \param samples latencies in nanoseconds (will be sorted)
+void printStats(const std::string &name, std::vector<double> &samples) {
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << name << ": queries=" << samples.size() << " mean=" << sum / samples.size() << "ns";
+    std::cout << " p50=" << percentile(0.50) << "ns p99=" << percentile(0.99) << "ns max=" << samples.back() << "ns\n";
+}
+
+/// The entry point of the rank benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    // number of ranks checked against a scan of all the players
+    const size_t CHECKS = 200;
+
+    size_t players = 1000000;
+    size_t games = 2000000;
+    size_t queries = 100000;
+    size_t top = 100;
+    std::string dir = "rankbench-ratings";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:g:q:k:o:h")) != -1) {
+        switch (opt) {
+            case 'p': players = strtoull(optarg, NULL, 10); break;
+            case 'g': games = strtoull(optarg, NULL, 10); break;
+            case 'q': queries = strtoull(optarg, NULL, 10); break;
+            case 'k': top = strtoull(optarg, NULL, 10); break;
+            case 'o': dir = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (players < 2 || games < 1 || top < 1 || top > Ratings::MAX_TOP) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    remove((dir + "/" + Ratings::FILE_NAME).c_str());
+
+    std::mt19937_64 rng(1);
+    std::vector<std::string> nicks(players);
+    for (size_t i = 0; i < players; i++)
+        nicks[i] = "player" + std::to_string(i);
+
+    // the players have a hidden strength, so the ratings spread out
+    std::vector<double> strength(players);
+    std::normal_distribution<double> normal(0, 1);
+    for (double &s : strength)
+        s = normal(rng);
+
+    size_t mismatches = 0;
+    std::vector<Ratings::Entry_t> before;
+    {
+        Ratings ratings(dir);
+        ratings.open();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < games; i++) {
+            size_t player1 = rng() % players;
+            size_t player2 = (player1 + 1 + rng() % (players - 1)) % players;
+            double p = 1.0 / (1.0 + exp(strength[player2] - strength[player1]));
+            double roll = (double)(rng() % 1000000) / 1000000;
+            ratings.submit(nicks[player1], nicks[player2], roll < p * 0.9 ? 1.0 : (roll < p * 0.9 + 0.1 ? 0.5 : 0.0));
+        }
+        double submitted = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ratings.close();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        Ratings::Stats_t stats = ratings.getStats();
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "updates: games=" << stats.results << " players=" << stats.players << " submit=" << games / submitted;
+        std::cout << " games/s apply+save=" << stats.results / seconds << " games/s\n";
+
+        // queries
+        std::vector<double> ranks, tops;
+        std::vector<Ratings::Entry_t> entries;
+        for (size_t i = 0; i < queries; i++) {
+            Ratings::Entry_t entry;
+            const std::string &nick = nicks[rng() % players];
+            auto begin = std::chrono::steady_clock::now();
+            bool found = ratings.getRank(nick, entry);
+            ranks.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count());
+            if (!found)
+                continue;
+
+            entries.clear();
+            begin = std::chrono::steady_clock::now();
+            ratings.getTop(top, entries);
+            tops.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count());
+        }
+        printStats("rank", ranks);
+        printStats("top " + std::to_string(top), tops);
+
+        // the ranks checked against a scan (the number of players rated higher, plus one)
+        std::vector<int> all(players, -1);
+        for (size_t i = 0; i < players; i++) {
+            Ratings::Entry_t entry;
+            if (ratings.getRank(nicks[i], entry))
+                all[i] = entry.rating;
+        }
+        double scanned = 0;
+        for (size_t i = 0; i < CHECKS; i++) {
+            size_t player = rng() % players;
+            Ratings::Entry_t entry;
+            if (!ratings.getRank(nicks[player], entry))
+                continue;
+            auto begin = std::chrono::steady_clock::now();
+            uint64_t rank = 1;
+            for (int rating : all)
+                rank += rating > all[player];
+            scanned += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            if (rank != entry.rank || entry.rating != all[player])
+                mismatches++;
+        }
+        std::cout << "scan: mean=" << scanned / CHECKS << "ns per rank\n";
+        for (size_t i = 1; i < entries.size(); i++)
+            if (entries[i].rating > entries[i - 1].rating || entries[i].rank < entries[i - 1].rank)
+                mismatches++;
+        before = entries;
+    }
+
+    // the leaderboard read back from the file
+    Ratings ratings(dir);
+    if (!ratings.open()) {
+        std::cerr << "the ratings in '" << dir << "' cannot be read\n";
+        return EXIT_FAILURE;
+    }
+    std::vector<Ratings::Entry_t> after;
+    ratings.getTop(top, after);
+    if (after.size() != before.size())
+        mismatches++;
+    for (size_t i = 0; i < std::min(before.size(), after.size()); i++)
+        if (after[i].nick != before[i].nick || after[i].rank != before[i].rank || after[i].rating != before[i].rating)
+            mismatches++;
+    std::cout << "reloaded: players=" << ratings.getStats().players << " best=";
+    if (!after.empty())
+        std::cout << after[0].nick << " (" << after[0].rating << ")";
+    std::cout << "\nmismatches=" << mismatches << "\n";
+    return mismatches ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../Server.h"
+#include "../Journal.h"
+#include "../Snapshot.h"
+#include "../Position.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-g games] [-m moves] [-t moves] [-c percent] [-n] [-o dir]\n";
+    std::cout << "Journals games in progress (and a snapshot of them), then measures\n";
+    std::cout << "how long it takes the server to restore them when it boots up.\n";
+    std::cout << "-g number of games in progress (default: 100000)\n";
+    std::cout << "-m number of moves of every game covered by the snapshot (default: 16)\n";
+    std::cout << "-t number of moves of every game journaled after the snapshot (default: 4)\n";
+    std::cout << "-c percentage of the games canceled after the snapshot (default: 10)\n";
+    std::cout << "-n do not write the snapshot (the whole journal is replayed)\n";
+    std::cout << "-o working directory of the benchmark (default: recoverybench)\n";
+}
+
+/// Plays a random move that does not finish the game
+/// \param position the position the move is played in
+/// \param rng random number generator
+/// \return column of the move, -1 if there is no such a move
+int playRandomMove(Position &position, std::mt19937_64 &rng) {
+    if (position.nbMoves() + 1 >= Position::WIDTH * Position::HEIGHT)
+        return -1;
+    int columns[Position::WIDTH];
+    int count = 0;
+    for (int col = 0; col < Position::WIDTH; col++)
+        if (position.canPlay(col) && !position.isWinningMove(col))
+            columns[count++] = col;
+    if (count == 0)
+        return -1;
+    int col = columns[rng() % count];
+    position.playCol(col);
+    return col;
+}
+
+/// The entry point of the recovery benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int games = 100000;
+    int snapshotMoves = 16;
+    int tailMoves = 4;
+    int canceledPercent = 10;
+    bool snapshot = true;
+    std::string dir = "recoverybench";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:m:t:c:no:h")) != -1) {
+        switch (opt) {
+            case 'g': games = atoi(optarg); break;
+            case 'm': snapshotMoves = atoi(optarg); break;
+            case 't': tailMoves = atoi(optarg); break;
+            case 'c': canceledPercent = atoi(optarg); break;
+            case 'n': snapshot = false; break;
+            case 'o': dir = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (games < 1 || snapshotMoves < 0 || tailMoves < 0 || canceledPercent < 0 || canceledPercent > 100) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the server uses the journal in its working directory
+    mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    if (chdir(dir.c_str()) < 0) {
+        std::cerr << "cannot change the working directory to '" << dir << "'\n";
+        return EXIT_FAILURE;
+    }
+    for (const std::string &segment : Journal::listSegments(Journal::DEFAULT_DIR))
+        remove(segment.c_str());
+    remove((Journal::DEFAULT_DIR + "/" + Snapshot::FILE_NAME).c_str());
+
+    std::mt19937_64 rng(1);
+    std::vector<Snapshot::Room_t> rooms(games);
+    std::vector<Position> positions(games);
+    std::vector<bool> live(games, true);
+    auto start = std::chrono::steady_clock::now();
+    {
+        Journal journal;
+        if (!journal.open()) {
+            std::cerr << "the journal in '" << dir << "/" << Journal::DEFAULT_DIR << "' cannot be opened\n";
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < games; i++) {
+            rooms[i] = {journal.nextGameId(), "player" + std::to_string(2 * i), "player" + std::to_string(2 * i + 1), ""};
+            journal.append(Journal::GAME_START, rooms[i].id, rooms[i].player1 + " " + rooms[i].player2);
+        }
+        // the games are played in rounds, so the moves of different games interleave
+        auto playRound = [&]() {
+            for (int i = 0; i < games; i++) {
+                int col = live[i] ? playRandomMove(positions[i], rng) : -1;
+                if (col < 0)
+                    continue;
+                rooms[i].moves += (char)('0' + col);
+                journal.append(Journal::GAME_MOVE, rooms[i].id, std::string(1, (char)('0' + col)));
+            }
+        };
+        for (int move = 0; move < snapshotMoves; move++)
+            playRound();
+        if (snapshot) {
+            uint64_t lsn = journal.getLastLsn();
+            journal.waitDurable(lsn);
+            Snapshot::write(Journal::DEFAULT_DIR, lsn, rooms);
+        }
+        for (int move = 0; move < tailMoves; move++)
+            playRound();
+        for (int i = 0; i < games; i++)
+            if ((int)(rng() % 100) < canceledPercent) {
+                live[i] = false;
+                journal.append(Journal::GAME_CANCELED, rooms[i].id, "canceled");
+            }
+        journal.close();
+        Journal::Stats_t stats = journal.getStats();
+        std::cout << "journaled: records=" << stats.records << " bytes=" << stats.bytes << " segments=" << stats.segments;
+        std::cout << " (" << std::fixed << std::setprecision(2) << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s)\n";
+    }
+    size_t expected = 0;
+    for (int i = 0; i < games; i++)
+        expected += live[i];
+
+    // loading the snapshot and replaying the journal only
+    std::vector<Snapshot::Room_t> recovered;
+    Snapshot::Stats_t stats;
+    start = std::chrono::steady_clock::now();
+    Snapshot::recover(Journal::DEFAULT_DIR, recovered, stats);
+    double loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "snapshot: lsn=" << stats.snapshotLsn << " games=" << stats.snapshotRooms;
+    std::cout << ", journal: segments=" << stats.segments << " records=" << stats.records << " last lsn=" << stats.lastLsn << "\n";
+
+    // the whole recovery as the server does it when it boots up
+    start = std::chrono::steady_clock::now();
+    Server server(Server::PORT_DEFAULT, Server::MAX_CLIENTS_DEFAULT);
+    size_t restored = server.restoreGames();
+    double restoreTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "games=" << games << " expected=" << expected << " recovered=" << recovered.size() << " restored=" << restored << "\n";
+    std::cout << "load (snapshot + journal)=" << loadTime << "s restore (server)=" << restoreTime << "s\n";
+    return restored == expected && recovered.size() == expected ? 0 : EXIT_FAILURE;
+}
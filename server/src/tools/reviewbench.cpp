@@ -0,0 +1,184 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+
+#include <unistd.h>
+#include <dirent.h>
+
+#include "../Annotator.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-g games] [-t threads] [-l seconds] [-r seed] [-b book] [-o dir]\n";
+    std::cout << "Stores a burst of random finished games, hands them all over for the post-game\n";
+    std::cout << "analysis at once (the way a crowded server would) and reports how long handing\n";
+    std::cout << "a game over takes, how many games were deferred or dropped and how fast they are annotated.\n";
+    std::cout << "-g number of games of the burst (default: 1000)\n";
+    std::cout << "-t number of worker threads of the analysis (default: 1)\n";
+    std::cout << "-l the most seconds to wait for the games to be annotated (default: 120)\n";
+    std::cout << "-r seed of the random number generator (default: 1)\n";
+    std::cout << "-b opening book (default: none)\n";
+    std::cout << "-o directory of the store (default: reviewbench-store)\n";
+}
+
+/// Removes all the files of a store of games
+/// \param dir directory of the store
+void removeStore(const std::string &dir) {
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && (name.compare(name.size() - 4, 4, ".dat") == 0 || name.compare(name.size() - 4, 4, ".idx") == 0))
+            remove((dir + "/" + name).c_str());
+    }
+    closedir(d);
+}
+
+/// Plays a random game (until a player wins or the board is full)
+/// \param rng random number generator
+/// \param result the result of the game
+/// \return the moves of the game
+std::string playRandom(std::mt19937_64 &rng, GameStore::Result &result) {
+    Position position;
+    std::string moves;
+    result = GameStore::DRAW;
+    while (position.nbMoves() < Position::WIDTH * Position::HEIGHT) {
+        std::vector<int> columns;
+        for (int col = 0; col < Position::WIDTH; col++)
+            if (position.canPlay(col))
+                columns.push_back(col);
+        int col = columns[rng() % columns.size()];
+        moves += (char)('0' + col);
+        if (position.isWinningMove(col)) {
+            result = position.nbMoves() % 2 == 0 ? GameStore::PLAYER_1_WON : GameStore::PLAYER_2_WON;
+            break;
+        }
+        position.playCol(col);
+    }
+    return moves;
+}
+
+/// The entry point of the post-game review benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int games = 1000;
+    int threads = Annotator::DEFAULT_THREADS;
+    int limit = 120;
+    uint64_t seed = 1;
+    std::string bookPath;
+    std::string dir = "reviewbench-store";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:t:l:r:b:o:h")) != -1) {
+        switch (opt) {
+            case 'g': games = atoi(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            case 'l': limit = atoi(optarg); break;
+            case 'r': seed = strtoull(optarg, NULL, 10); break;
+            case 'b': bookPath = optarg; break;
+            case 'o': dir = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (games < 1 || threads < 1 || limit < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    removeStore(dir);
+
+    GameStore store(dir);
+    if (!store.open()) {
+        std::cerr << "the store in '" << dir << "' cannot be opened\n";
+        return EXIT_FAILURE;
+    }
+    std::mt19937_64 rng(seed);
+    std::vector<GameStore::Game_t> finished(games);
+    uint64_t now = (uint64_t)time(NULL);
+    for (int i = 0; i < games; i++) {
+        GameStore::Game_t &game = finished[i];
+        game.journalId = i + 1;
+        game.player1 = "player" + std::to_string(2 * i);
+        game.player2 = "player" + std::to_string(2 * i + 1);
+        game.moves = playRandom(rng, game.result);
+        game.startTime = now - 60;
+        game.endTime = now;
+        if (store.append(game) == 0) {
+            std::cerr << "game " << i << " could not be stored\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    OpeningBook book(bookPath);
+    Annotator annotator(store);
+    annotator.open(threads, bookPath.empty() ? NULL : &book);
+
+    // the whole burst is handed over at once
+    std::vector<double> samples;
+    auto start = std::chrono::steady_clock::now();
+    for (const GameStore::Game_t &game : finished) {
+        auto submitted = std::chrono::steady_clock::now();
+        annotator.submit(game.id, game.moves);
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - submitted).count());
+    }
+
+    // waiting for the games to be annotated (or the time limit)
+    Annotator::Stats_t stats;
+    while (1) {
+        stats = annotator.getStats();
+        if (stats.annotated + stats.dropped >= stats.submitted ||
+            std::chrono::steady_clock::now() - start >= std::chrono::seconds(limit))
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    annotator.close();
+
+    // every annotated game has to have its moves annotated in the store
+    uint64_t annotatedGames = 0, mismatches = 0;
+    for (const GameStore::Game_t &game : finished) {
+        std::vector<uint8_t> annotations;
+        if (!store.getAnnotations(game.id, annotations) || annotations.size() != game.moves.size()) {
+            mismatches++;
+            continue;
+        }
+        bool annotated = false;
+        for (uint8_t annotation : annotations) {
+            if (annotation == 0)
+                continue;
+            annotated = true;
+            if ((annotation & GameStore::ANNOTATION_ACCURACY) > 101)
+                mismatches++;
+        }
+        annotatedGames += annotated;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "submit: games=" << samples.size() << " p50=" << percentile(0.50) << "ns p99=" << percentile(0.99);
+    std::cout << "ns max=" << samples.back() << "ns\n";
+    std::cout << "games: submitted=" << stats.submitted << " deferred=" << stats.deferred << " dropped=" << stats.dropped;
+    std::cout << " annotated=" << stats.annotated << " (" << std::setprecision(2) << seconds << "s, ";
+    std::cout << std::setprecision(1) << stats.annotated / seconds << " games/s)\n" << std::setprecision(0);
+    std::cout << "moves: annotated=" << stats.moves << " blunders=" << stats.blunders << " skipped=" << stats.skipped << "\n";
+    std::cout << "games with annotations in the store=" << annotatedGames << " mismatches=" << mismatches << "\n";
+    return mismatches ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Connect4.h"
+#include "../Bot.h"
+#include "../WinCheck.h"
+#include "../OpeningBook.h"
+#include "../Tablebase.h"
+
+/// Results of the games played by one thread
+struct Results_t {
+    uint64_t games = 0;        ///< number of games played
+    uint64_t moves = 0;        ///< number of moves played
+    uint64_t player1Wins = 0;  ///< games won by the first player
+    uint64_t player2Wins = 0;  ///< games won by the second player
+    uint64_t draws = 0;        ///< games that ended in a draw
+    std::string record;        ///< the games played ("moves result" per line), if requested
+};
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-g games] [-t threads] [-r seed] [-l lanes] [-1 level] [-2 level] [-b book] [-e tablebase] [-o file]\n";
+    std::cout << "Plays bot-vs-bot games against the game engine (no server, no network).\n";
+    std::cout << "The results only depend on the seed and the number of threads.\n";
+    std::cout << "-g number of games (default: 100000)\n";
+    std::cout << "-t number of threads (default: all cores)\n";
+    std::cout << "-r seed of the random number generators (default: 1)\n";
+    std::cout << "-l number of games every thread plays in lockstep, checking the end\n";
+    std::cout << "   of all of them at once with the SIMD kernel (default: 0 - one by one through the engine)\n";
+    std::cout << "-1 level of the first bot - random/greedy (default: greedy)\n";
+    std::cout << "-2 level of the second bot - random/greedy (default: greedy)\n";
+    std::cout << "-b opening book the bots follow (default: none)\n";
+    std::cout << "-e endgame tablebase the bots follow (default: none)\n";
+    std::cout << "-o file the games are written into, one per line (default: none)\n";
+}
+
+/// Adds a finished game to the results
+/// \param results the results of the thread
+/// \param moves the moves of the game (columns)
+/// \param state how the game ended
+/// \param record true, if the game should be recorded
+void addResult(Results_t *results, const std::string &moves, Connect4::GameState state, bool record) {
+    results->games++;
+    results->moves += moves.size();
+    switch (state) {
+        case Connect4::PLAYER_1_WINS: results->player1Wins++; break;
+        case Connect4::PLAYER_2_WINS: results->player2Wins++; break;
+        default: results->draws++; break;
+    }
+    if (record) {
+        results->record += moves;
+        results->record += state == Connect4::DRAW ? " 0\n" : (state == Connect4::PLAYER_1_WINS ? " 1\n" : " 2\n");
+    }
+}
+
+/// Plays the given number of games on one thread
+/// \param games number of games
+/// \param seed seed of the random number generators of the thread
+/// \param level1 level of the first bot
+/// \param level2 level of the second bot
+/// \param book opening book (NULL if none)
+/// \param tablebase endgame tablebase (NULL if none)
+/// \param record true, if the games should be recorded
+/// \param results where the results are stored
+void play(uint64_t games, uint64_t seed, Bot::Level level1, Bot::Level level2,
+          OpeningBook *book, Tablebase *tablebase, bool record, Results_t *results) {
+    const std::string PLAYER_1 = "bot1";
+    const std::string PLAYER_2 = "bot2";
+    Bot bot1(level1, seed * 2, book, tablebase);
+    Bot bot2(level2, seed * 2 + 1, book, tablebase);
+    std::string moves;
+
+    for (uint64_t i = 0; i < games; i++) {
+        Connect4 game(PLAYER_1, PLAYER_2, NULL);
+        Connect4::GameState state = Connect4::CONTINUE;
+        bool player1IsUp = true;
+        moves.clear();
+        while (state == Connect4::CONTINUE) {
+            int col = (player1IsUp ? bot1 : bot2).chooseMove(game.getPosition());
+            state = game.play(player1IsUp ? PLAYER_1 : PLAYER_2, col);
+            moves.push_back((char)('0' + col));
+            player1IsUp = !player1IsUp;
+        }
+        addResult(results, moves, state, record);
+    }
+}
+
+/// Plays the given number of games on one thread, #lanes of them at a time.
+///
+/// The games do not go through class #Connect4, each of them is just
+/// a #Position. After every round of moves, the tiles of the players
+/// who just played are checked for an alignment in one batch (#WinCheck).
+///
+/// \param games number of games
+/// \param lanes number of games played at a time
+/// \param seed seed of the random number generators of the thread
+/// \param level1 level of the first bot
+/// \param level2 level of the second bot
+/// \param book opening book (NULL if none)
+/// \param tablebase endgame tablebase (NULL if none)
+/// \param record true, if the games should be recorded
+/// \param results where the results are stored
+void playBatched(uint64_t games, int lanes, uint64_t seed, Bot::Level level1, Bot::Level level2,
+                 OpeningBook *book, Tablebase *tablebase, bool record, Results_t *results) {
+    const int CELLS = Position::WIDTH * Position::HEIGHT;
+    Bot bot1(level1, seed * 2, book, tablebase);
+    Bot bot2(level2, seed * 2 + 1, book, tablebase);
+    std::vector<Position> positions;
+    std::vector<std::string> moves;
+    std::vector<uint64_t> bitboards;
+    std::vector<uint8_t> aligned;
+    uint64_t started = 0;
+
+    for (; started < games && (int)positions.size() < lanes; started++) {
+        positions.push_back(Position());
+        moves.push_back(std::string());
+    }
+    while (!positions.empty()) {
+        size_t count = positions.size();
+        bitboards.resize(count);
+        aligned.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            bool player1IsUp = positions[i].nbMoves() % 2 == 0;
+            int col = (player1IsUp ? bot1 : bot2).chooseMove(positions[i]);
+            positions[i].playCol(col);
+            moves[i].push_back((char)('0' + col));
+            bitboards[i] = positions[i].getCurrentPosition() ^ positions[i].getMask();
+        }
+        WinCheck::hasAlignment(bitboards.data(), aligned.data(), count);
+
+        // replace the finished games with new ones (or drop the lane)
+        for (size_t i = count; i-- > 0;) {
+            Connect4::GameState state = Connect4::CONTINUE;
+            if (aligned[i])
+                state = positions[i].nbMoves() % 2 == 1 ? Connect4::PLAYER_1_WINS : Connect4::PLAYER_2_WINS;
+            else if (positions[i].nbMoves() == CELLS)
+                state = Connect4::DRAW;
+            if (state == Connect4::CONTINUE)
+                continue;
+            addResult(results, moves[i], state, record);
+            if (started < games) {
+                started++;
+                positions[i] = Position();
+                moves[i].clear();
+            } else {
+                positions.erase(positions.begin() + i);
+                moves.erase(moves.begin() + i);
+            }
+        }
+    }
+}
+
+/// The entry point of the self-play tool
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    uint64_t games = 100000;
+    int threads = (int)std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+    int lanes = 0;
+    Bot::Level level1 = Bot::GREEDY;
+    Bot::Level level2 = Bot::GREEDY;
+    std::string bookPath;
+    std::string tablebasePath;
+    std::string output;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:t:r:l:1:2:b:e:o:h")) != -1) {
+        switch (opt) {
+            case 'g': games = strtoull(optarg, NULL, 10); break;
+            case 't': threads = atoi(optarg); break;
+            case 'r': seed = strtoull(optarg, NULL, 10); break;
+            case 'l': lanes = atoi(optarg); break;
+            case '1':
+            case '2':
+                if (!Bot::parseLevel(optarg, opt == '1' ? level1 : level2)) {
+                    printHelp(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'b': bookPath = optarg; break;
+            case 'e': tablebasePath = optarg; break;
+            case 'o': output = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (threads < 1 || lanes < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    OpeningBook book(bookPath);
+    Tablebase tablebase(tablebasePath);
+    if (!bookPath.empty() && !book.isAvailable()) {
+        std::cerr << "opening book '" << bookPath << "' cannot be loaded\n";
+        return EXIT_FAILURE;
+    }
+    if (!tablebasePath.empty() && !tablebase.isAvailable()) {
+        std::cerr << "tablebase '" << tablebasePath << "' cannot be loaded\n";
+        return EXIT_FAILURE;
+    }
+
+    // every thread gets a fixed share of the games and its own seed
+    std::vector<Results_t> results(threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        uint64_t share = games / threads + ((uint64_t)t < games % threads ? 1 : 0);
+        OpeningBook *b = bookPath.empty() ? NULL : &book;
+        Tablebase *e = tablebasePath.empty() ? NULL : &tablebase;
+        if (lanes > 0)
+            workers.emplace_back(playBatched, share, lanes, seed * threads + t, level1, level2, b, e, !output.empty(), &results[t]);
+        else workers.emplace_back(play, share, seed * threads + t, level1, level2, b, e, !output.empty(), &results[t]);
+    }
+    for (auto &w : workers)
+        w.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Results_t total;
+    for (auto &r : results) {
+        total.games += r.games;
+        total.moves += r.moves;
+        total.player1Wins += r.player1Wins;
+        total.player2Wins += r.player2Wins;
+        total.draws += r.draws;
+    }
+
+    if (!output.empty()) {
+        std::ofstream file(output, std::ios::out | std::ios::trunc);
+        for (auto &r : results)
+            file << r.record;
+        if (file.fail()) {
+            std::cerr << "writing the games into '" << output << "' failed\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto percent = [&](uint64_t n) {
+        return total.games ? 100.0 * n / total.games : 0.0;
+    };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "games=" << total.games << " moves=" << total.moves << " threads=" << threads << " seed=" << seed;
+    if (lanes > 0)
+        std::cout << " lanes=" << lanes << " win check=" << WinCheck::getName(WinCheck::getIsa());
+    std::cout << "\n";
+    std::cout << "time=" << elapsed << "s games/s=" << (elapsed > 0 ? total.games / elapsed : 0.0);
+    std::cout << " moves/s=" << (elapsed > 0 ? total.moves / elapsed : 0.0);
+    std::cout << " avg length=" << (total.games ? (double)total.moves / total.games : 0.0) << "\n";
+    std::cout << "player1 wins=" << total.player1Wins << " (" << percent(total.player1Wins) << "%)";
+    std::cout << " player2 wins=" << total.player2Wins << " (" << percent(total.player2Wins) << "%)";
+    std::cout << " draws=" << total.draws << " (" << percent(total.draws) << "%)\n";
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Position.h"
+#include "../Solver.h"
+#include "../TranspositionTable.h"
+#include "../OpeningBook.h"
+
+/// Position to be solved (moves + the expected score if known)
+struct Task_t {
+    std::string moves; ///< sequence of moves (column indexes 0-6)
+    bool hasExpected;  ///< true, if the expected score is known
+    int expected;      ///< the expected score
+};
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-t threads] [-s] [-m entries] [-b book] [moves...]\n";
+    std::cout << "Solves Connect4 positions given as sequences of columns (0-6), for example 3344.\n";
+    std::cout << "If no positions are given, they are read from the standard input\n";
+    std::cout << "one per line (\"<moves> [expected score]\").\n";
+    std::cout << "-t number of threads (default: all cores)\n";
+    std::cout << "-s scaling report - solves the positions with 1, 2, 4, ... threads\n";
+    std::cout << "-b opening book consulted before searching\n";
+    std::cout << "-m number of entries of the transposition table (default: " << TranspositionTable::DEFAULT_SIZE << ")\n";
+}
+
+/// Solves all the tasks with the given number of threads
+/// \param tasks positions that are going to be solved
+/// \param threads number of threads
+/// \param table transposition table shared by the threads
+/// \param verbose true, if the result of each position should be printed out
+/// \param book opening book (may be NULL)
+/// \param nodes total number of explored positions (output)
+/// \return elapsed time in seconds
+double solveAll(const std::vector<Task_t> &tasks, int threads, TranspositionTable &table, bool verbose, OpeningBook *book, uint64_t &nodes) {
+    nodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &task : tasks) {
+        Position position;
+        if (position.play(task.moves) != task.moves.size()) {
+            std::cerr << "invalid position '" << task.moves << "'\n";
+            continue;
+        }
+        uint64_t taskNodes;
+        auto taskStart = std::chrono::steady_clock::now();
+        int score = Solver::solveParallel(position, threads, table, taskNodes, false, book);
+        double taskTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - taskStart).count();
+        nodes += taskNodes;
+
+        if (verbose) {
+            std::cout << (task.moves.empty() ? "-" : task.moves) << " score=" << score;
+            if (task.hasExpected && task.expected != score)
+                std::cout << " (MISMATCH, expected " << task.expected << ")";
+            std::cout << " nodes=" << taskNodes << " time=" << std::fixed << std::setprecision(3) << taskTime << "s";
+            std::cout << " knps=" << std::setprecision(0) << (taskTime > 0 ? taskNodes / taskTime / 1000.0 : 0.0) << "\n";
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// The entry point of the solver
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int threads = (int)std::thread::hardware_concurrency();
+    bool scaling = false;
+    uint64_t tableSize = TranspositionTable::DEFAULT_SIZE;
+    std::string bookPath;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:sm:b:h")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 's': scaling = true; break;
+            case 'm': tableSize = strtoull(optarg, NULL, 10); break;
+            case 'b': bookPath = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (threads < 1 || tableSize == 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Task_t> tasks;
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++)
+            tasks.push_back({argv[i], false, 0});
+    }
+    else {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::stringstream ss(line);
+            Task_t task = {"", false, 0};
+            ss >> task.moves;
+            if (ss >> task.expected)
+                task.hasExpected = true;
+            tasks.push_back(task);
+        }
+    }
+
+    TranspositionTable table(tableSize);
+    uint64_t nodes;
+
+    std::unique_ptr<OpeningBook> book;
+    if (!bookPath.empty()) {
+        book.reset(new OpeningBook(bookPath));
+        if (!book->isAvailable()) {
+            std::cerr << "opening book '" << bookPath << "' cannot be loaded\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!scaling) {
+        double time = solveAll(tasks, threads, table, true, book.get(), nodes);
+        std::cout << "threads=" << threads << " positions=" << tasks.size() << " nodes=" << nodes;
+        std::cout << " time=" << std::fixed << std::setprecision(3) << time << "s";
+        std::cout << " knps=" << std::setprecision(0) << (time > 0 ? nodes / time / 1000.0 : 0.0) << "\n";
+        return 0;
+    }
+
+    // scaling report - the table is emptied before every
+    // run so each thread count starts from scratch
+    std::vector<int> threadCounts;
+    for (int t = 1; t < threads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(threads);
+
+    double baseTime = 0;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "nodes" << std::setw(10) << "time[s]"
+              << std::setw(12) << "knps" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << "\n";
+    for (int t : threadCounts) {
+        table.reset();
+        double time = solveAll(tasks, t, table, false, book.get(), nodes);
+        if (t == 1)
+            baseTime = time;
+        double speedup = time > 0 ? baseTime / time : 0.0;
+        std::cout << std::setw(8) << t << std::setw(14) << nodes
+                  << std::setw(10) << std::fixed << std::setprecision(3) << time
+                  << std::setw(12) << std::setprecision(0) << (time > 0 ? nodes / time / 1000.0 : 0.0)
+                  << std::setw(10) << std::setprecision(2) << speedup
+                  << std::setw(11) << std::setprecision(1) << speedup / t * 100.0 << "%\n";
+    }
+    return 0;
+}
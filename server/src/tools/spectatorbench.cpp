@@ -0,0 +1,203 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "../Spectators.h"
+
+/// One spectator reading what they are sent (the other end of their socket)
+struct Reader_t {
+    int socket;          ///< the socket
+    uint64_t gameId;     ///< id of the game they watch
+    std::string buffer;  ///< data received that do not make a whole frame yet
+    uint64_t lastMove;   ///< number of the last move they know
+    uint64_t frames;     ///< number of frames received
+    uint64_t snapshots;  ///< number of snapshots received
+    uint64_t gaps;       ///< number of moves that were neither received nor covered by a snapshot
+    bool ended;          ///< true, if they received WATCH_END
+};
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-s spectators] [-g games] [-m moves] [-l percent] [-i us]\n";
+    std::cout << "Publishes the moves of games watched by many spectators and measures how long\n";
+    std::cout << "publishing a move takes (the players wait for it) and how the spectators are served.\n";
+    std::cout << "-s number of spectators (default: 5000)\n";
+    std::cout << "-g number of games (default: 10)\n";
+    std::cout << "-m number of moves of every game (default: 200)\n";
+    std::cout << "-l percentage of slow spectators who never read anything (default: 10)\n";
+    std::cout << "-i interval between two rounds of moves in microseconds (default: 5000)\n";
+}
+
+/// Parses the frames the reader has received
+/// \param reader the reader
+void parseFrames(Reader_t &reader) {
+    size_t offset = 0;
+    while (reader.buffer.size() - offset >= 12) {
+        size_t length = strtoul(reader.buffer.substr(offset + 8, 4).c_str(), NULL, 10);
+        if (reader.buffer.size() - offset < 12 + length + 2)
+            break;
+        std::string msg = reader.buffer.substr(offset + 12, length);
+        offset += 12 + length + 2;
+        reader.frames++;
+
+        // WATCH_STATE <id> <player1> <player2> <number of moves> ..., WATCH_PLAY <id> <number of the move> ...
+        std::vector<std::string> tokens;
+        size_t start = 0, end;
+        while ((end = msg.find(' ', start)) != std::string::npos) {
+            tokens.push_back(msg.substr(start, end - start));
+            start = end + 1;
+        }
+        tokens.push_back(msg.substr(start));
+        if (tokens[0] == Spectators::WATCH_STATE) {
+            reader.snapshots++;
+            reader.lastMove = strtoull(tokens[4].c_str(), NULL, 10);
+        }
+        else if (tokens[0] == Spectators::WATCH_PLAY) {
+            uint64_t move = strtoull(tokens[2].c_str(), NULL, 10);
+            if (move != reader.lastMove + 1)
+                reader.gaps++;
+            reader.lastMove = move;
+        }
+        else if (tokens[0] == Spectators::WATCH_END)
+            reader.ended = true;
+    }
+    reader.buffer.erase(0, offset);
+}
+
+/// The entry point of the spectator benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    int spectatorCount = 5000;
+    int games = 10;
+    int moves = 200;
+    int slowPercent = 10;
+    int intervalUs = 5000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:g:m:l:i:h")) != -1) {
+        switch (opt) {
+            case 's': spectatorCount = atoi(optarg); break;
+            case 'g': games = atoi(optarg); break;
+            case 'm': moves = atoi(optarg); break;
+            case 'l': slowPercent = atoi(optarg); break;
+            case 'i': intervalUs = atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (spectatorCount < 1 || games < 1 || moves < 1 || slowPercent < 0 || slowPercent > 100 || intervalUs < 0) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Spectators spectators;
+    spectators.open("silhavyj");
+
+    // the slow spectators are the first ones of every game, the others read everything
+    std::vector<Reader_t> readers;
+    std::vector<int> slowSockets;
+    for (int i = 0; i < spectatorCount; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+            std::cerr << "socketpair failed (too many open files?)\n";
+            return EXIT_FAILURE;
+        }
+        uint64_t gameId = 1 + i % games;
+        spectators.join(gameId, "player1", "player2", "");
+        spectators.watch("spectator" + std::to_string(i), fds[0], std::make_shared<std::mutex>(), gameId);
+        if (i * 100 < spectatorCount * slowPercent) {
+            int size = 4096; // so they fall behind soon
+            setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+            slowSockets.push_back(fds[1]);
+        }
+        else readers.push_back({fds[1], gameId, "", 0, 0, 0, 0, false});
+    }
+
+    std::atomic<bool> publishing(true);
+    std::thread reading([&]() {
+        std::vector<struct pollfd> pfds(readers.size());
+        for (size_t i = 0; i < readers.size(); i++)
+            pfds[i] = {readers[i].socket, POLLIN, 0};
+        char buffer[65536];
+        size_t ended = 0;
+        while (ended < readers.size()) {
+            if (poll(pfds.data(), pfds.size(), 100) == 0 && !publishing)
+                break;
+            for (size_t i = 0; i < pfds.size(); i++) {
+                if (!(pfds[i].revents & POLLIN))
+                    continue;
+                ssize_t n = recv(pfds[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n <= 0)
+                    continue;
+                readers[i].buffer.append(buffer, n);
+                bool wasEnded = readers[i].ended;
+                parseFrames(readers[i]);
+                if (!wasEnded && readers[i].ended)
+                    ended++;
+            }
+        }
+    });
+
+    // the moves of the games are played in rounds
+    std::vector<double> latencies;
+    latencies.reserve((size_t)games * moves);
+    auto start = std::chrono::steady_clock::now();
+    for (int move = 0; move < moves; move++) {
+        for (int game = 1; game <= games; game++) {
+            auto before = std::chrono::steady_clock::now();
+            spectators.publishMove(game, move % 2 ? "player2" : "player1", move % 6, move % 7);
+            latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - before).count());
+        }
+        if (intervalUs > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(intervalUs));
+    }
+    for (int game = 1; game <= games; game++) {
+        spectators.publishResult(game, "draw");
+        spectators.publishEnd(game);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    publishing = false;
+    reading.join();
+    Spectators::Stats_t stats = spectators.getStats();
+    spectators.close();
+
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t frames = 0, snapshots = 0, gaps = 0, ended = 0;
+    for (const Reader_t &reader : readers) {
+        frames += reader.frames;
+        snapshots += reader.snapshots;
+        gaps += reader.gaps;
+        ended += reader.ended;
+        close(reader.socket);
+    }
+    for (int socket : slowSockets)
+        close(socket);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "spectators=" << spectatorCount << " (slow=" << slowSockets.size() << ") games=" << games << " moves=" << (uint64_t)games * moves;
+    std::cout << " (" << std::setprecision(2) << seconds << "s)\n" << std::setprecision(0);
+    std::cout << "publish: p50=" << latencies[latencies.size() / 2] << "ns p99=" << latencies[latencies.size() * 99 / 100];
+    std::cout << "ns max=" << latencies.back() << "ns\n";
+    std::cout << "delivery: published=" << stats.published << " sent=" << stats.sent << " coalesced=" << stats.snapshots;
+    std::cout << " disconnected=" << stats.dropped << "\n";
+    std::cout << "readers: frames=" << frames << " snapshots=" << snapshots << " gaps=" << gaps << " ended=" << ended << "/" << readers.size() << "\n";
+    return gaps == 0 && ended == readers.size() ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
+#include <unistd.h>
+#include <dirent.h>
+
+#include "../GameStore.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-g games] [-p players] [-d days] [-q queries] [-o dir]\n";
+    std::cout << "Appends finished games into a store of games and measures the ingestion\n";
+    std::cout << "rate and the latency of the queries (a page of the history of a player, one game).\n";
+    std::cout << "-g number of games appended (default: 1000000)\n";
+    std::cout << "-p number of players (default: 50000)\n";
+    std::cout << "-d number of days the games are spread over (default: 7)\n";
+    std::cout << "-q number of queries of each kind (default: 100000)\n";
+    std::cout << "-o directory of the store (default: storebench)\n";
+}
+
+/// Prints out latency statistics of the samples given as a parameter
+/// \param name name of the measurement
+/// \param samples latencies in nanoseconds (will be sorted)
+void printStats(const std::string &name, std::vector<double> &samples) {
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << name << ": queries=" << samples.size() << " mean=" << sum / samples.size() << "ns";
+    std::cout << " p50=" << percentile(0.50) << "ns p99=" << percentile(0.99) << "ns max=" << samples.back() << "ns\n";
+}
+
+/// Removes all the files of a store of games
+/// \param dir directory of the store
+void removeStore(const std::string &dir) {
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && (name.compare(name.size() - 4, 4, ".dat") == 0 || name.compare(name.size() - 4, 4, ".idx") == 0))
+            remove((dir + "/" + name).c_str());
+    }
+    closedir(d);
+}
+
+/// The entry point of the store benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    // a player's history is paged by this many games
+    const size_t PAGE_SIZE = 10;
+
+    size_t games = 1000000;
+    size_t players = 50000;
+    int days = 7;
+    size_t queries = 100000;
+    std::string dir = "storebench";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:p:d:q:o:h")) != -1) {
+        switch (opt) {
+            case 'g': games = strtoull(optarg, NULL, 10); break;
+            case 'p': players = strtoull(optarg, NULL, 10); break;
+            case 'd': days = atoi(optarg); break;
+            case 'q': queries = strtoull(optarg, NULL, 10); break;
+            case 'o': dir = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (games < 1 || players < 2 || days < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    removeStore(dir);
+
+    std::mt19937_64 rng(1);
+    std::vector<std::string> nicks(players);
+    for (size_t i = 0; i < players; i++)
+        nicks[i] = "player" + std::to_string(i);
+    std::vector<uint64_t> ids;
+    ids.reserve(games);
+
+    // ingestion - the games end evenly over the days
+    uint64_t firstTime = (uint64_t)time(NULL) - (uint64_t)days * 24 * 60 * 60;
+    {
+        GameStore store(dir);
+        if (!store.open()) {
+            std::cerr << "the store in '" << dir << "' cannot be opened\n";
+            return EXIT_FAILURE;
+        }
+        GameStore::Game_t game;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < games; i++) {
+            size_t player1 = rng() % players;
+            size_t player2 = (player1 + 1 + rng() % (players - 1)) % players;
+            uint64_t endTime = firstTime + i * (uint64_t)days * 24 * 60 * 60 / games;
+            game.journalId = i + 1;
+            game.player1 = nicks[player1];
+            game.player2 = nicks[player2];
+            game.moves.resize(7 + rng() % 36);
+            for (char &move : game.moves)
+                move = (char)('0' + rng() % 7);
+            game.result = (GameStore::Result)(rng() % 3);
+            game.startTime = endTime - 60;
+            game.endTime = endTime;
+            if (store.append(game) == 0) {
+                std::cerr << "game " << i << " could not be stored\n";
+                return EXIT_FAILURE;
+            }
+            ids.push_back(game.id);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        GameStore::Stats_t stats = store.getStats();
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "ingestion: games=" << stats.games << " players=" << stats.players << " bytes=" << stats.bytes;
+        std::cout << " rate=" << stats.games / seconds << " games/s\n";
+    }
+
+    // queries against the reopened store (the files are mapped again)
+    GameStore store(dir);
+    if (!store.open()) {
+        std::cerr << "the store in '" << dir << "' cannot be reopened\n";
+        return EXIT_FAILURE;
+    }
+    std::vector<GameStore::Game_t> page;
+    std::vector<double> firstPages, nextPages, lookups;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < queries; i++) {
+        const std::string &nick = nicks[rng() % players];
+        page.clear();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t cursor = store.getHistory(nick, 0, PAGE_SIZE, page);
+        firstPages.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        for (size_t j = 1; j < page.size(); j++)
+            if (page[j].endTime > page[j - 1].endTime || (page[j].player1 != nick && page[j].player2 != nick))
+                mismatches++;
+        if (cursor != 0) {
+            page.clear();
+            start = std::chrono::steady_clock::now();
+            store.getHistory(nick, cursor, PAGE_SIZE, page);
+            nextPages.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        GameStore::Game_t game;
+        uint64_t id = ids[rng() % ids.size()];
+        start = std::chrono::steady_clock::now();
+        bool found = store.getGame(id, game);
+        lookups.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        if (!found || game.id != id)
+            mismatches++;
+    }
+    printStats("history (first page)", firstPages);
+    printStats("history (next page)", nextPages);
+    printStats("game", lookups);
+    std::cout << "mismatches=" << mismatches << "\n";
+    return mismatches ? EXIT_FAILURE : 0;
+}
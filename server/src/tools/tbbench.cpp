@@ -0,0 +1,144 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../Position.h"
+#include "../Solver.h"
+#include "../TranspositionTable.h"
+#include "../Tablebase.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-f file] [-n probes] [-c rounds] [-v positions]\n";
+    std::cout << "Measures the probe latency of an endgame tablebase.\n";
+    std::cout << "-f tablebase file (default: " << Tablebase::DEFAULT_PATH << ")\n";
+    std::cout << "-n number of hot probes (default: 1000000)\n";
+    std::cout << "-c number of cold rounds - the file is evicted from the page cache before each one (default: 20)\n";
+    std::cout << "-v number of positions verified against the solver (default: 0)\n";
+}
+
+/// Prints out latency statistics of the samples given as a parameter
+/// \param name name of the measurement
+/// \param samples latencies in nanoseconds (will be sorted)
+void printStats(const std::string &name, std::vector<double> &samples) {
+    if (samples.empty())
+        return;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))];
+    };
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << name << ": probes=" << samples.size() << " mean=" << sum / samples.size() << "ns";
+    std::cout << " p50=" << percentile(0.50) << "ns p99=" << percentile(0.99) << "ns max=" << samples.back() << "ns\n";
+}
+
+/// Evicts the file from the page cache (only works for pages no one has mapped)
+/// \param path to the file
+void evictFromPageCache(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/// The entry point of the tablebase benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    std::string path = Tablebase::DEFAULT_PATH;
+    size_t hotProbes = 1000000;
+    int coldRounds = 20;
+    int verify = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:n:c:v:h")) != -1) {
+        switch (opt) {
+            case 'f': path = optarg; break;
+            case 'n': hotProbes = strtoull(optarg, NULL, 10); break;
+            case 'c': coldRounds = atoi(optarg); break;
+            case 'v': verify = atoi(optarg); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+
+    std::vector<uint64_t> keys;
+    {
+        Tablebase tablebase(path);
+        if (!tablebase.isAvailable()) {
+            std::cerr << "tablebase '" << path << "' cannot be loaded\n";
+            return EXIT_FAILURE;
+        }
+        tablebase.collectKeys(keys);
+        std::cout << "tablebase=" << path << " entries=" << tablebase.size() << " empty<=" << tablebase.getMaxEmpty() << "\n";
+    }
+    if (keys.empty())
+        return 0;
+
+    std::mt19937_64 rng(1);
+    int score;
+
+    // cold - a fresh mapping of a file evicted from the page cache
+    std::vector<double> cold;
+    for (int round = 0; round < coldRounds; round++) {
+        evictFromPageCache(path);
+        Tablebase tablebase(path);
+        for (int i = 0; i < 16; i++) {
+            uint64_t key = keys[rng() % keys.size()];
+            auto start = std::chrono::steady_clock::now();
+            tablebase.probeKey(key, score);
+            cold.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    printStats("cold (page cache evicted)", cold);
+
+    // hot - everything is in the page cache and mapped
+    Tablebase tablebase(path);
+    for (uint64_t key : keys)
+        tablebase.probeKey(key, score);
+    std::vector<double> hot;
+    hot.reserve(hotProbes);
+    uint64_t found = 0;
+    for (size_t i = 0; i < hotProbes; i++) {
+        uint64_t key = keys[rng() % keys.size()];
+        auto start = std::chrono::steady_clock::now();
+        found += tablebase.probeKey(key, score);
+        hot.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    printStats("hot (page cache warm)", hot);
+    if (found != hotProbes)
+        std::cerr << "WARNING: " << hotProbes - found << " keys were not found\n";
+
+    // verification against the solver
+    if (verify > 0) {
+        TranspositionTable table;
+        Solver solver(&table);
+        int mismatches = 0;
+        for (int i = 0; i < verify; i++) {
+            Position position = Position::fromKey(keys[rng() % keys.size()]);
+            int expected = solver.solve(position);
+            if (!tablebase.probe(position, score) || score != expected)
+                mismatches++;
+        }
+        std::cout << "verified=" << verify << " mismatches=" << mismatches << "\n";
+        return mismatches ? EXIT_FAILURE : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../Position.h"
+#include "../Tablebase.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-k empty] [-s seeds] [-r rng seed] [-t threads] [-o file] [moves...]\n";
+    std::cout << "Generates an endgame tablebase. Starting from seed positions with K empty\n";
+    std::cout << "tiles, all the positions reachable from them are enumerated and scored\n";
+    std::cout << "backwards from the full grid (retrograde analysis) in parallel.\n";
+    std::cout << "Seed positions may be given as sequences of columns (0-6), otherwise random ones are used.\n";
+    std::cout << "-k number of empty tiles of the seed positions (default: 10)\n";
+    std::cout << "-s number of random seed positions (default: 1000)\n";
+    std::cout << "-r seed of the random number generator (default: 1)\n";
+    std::cout << "-t number of threads (default: all cores)\n";
+    std::cout << "-o output file (default: " << Tablebase::DEFAULT_PATH << ")\n";
+}
+
+/// Compares two positions by their canonical keys
+/// \param a the first position
+/// \param b the second position
+/// \return true, if a goes before b
+bool byKey(const Position &a, const Position &b) {
+    return a.canonicalKey() < b.canonicalKey();
+}
+
+/// Sorts the positions and removes duplicates (mirror images included)
+/// \param positions the positions
+void sortUnique(std::vector<Position> &positions) {
+    std::sort(positions.begin(), positions.end(), byKey);
+    positions.erase(std::unique(positions.begin(), positions.end(), [](const Position &a, const Position &b) {
+        return a.canonicalKey() == b.canonicalKey();
+    }), positions.end());
+}
+
+/// Runs the function given as a parameter on all the threads,
+/// each thread gets its own slice [from, to) of the range [0, count)
+/// \param threads number of threads
+/// \param count size of the range
+/// \param f the function (thread index, from, to)
+template<typename F>
+void parallelFor(int threads, size_t count, F f) {
+    std::vector<std::thread> workers;
+    size_t chunk = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t from = std::min(count, t * chunk);
+        size_t to = std::min(count, from + chunk);
+        workers.emplace_back(f, t, from, to);
+    }
+    for (auto &w : workers)
+        w.join();
+}
+
+/// The entry point of the tablebase generator
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    const int CELLS = Position::WIDTH * Position::HEIGHT;
+    int maxEmpty = 10;
+    int seeds = 1000;
+    unsigned int rngSeed = 1;
+    int threads = (int)std::thread::hardware_concurrency();
+    std::string output = Tablebase::DEFAULT_PATH;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:s:r:t:o:h")) != -1) {
+        switch (opt) {
+            case 'k': maxEmpty = atoi(optarg); break;
+            case 's': seeds = atoi(optarg); break;
+            case 'r': rngSeed = strtoul(optarg, NULL, 10); break;
+            case 't': threads = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (maxEmpty < 1 || maxEmpty > CELLS || seeds < 0 || threads < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto start = std::chrono::steady_clock::now();
+    int firstPly = CELLS - maxEmpty;
+
+    // levels[i] holds the positions with firstPly + i moves
+    std::vector<std::vector<Position>> levels(maxEmpty);
+
+    for (int i = optind; i < argc; i++) {
+        Position position;
+        std::string moves(argv[i]);
+        if (position.play(moves) != moves.size() || position.nbMoves() != firstPly) {
+            std::cerr << "seed '" << moves << "' is not a valid position with " << maxEmpty << " empty tiles\n";
+            return EXIT_FAILURE;
+        }
+        levels[0].push_back(position);
+    }
+
+    // random seeds - every thread has its own generator, so the
+    // result only depends on the seed and the number of threads
+    std::vector<std::vector<Position>> randomSeeds(threads);
+    parallelFor(threads, seeds, [&](int t, size_t from, size_t to) {
+        std::mt19937_64 rng(rngSeed + t);
+        for (size_t i = from; i < to; i++) {
+            Position position;
+            while (position.nbMoves() < firstPly) {
+                int playable = 0;
+                int columns[Position::WIDTH];
+                for (int col = 0; col < Position::WIDTH; col++)
+                    if (position.canPlay(col) && !position.isWinningMove(col))
+                        columns[playable++] = col;
+                if (playable == 0) {
+                    position = Position();
+                    continue;
+                }
+                position.playCol(columns[rng() % playable]);
+            }
+            randomSeeds[t].push_back(position);
+        }
+    });
+    for (auto &s : randomSeeds)
+        levels[0].insert(levels[0].end(), s.begin(), s.end());
+    sortUnique(levels[0]);
+
+    // forward pass - enumerate all the positions reachable from the seeds
+    for (int i = 0; i + 1 < maxEmpty; i++) {
+        std::vector<std::vector<Position>> children(threads);
+        const std::vector<Position> &level = levels[i];
+        parallelFor(threads, level.size(), [&](int t, size_t from, size_t to) {
+            for (size_t j = from; j < to; j++)
+                for (int col = 0; col < Position::WIDTH; col++) {
+                    if (!level[j].canPlay(col) || level[j].isWinningMove(col))
+                        continue;
+                    Position child(level[j]);
+                    child.playCol(col);
+                    children[t].push_back(child);
+                }
+        });
+        for (auto &c : children)
+            levels[i + 1].insert(levels[i + 1].end(), c.begin(), c.end());
+        sortUnique(levels[i + 1]);
+        std::cerr << "empty=" << maxEmpty - i - 1 << " positions=" << levels[i + 1].size() << "\n";
+    }
+    double enumerationTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // backward pass - score every level from its (already scored) children
+    auto scoringStart = std::chrono::steady_clock::now();
+    std::vector<std::vector<int8_t>> scores(maxEmpty);
+    uint64_t scored = 0;
+    for (int i = maxEmpty - 1; i >= 0; i--) {
+        const std::vector<Position> &level = levels[i];
+        scores[i].resize(level.size());
+        parallelFor(threads, level.size(), [&](int, size_t from, size_t to) {
+            for (size_t j = from; j < to; j++) {
+                const Position &position = level[j];
+                int best = -CELLS;
+                for (int col = 0; col < Position::WIDTH; col++) {
+                    if (!position.canPlay(col))
+                        continue;
+                    int value;
+                    if (position.isWinningMove(col))
+                        value = (CELLS + 1 - position.nbMoves()) / 2;
+                    else if (position.nbMoves() + 1 == CELLS)
+                        value = 0;
+                    else {
+                        Position child(position);
+                        child.playCol(col);
+                        auto it = std::lower_bound(levels[i + 1].begin(), levels[i + 1].end(), child, byKey);
+                        value = -scores[i + 1][it - levels[i + 1].begin()];
+                    }
+                    best = std::max(best, value);
+                }
+                scores[i][j] = (int8_t)best;
+            }
+        });
+        scored += level.size();
+    }
+    double scoringTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - scoringStart).count();
+
+    std::vector<std::pair<uint64_t,int8_t>> entries;
+    entries.reserve(scored);
+    for (int i = 0; i < maxEmpty; i++)
+        for (size_t j = 0; j < levels[i].size(); j++)
+            entries.push_back({levels[i][j].canonicalKey(), scores[i][j]});
+    std::sort(entries.begin(), entries.end());
+
+    size_t slash = output.find_last_of('/');
+    if (slash != std::string::npos)
+        mkdir(output.substr(0, slash).c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    if (!Tablebase::write(output, maxEmpty, entries)) {
+        std::cerr << "writing the tablebase into '" << output << "' failed\n";
+        return EXIT_FAILURE;
+    }
+    struct stat st;
+    stat(output.c_str(), &st);
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "tablebase=" << output << " empty<=" << maxEmpty << " seeds=" << levels[0].size() << " entries=" << entries.size() << "\n";
+    std::cout << "file size=" << st.st_size << "B (" << (entries.empty() ? 0.0 : (double)st.st_size / entries.size()) << "B per entry)\n";
+    std::cout << "enumeration=" << enumerationTime << "s scoring=" << scoringTime << "s total=" << total << "s\n";
+    std::cout << "scoring throughput=" << (scoringTime > 0 ? scored / scoringTime : 0.0) << " positions/s";
+    std::cout << " (" << (scoringTime > 0 ? scored / scoringTime / threads : 0.0) << " positions/s per core, " << threads << " threads)\n";
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "../Connect4.h"
+#include "../Position.h"
+#include "../WinCheck.h"
+
+/// Prints out how to use the program
+/// \param name name of the program
+void printHelp(const char *name) {
+    std::cout << "Usage: " << name << " [-n games] [-i iterations] [-r seed]\n";
+    std::cout << "Compares the ways of checking the end of a game: the scan of the grid\n";
+    std::cout << "(Connect4::getWinningTiles), the scalar bitboard check and the SIMD batch check.\n";
+    std::cout << "-n number of random games checked (default: 4096)\n";
+    std::cout << "-i number of times all of them are checked (default: 200)\n";
+    std::cout << "-r seed of the random number generator (default: 1)\n";
+}
+
+/// Prints out the result of one measurement
+/// \param name name of the method
+/// \param checks number of games checked
+/// \param seconds time it took
+/// \param baseline time of the grid scan (used for the speedup)
+void printResult(const std::string &name, uint64_t checks, double seconds, double baseline) {
+    std::cout << std::left << std::setw(18) << name << std::right << std::fixed;
+    std::cout << std::setprecision(2) << std::setw(10) << seconds * 1e9 / checks << " ns/game";
+    std::cout << std::setprecision(1) << std::setw(10) << checks / seconds / 1e6 << " M games/s";
+    std::cout << std::setprecision(1) << std::setw(10) << baseline / seconds << "x\n";
+}
+
+/// The entry point of the win check benchmark
+///
+/// \param argc number of arguments the user enters in the terminal
+/// \param argv argument values
+/// \return 0 on successful execution, EXIT_FAILURE otherwise
+int main(int argc, char *argv[]) {
+    const int CELLS = Position::WIDTH * Position::HEIGHT;
+    size_t count = 4096;
+    int iterations = 200;
+    uint64_t seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:i:r:h")) != -1) {
+        switch (opt) {
+            case 'n': count = strtoull(optarg, NULL, 10); break;
+            case 'i': iterations = atoi(optarg); break;
+            case 'r': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                printHelp(argv[0]);
+                return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (count == 0 || iterations < 1) {
+        printHelp(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // random games stopped at a random move (or when someone wins)
+    std::mt19937_64 rng(seed);
+    std::vector<std::unique_ptr<Connect4>> games;
+    std::vector<uint64_t> bitboards;
+    for (size_t i = 0; i < count; i++) {
+        std::unique_ptr<Connect4> game(new Connect4("player1", "player2", NULL));
+        int length = rng() % CELLS + 1;
+        Connect4::GameState state = Connect4::CONTINUE;
+        for (int move = 0; move < length && state == Connect4::CONTINUE; move++) {
+            int col;
+            do {
+                col = rng() % Position::WIDTH;
+            } while (!game->getPosition().canPlay(col));
+            state = game->play(move % 2 == 0 ? "player1" : "player2", col);
+        }
+        const Position &position = game->getPosition();
+        bitboards.push_back(position.getCurrentPosition());
+        bitboards.push_back(position.getCurrentPosition() ^ position.getMask());
+        games.push_back(std::move(game));
+    }
+    uint64_t checks = (uint64_t)count * iterations;
+    std::cout << "games=" << count << " iterations=" << iterations << " best isa=" << WinCheck::getName(WinCheck::getIsa()) << "\n";
+
+    // the scan of the grid
+    uint64_t scanWins = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+        for (auto &game : games)
+            scanWins += !game->getWinningTiles().empty();
+    double scan = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printResult("grid scan", checks, scan, scan);
+
+    // scalar bitboard check (both players of every game)
+    uint64_t scalarWins = 0;
+    start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+        for (size_t i = 0; i < bitboards.size(); i += 2)
+            scalarWins += Position::hasAlignment(bitboards[i]) | Position::hasAlignment(bitboards[i + 1]);
+    double scalar = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printResult("bitboard", checks, scalar, scan);
+
+    bool consistent = scanWins == scalarWins;
+    std::vector<uint8_t> results(bitboards.size());
+    for (WinCheck::Isa isa : {WinCheck::SCALAR, WinCheck::SSE4, WinCheck::AVX2}) {
+        if (!WinCheck::isSupported(isa))
+            continue;
+        uint64_t wins = 0;
+        start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            WinCheck::hasAlignment(isa, bitboards.data(), results.data(), bitboards.size());
+            for (size_t i = 0; i < results.size(); i += 2)
+                wins += results[i] | results[i + 1];
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printResult(std::string("batch ") + WinCheck::getName(isa), checks, elapsed, scan);
+        consistent &= wins == scanWins;
+    }
+
+    std::cout << "games won=" << scanWins / iterations << " (" << (consistent ? "all methods agree" : "METHODS DISAGREE") << ")\n";
+    return consistent ? 0 : EXIT_FAILURE;
+}